@@ -3,12 +3,15 @@
 #include "native/os/OS.h"
 #include "parser/Parser.h"
 #include "semantic/SemanticAnalyzer.h"
+#include "serve/Supervisor.h"
 #include "vm/Compiler.h"
 #include "vm/VM.h"
 #include "vm/serializer/Serializer.h"
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -63,11 +66,12 @@ int main(int argc, char **argv) {
     }
 
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " [build] <file> [output]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [build | serve --procs N] <file> [output]" << std::endl;
         return 1;
     }
 
     bool buildStandalone = false;
+    int serveProcs = 0;
     std::string inputFile;
     std::string outputFile;
 
@@ -83,6 +87,21 @@ int main(int argc, char **argv) {
         } else {
             outputFile = "app";
         }
+    } else if (command == "serve") {
+        int i = 2;
+        serveProcs = static_cast<int>(std::thread::hardware_concurrency());
+        if (i + 1 < argc && std::string(argv[i]) == "--procs") {
+            serveProcs = std::atoi(argv[i + 1]);
+            i += 2;
+        }
+        if (i >= argc || serveProcs < 1) {
+            std::cerr << "Usage: " << argv[0] << " serve [--procs N] <file.try> [args...]" << std::endl;
+            return 1;
+        }
+        inputFile = argv[i];
+        for (i++; i < argc; i++) {
+            StdLib::OSModule::commandLineArgs.push_back(argv[i]);
+        }
     } else {
         inputFile = argv[1];
         for (int i = 2; i < argc; i++) {
@@ -122,6 +141,8 @@ int main(int argc, char **argv) {
                 std::cerr << "Error building standalone executable: " << outputFile << std::endl;
                 return 1;
             }
+        } else if (serveProcs > 0) {
+            return Serve::runPrefork(function, serveProcs);
         } else {
             VM vm;
             InterpretResult result = vm.interpret(function);
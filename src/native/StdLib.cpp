@@ -1,15 +1,26 @@
+#include "atomics/Atomics.h"
+#include "compress/Compress.h"
 #include "core/Core.h"
 #include "crypto/Crypto.h"
+#include "csv/Csv.h"
 #include "fs/FS.h"
+#include "immutable/Immutable.h"
 #include "list/List.h"
+#include "log/Log.h"
 #include "map/Map.h"
 #include "math/Math.h"
+#include "msgpack/MsgPack.h"
+#include "ndarray/NDArray.h"
+#include "net/Datagram.h"
 #include "net/Net.h"
 #include "net/WebSocket.h"
 #include "os/OS.h"
+#include "queue/Queue.h"
 #include "random/Random.h"
 #include "regex/Regex.h"
+#include "set/Set.h"
 #include "string/String.h"
+#include "task/Task.h"
 #include "terminal/Terminal.h"
 #include "time/Time.h"
 #include "worker/Worker.h"
@@ -21,18 +32,29 @@ namespace StdLib {
 void registerAll(VM *vm) {
     Core::registerAll(vm);
     Math::registerAll(vm);
+    NDArrayModule::registerAll(vm);
     FS::registerAll(vm);
     Net::registerAll(vm);
+    DatagramModule::registerAll(vm);
     Json::registerAll(vm);
+    CsvModule::registerAll(vm);
+    MsgPackModule::registerAll(vm);
+    CompressModule::registerAll(vm);
     StringModule::registerAll(vm);
     TimeModule::registerAll(vm);
     ListModule::registerAll(vm);
+    LogModule::registerAll(vm);
     OSModule::registerAll(vm);
     RandomModule::registerAll(vm);
     TerminalModule::registerAll(vm);
     MapModule::registerAll(vm);
+    SetModule::registerAll(vm);
+    QueueModule::registerAll(vm);
     RegexModule::registerAll(vm);
+    AtomicsModule::registerAll(vm);
+    ImmutableModule::registerAll(vm);
     WorkerModule::registerAll(vm);
+    TaskModule::registerAll(vm);
     CryptoModule::registerAll(vm);
     WebSocketModule::registerAll(vm);
     Test::registerAll(vm);
@@ -42,18 +64,29 @@ void registerAll(VM *vm) {
 void registerSymbols(SymbolTable *scope) {
     Core::registerSymbols(scope);
     Math::registerSymbols(scope);
+    NDArrayModule::registerSymbols(scope);
     FS::registerSymbols(scope);
     Net::registerSymbols(scope);
+    DatagramModule::registerSymbols(scope);
     Json::registerSymbols(scope);
+    CsvModule::registerSymbols(scope);
+    MsgPackModule::registerSymbols(scope);
+    CompressModule::registerSymbols(scope);
     StringModule::registerSymbols(scope);
     TimeModule::registerSymbols(scope);
     ListModule::registerSymbols(scope);
+    LogModule::registerSymbols(scope);
     OSModule::registerSymbols(scope);
     RandomModule::registerSymbols(scope);
     TerminalModule::registerSymbols(scope);
     MapModule::registerSymbols(scope);
+    SetModule::registerSymbols(scope);
+    QueueModule::registerSymbols(scope);
     RegexModule::registerSymbols(scope);
+    AtomicsModule::registerSymbols(scope);
+    ImmutableModule::registerSymbols(scope);
     WorkerModule::registerSymbols(scope);
+    TaskModule::registerSymbols(scope);
     CryptoModule::registerSymbols(scope);
     WebSocketModule::registerSymbols(scope);
     Test::registerSymbols(scope);
@@ -0,0 +1,267 @@
+#include "Atomics.h"
+#include "../StdLib.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace StdLib {
+namespace AtomicsModule {
+
+using Handle = std::shared_ptr<SharedStore>;
+
+static void freeBuffer(void *ptr) {
+    delete static_cast<Handle *>(ptr);
+}
+
+VMValue wrapSharedStore(Handle store) {
+    if (!store)
+        return nullptr;
+    auto klass = currentVM->globals.find("SharedArrayBuffer");
+    if (klass == currentVM->globals.end() || !klass->second.isClass())
+        return nullptr;
+    auto instance = new ObjInstance(klass->second.asClass());
+    instance->nativeData = new Handle(std::move(store));
+    instance->freeFn = freeBuffer;
+    return instance;
+}
+
+Handle sharedStoreOf(VMValue value) {
+    if (!value.isInstance())
+        return nullptr;
+    auto instance = value.asInstance();
+    if (instance->freeFn != freeBuffer)
+        return nullptr;
+    return *static_cast<Handle *>(instance->nativeData);
+}
+
+static SharedStore *unwrap(VMValue value) {
+    if (!value.isInstance())
+        return nullptr;
+    auto instance = value.asInstance();
+    if (instance->freeFn != freeBuffer)
+        return nullptr;
+    return static_cast<Handle *>(instance->nativeData)->get();
+}
+
+// Truncates to an integer and wraps it to the slot width the way a C
+// integer conversion would; false for non-numbers, NaN, infinities and
+// values outside the int64 range.
+template <typename T> static bool toSlotValue(VMValue value, T &out) {
+    if (!value.isNumber())
+        return false;
+    double d = value.asNumber();
+    if (!std::isfinite(d) || d < -9223372036854775808.0 || d >= 9223372036854775808.0)
+        return false;
+    out = static_cast<T>(static_cast<int64_t>(d));
+    return true;
+}
+
+// Resolves slot `index` of sizeof(T) bytes; null when out of range.
+template <typename T> static T *slot(VMValue buffer, VMValue index) {
+    SharedStore *store = unwrap(buffer);
+    if (!store || !index.isNumber())
+        return nullptr;
+    double i = index.asNumber();
+    if (i < 0 || i != std::floor(i) || (i + 1) * sizeof(T) > store->byteLength)
+        return nullptr;
+    return reinterpret_cast<T *>(store->bytes()) + static_cast<size_t>(i);
+}
+
+static VMValue sabCreate(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isNumber())
+        return nullptr;
+    double length = args[0].asNumber();
+    if (!(length >= 0) || length != std::floor(length) || length > static_cast<double>(SIZE_MAX / 2))
+        return nullptr;
+    auto store = std::make_shared<SharedStore>();
+    store->byteLength = static_cast<size_t>(length);
+    store->words.reset(new (std::nothrow) uint64_t[(store->byteLength + 7) / 8]());
+    if (!store->words)
+        return nullptr;
+    return wrapSharedStore(std::move(store));
+}
+
+static VMValue sabByteLength(int argCount, VMValue *args) {
+    (void)argCount;
+    SharedStore *store = unwrap(args[-1]);
+    if (!store)
+        return nullptr;
+    return static_cast<double>(store->byteLength);
+}
+
+static VMValue sabGet(int argCount, VMValue *args) {
+    (void)argCount;
+    uint8_t *byte = slot<uint8_t>(args[-1], args[0]);
+    if (!byte)
+        return nullptr;
+    return static_cast<double>(std::atomic_ref<uint8_t>(*byte).load(std::memory_order_relaxed));
+}
+
+static VMValue sabSet(int argCount, VMValue *args) {
+    (void)argCount;
+    uint8_t *byte = slot<uint8_t>(args[-1], args[0]);
+    uint8_t value;
+    if (!byte || !toSlotValue(args[1], value))
+        return nullptr;
+    std::atomic_ref<uint8_t>(*byte).store(value, std::memory_order_relaxed);
+    return args[1];
+}
+
+template <typename T> static VMValue atomicRead(int argCount, VMValue *args) {
+    (void)argCount;
+    T *p = slot<T>(args[0], args[1]);
+    if (!p)
+        return nullptr;
+    return static_cast<double>(std::atomic_ref<T>(*p).load());
+}
+
+template <typename T> static VMValue atomicWrite(int argCount, VMValue *args) {
+    (void)argCount;
+    T *p = slot<T>(args[0], args[1]);
+    T value;
+    if (!p || !toSlotValue(args[2], value))
+        return nullptr;
+    std::atomic_ref<T>(*p).store(value);
+    return static_cast<double>(value);
+}
+
+template <typename T> static VMValue atomicAdd(int argCount, VMValue *args) {
+    (void)argCount;
+    T *p = slot<T>(args[0], args[1]);
+    T delta;
+    if (!p || !toSlotValue(args[2], delta))
+        return nullptr;
+    return static_cast<double>(std::atomic_ref<T>(*p).fetch_add(delta));
+}
+
+template <typename T> static VMValue atomicCompareExchange(int argCount, VMValue *args) {
+    (void)argCount;
+    T *p = slot<T>(args[0], args[1]);
+    T expected, desired;
+    if (!p || !toSlotValue(args[2], expected) || !toSlotValue(args[3], desired))
+        return nullptr;
+    std::atomic_ref<T>(*p).compare_exchange_strong(expected, desired);
+    return static_cast<double>(expected);
+}
+
+// Atomics.wait(buffer, index, expected, timeoutMs?) blocks the calling
+// thread while the 32-bit slot still holds `expected`.
+static VMValue atomicWait(int argCount, VMValue *args) {
+    if (argCount < 3 || argCount > 4)
+        return nullptr;
+    int32_t *p = slot<int32_t>(args[0], args[1]);
+    int32_t expected;
+    if (!p || !toSlotValue(args[2], expected))
+        return nullptr;
+    double timeoutMs = argCount == 4 && args[3].isNumber() ? args[3].asNumber() : -1;
+    if (std::isnan(timeoutMs) || timeoutMs > 1e15)
+        timeoutMs = -1; // NaN and timeouts beyond ~30000 years wait forever
+
+    std::atomic_ref<int32_t> cell(*p);
+    if (cell.load() != expected)
+        return new ObjString("not-equal");
+#ifdef __linux__
+    struct timespec ts;
+    struct timespec *tsp = nullptr;
+    if (timeoutMs >= 0) {
+        ts.tv_sec = static_cast<time_t>(timeoutMs / 1000);
+        ts.tv_nsec = static_cast<long>(std::fmod(timeoutMs, 1000.0) * 1e6);
+        tsp = &ts;
+    }
+    // FUTEX_WAIT returns early on spurious wakeups; callers re-check the
+    // slot in a loop, as with any futex.
+    long rc = syscall(SYS_futex, p, FUTEX_WAIT_PRIVATE, expected, tsp, nullptr, 0);
+    if (rc != 0 && errno == ETIMEDOUT)
+        return new ObjString("timed-out");
+    if (rc != 0 && errno == EAGAIN)
+        return new ObjString("not-equal");
+    return new ObjString("ok");
+#else
+    if (timeoutMs >= 0) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(timeoutMs);
+        while (cell.load() == expected) {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return new ObjString("timed-out");
+            std::this_thread::yield();
+        }
+        return new ObjString("ok");
+    }
+    cell.wait(expected);
+    return new ObjString("ok");
+#endif
+}
+
+// Atomics.notify(buffer, index, count?) wakes up to `count` waiters
+// (all by default) and returns how many were woken where known.
+static VMValue atomicNotify(int argCount, VMValue *args) {
+    if (argCount < 2 || argCount > 3)
+        return nullptr;
+    int32_t *p = slot<int32_t>(args[0], args[1]);
+    if (!p)
+        return nullptr;
+    double requested = argCount == 3 && args[2].isNumber() ? args[2].asNumber() : INT32_MAX;
+    if (std::isnan(requested))
+        return nullptr;
+    int count = static_cast<int>(std::clamp(requested, 0.0, static_cast<double>(INT32_MAX)));
+    if (count <= 0)
+        return 0.0;
+#ifdef __linux__
+    long woken = syscall(SYS_futex, p, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    return static_cast<double>(woken < 0 ? 0 : woken);
+#else
+    std::atomic_ref<int32_t> cell(*p);
+    if (count == 1)
+        cell.notify_one();
+    else
+        cell.notify_all();
+    return static_cast<double>(count == INT32_MAX ? 0 : count);
+#endif
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto sabClass = new ObjClass("SharedArrayBuffer");
+    sabClass->statics["create"] = new ObjNative("create", 1, sabCreate);
+    sabClass->methods["byteLength"] = new ObjNative("byteLength", 0, sabByteLength);
+    sabClass->methods["get"] = new ObjNative("get", 1, sabGet);
+    sabClass->methods["set"] = new ObjNative("set", 2, sabSet);
+    vm->globals["SharedArrayBuffer"] = sabClass;
+
+    auto atomicsClass = new ObjClass("Atomics");
+    atomicsClass->statics["read"] = new ObjNative("read", 2, atomicRead<int32_t>);
+    atomicsClass->statics["write"] = new ObjNative("write", 3, atomicWrite<int32_t>);
+    atomicsClass->statics["add"] = new ObjNative("add", 3, atomicAdd<int32_t>);
+    atomicsClass->statics["compareExchange"] = new ObjNative("compareExchange", 4, atomicCompareExchange<int32_t>);
+    atomicsClass->statics["read64"] = new ObjNative("read64", 2, atomicRead<int64_t>);
+    atomicsClass->statics["write64"] = new ObjNative("write64", 3, atomicWrite<int64_t>);
+    atomicsClass->statics["add64"] = new ObjNative("add64", 3, atomicAdd<int64_t>);
+    atomicsClass->statics["compareExchange64"] =
+        new ObjNative("compareExchange64", 4, atomicCompareExchange<int64_t>);
+    atomicsClass->statics["wait"] = new ObjNative("wait", -1, atomicWait);
+    atomicsClass->statics["notify"] = new ObjNative("notify", -1, atomicNotify);
+    vm->globals["Atomics"] = atomicsClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "SharedArrayBuffer";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+    sym.name = "Atomics";
+    scope->define(sym);
+}
+
+} // namespace AtomicsModule
+} // namespace StdLib
@@ -0,0 +1,33 @@
+#ifndef TRYPILLIA_ATOMICS_H
+#define TRYPILLIA_ATOMICS_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+#include <cstdint>
+#include <memory>
+
+namespace StdLib {
+namespace AtomicsModule {
+
+// Backing store of a SharedArrayBuffer. Owned jointly by every VM that
+// holds a handle to it; 8-byte aligned so 64-bit slots can be atomic.
+struct SharedStore {
+    std::unique_ptr<uint64_t[]> words;
+    size_t byteLength = 0;
+
+    uint8_t *bytes() const {
+        return reinterpret_cast<uint8_t *>(words.get());
+    }
+};
+
+// Wraps a store in a SharedArrayBuffer instance of the current VM.
+VMValue wrapSharedStore(std::shared_ptr<SharedStore> store);
+// Returns the store behind a SharedArrayBuffer value, or null.
+std::shared_ptr<SharedStore> sharedStoreOf(VMValue value);
+
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace AtomicsModule
+} // namespace StdLib
+
+#endif
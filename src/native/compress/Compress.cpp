@@ -0,0 +1,289 @@
+#include "Compress.h"
+#include "../../vm/runtime/GC.h"
+#include "../StdLib.h"
+#include "../fs/FS.h"
+#include "../net/Net.h"
+#include "Deflate.h"
+#include "Lz4.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace StdLib {
+namespace CompressModule {
+
+enum class Format { GZIP, DEFLATE, LZ4 };
+
+struct CompressStream {
+    Format format;
+    int level;
+    Deflate::Deflater deflater;
+    Lz4::FrameWriter lz4;
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    bool started = false;
+    bool finished = false;
+    // File or Socket the output is forwarded to; nil to return it instead
+    VMValue target = nullptr;
+
+    CompressStream(Format f, int l) : format(f), level(l), deflater(l) {
+    }
+};
+
+static void freeStream(void *ptr) {
+    delete static_cast<CompressStream *>(ptr);
+}
+
+static void traceStream(void *ptr) {
+    GC::markValue(static_cast<CompressStream *>(ptr)->target);
+}
+
+static CompressStream *unwrapStream(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeStream)
+        return nullptr;
+    return static_cast<CompressStream *>(value.asInstance()->nativeData);
+}
+
+// Optional trailing level argument, defaulting to 6
+static bool levelArg(int argCount, VMValue *args, int index, int &level) {
+    level = 6;
+    if (argCount <= index)
+        return true;
+    if (!args[index].isNumber())
+        return false;
+    level = static_cast<int>(args[index].asNumber());
+    return level >= 0 && level <= 9;
+}
+
+// Optional output limit for decompressors, so hostile input cannot
+// expand without bound
+static bool limitArg(int argCount, VMValue *args, int index, size_t &limit) {
+    limit = SIZE_MAX;
+    if (argCount <= index)
+        return true;
+    if (!args[index].isNumber() || args[index].asNumber() < 0)
+        return false;
+    limit = static_cast<size_t>(args[index].asNumber());
+    return true;
+}
+
+static VMValue compressLz4(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    return Lz4::compressFrame(args[0].asString()->flatView());
+}
+
+static VMValue compressUnlz4(int argCount, VMValue *args) {
+    size_t limit;
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || !limitArg(argCount, args, 1, limit))
+        return nullptr;
+    std::string out;
+    if (!Lz4::decompressFrame(args[0].asString()->flatView(), out, limit))
+        return nullptr;
+    return out;
+}
+
+static VMValue compressLz4Block(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    std::string out;
+    Lz4::compressBlock(args[0].asString()->flatView(), out);
+    return out;
+}
+
+// Raw blocks carry no length, so the caller passes the decoded size. No
+// block expands more than 255 to 1, so larger sizes are refused before
+// anything is allocated.
+static VMValue compressUnlz4Block(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isString() || !args[1].isNumber() || args[1].asNumber() < 0)
+        return nullptr;
+    std::string_view input = args[0].asString()->flatView();
+    if (!(args[1].asNumber() <= static_cast<double>(input.size()) * 255))
+        return nullptr;
+    size_t size = static_cast<size_t>(args[1].asNumber());
+    std::string out;
+    out.reserve(size);
+    if (!Lz4::decompressBlock(input, out, size) || out.size() != size)
+        return nullptr;
+    return out;
+}
+
+static VMValue compressDeflate(int argCount, VMValue *args) {
+    int level;
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || !levelArg(argCount, args, 1, level))
+        return nullptr;
+    return Deflate::deflate(args[0].asString()->flatView(), level);
+}
+
+static VMValue compressInflate(int argCount, VMValue *args) {
+    size_t limit;
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || !limitArg(argCount, args, 1, limit))
+        return nullptr;
+    std::string out;
+    if (!Deflate::inflate(args[0].asString()->flatView(), out, limit))
+        return nullptr;
+    return out;
+}
+
+static VMValue compressGzip(int argCount, VMValue *args) {
+    int level;
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || !levelArg(argCount, args, 1, level))
+        return nullptr;
+    return Deflate::gzip(args[0].asString()->flatView(), level);
+}
+
+static VMValue compressGunzip(int argCount, VMValue *args) {
+    size_t limit;
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || !limitArg(argCount, args, 1, limit))
+        return nullptr;
+    std::string out;
+    if (!Deflate::gunzip(args[0].asString()->flatView(), out, limit))
+        return nullptr;
+    return out;
+}
+
+static VMValue compressCrc32(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    return static_cast<double>(Deflate::crc32(0, args[0].asString()->flatView()));
+}
+
+// Compress.stream(format, target?, level?)
+static VMValue compressStream(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 3 || !args[0].isString())
+        return nullptr;
+    const std::string &name = args[0].asString()->flatView();
+    Format format;
+    if (name == "gzip")
+        format = Format::GZIP;
+    else if (name == "deflate")
+        format = Format::DEFLATE;
+    else if (name == "lz4")
+        format = Format::LZ4;
+    else
+        return nullptr;
+
+    VMValue target = argCount >= 2 ? args[1] : VMValue(nullptr);
+    if (!target.isNil() && !target.isInstance())
+        return nullptr;
+    int level;
+    if (!levelArg(argCount, args, 2, level))
+        return nullptr;
+
+    auto stream = new CompressStream(format, level);
+    stream->target = target;
+    auto instance = new ObjInstance(currentVM->globals["CompressStream"].asClass());
+    instance->nativeData = stream;
+    instance->freeFn = freeStream;
+    instance->traceFn = traceStream;
+    return instance;
+}
+
+// Hands produced bytes to the caller: returned as a String without a
+// target, written through with a Result otherwise.
+static VMValue deliver(CompressStream *stream, std::string &out) {
+    if (stream->target.isNil())
+        return out;
+    if (out.empty())
+        return makeResultOk(currentVM, true);
+    bool ok = FS::writeToFile(stream->target, out) || Net::sendToSocket(stream->target, out);
+    if (!ok)
+        return makeResultErr(currentVM, "Failed to write compressed data");
+    return makeResultOk(currentVM, true);
+}
+
+static void begin(CompressStream *stream, std::string &out) {
+    if (stream->started)
+        return;
+    stream->started = true;
+    if (stream->format == Format::GZIP)
+        Deflate::gzipHeader(out, stream->level);
+}
+
+static VMValue streamWrite(int argCount, VMValue *args) {
+    CompressStream *stream = unwrapStream(args[-1]);
+    if (!stream || stream->finished || argCount != 1 || !args[0].isString())
+        return nullptr;
+    std::string_view data = args[0].asString()->flatView();
+    std::string out;
+    begin(stream, out);
+    if (stream->format == Format::LZ4) {
+        stream->lz4.write(data, out);
+    } else {
+        stream->deflater.write(data, out);
+        if (stream->format == Format::GZIP) {
+            stream->crc = Deflate::crc32(stream->crc, data);
+            stream->size += data.size();
+        }
+    }
+    return deliver(stream, out);
+}
+
+// Emits everything written so far so the reader can decode it, without
+// ending the stream.
+static VMValue streamFlush(int argCount, VMValue *args) {
+    (void)argCount;
+    CompressStream *stream = unwrapStream(args[-1]);
+    if (!stream || stream->finished)
+        return nullptr;
+    std::string out;
+    begin(stream, out);
+    if (stream->format == Format::LZ4)
+        stream->lz4.flush(out);
+    else
+        stream->deflater.flush(out);
+    return deliver(stream, out);
+}
+
+static VMValue streamFinish(int argCount, VMValue *args) {
+    (void)argCount;
+    CompressStream *stream = unwrapStream(args[-1]);
+    if (!stream || stream->finished)
+        return nullptr;
+    std::string out;
+    begin(stream, out);
+    if (stream->format == Format::LZ4) {
+        stream->lz4.finish(out);
+    } else {
+        stream->deflater.finish(out);
+        if (stream->format == Format::GZIP)
+            Deflate::gzipTrailer(out, stream->crc, stream->size);
+    }
+    stream->finished = true;
+    return deliver(stream, out);
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto compressClass = new ObjClass("Compress");
+    compressClass->statics["lz4"] = new ObjNative("lz4", 1, compressLz4);
+    compressClass->statics["unlz4"] = new ObjNative("unlz4", -1, compressUnlz4);
+    compressClass->statics["lz4Block"] = new ObjNative("lz4Block", 1, compressLz4Block);
+    compressClass->statics["unlz4Block"] = new ObjNative("unlz4Block", 2, compressUnlz4Block);
+    compressClass->statics["deflate"] = new ObjNative("deflate", -1, compressDeflate);
+    compressClass->statics["inflate"] = new ObjNative("inflate", -1, compressInflate);
+    compressClass->statics["gzip"] = new ObjNative("gzip", -1, compressGzip);
+    compressClass->statics["gunzip"] = new ObjNative("gunzip", -1, compressGunzip);
+    compressClass->statics["crc32"] = new ObjNative("crc32", 1, compressCrc32);
+    compressClass->statics["stream"] = new ObjNative("stream", -1, compressStream);
+    vm->globals["Compress"] = compressClass;
+
+    auto streamClass = new ObjClass("CompressStream");
+    streamClass->methods["write"] = new ObjNative("write", 1, streamWrite);
+    streamClass->methods["flush"] = new ObjNative("flush", 0, streamFlush);
+    streamClass->methods["finish"] = new ObjNative("finish", 0, streamFinish);
+    vm->globals["CompressStream"] = streamClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.type = "class";
+    sym.isConst = true;
+    sym.name = "Compress";
+    scope->define(sym);
+    sym.name = "CompressStream";
+    scope->define(sym);
+}
+
+} // namespace CompressModule
+} // namespace StdLib
@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_COMPRESS_H
+#define TRYPILLIA_COMPRESS_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace CompressModule {
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace CompressModule
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,882 @@
+#include "Deflate.h"
+#include <algorithm>
+#include <cstring>
+
+namespace StdLib {
+namespace Deflate {
+
+namespace {
+
+constexpr size_t kWindowSize = 32768;
+constexpr size_t kBlockSize = 65536;
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+constexpr int kHashBits = 15;
+constexpr int kMaxCodeBits = 15;
+constexpr int kMaxCodeLengthBits = 7;
+constexpr int kFastBits = 9;
+
+const uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t kDistBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order in which code length code lengths are sent
+const uint8_t kCodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct Level {
+    int chain;
+    size_t nice;
+    bool lazy;
+};
+
+// Hash chain depth, good-enough length and lazy matching per level,
+// roughly following zlib's table
+const Level kLevels[10] = {{0, 0, false},      {4, 8, false},      {4, 16, false},    {4, 32, false},
+                           {16, 16, true},     {32, 32, true},     {128, 128, true},  {256, 128, true},
+                           {1024, 258, true},  {4096, 258, true}};
+
+// Symbol lookups for match lengths 0..258 and distances 1..32768
+struct CodeTables {
+    uint8_t lengthCode[kMaxMatch + 1];
+    uint8_t distCode[kWindowSize + 1];
+    uint32_t crc[8][256];
+
+    CodeTables() {
+        for (int code = 0; code < 29; code++) {
+            int span = 1 << kLengthExtra[code];
+            for (int i = 0; i < span && kLengthBase[code] + i <= 258; i++)
+                lengthCode[kLengthBase[code] + i] = static_cast<uint8_t>(code);
+        }
+        lengthCode[258] = 28;
+        for (int code = 0; code < 30; code++) {
+            int span = 1 << kDistExtra[code];
+            for (int i = 0; i < span && kDistBase[code] + i <= 32768; i++)
+                distCode[kDistBase[code] + i] = static_cast<uint8_t>(code);
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            for (int t = 1; t < 8; t++)
+                crc[t][n] = (crc[t - 1][n] >> 8) ^ crc[0][crc[t - 1][n] & 0xff];
+        }
+    }
+};
+
+const CodeTables &tables() {
+    static const CodeTables instance;
+    return instance;
+}
+
+uint32_t reverseBits(uint32_t code, int length) {
+    uint32_t result = 0;
+    for (int i = 0; i < length; i++) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+// Huffman code lengths for `freq`, at most `maxBits` long. Over-long
+// trees are rebuilt from halved frequencies until they fit, which keeps
+// every code complete. A lone symbol gets a partner so the code is never
+// a single one-bit entry.
+void buildLengths(const uint32_t *freq, int n, int maxBits, uint8_t *lengths) {
+    std::vector<uint32_t> weights(freq, freq + n);
+    std::fill(lengths, lengths + n, 0);
+
+    for (;;) {
+        std::vector<int> used;
+        for (int i = 0; i < n; i++) {
+            if (weights[i])
+                used.push_back(i);
+        }
+        if (used.empty())
+            return;
+        if (used.size() == 1) {
+            lengths[used[0]] = 1;
+            lengths[used[0] == 0 ? 1 : 0] = 1;
+            return;
+        }
+        std::stable_sort(used.begin(), used.end(), [&](int a, int b) { return weights[a] < weights[b]; });
+
+        // Two-queue construction: leaves sorted by weight, internal nodes
+        // are created in non-decreasing weight order
+        size_t leaves = used.size();
+        std::vector<uint64_t> weight(2 * leaves - 1);
+        std::vector<int> parent(2 * leaves - 1, -1);
+        for (size_t i = 0; i < leaves; i++)
+            weight[i] = weights[used[i]];
+        size_t nextLeaf = 0, nextNode = leaves, created = leaves;
+        auto takeSmallest = [&]() {
+            if (nextLeaf < leaves && (nextNode >= created || weight[nextLeaf] <= weight[nextNode]))
+                return nextLeaf++;
+            return nextNode++;
+        };
+        while (created < 2 * leaves - 1) {
+            size_t a = takeSmallest();
+            size_t b = takeSmallest();
+            weight[created] = weight[a] + weight[b];
+            parent[a] = parent[b] = static_cast<int>(created);
+            created++;
+        }
+        std::vector<int> depth(2 * leaves - 1, 0);
+        int maxDepth = 0;
+        for (size_t i = 2 * leaves - 1; i-- > 0;) {
+            if (parent[i] >= 0)
+                depth[i] = depth[parent[i]] + 1;
+            if (i < leaves)
+                maxDepth = std::max(maxDepth, depth[i]);
+        }
+        if (maxDepth <= maxBits) {
+            for (size_t i = 0; i < leaves; i++)
+                lengths[used[i]] = static_cast<uint8_t>(depth[i]);
+            return;
+        }
+        for (int symbol : used)
+            weights[symbol] = (weights[symbol] + 1) / 2;
+    }
+}
+
+// Canonical codes (RFC 1951 3.2.2), bit-reversed for LSB-first output.
+void buildCodes(const uint8_t *lengths, int n, uint16_t *codes) {
+    uint16_t count[kMaxCodeBits + 1] = {0};
+    for (int i = 0; i < n; i++)
+        count[lengths[i]]++;
+    count[0] = 0;
+    uint16_t next[kMaxCodeBits + 1] = {0};
+    uint16_t code = 0;
+    for (int bits = 1; bits <= kMaxCodeBits; bits++) {
+        code = static_cast<uint16_t>((code + count[bits - 1]) << 1);
+        next[bits] = code;
+    }
+    for (int i = 0; i < n; i++) {
+        if (lengths[i])
+            codes[i] = static_cast<uint16_t>(reverseBits(next[lengths[i]]++, lengths[i]));
+    }
+}
+
+void fixedLengths(uint8_t *litLengths, uint8_t *distLengths) {
+    for (int i = 0; i < 288; i++)
+        litLengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    for (int i = 0; i < 30; i++)
+        distLengths[i] = 5;
+}
+
+inline uint32_t hash3(const unsigned char *p) {
+    uint32_t v = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+} // namespace
+
+uint32_t crc32(uint32_t crc, std::string_view data) {
+    const CodeTables &t = tables();
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data());
+    size_t n = data.size();
+    crc = ~crc;
+    // Slicing-by-8: one table lookup per input byte, eight in parallel
+    while (n >= 8) {
+        uint32_t lo = crc ^ (uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24));
+        crc = t.crc[7][lo & 0xff] ^ t.crc[6][(lo >> 8) & 0xff] ^ t.crc[5][(lo >> 16) & 0xff] ^ t.crc[4][lo >> 24] ^
+              t.crc[3][p[4]] ^ t.crc[2][p[5]] ^ t.crc[1][p[6]] ^ t.crc[0][p[7]];
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+        crc = t.crc[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// ---- Compression ----
+
+Deflater::Deflater(int level) : level(std::clamp(level, 0, 9)) {
+}
+
+void Deflater::putBits(uint32_t bits, int count, std::string &out) {
+    bitBuffer |= uint64_t(bits) << bitCount;
+    bitCount += count;
+    while (bitCount >= 8) {
+        out += static_cast<char>(bitBuffer & 0xff);
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void Deflater::alignToByte(std::string &out) {
+    if (bitCount > 0)
+        putBits(0, 8 - bitCount, out);
+}
+
+void Deflater::write(std::string_view data, std::string &out) {
+    while (!data.empty()) {
+        size_t take = std::min(kBlockSize - (window.size() - pendingStart), data.size());
+        window.append(data.substr(0, take));
+        data.remove_prefix(take);
+        if (window.size() - pendingStart == kBlockSize)
+            compressPending(false, out);
+    }
+}
+
+void Deflater::flush(std::string &out) {
+    compressPending(false, out);
+    putBits(0, 3, out);
+    alignToByte(out);
+    putBits(0x0000, 16, out);
+    putBits(0xFFFF, 16, out);
+}
+
+void Deflater::finish(std::string &out) {
+    compressPending(true, out);
+    alignToByte(out);
+}
+
+void Deflater::compressPending(bool last, std::string &out) {
+    if (window.size() == pendingStart && !last)
+        return;
+    tokens.clear();
+    if (level > 0) {
+        head.assign(size_t{1} << kHashBits, -1);
+        prev.assign(window.size(), -1);
+        const unsigned char *base = reinterpret_cast<const unsigned char *>(window.data());
+        // Earlier input stays reachable for matches
+        for (size_t p = 0; p + 2 < pendingStart; p++) {
+            uint32_t h = hash3(base + p);
+            prev[p] = head[h];
+            head[h] = static_cast<int32_t>(p);
+        }
+        findMatches(pendingStart, window.size());
+    }
+    emitBlock(std::string_view(window).substr(pendingStart), last, out);
+
+    if (window.size() > kWindowSize)
+        window.erase(0, window.size() - kWindowSize);
+    pendingStart = window.size();
+}
+
+void Deflater::findMatches(size_t from, size_t to) {
+    const unsigned char *base = reinterpret_cast<const unsigned char *>(window.data());
+    const Level params = kLevels[level];
+
+    auto insert = [&](size_t p) {
+        if (p + 2 < to) {
+            uint32_t h = hash3(base + p);
+            prev[p] = head[h];
+            head[h] = static_cast<int32_t>(p);
+        }
+    };
+    // Longest earlier match for position p, walking the hash chain
+    auto longest = [&](size_t p, size_t &bestDist) {
+        size_t limit = std::min(kMaxMatch, to - p);
+        size_t bestLen = 0;
+        if (limit < kMinMatch)
+            return bestLen;
+        int32_t candidate = head[hash3(base + p)];
+        int chain = params.chain;
+        while (candidate >= 0 && chain-- > 0) {
+            size_t c = static_cast<size_t>(candidate);
+            if (p - c > kWindowSize)
+                break;
+            if (base[c + bestLen] == base[p + bestLen] && base[c] == base[p]) {
+                size_t len = 0;
+                while (len < limit && base[c + len] == base[p + len])
+                    len++;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = p - c;
+                    if (len >= params.nice || len == limit)
+                        break;
+                }
+            }
+            candidate = prev[c];
+        }
+        return bestLen >= kMinMatch ? bestLen : 0;
+    };
+
+    size_t i = from;
+    while (i < to) {
+        size_t dist = 0;
+        size_t len = longest(i, dist);
+        insert(i);
+        if (len && params.lazy && len < params.nice && i + 1 < to) {
+            size_t nextDist = 0;
+            if (longest(i + 1, nextDist) > len) {
+                tokens.push_back({base[i], 0});
+                i++;
+                continue;
+            }
+        }
+        if (!len) {
+            tokens.push_back({base[i], 0});
+            i++;
+            continue;
+        }
+        tokens.push_back({static_cast<uint16_t>(len), static_cast<uint16_t>(dist)});
+        for (size_t k = 1; k < len; k++)
+            insert(i + k);
+        i += len;
+    }
+}
+
+void Deflater::emitBlock(std::string_view raw, bool last, std::string &out) {
+    const CodeTables &t = tables();
+    if (level == 0) {
+        tokens.clear();
+        for (unsigned char c : raw)
+            tokens.push_back({c, 0});
+    }
+
+    uint32_t litFreq[286] = {0};
+    uint32_t distFreq[30] = {0};
+    uint64_t extraBits = 0;
+    litFreq[256] = 1;
+    for (const Token &token : tokens) {
+        if (!token.dist) {
+            litFreq[token.litlen]++;
+            continue;
+        }
+        int lc = t.lengthCode[token.litlen];
+        int dc = t.distCode[token.dist];
+        litFreq[257 + lc]++;
+        distFreq[dc]++;
+        extraBits += kLengthExtra[lc] + kDistExtra[dc];
+    }
+
+    // Dynamic code description
+    uint8_t litLengths[288] = {0};
+    uint8_t distLengths[30] = {0};
+    buildLengths(litFreq, 286, kMaxCodeBits, litLengths);
+    buildLengths(distFreq, 30, kMaxCodeBits, distLengths);
+    if (std::all_of(distLengths, distLengths + 30, [](uint8_t l) { return l == 0; }))
+        distLengths[0] = distLengths[1] = 1;
+    int hlit = 286;
+    while (hlit > 257 && !litLengths[hlit - 1])
+        hlit--;
+    int hdist = 30;
+    while (hdist > 1 && !distLengths[hdist - 1])
+        hdist--;
+
+    // Run-length code the concatenated lengths with symbols 16, 17, 18
+    std::vector<uint8_t> all(litLengths, litLengths + hlit);
+    all.insert(all.end(), distLengths, distLengths + hdist);
+    struct Run {
+        uint8_t symbol;
+        uint8_t extra;
+    };
+    std::vector<Run> runs;
+    uint32_t clFreq[19] = {0};
+    for (size_t i = 0; i < all.size();) {
+        uint8_t value = all[i];
+        size_t run = 1;
+        while (i + run < all.size() && all[i + run] == value)
+            run++;
+        size_t left = run;
+        if (value == 0) {
+            while (left >= 11) {
+                size_t n = std::min<size_t>(left, 138);
+                runs.push_back({18, static_cast<uint8_t>(n - 11)});
+                left -= n;
+            }
+            if (left >= 3) {
+                runs.push_back({17, static_cast<uint8_t>(left - 3)});
+                left = 0;
+            }
+        } else {
+            runs.push_back({value, 0});
+            left--;
+            while (left >= 3) {
+                size_t n = std::min<size_t>(left, 6);
+                runs.push_back({16, static_cast<uint8_t>(n - 3)});
+                left -= n;
+            }
+        }
+        while (left--)
+            runs.push_back({value, 0});
+        i += run;
+    }
+    for (const Run &r : runs)
+        clFreq[r.symbol]++;
+    uint8_t clLengths[19] = {0};
+    buildLengths(clFreq, 19, kMaxCodeLengthBits, clLengths);
+    int hclen = 19;
+    while (hclen > 4 && !clLengths[kCodeLengthOrder[hclen - 1]])
+        hclen--;
+
+    uint64_t dynamicBits = 3 + 14 + 3 * uint64_t(hclen) + extraBits;
+    for (const Run &r : runs)
+        dynamicBits += clLengths[r.symbol] + (r.symbol == 16 ? 2 : r.symbol == 17 ? 3 : r.symbol == 18 ? 7 : 0);
+    uint8_t fixedLit[288], fixedDist[30];
+    fixedLengths(fixedLit, fixedDist);
+    uint64_t fixedBits = 3 + extraBits;
+    for (int i = 0; i < 286; i++) {
+        dynamicBits += uint64_t(litFreq[i]) * litLengths[i];
+        fixedBits += uint64_t(litFreq[i]) * fixedLit[i];
+    }
+    for (int i = 0; i < 30; i++) {
+        dynamicBits += uint64_t(distFreq[i]) * distLengths[i];
+        fixedBits += uint64_t(distFreq[i]) * fixedDist[i];
+    }
+    size_t storedChunks = std::max<size_t>(1, (raw.size() + 65534) / 65535);
+    uint64_t storedBits = storedChunks * (3 + 7 + 32) + 8 * uint64_t(raw.size());
+
+    if (storedBits <= dynamicBits && storedBits <= fixedBits) {
+        size_t at = 0;
+        do {
+            size_t n = std::min<size_t>(raw.size() - at, 65535);
+            bool final = last && at + n == raw.size();
+            putBits(final ? 1 : 0, 1, out);
+            putBits(0, 2, out);
+            alignToByte(out);
+            putBits(static_cast<uint32_t>(n), 16, out);
+            putBits(static_cast<uint32_t>(~n & 0xffff), 16, out);
+            out.append(raw.substr(at, n));
+            at += n;
+        } while (at < raw.size());
+        return;
+    }
+
+    const uint8_t *useLit = litLengths;
+    const uint8_t *useDist = distLengths;
+    putBits(last ? 1 : 0, 1, out);
+    if (fixedBits <= dynamicBits) {
+        putBits(1, 2, out);
+        useLit = fixedLit;
+        useDist = fixedDist;
+    } else {
+        putBits(2, 2, out);
+        putBits(hlit - 257, 5, out);
+        putBits(hdist - 1, 5, out);
+        putBits(hclen - 4, 4, out);
+        for (int i = 0; i < hclen; i++)
+            putBits(clLengths[kCodeLengthOrder[i]], 3, out);
+        uint16_t clCodes[19] = {0};
+        buildCodes(clLengths, 19, clCodes);
+        for (const Run &r : runs) {
+            putBits(clCodes[r.symbol], clLengths[r.symbol], out);
+            if (r.symbol == 16)
+                putBits(r.extra, 2, out);
+            else if (r.symbol == 17)
+                putBits(r.extra, 3, out);
+            else if (r.symbol == 18)
+                putBits(r.extra, 7, out);
+        }
+    }
+
+    uint16_t litCodes[288] = {0};
+    uint16_t distCodes[30] = {0};
+    buildCodes(useLit, 288, litCodes);
+    buildCodes(useDist, 30, distCodes);
+    for (const Token &token : tokens) {
+        if (!token.dist) {
+            putBits(litCodes[token.litlen], useLit[token.litlen], out);
+            continue;
+        }
+        int lc = t.lengthCode[token.litlen];
+        int dc = t.distCode[token.dist];
+        putBits(litCodes[257 + lc], useLit[257 + lc], out);
+        putBits(token.litlen - kLengthBase[lc], kLengthExtra[lc], out);
+        putBits(distCodes[dc], useDist[dc], out);
+        putBits(token.dist - kDistBase[dc], kDistExtra[dc], out);
+    }
+    putBits(litCodes[256], useLit[256], out);
+}
+
+// ---- Decompression ----
+
+namespace {
+
+struct BitReader {
+    const unsigned char *data;
+    size_t size;
+    size_t pos = 0;
+    uint64_t bits = 0;
+    int count = 0;
+
+    // Tops up the bit buffer; false if the input ran out first.
+    bool need(int n) {
+        while (count < n) {
+            if (pos >= size)
+                return false;
+            bits |= uint64_t(data[pos++]) << count;
+            count += 8;
+        }
+        return true;
+    }
+
+    void fill() {
+        while (count <= 56 && pos < size) {
+            bits |= uint64_t(data[pos++]) << count;
+            count += 8;
+        }
+    }
+
+    uint32_t take(int n) {
+        uint32_t v = static_cast<uint32_t>(bits & ((uint64_t(1) << n) - 1));
+        bits >>= n;
+        count -= n;
+        return v;
+    }
+
+    // Bytes used so far, not counting whole bytes still buffered.
+    size_t consumed() const {
+        return pos - count / 8;
+    }
+
+    // Drops the rest of the current byte and hands whole buffered bytes
+    // back to the input, so stored data can be read straight from `data`.
+    void alignToByte() {
+        pos -= count / 8;
+        bits = 0;
+        count = 0;
+    }
+};
+
+// Canonical decoding table: a direct lookup for codes up to kFastBits
+// long, and per-length counts for the rest.
+struct Huffman {
+    uint16_t count[kMaxCodeBits + 1];
+    uint16_t symbol[288];
+    uint16_t fast[1 << kFastBits];
+
+    bool build(const uint8_t *lengths, int n) {
+        std::fill(std::begin(count), std::end(count), 0);
+        std::fill(std::begin(fast), std::end(fast), 0);
+        for (int i = 0; i < n; i++)
+            count[lengths[i]]++;
+        count[0] = 0;
+        int left = 1;
+        for (int len = 1; len <= kMaxCodeBits; len++) {
+            left = (left << 1) - count[len];
+            if (left < 0)
+                return false; // over-subscribed
+        }
+        uint16_t offset[kMaxCodeBits + 2] = {0};
+        for (int len = 1; len <= kMaxCodeBits; len++)
+            offset[len + 1] = offset[len] + count[len];
+        uint16_t next[kMaxCodeBits + 1] = {0};
+        uint16_t code = 0;
+        for (int len = 1; len <= kMaxCodeBits; len++) {
+            code = static_cast<uint16_t>((code + count[len - 1]) << 1);
+            if (len == 1)
+                code = 0;
+            next[len] = code;
+        }
+        for (int i = 0; i < n; i++) {
+            int len = lengths[i];
+            if (!len)
+                continue;
+            symbol[offset[len]++] = static_cast<uint16_t>(i);
+            if (len <= kFastBits) {
+                uint32_t reversed = reverseBits(next[len], len);
+                for (uint32_t r = reversed; r < (1u << kFastBits); r += 1u << len)
+                    fast[r] = static_cast<uint16_t>((len << 12) | i);
+            }
+            next[len]++;
+        }
+        return true;
+    }
+
+    // Symbol or -1 when the input is exhausted or the code is invalid.
+    int decode(BitReader &in) const {
+        in.fill();
+        uint16_t entry = fast[in.bits & ((1u << kFastBits) - 1)];
+        int len = entry >> 12;
+        if (len && len <= in.count) {
+            in.take(len);
+            return entry & 0xfff;
+        }
+        int code = 0, first = 0, index = 0;
+        for (len = 1; len <= kMaxCodeBits; len++) {
+            if (!in.need(1))
+                return -1;
+            code |= static_cast<int>(in.take(1));
+            int c = count[len];
+            if (code - first < c)
+                return symbol[index + (code - first)];
+            index += c;
+            first = (first + c) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+const Huffman &fixedLitTable() {
+    static const Huffman table = [] {
+        Huffman h;
+        uint8_t lit[288], dist[30];
+        fixedLengths(lit, dist);
+        h.build(lit, 288);
+        return h;
+    }();
+    return table;
+}
+
+const Huffman &fixedDistTable() {
+    static const Huffman table = [] {
+        Huffman h;
+        uint8_t lit[288], dist[30];
+        fixedLengths(lit, dist);
+        h.build(dist, 30);
+        return h;
+    }();
+    return table;
+}
+
+} // namespace
+
+Inflater::Status Inflater::inflate(std::string_view in, std::string &out, size_t &consumed, size_t maxOutput) {
+    BitReader reader{reinterpret_cast<const unsigned char *>(in.data()), in.size()};
+    consumed = 0;
+
+    // Back-references may reach into earlier calls' output, so decode
+    // after a copy of it unless there is none
+    std::string scratch;
+    bool direct = history.empty();
+    std::string &dst = direct ? out : scratch;
+    if (!direct)
+        scratch = history;
+    const size_t base = dst.size();
+    const size_t reach = direct ? 0 : history.size();
+
+    auto finishCall = [&](Status status) {
+        if (!direct)
+            out.append(scratch, base, std::string::npos);
+        size_t produced = dst.size() - base + reach;
+        size_t keep = std::min(produced, kWindowSize);
+        history.assign(dst, dst.size() - keep, keep);
+        return status;
+    };
+
+    Huffman lit, dist;
+    for (;;) {
+        consumed = reader.consumed();
+        if (!reader.need(3))
+            return finishCall(reader.count == 0 || reader.bits == 0 ? Status::NEED_MORE : Status::INVALID);
+        bool final = reader.take(1);
+        uint32_t type = reader.take(2);
+
+        if (type == 0) {
+            reader.alignToByte();
+            if (reader.size - reader.pos < 4)
+                return finishCall(Status::INVALID);
+            const unsigned char *header = reader.data + reader.pos;
+            uint32_t len = header[0] | (header[1] << 8);
+            uint32_t nlen = header[2] | (header[3] << 8);
+            reader.pos += 4;
+            if ((len ^ 0xffff) != nlen || reader.size - reader.pos < len)
+                return finishCall(Status::INVALID);
+            if (dst.size() - base + len > maxOutput)
+                return finishCall(Status::TOO_LARGE);
+            dst.append(reinterpret_cast<const char *>(reader.data + reader.pos), len);
+            reader.pos += len;
+        } else if (type == 1 || type == 2) {
+            const Huffman *litTable = &fixedLitTable();
+            const Huffman *distTable = &fixedDistTable();
+            if (type == 2) {
+                if (!reader.need(14))
+                    return finishCall(Status::INVALID);
+                int hlit = static_cast<int>(reader.take(5)) + 257;
+                int hdist = static_cast<int>(reader.take(5)) + 1;
+                int hclen = static_cast<int>(reader.take(4)) + 4;
+                if (hlit > 286 || hdist > 30)
+                    return finishCall(Status::INVALID);
+                uint8_t clLengths[19] = {0};
+                for (int i = 0; i < hclen; i++) {
+                    if (!reader.need(3))
+                        return finishCall(Status::INVALID);
+                    clLengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(reader.take(3));
+                }
+                Huffman cl;
+                if (!cl.build(clLengths, 19))
+                    return finishCall(Status::INVALID);
+                uint8_t lengths[286 + 30] = {0};
+                int filled = 0;
+                while (filled < hlit + hdist) {
+                    int sym = cl.decode(reader);
+                    if (sym < 0)
+                        return finishCall(Status::INVALID);
+                    if (sym < 16) {
+                        lengths[filled++] = static_cast<uint8_t>(sym);
+                        continue;
+                    }
+                    int repeat;
+                    uint8_t value = 0;
+                    if (sym == 16) {
+                        if (filled == 0 || !reader.need(2))
+                            return finishCall(Status::INVALID);
+                        value = lengths[filled - 1];
+                        repeat = 3 + static_cast<int>(reader.take(2));
+                    } else if (sym == 17) {
+                        if (!reader.need(3))
+                            return finishCall(Status::INVALID);
+                        repeat = 3 + static_cast<int>(reader.take(3));
+                    } else {
+                        if (!reader.need(7))
+                            return finishCall(Status::INVALID);
+                        repeat = 11 + static_cast<int>(reader.take(7));
+                    }
+                    if (filled + repeat > hlit + hdist)
+                        return finishCall(Status::INVALID);
+                    while (repeat--)
+                        lengths[filled++] = value;
+                }
+                if (!lengths[256] || !lit.build(lengths, hlit) || !dist.build(lengths + hlit, hdist))
+                    return finishCall(Status::INVALID);
+                litTable = &lit;
+                distTable = &dist;
+            }
+
+            for (;;) {
+                int sym = litTable->decode(reader);
+                if (sym < 0)
+                    return finishCall(Status::INVALID);
+                if (sym < 256) {
+                    if (dst.size() - base >= maxOutput)
+                        return finishCall(Status::TOO_LARGE);
+                    dst += static_cast<char>(sym);
+                    continue;
+                }
+                if (sym == 256)
+                    break;
+                sym -= 257;
+                if (sym >= 29 || !reader.need(kLengthExtra[sym]))
+                    return finishCall(Status::INVALID);
+                size_t length = kLengthBase[sym] + reader.take(kLengthExtra[sym]);
+                int dsym = distTable->decode(reader);
+                if (dsym < 0 || dsym >= 30 || !reader.need(kDistExtra[dsym]))
+                    return finishCall(Status::INVALID);
+                size_t distance = kDistBase[dsym] + reader.take(kDistExtra[dsym]);
+                if (distance > dst.size() - base + reach)
+                    return finishCall(Status::INVALID);
+                if (dst.size() - base + length > maxOutput)
+                    return finishCall(Status::TOO_LARGE);
+
+                size_t at = dst.size();
+                dst.resize(at + length);
+                char *to = dst.data() + at;
+                const char *from = to - distance;
+                if (distance >= length) {
+                    std::memcpy(to, from, length);
+                } else {
+                    for (size_t i = 0; i < length; i++)
+                        to[i] = from[i];
+                }
+            }
+        } else {
+            return finishCall(Status::INVALID);
+        }
+
+        if (final) {
+            consumed = reader.consumed();
+            return finishCall(Status::DONE);
+        }
+    }
+}
+
+// ---- Convenience wrappers ----
+
+std::string deflate(std::string_view src, int level) {
+    std::string out;
+    out.reserve(src.size() / 2 + 64);
+    Deflater deflater(level);
+    deflater.write(src, out);
+    deflater.finish(out);
+    return out;
+}
+
+bool inflate(std::string_view src, std::string &out, size_t maxOutput) {
+    Inflater inflater;
+    size_t consumed = 0;
+    return inflater.inflate(src, out, consumed, maxOutput) == Inflater::Status::DONE;
+}
+
+void gzipHeader(std::string &out, int level) {
+    // No name or timestamp; XFL marks the fastest/strongest levels; OS unknown
+    const char header[10] = {char(0x1f), char(0x8b), 8, 0, 0, 0, 0, 0, char(level >= 9 ? 2 : level <= 1 ? 4 : 0),
+                             char(0xff)};
+    out.append(header, sizeof(header));
+}
+
+void gzipTrailer(std::string &out, uint32_t crc, uint64_t size) {
+    uint32_t isize = static_cast<uint32_t>(size);
+    for (int i = 0; i < 4; i++)
+        out += static_cast<char>((crc >> (i * 8)) & 0xff);
+    for (int i = 0; i < 4; i++)
+        out += static_cast<char>((isize >> (i * 8)) & 0xff);
+}
+
+std::string gzip(std::string_view src, int level) {
+    std::string out;
+    out.reserve(src.size() / 2 + 64);
+    gzipHeader(out, level);
+    Deflater deflater(level);
+    deflater.write(src, out);
+    deflater.finish(out);
+    gzipTrailer(out, crc32(0, src), src.size());
+    return out;
+}
+
+bool gunzip(std::string_view src, std::string &out, size_t maxOutput) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(src.data());
+    size_t n = src.size();
+    size_t pos = 0;
+    const size_t outStart = out.size();
+
+    do {
+        if (n - pos < 18 || p[pos] != 0x1f || p[pos + 1] != 0x8b || p[pos + 2] != 8)
+            return false;
+        unsigned flags = p[pos + 3];
+        if (flags & 0xe0)
+            return false;
+        pos += 10;
+        if (flags & 0x04) { // FEXTRA
+            if (n - pos < 2)
+                return false;
+            size_t extra = p[pos] | (size_t(p[pos + 1]) << 8);
+            pos += 2;
+            if (extra > n - pos)
+                return false;
+            pos += extra;
+        }
+        for (unsigned flag : {0x08u, 0x10u}) { // FNAME, FCOMMENT
+            if (!(flags & flag))
+                continue;
+            const void *nul = std::memchr(p + pos, 0, n - pos);
+            if (!nul)
+                return false;
+            pos = static_cast<const unsigned char *>(nul) - p + 1;
+        }
+        if (flags & 0x02) // FHCRC
+            pos += 2;
+        if (pos > n)
+            return false;
+
+        size_t memberStart = out.size();
+        Inflater inflater;
+        size_t consumed = 0;
+        if (inflater.inflate(src.substr(pos), out, consumed, maxOutput - (out.size() - outStart)) !=
+            Inflater::Status::DONE)
+            return false;
+        pos += consumed;
+        if (n - pos < 8)
+            return false;
+        std::string_view member = std::string_view(out).substr(memberStart);
+        uint32_t crc = uint32_t(p[pos]) | (uint32_t(p[pos + 1]) << 8) | (uint32_t(p[pos + 2]) << 16) |
+                       (uint32_t(p[pos + 3]) << 24);
+        uint32_t isize = uint32_t(p[pos + 4]) | (uint32_t(p[pos + 5]) << 8) | (uint32_t(p[pos + 6]) << 16) |
+                         (uint32_t(p[pos + 7]) << 24);
+        if (crc != crc32(0, member) || isize != static_cast<uint32_t>(member.size()))
+            return false;
+        pos += 8;
+    } while (pos < n);
+    return true;
+}
+
+} // namespace Deflate
+} // namespace StdLib
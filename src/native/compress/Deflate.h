@@ -0,0 +1,84 @@
+#ifndef TRYPILLIA_DEFLATE_H
+#define TRYPILLIA_DEFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Raw DEFLATE (RFC 1951) and the gzip wrapper (RFC 1952), written from
+// the specifications so the build needs no zlib.
+namespace StdLib {
+namespace Deflate {
+
+uint32_t crc32(uint32_t crc, std::string_view data);
+
+// Streaming compressor. Input is buffered and compressed in blocks of up
+// to 64 KiB; matches may reach 32 KiB back across block boundaries, so
+// one Deflater per stream keeps its context.
+class Deflater {
+  public:
+    // 1 (fastest) to 9 (smallest); 0 stores without compressing.
+    explicit Deflater(int level = 6);
+
+    void write(std::string_view data, std::string &out);
+    // Compresses buffered input and byte-aligns the output with an empty
+    // stored block (00 00 FF FF), as sync flushes and permessage-deflate do.
+    void flush(std::string &out);
+    // Compresses buffered input as the final block.
+    void finish(std::string &out);
+
+  private:
+    struct Token {
+        uint16_t litlen;
+        uint16_t dist;
+    };
+
+    void compressPending(bool last, std::string &out);
+    void findMatches(size_t from, size_t to);
+    void emitBlock(std::string_view raw, bool last, std::string &out);
+    void putBits(uint32_t bits, int count, std::string &out);
+    void alignToByte(std::string &out);
+
+    int level;
+    // Last 32 KiB of already compressed input followed by pending input
+    std::string window;
+    size_t pendingStart = 0;
+    std::vector<int32_t> head;
+    std::vector<int32_t> prev;
+    std::vector<Token> tokens;
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+};
+
+// Decompressor for complete blocks. It keeps the last 32 KiB of output
+// so a later call can continue a stream whose chunks end on block
+// boundaries (as permessage-deflate messages do).
+class Inflater {
+  public:
+    enum class Status { DONE, NEED_MORE, INVALID, TOO_LARGE };
+
+    // Decodes from `in`, appending to `out`, until the final block ends
+    // (DONE) or the input runs out at a block boundary (NEED_MORE).
+    // `consumed` receives the bytes used up to the end of the last block.
+    Status inflate(std::string_view in, std::string &out, size_t &consumed, size_t maxOutput = SIZE_MAX);
+
+  private:
+    std::string history;
+};
+
+std::string deflate(std::string_view src, int level = 6);
+bool inflate(std::string_view src, std::string &out, size_t maxOutput = SIZE_MAX);
+std::string gzip(std::string_view src, int level = 6);
+// Accepts concatenated members and checks each CRC and length.
+bool gunzip(std::string_view src, std::string &out, size_t maxOutput = SIZE_MAX);
+
+// Gzip header and trailer, for streaming writers.
+void gzipHeader(std::string &out, int level);
+void gzipTrailer(std::string &out, uint32_t crc, uint64_t size);
+
+} // namespace Deflate
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,408 @@
+#include "Lz4.h"
+#include <cstring>
+#include <vector>
+
+namespace StdLib {
+namespace Lz4 {
+
+namespace {
+
+constexpr uint32_t kPrime1 = 2654435761U;
+constexpr uint32_t kPrime2 = 2246822519U;
+constexpr uint32_t kPrime3 = 3266489917U;
+constexpr uint32_t kPrime4 = 668265263U;
+constexpr uint32_t kPrime5 = 374761393U;
+
+constexpr uint32_t kFrameMagic = 0x184D2204;
+constexpr uint32_t kSkippableMask = 0xFFFFFFF0;
+constexpr uint32_t kSkippableMagic = 0x184D2A50;
+constexpr size_t kBlockSize = 64 * 1024;
+constexpr uint32_t kUncompressedFlag = 0x80000000u;
+
+// Sequences need 4 matching bytes; the last 5 bytes of a block are always
+// literals and no match may start in the last 12.
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMfLimit = 12;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashLog = 14;
+
+inline uint32_t rotl(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+inline uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t readLE32(const unsigned char *p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void putLE32(std::string &out, uint32_t v) {
+    char b[4] = {char(v & 0xff), char((v >> 8) & 0xff), char((v >> 16) & 0xff), char(v >> 24)};
+    out.append(b, 4);
+}
+
+inline uint32_t round32(uint32_t acc, uint32_t input) {
+    acc += input * kPrime2;
+    return rotl(acc, 13) * kPrime1;
+}
+
+inline uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * kPrime1) >> (32 - kHashLog);
+}
+
+// Literal and match lengths past 15 continue in 255-valued bytes.
+void putLength(std::string &out, size_t length) {
+    while (length >= 255) {
+        out += char(255);
+        length -= 255;
+    }
+    out += char(length);
+}
+
+void putSequence(std::string &out, const unsigned char *literals, size_t literalLength, size_t offset,
+                 size_t matchLength) {
+    size_t matchCode = matchLength - kMinMatch;
+    unsigned token = (literalLength >= 15 ? 15u : unsigned(literalLength)) << 4;
+    if (offset)
+        token |= matchCode >= 15 ? 15u : unsigned(matchCode);
+    out += char(token);
+    if (literalLength >= 15)
+        putLength(out, literalLength - 15);
+    out.append(reinterpret_cast<const char *>(literals), literalLength);
+    if (!offset)
+        return;
+    out += char(offset & 0xff);
+    out += char(offset >> 8);
+    if (matchCode >= 15)
+        putLength(out, matchCode - 15);
+}
+
+} // namespace
+
+Xxh32::Xxh32(uint32_t seed) : seed(seed) {
+    v[0] = seed + kPrime1 + kPrime2;
+    v[1] = seed + kPrime2;
+    v[2] = seed;
+    v[3] = seed - kPrime1;
+}
+
+void Xxh32::update(std::string_view data) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data());
+    size_t n = data.size();
+    total += n;
+
+    if (buffered + n < 16) {
+        std::memcpy(buffer + buffered, p, n);
+        buffered += n;
+        return;
+    }
+    if (buffered) {
+        size_t fill = 16 - buffered;
+        std::memcpy(buffer + buffered, p, fill);
+        for (int i = 0; i < 4; i++)
+            v[i] = round32(v[i], readLE32(buffer + i * 4));
+        p += fill;
+        n -= fill;
+        buffered = 0;
+    }
+    while (n >= 16) {
+        for (int i = 0; i < 4; i++)
+            v[i] = round32(v[i], readLE32(p + i * 4));
+        p += 16;
+        n -= 16;
+    }
+    std::memcpy(buffer, p, n);
+    buffered = n;
+}
+
+uint32_t Xxh32::digest() const {
+    uint32_t h;
+    if (total >= 16)
+        h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+    else
+        h = seed + kPrime5;
+    h += static_cast<uint32_t>(total);
+
+    size_t i = 0;
+    for (; i + 4 <= buffered; i += 4) {
+        h += readLE32(buffer + i) * kPrime3;
+        h = rotl(h, 17) * kPrime4;
+    }
+    for (; i < buffered; i++) {
+        h += buffer[i] * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+    h ^= h >> 15;
+    h *= kPrime2;
+    h ^= h >> 13;
+    h *= kPrime3;
+    h ^= h >> 16;
+    return h;
+}
+
+// Greedy single-probe matcher in the style of LZ4's fast mode: a hash of
+// the next 4 bytes finds one candidate, and the scan skips faster the
+// longer it goes without a match.
+void compressBlock(std::string_view src, std::string &out) {
+    const unsigned char *base = reinterpret_cast<const unsigned char *>(src.data());
+    const size_t n = src.size();
+    size_t anchor = 0;
+
+    if (n >= kMfLimit + 1) {
+        // Positions are stored +1 so zero means empty
+        std::vector<uint32_t> table(size_t{1} << kHashLog, 0);
+        const size_t matchLimit = n - kLastLiterals;
+        const size_t lastStart = n - kMfLimit;
+        size_t ip = 0;
+
+        while (ip <= lastStart) {
+            uint32_t sequence = read32(base + ip);
+            uint32_t h = hashSequence(sequence);
+            size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(ip + 1);
+            if (!candidate || ip - (candidate - 1) > kMaxOffset || read32(base + candidate - 1) != sequence) {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            size_t ref = candidate - 1;
+            while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t end = ip + kMinMatch;
+            while (end < matchLimit && base[end] == base[ref + (end - ip)])
+                end++;
+
+            putSequence(out, base + anchor, ip - anchor, ip - ref, end - ip);
+            ip = end;
+            anchor = ip;
+            if (ip - 2 <= lastStart)
+                table[hashSequence(read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2 + 1);
+        }
+    }
+    putSequence(out, base + anchor, n - anchor, 0, kMinMatch);
+}
+
+bool decompressBlock(std::string_view src, std::string &out, size_t maxOutput) {
+    const unsigned char *ip = reinterpret_cast<const unsigned char *>(src.data());
+    const unsigned char *const end = ip + src.size();
+    const size_t start = out.size();
+
+    auto readLength = [&](size_t &length) {
+        unsigned char b;
+        do {
+            if (ip >= end)
+                return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < end) {
+        unsigned token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(literalLength))
+            return false;
+        if (literalLength > size_t(end - ip) || out.size() - start + literalLength > maxOutput)
+            return false;
+        out.append(reinterpret_cast<const char *>(ip), literalLength);
+        ip += literalLength;
+        if (ip == end)
+            return true; // the last sequence has no match
+
+        if (end - ip < 2)
+            return false;
+        size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength))
+            return false;
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > out.size() || out.size() - start + matchLength > maxOutput)
+            return false;
+
+        size_t at = out.size();
+        out.resize(at + matchLength);
+        char *dst = out.data() + at;
+        const char *from = dst - offset;
+        if (offset >= matchLength) {
+            std::memcpy(dst, from, matchLength);
+        } else {
+            // Overlapping copy repeats the last `offset` bytes
+            for (size_t i = 0; i < matchLength; i++)
+                dst[i] = from[i];
+        }
+    }
+    return false;
+}
+
+void FrameWriter::header(std::string &out) {
+    putLE32(out, kFrameMagic);
+    // Version 01, independent blocks, content checksum; 64 KiB blocks
+    const char descriptor[2] = {char(0x64), char(0x40)};
+    out.append(descriptor, 2);
+    Xxh32 h;
+    h.update(std::string_view(descriptor, 2));
+    out += char((h.digest() >> 8) & 0xff);
+    started = true;
+}
+
+void FrameWriter::emitBlock(std::string_view data, std::string &out) {
+    size_t sizeAt = out.size();
+    putLE32(out, 0);
+    compressBlock(data, out);
+    size_t compressed = out.size() - sizeAt - 4;
+    if (compressed >= data.size()) {
+        out.resize(sizeAt);
+        putLE32(out, static_cast<uint32_t>(data.size()) | kUncompressedFlag);
+        out.append(data);
+        return;
+    }
+    uint32_t size = static_cast<uint32_t>(compressed);
+    for (int i = 0; i < 4; i++)
+        out[sizeAt + i] = char((size >> (i * 8)) & 0xff);
+}
+
+void FrameWriter::write(std::string_view data, std::string &out) {
+    if (!started)
+        header(out);
+    hash.update(data);
+    // Full blocks straight from the caller's data skip the pending copy
+    if (!pending.empty()) {
+        size_t take = std::min(kBlockSize - pending.size(), data.size());
+        pending.append(data.substr(0, take));
+        data.remove_prefix(take);
+        if (pending.size() < kBlockSize)
+            return;
+        emitBlock(pending, out);
+        pending.clear();
+    }
+    while (data.size() >= kBlockSize) {
+        emitBlock(data.substr(0, kBlockSize), out);
+        data.remove_prefix(kBlockSize);
+    }
+    pending.assign(data);
+}
+
+void FrameWriter::flush(std::string &out) {
+    if (!started)
+        header(out);
+    if (!pending.empty()) {
+        emitBlock(pending, out);
+        pending.clear();
+    }
+}
+
+void FrameWriter::finish(std::string &out) {
+    flush(out);
+    putLE32(out, 0);
+    putLE32(out, hash.digest());
+}
+
+std::string compressFrame(std::string_view src) {
+    std::string out;
+    out.reserve(src.size() / 2 + 32);
+    FrameWriter writer;
+    writer.write(src, out);
+    writer.finish(out);
+    return out;
+}
+
+bool decompressFrame(std::string_view src, std::string &out, size_t maxOutput) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(src.data());
+    size_t n = src.size();
+    size_t pos = 0;
+    const size_t outStart = out.size();
+
+    if (n < 4)
+        return false;
+    while (pos < n) {
+        if (n - pos < 4)
+            return false;
+        uint32_t magic = readLE32(p + pos);
+        pos += 4;
+        if ((magic & kSkippableMask) == kSkippableMagic) {
+            if (n - pos < 4)
+                return false;
+            size_t skip = readLE32(p + pos);
+            pos += 4;
+            if (skip > n - pos)
+                return false;
+            pos += skip;
+            continue;
+        }
+        if (magic != kFrameMagic || n - pos < 3)
+            return false;
+
+        size_t descriptorAt = pos;
+        unsigned flags = p[pos];
+        unsigned bd = p[pos + 1];
+        pos += 2;
+        if ((flags >> 6) != 1 || (flags & 0x02) || (bd & 0x8f))
+            return false;
+        bool blockChecksum = flags & 0x10;
+        bool contentSize = flags & 0x08;
+        bool contentChecksum = flags & 0x04;
+        bool dictionary = flags & 0x01;
+        int sizeCode = (bd >> 4) & 7;
+        if (sizeCode < 4 || dictionary)
+            return false;
+        size_t maxBlock = size_t{1} << (8 + 2 * sizeCode);
+
+        size_t optional = (contentSize ? 8 : 0);
+        if (n - pos < optional + 1)
+            return false;
+        pos += optional;
+        Xxh32 descriptorHash;
+        descriptorHash.update(src.substr(descriptorAt, pos - descriptorAt));
+        if (p[pos++] != ((descriptorHash.digest() >> 8) & 0xff))
+            return false;
+
+        size_t frameStart = out.size();
+        for (;;) {
+            if (n - pos < 4)
+                return false;
+            uint32_t word = readLE32(p + pos);
+            pos += 4;
+            if (word == 0)
+                break;
+            size_t size = word & ~kUncompressedFlag;
+            if (size > maxBlock || size > n - pos)
+                return false;
+            std::string_view block = src.substr(pos, size);
+            size_t budget = maxOutput - (out.size() - outStart);
+            if (word & kUncompressedFlag) {
+                if (size > budget)
+                    return false;
+                out.append(block);
+            } else if (!decompressBlock(block, out, std::min(budget, maxBlock))) {
+                return false;
+            }
+            pos += size;
+            if (blockChecksum) {
+                if (n - pos < 4)
+                    return false;
+                pos += 4;
+            }
+        }
+        if (contentChecksum) {
+            if (n - pos < 4)
+                return false;
+            Xxh32 content;
+            content.update(std::string_view(out).substr(frameStart));
+            if (readLE32(p + pos) != content.digest())
+                return false;
+            pos += 4;
+        }
+    }
+    return true;
+}
+
+} // namespace Lz4
+} // namespace StdLib
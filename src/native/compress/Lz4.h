@@ -0,0 +1,62 @@
+#ifndef TRYPILLIA_LZ4_H
+#define TRYPILLIA_LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// LZ4 block and frame format, written from the format specification.
+// Frames use independent 64 KiB blocks and a content checksum, so any
+// conforming LZ4 tool reads them.
+namespace StdLib {
+namespace Lz4 {
+
+// Streaming XXH32, the checksum LZ4 frames use.
+class Xxh32 {
+  public:
+    explicit Xxh32(uint32_t seed = 0);
+    void update(std::string_view data);
+    uint32_t digest() const;
+
+  private:
+    uint32_t v[4];
+    uint32_t seed;
+    uint64_t total = 0;
+    unsigned char buffer[16];
+    size_t buffered = 0;
+};
+
+// Appends the block encoding of `src` to `out`.
+void compressBlock(std::string_view src, std::string &out);
+// Appends the decoded block to `out`. Matches may reach back into bytes
+// already in `out` (for linked frame blocks). Fails on malformed input or
+// when more than `maxOutput` bytes would be produced.
+bool decompressBlock(std::string_view src, std::string &out, size_t maxOutput);
+
+// Incremental frame writer; the header goes out with the first bytes.
+class FrameWriter {
+  public:
+    void write(std::string_view data, std::string &out);
+    // Emits buffered input as a (possibly short) block.
+    void flush(std::string &out);
+    // Emits the rest, the end mark and the content checksum.
+    void finish(std::string &out);
+
+  private:
+    void header(std::string &out);
+    void emitBlock(std::string_view data, std::string &out);
+
+    std::string pending;
+    Xxh32 hash;
+    bool started = false;
+};
+
+std::string compressFrame(std::string_view src);
+// Decodes one or more concatenated frames (skippable frames are skipped).
+bool decompressFrame(std::string_view src, std::string &out, size_t maxOutput = SIZE_MAX);
+
+} // namespace Lz4
+} // namespace StdLib
+
+#endif
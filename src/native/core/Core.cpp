@@ -47,6 +47,16 @@ static std::string stringify(const VMValue &val, bool inContainer = false) {
         }
         s += "}";
         return s;
+    } else if (val.isSet()) {
+        std::string s = "Set {";
+        auto set = val.asSet();
+        for (size_t i = 0; i < set->entries.size(); ++i) {
+            s += stringify(set->entries[i], true);
+            if (i < set->entries.size() - 1)
+                s += ", ";
+        }
+        s += "}";
+        return s;
     } else if (val.isClass()) {
         return "<class " + val.asClass()->name + ">";
     } else if (val.isInstance()) {
@@ -0,0 +1,603 @@
+#include "Csv.h"
+#include "../../vm/runtime/GC.h"
+#include "../StdLib.h"
+#include "../string/StringKernels.h"
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace StdLib {
+namespace CsvModule {
+
+namespace Kernels = StdLib::StringKernels;
+
+constexpr size_t kChunkSize = 1 << 16;
+
+enum class ColumnType { STRING, NUMBER, BOOL };
+
+struct Dialect {
+    char delimiter = ',';
+    char quote = '"';
+};
+
+struct CsvReader {
+    Dialect dialect;
+    // Null when reading from an in-memory string
+    FILE *file = nullptr;
+    std::string buffer;
+    size_t pos = 0;
+    bool eof = false;
+    bool useHeader = false;
+    // Header names, shared as map keys by every row
+    std::vector<VMValue> header;
+    // Map of column (name or index) to "number" / "bool" / "string"
+    VMValue typeSpec = nullptr;
+    std::vector<ColumnType> types;
+    // Fields of the last parsed record; strings are reused across records
+    std::vector<std::string> fields;
+    size_t fieldCount = 0;
+
+    ~CsvReader() {
+        if (file)
+            fclose(file);
+    }
+};
+
+struct CsvWriter {
+    Dialect dialect;
+    FILE *file = nullptr;
+    std::string buffer;
+    std::vector<VMValue> columns;
+
+    bool flush() {
+        if (!file || buffer.empty())
+            return true;
+        bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        buffer.clear();
+        return ok;
+    }
+
+    ~CsvWriter() {
+        if (file) {
+            flush();
+            fclose(file);
+        }
+    }
+};
+
+static void freeReader(void *ptr) {
+    delete static_cast<CsvReader *>(ptr);
+}
+
+static void traceReader(void *ptr) {
+    CsvReader *reader = static_cast<CsvReader *>(ptr);
+    GC::markValue(reader->typeSpec);
+    for (auto &key : reader->header)
+        GC::markValue(key);
+}
+
+static void freeWriter(void *ptr) {
+    delete static_cast<CsvWriter *>(ptr);
+}
+
+static void traceWriter(void *ptr) {
+    for (auto &column : static_cast<CsvWriter *>(ptr)->columns)
+        GC::markValue(column);
+}
+
+static CsvReader *unwrapReader(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeReader)
+        return nullptr;
+    return static_cast<CsvReader *>(value.asInstance()->nativeData);
+}
+
+static CsvWriter *unwrapWriter(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeWriter)
+        return nullptr;
+    return static_cast<CsvWriter *>(value.asInstance()->nativeData);
+}
+
+static VMValue option(VMValue options, std::string_view name) {
+    if (!options.isMap())
+        return nullptr;
+    for (auto &[key, value] : options.asMap()->values) {
+        if (key.isString() && key.asString()->flatView() == name)
+            return value;
+    }
+    return nullptr;
+}
+
+static bool readChar(VMValue options, std::string_view name, char &out) {
+    VMValue value = option(options, name);
+    if (value.isNil())
+        return true;
+    if (!value.isString() || value.asString()->length != 1)
+        return false;
+    out = value.asString()->flatView()[0];
+    return true;
+}
+
+// Options shared by readers and writers; false if they are malformed.
+static bool readDialect(VMValue options, Dialect &dialect) {
+    if (!options.isNil() && !options.isMap())
+        return false;
+    if (!readChar(options, "delimiter", dialect.delimiter) || !readChar(options, "quote", dialect.quote))
+        return false;
+    return dialect.delimiter != dialect.quote && dialect.delimiter != '\n' && dialect.delimiter != '\r';
+}
+
+// ---- Reading ----
+
+enum class ParseStatus { RECORD, NEED_MORE, END };
+
+static std::string &nextField(CsvReader *reader) {
+    if (reader->fieldCount == reader->fields.size())
+        reader->fields.emplace_back();
+    std::string &field = reader->fields[reader->fieldCount++];
+    field.clear();
+    return field;
+}
+
+// Parses the record at reader->pos into reader->fields (RFC 4180 quoting,
+// LF or CRLF line ends, blank lines skipped). Returns NEED_MORE when the
+// record may continue past the buffered data; nothing is consumed then.
+static ParseStatus parseRecord(CsvReader *reader) {
+    std::string_view buf = reader->buffer;
+    const size_t end = buf.size();
+    const char delim = reader->dialect.delimiter;
+    const char quote = reader->dialect.quote;
+    size_t p = reader->pos;
+    reader->fieldCount = 0;
+
+    while (p < end && (buf[p] == '\n' || buf[p] == '\r'))
+        p++;
+    reader->pos = p;
+    if (p >= end)
+        return reader->eof ? ParseStatus::END : ParseStatus::NEED_MORE;
+
+    for (;;) {
+        std::string &field = nextField(reader);
+        if (p < end && buf[p] == quote) {
+            size_t from = p + 1;
+            for (;;) {
+                const void *hit = memchr(buf.data() + from, quote, end - from);
+                if (!hit) {
+                    if (!reader->eof)
+                        return ParseStatus::NEED_MORE;
+                    // Unterminated quote: the field runs to the end of input
+                    field.append(buf, from, end - from);
+                    p = end;
+                    break;
+                }
+                size_t close = static_cast<const char *>(hit) - buf.data();
+                field.append(buf, from, close - from);
+                if (close + 1 == end && !reader->eof)
+                    return ParseStatus::NEED_MORE;
+                if (close + 1 < end && buf[close + 1] == quote) {
+                    field += quote;
+                    from = close + 2;
+                    continue;
+                }
+                p = close + 1;
+                break;
+            }
+            // Text between the closing quote and the delimiter is kept
+            size_t stop = Kernels::findAny(buf, p, delim, '\n', '\r', delim);
+            stop = stop == Kernels::npos ? end : stop;
+            field.append(buf, p, stop - p);
+            p = stop;
+        } else {
+            size_t stop = Kernels::findAny(buf, p, delim, '\n', '\r', delim);
+            stop = stop == Kernels::npos ? end : stop;
+            field.assign(buf, p, stop - p);
+            p = stop;
+        }
+
+        if (p >= end) {
+            if (!reader->eof)
+                return ParseStatus::NEED_MORE;
+            reader->pos = p;
+            return ParseStatus::RECORD;
+        }
+        char c = buf[p];
+        if (c == delim) {
+            p++;
+            continue;
+        }
+        if (c == '\r') {
+            if (p + 1 == end && !reader->eof)
+                return ParseStatus::NEED_MORE;
+            p += (p + 1 < end && buf[p + 1] == '\n') ? 2 : 1;
+        } else {
+            p++;
+        }
+        reader->pos = p;
+        return ParseStatus::RECORD;
+    }
+}
+
+// Drops consumed input and appends the next chunk of the file.
+static void refill(CsvReader *reader) {
+    if (reader->pos > 0) {
+        reader->buffer.erase(0, reader->pos);
+        reader->pos = 0;
+    }
+    if (!reader->file) {
+        reader->eof = true;
+        return;
+    }
+    size_t old = reader->buffer.size();
+    reader->buffer.resize(old + kChunkSize);
+    size_t got = fread(reader->buffer.data() + old, 1, kChunkSize, reader->file);
+    reader->buffer.resize(old + got);
+    if (got < kChunkSize)
+        reader->eof = true;
+}
+
+static bool nextRecord(CsvReader *reader) {
+    for (;;) {
+        ParseStatus status = parseRecord(reader);
+        if (status == ParseStatus::NEED_MORE) {
+            refill(reader);
+            continue;
+        }
+        return status == ParseStatus::RECORD;
+    }
+}
+
+static void resolveTypes(CsvReader *reader) {
+    reader->types.clear();
+    if (!reader->typeSpec.isMap())
+        return;
+    for (auto &[key, value] : reader->typeSpec.asMap()->values) {
+        if (!value.isString())
+            continue;
+        std::string_view name = value.asString()->flatView();
+        ColumnType type = name == "number" ? ColumnType::NUMBER : name == "bool" ? ColumnType::BOOL : ColumnType::STRING;
+
+        size_t column = SIZE_MAX;
+        if (key.isNumber() && key.asNumber() >= 0) {
+            column = static_cast<size_t>(key.asNumber());
+        } else if (key.isString()) {
+            for (size_t i = 0; i < reader->header.size(); i++) {
+                if (reader->header[i].asString()->flatView() == key.asString()->flatView())
+                    column = i;
+            }
+        }
+        if (column == SIZE_MAX)
+            continue;
+        if (column >= reader->types.size())
+            reader->types.resize(column + 1, ColumnType::STRING);
+        reader->types[column] = type;
+    }
+}
+
+// Typed fields that do not parse become nil.
+static VMValue convertField(CsvReader *reader, size_t column, const std::string &text) {
+    ColumnType type = column < reader->types.size() ? reader->types[column] : ColumnType::STRING;
+    if (type == ColumnType::NUMBER) {
+        std::string_view digits = Kernels::trim(text);
+        double value;
+        auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+        if (digits.empty() || ec != std::errc() || ptr != digits.data() + digits.size())
+            return nullptr;
+        return value;
+    }
+    if (type == ColumnType::BOOL) {
+        if (text == "true" || text == "1")
+            return true;
+        if (text == "false" || text == "0")
+            return false;
+        return nullptr;
+    }
+    return text;
+}
+
+static VMValue buildRow(CsvReader *reader) {
+    if (!reader->useHeader) {
+        std::vector<VMValue> values;
+        values.reserve(reader->fieldCount);
+        for (size_t i = 0; i < reader->fieldCount; i++)
+            values.push_back(convertField(reader, i, reader->fields[i]));
+        return new ObjList(values);
+    }
+    auto row = new ObjMap();
+    for (size_t i = 0; i < reader->fieldCount; i++) {
+        VMValue key = i < reader->header.size() ? reader->header[i] : VMValue(static_cast<double>(i));
+        row->values[key] = convertField(reader, i, reader->fields[i]);
+    }
+    return row;
+}
+
+// Applies options and, in header mode, consumes the header record.
+static VMValue wrapReader(CsvReader *reader, VMValue options) {
+    VMValue header = option(options, "header");
+    reader->useHeader = header.isBool() && header.asBool();
+    reader->typeSpec = option(options, "types");
+    if (reader->useHeader && nextRecord(reader)) {
+        for (size_t i = 0; i < reader->fieldCount; i++)
+            reader->header.push_back(VMValue(reader->fields[i]));
+    }
+    resolveTypes(reader);
+
+    auto instance = new ObjInstance(currentVM->globals["CsvReader"].asClass());
+    instance->nativeData = reader;
+    instance->freeFn = freeReader;
+    instance->traceFn = traceReader;
+    return instance;
+}
+
+static VMValue csvOpen(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isString())
+        return nullptr;
+    VMValue options = argCount == 2 ? args[1] : VMValue(nullptr);
+    Dialect dialect;
+    if (!readDialect(options, dialect))
+        return makeResultErr(currentVM, "Invalid CSV options");
+
+    std::string path = args[0].asString()->flatten();
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return makeResultErr(currentVM, "Failed to open file: " + path);
+
+    auto reader = new CsvReader();
+    reader->dialect = dialect;
+    reader->file = file;
+    return makeResultOk(currentVM, wrapReader(reader, options));
+}
+
+static VMValue csvFromString(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isString())
+        return nullptr;
+    VMValue options = argCount == 2 ? args[1] : VMValue(nullptr);
+    Dialect dialect;
+    if (!readDialect(options, dialect))
+        return nullptr;
+
+    auto reader = new CsvReader();
+    reader->dialect = dialect;
+    reader->buffer = args[0].asString()->flatView();
+    reader->eof = true;
+    return wrapReader(reader, options);
+}
+
+static VMValue readerNext(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvReader *reader = unwrapReader(args[-1]);
+    if (!reader || !nextRecord(reader))
+        return nullptr;
+    return buildRow(reader);
+}
+
+static VMValue readerReadAll(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvReader *reader = unwrapReader(args[-1]);
+    if (!reader)
+        return nullptr;
+    auto rows = new ObjList(std::vector<VMValue>{});
+    while (nextRecord(reader))
+        rows->elements.push_back(buildRow(reader));
+    return rows;
+}
+
+static VMValue readerHeaders(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvReader *reader = unwrapReader(args[-1]);
+    if (!reader || !reader->useHeader)
+        return nullptr;
+    return new ObjList(reader->header);
+}
+
+static VMValue readerClose(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvReader *reader = unwrapReader(args[-1]);
+    if (!reader)
+        return nullptr;
+    if (reader->file) {
+        fclose(reader->file);
+        reader->file = nullptr;
+    }
+    reader->buffer.clear();
+    reader->pos = 0;
+    reader->eof = true;
+    return makeResultOk(currentVM, true);
+}
+
+static VMValue csvParse(int argCount, VMValue *args) {
+    VMValue reader = csvFromString(argCount, args);
+    if (reader.isNil())
+        return nullptr;
+    return readerReadAll(0, &reader + 1);
+}
+
+// ---- Writing ----
+
+static void appendField(std::string &out, VMValue value, const Dialect &dialect) {
+    if (value.isNil())
+        return;
+    if (value.isNumber()) {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value.asNumber());
+        out.append(digits, result.ptr);
+        return;
+    }
+    if (value.isBool()) {
+        out += value.asBool() ? "true" : "false";
+        return;
+    }
+    std::string text = value.isString() ? std::string(value.asString()->flatView()) : value.toString();
+    if (Kernels::findAny(text, 0, dialect.delimiter, dialect.quote, '\n', '\r') == Kernels::npos) {
+        out += text;
+        return;
+    }
+    out += dialect.quote;
+    size_t start = 0;
+    size_t at;
+    while ((at = text.find(dialect.quote, start)) != std::string::npos) {
+        out.append(text, start, at - start + 1);
+        out += dialect.quote;
+        start = at + 1;
+    }
+    out.append(text, start, std::string::npos);
+    out += dialect.quote;
+}
+
+// Lists are written in order; maps by `columns`, missing keys left empty.
+static bool appendRow(std::string &out, VMValue row, const std::vector<VMValue> &columns, const Dialect &dialect) {
+    if (row.isList()) {
+        auto &values = row.asList()->elements;
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0)
+                out += dialect.delimiter;
+            appendField(out, values[i], dialect);
+        }
+    } else if (row.isMap() && !columns.empty()) {
+        auto &values = row.asMap()->values;
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (i > 0)
+                out += dialect.delimiter;
+            auto it = values.find(columns[i]);
+            if (it != values.end())
+                appendField(out, it->second, dialect);
+        }
+    } else {
+        return false;
+    }
+    out += '\n';
+    return true;
+}
+
+static bool readColumns(VMValue options, std::vector<VMValue> &columns) {
+    VMValue value = option(options, "columns");
+    if (value.isNil())
+        return true;
+    if (!value.isList())
+        return false;
+    columns = value.asList()->elements;
+    return true;
+}
+
+static VMValue csvWriter(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isString())
+        return nullptr;
+    VMValue options = argCount == 2 ? args[1] : VMValue(nullptr);
+    Dialect dialect;
+    std::vector<VMValue> columns;
+    if (!readDialect(options, dialect) || !readColumns(options, columns))
+        return makeResultErr(currentVM, "Invalid CSV options");
+
+    std::string path = args[0].asString()->flatten();
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return makeResultErr(currentVM, "Failed to open file: " + path);
+
+    auto writer = new CsvWriter();
+    writer->dialect = dialect;
+    writer->file = file;
+    writer->columns = std::move(columns);
+    if (!writer->columns.empty())
+        appendRow(writer->buffer, new ObjList(writer->columns), {}, dialect);
+
+    auto instance = new ObjInstance(currentVM->globals["CsvWriter"].asClass());
+    instance->nativeData = writer;
+    instance->freeFn = freeWriter;
+    instance->traceFn = traceWriter;
+    return makeResultOk(currentVM, instance);
+}
+
+static VMValue writerWrite(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvWriter *writer = unwrapWriter(args[-1]);
+    if (!writer || !writer->file)
+        return nullptr;
+    if (!appendRow(writer->buffer, args[0], writer->columns, writer->dialect))
+        return makeResultErr(currentVM, "Row must be a list, or a map when columns are set");
+    if (writer->buffer.size() >= kChunkSize && !writer->flush())
+        return makeResultErr(currentVM, "Failed to write CSV data");
+    return makeResultOk(currentVM, true);
+}
+
+static VMValue writerFlush(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvWriter *writer = unwrapWriter(args[-1]);
+    if (!writer)
+        return nullptr;
+    if (!writer->flush() || (writer->file && fflush(writer->file) != 0))
+        return makeResultErr(currentVM, "Failed to write CSV data");
+    return makeResultOk(currentVM, true);
+}
+
+static VMValue writerClose(int argCount, VMValue *args) {
+    (void)argCount;
+    CsvWriter *writer = unwrapWriter(args[-1]);
+    if (!writer)
+        return nullptr;
+    bool ok = writer->flush();
+    if (writer->file) {
+        ok = fclose(writer->file) == 0 && ok;
+        writer->file = nullptr;
+    }
+    if (!ok)
+        return makeResultErr(currentVM, "Failed to write CSV data");
+    return makeResultOk(currentVM, true);
+}
+
+static VMValue csvStringify(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isList())
+        return nullptr;
+    VMValue options = argCount == 2 ? args[1] : VMValue(nullptr);
+    Dialect dialect;
+    std::vector<VMValue> columns;
+    if (!readDialect(options, dialect) || !readColumns(options, columns))
+        return nullptr;
+
+    std::string out;
+    if (!columns.empty())
+        appendRow(out, new ObjList(columns), {}, dialect);
+    for (const auto &row : args[0].asList()->elements) {
+        if (!appendRow(out, row, columns, dialect))
+            return nullptr;
+    }
+    return out;
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto csvClass = new ObjClass("Csv");
+    csvClass->statics["open"] = new ObjNative("open", -1, csvOpen);
+    csvClass->statics["fromString"] = new ObjNative("fromString", -1, csvFromString);
+    csvClass->statics["parse"] = new ObjNative("parse", -1, csvParse);
+    csvClass->statics["writer"] = new ObjNative("writer", -1, csvWriter);
+    csvClass->statics["stringify"] = new ObjNative("stringify", -1, csvStringify);
+    vm->globals["Csv"] = csvClass;
+
+    auto readerClass = new ObjClass("CsvReader");
+    readerClass->methods["next"] = new ObjNative("next", 0, readerNext);
+    readerClass->methods["readAll"] = new ObjNative("readAll", 0, readerReadAll);
+    readerClass->methods["headers"] = new ObjNative("headers", 0, readerHeaders);
+    readerClass->methods["close"] = new ObjNative("close", 0, readerClose);
+    vm->globals["CsvReader"] = readerClass;
+
+    auto writerClass = new ObjClass("CsvWriter");
+    writerClass->methods["write"] = new ObjNative("write", 1, writerWrite);
+    writerClass->methods["flush"] = new ObjNative("flush", 0, writerFlush);
+    writerClass->methods["close"] = new ObjNative("close", 0, writerClose);
+    vm->globals["CsvWriter"] = writerClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.type = "class";
+    sym.isConst = true;
+    sym.name = "Csv";
+    scope->define(sym);
+    sym.name = "CsvReader";
+    scope->define(sym);
+    sym.name = "CsvWriter";
+    scope->define(sym);
+}
+
+} // namespace CsvModule
+} // namespace StdLib
@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_CSV_H
+#define TRYPILLIA_CSV_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace CsvModule {
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace CsvModule
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,455 @@
+#include "AsyncIO.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace StdLib {
+namespace AsyncIO {
+
+constexpr unsigned kRingEntries = 256;
+constexpr size_t kPoolThreads = 4;
+
+static void closeFd(Op *op) {
+    if (op->fd >= 0 && op->kind != Op::Kind::POLL)
+        close(op->fd);
+    op->fd = -1;
+}
+
+// Accounts for one kernel result; true once the op is finished
+static bool advance(Op *op, long result) {
+    if (result < 0) {
+        op->error = static_cast<int>(-result);
+        return true;
+    }
+    if (op->kind == Op::Kind::FSYNC || op->kind == Op::Kind::POLL)
+        return true;
+    if (result == 0) {
+        // End of file: keep what was read. A write that makes no progress
+        // would spin forever, so treat it as an error.
+        if (op->kind == Op::Kind::READ)
+            op->buffer.resize(op->done);
+        else
+            op->error = EIO;
+        return true;
+    }
+    op->done += static_cast<size_t>(result);
+    if (op->done < op->buffer.size())
+        return false;
+    if (op->kind == Op::Kind::READ && op->toEof) {
+        if (op->buffer.size() >= kMaxTransfer) {
+            op->error = EFBIG;
+            return true;
+        }
+        op->buffer.resize(std::min(op->buffer.size() * 2, kMaxTransfer));
+        return false;
+    }
+    return true;
+}
+
+// Runs an op to completion with blocking calls
+static void runBlocking(Op *op) {
+    while (true) {
+        long result;
+        size_t want = std::min(op->buffer.size() - op->done, kMaxTransfer);
+#ifndef _WIN32
+        if (op->kind == Op::Kind::FSYNC)
+            result = fsync(op->fd);
+        else if (op->kind == Op::Kind::READ)
+            result = pread(op->fd, op->buffer.data() + op->done, want, static_cast<off_t>(op->offset + op->done));
+        else
+            result = pwrite(op->fd, op->buffer.data() + op->done, want, static_cast<off_t>(op->offset + op->done));
+#else
+        if (op->kind == Op::Kind::FSYNC) {
+            result = _commit(op->fd);
+        } else {
+            _lseeki64(op->fd, static_cast<long long>(op->offset + op->done), SEEK_SET);
+            unsigned chunk = static_cast<unsigned>(std::min<size_t>(want, 1u << 30));
+            result = op->kind == Op::Kind::READ ? _read(op->fd, op->buffer.data() + op->done, chunk)
+                                                : _write(op->fd, op->buffer.data() + op->done, chunk);
+        }
+#endif
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (advance(op, result < 0 ? -errno : result))
+            return;
+    }
+}
+
+// Fallback: blocking calls on a few background threads. POLL ops never
+// take one of those: they all wait in a single poll() on a separate
+// thread, so pending watches cannot starve file requests.
+class PoolEngine : public Engine {
+  public:
+    ~PoolEngine() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            wakePoller();
+        }
+        work.notify_all();
+        for (std::thread &thread : threads)
+            thread.join();
+        if (poller.joinable())
+            poller.join();
+#ifndef _WIN32
+        for (int fd : wakePipe)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    void submit(const std::vector<Op *> &ops) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bool polls = false;
+            for (Op *op : ops) {
+                if (op->kind == Op::Kind::POLL) {
+                    watched.push_back(op);
+                    polls = true;
+                } else {
+                    queue.push_back(op);
+                }
+            }
+            pending += ops.size();
+            if (polls)
+                startPolling();
+            while (threads.size() < kPoolThreads && threads.size() < pending - watched.size())
+                threads.emplace_back([this] { loop(); });
+        }
+        work.notify_all();
+    }
+
+    void reap(bool wait, std::vector<Op *> &done) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wait)
+            finished.wait(lock, [this] { return !completed.empty() || pending == 0; });
+        pending -= completed.size();
+        done.insert(done.end(), completed.begin(), completed.end());
+        completed.clear();
+    }
+
+    size_t inflight() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending;
+    }
+
+    const char *name() const override {
+        return "threads";
+    }
+
+  private:
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            work.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+            Op *op = queue.front();
+            queue.pop_front();
+            lock.unlock();
+            runBlocking(op);
+            closeFd(op);
+            lock.lock();
+            completed.push_back(op);
+            finished.notify_one();
+        }
+    }
+
+    // Completes watched ops, with `error` if non-zero; mutex held
+    void finishPolls(int error) {
+        for (Op *op : watched) {
+            op->error = error;
+            completed.push_back(op);
+        }
+        watched.clear();
+        finished.notify_one();
+    }
+
+    // Starts the poller, or tells it the watched set changed; mutex held
+    void startPolling() {
+#ifndef _WIN32
+        if (poller.joinable()) {
+            wakePoller();
+            return;
+        }
+        if (pipe(wakePipe) != 0) {
+            finishPolls(errno);
+            return;
+        }
+        for (int fd : wakePipe) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+        poller = std::thread([this] { pollLoop(); });
+#else
+        finishPolls(ENOSYS);
+#endif
+    }
+
+    void wakePoller() {
+#ifndef _WIN32
+        char byte = 0;
+        if (wakePipe[1] >= 0)
+            (void)!write(wakePipe[1], &byte, 1);
+#endif
+    }
+
+#ifndef _WIN32
+    // One poll() over the wake pipe and every watched descriptor
+    void pollLoop() {
+        std::vector<Op *> snapshot;
+        std::vector<pollfd> fds;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            snapshot = watched;
+            lock.unlock();
+            fds.assign(1, pollfd{wakePipe[0], POLLIN, 0});
+            for (Op *op : snapshot)
+                fds.push_back(pollfd{op->fd, POLLIN, 0});
+            int ready = poll(fds.data(), fds.size(), -1);
+            int error = ready < 0 && errno != EINTR ? errno : 0;
+            if (fds[0].revents) {
+                char drain[64];
+                while (read(wakePipe[0], drain, sizeof(drain)) > 0) {
+                }
+            }
+            lock.lock();
+            if (error) {
+                finishPolls(error);
+                continue;
+            }
+            bool any = false;
+            for (size_t i = 0; i < snapshot.size(); i++) {
+                if (ready <= 0 || !fds[i + 1].revents)
+                    continue;
+                Op *op = snapshot[i];
+                if (fds[i + 1].revents & POLLNVAL)
+                    op->error = EBADF;
+                watched.erase(std::find(watched.begin(), watched.end(), op));
+                completed.push_back(op);
+                any = true;
+            }
+            if (any)
+                finished.notify_one();
+        }
+    }
+#endif
+
+    mutable std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable finished;
+    std::deque<Op *> queue;
+    std::vector<Op *> completed;
+    std::vector<std::thread> threads;
+    // POLL ops waiting on the poller thread
+    std::vector<Op *> watched;
+    std::thread poller;
+    int wakePipe[2] = {-1, -1};
+    size_t pending = 0;
+    bool stopping = false;
+};
+
+#ifdef __linux__
+// io_uring through the raw syscalls, so no liburing is needed
+class UringEngine : public Engine {
+  public:
+    ~UringEngine() override {
+        if (sqes)
+            munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing)
+            munmap(sqRing, sqRingSize);
+        if (ringFd >= 0)
+            close(ringFd);
+    }
+
+    bool setup(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0)
+            return false;
+        // IORING_OP_READ/WRITE arrived together with this feature (5.6)
+        if (!(params.features & IORING_FEAT_RW_CUR_POS))
+            return false;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        sqRing = map(sqRingSize, IORING_OFF_SQ_RING);
+        cqRing = single ? sqRing : map(cqRingSize, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(map(sqesSize, IORING_OFF_SQES));
+        if (!sqRing || !cqRing || !sqes)
+            return false;
+
+        char *sq = static_cast<char *>(sqRing);
+        sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        char *cq = static_cast<char *>(cqRing);
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        cqEntries = params.cq_entries;
+        return true;
+    }
+
+    void submit(const std::vector<Op *> &ops) override {
+        backlog.insert(backlog.end(), ops.begin(), ops.end());
+        flush();
+    }
+
+    void reap(bool wait, std::vector<Op *> &done) override {
+        size_t before = done.size();
+        while (true) {
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                io_uring_cqe *cqe = &cqes[head & cqMask];
+                Op *op = reinterpret_cast<Op *>(static_cast<uintptr_t>(cqe->user_data));
+                active--;
+                if (advance(op, cqe->res)) {
+                    closeFd(op);
+                    done.push_back(op);
+                } else {
+                    // Short transfer: queue the remainder
+                    backlog.push_back(op);
+                }
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            flush();
+            if (!wait || done.size() > before || active == 0)
+                return;
+            enter(0, 1, IORING_ENTER_GETEVENTS);
+        }
+    }
+
+    size_t inflight() const override {
+        return active + backlog.size();
+    }
+
+    const char *name() const override {
+        return "io_uring";
+    }
+
+  private:
+    void *map(size_t size, off_t offset) {
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        int ret;
+        do
+            ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+        while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    // Moves backlog ops into free SQ slots, keeping no more in flight than
+    // the completion ring holds, then submits them with a single syscall
+    void flush() {
+        unsigned tail = *sqTail;
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        while (!backlog.empty() && tail - head < sqEntries && active + unsubmitted < cqEntries) {
+            Op *op = backlog.front();
+            backlog.pop_front();
+            unsigned slot = tail & sqMask;
+            io_uring_sqe *sqe = &sqes[slot];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->fd = op->fd;
+            sqe->user_data = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(op));
+            if (op->kind == Op::Kind::POLL) {
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->poll_events = POLLIN;
+            } else if (op->kind == Op::Kind::FSYNC) {
+                sqe->opcode = IORING_OP_FSYNC;
+            } else {
+                sqe->opcode = op->kind == Op::Kind::READ ? IORING_OP_READ : IORING_OP_WRITE;
+                sqe->off = op->offset + op->done;
+                sqe->addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(op->buffer.data() + op->done));
+                sqe->len = static_cast<uint32_t>(std::min(op->buffer.size() - op->done, kMaxTransfer));
+            }
+            sqArray[slot] = slot;
+            tail++;
+            unsubmitted++;
+        }
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+        if (unsubmitted == 0)
+            return;
+        int ret = enter(unsubmitted, 0, 0);
+        if (ret > 0) {
+            unsubmitted -= static_cast<unsigned>(ret);
+            active += static_cast<size_t>(ret);
+        }
+    }
+
+    int ringFd = -1;
+    void *sqRing = nullptr;
+    void *cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned cqMask = 0;
+    unsigned cqEntries = 0;
+    // Prepared in the SQ but not yet accepted by the kernel
+    unsigned unsubmitted = 0;
+    // Accepted by the kernel, completion not yet reaped
+    size_t active = 0;
+    std::deque<Op *> backlog;
+};
+#endif
+
+Engine &Engine::current() {
+    thread_local std::unique_ptr<Engine> engine;
+    if (!engine) {
+#ifdef __linux__
+        // TRYPILLIA_NO_IO_URING forces the thread pool, e.g. to compare
+        if (!getenv("TRYPILLIA_NO_IO_URING")) {
+            auto ring = std::make_unique<UringEngine>();
+            if (ring->setup(kRingEntries))
+                engine = std::move(ring);
+        }
+#endif
+        if (!engine)
+            engine = std::make_unique<PoolEngine>();
+    }
+    return *engine;
+}
+
+} // namespace AsyncIO
+} // namespace StdLib
@@ -0,0 +1,57 @@
+#ifndef TRYPILLIA_NATIVE_ASYNCIO_H
+#define TRYPILLIA_NATIVE_ASYNCIO_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Asynchronous file I/O for the VM thread. On Linux requests go through
+// an io_uring; where the ring cannot be set up (old kernels, seccomp
+// filters, other systems) a small thread pool runs them with blocking
+// calls. Either way the caller submits Ops and later reaps them.
+namespace StdLib {
+namespace AsyncIO {
+
+// A single read or write never asks the kernel for more than this
+constexpr size_t kMaxTransfer = 1 << 30;
+
+struct Op {
+    // POLL finishes once `fd` is readable
+    enum class Kind { READ, WRITE, FSYNC, POLL };
+    Kind kind = Kind::READ;
+    // Owned descriptor, closed once the op is reaped; POLL only borrows it
+    int fd = -1;
+    uint64_t offset = 0;
+    // READ: bytes wanted, filled up to `done`; WRITE: bytes to write
+    std::string buffer;
+    size_t done = 0;
+    // READ: the buffer is only a first guess (the file reports no size);
+    // grow it and keep reading until end of file, up to kMaxTransfer
+    bool toEof = false;
+    // 0 on success, otherwise an errno value
+    int error = 0;
+    // Opaque to the engine; the script bindings hang their promise here
+    void *owner = nullptr;
+    size_t index = 0;
+};
+
+class Engine {
+  public:
+    // The engine for the calling thread, so every Worker gets its own ring
+    static Engine &current();
+    virtual ~Engine() = default;
+
+    // Queues the ops and hands the whole batch to the kernel in one call
+    virtual void submit(const std::vector<Op *> &ops) = 0;
+    // Moves finished ops to `done`, blocking for at least one if `wait`
+    // and anything is in flight.
+    virtual void reap(bool wait, std::vector<Op *> &done) = 0;
+    virtual size_t inflight() const = 0;
+    virtual const char *name() const = 0;
+};
+
+} // namespace AsyncIO
+} // namespace StdLib
+
+#endif
@@ -1,17 +1,43 @@
 #include "FS.h"
 #include "../StdLib.h"
+#include "../net/Net.h"
+#include "../promise/Promise.h"
+#include "AsyncIO.h"
+#include "Walk.h"
+#include "Watch.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 namespace StdLib {
 namespace FS {
 
+// The path is kept so the file can be reopened for zero-copy sends
+struct FileData {
+    std::fstream stream;
+    std::string path;
+};
+
 static void freeFile(void *nativeData) {
-    std::fstream *file = static_cast<std::fstream *>(nativeData);
+    FileData *file = static_cast<FileData *>(nativeData);
     if (file) {
-        if (file->is_open())
-            file->close();
+        if (file->stream.is_open())
+            file->stream.close();
         delete file;
     }
 }
@@ -33,8 +59,8 @@ static VMValue fileOpen(int argCount, VMValue *args) {
     else if (mode == "rw")
         fmode = std::ios_base::in | std::ios_base::out;
 
-    std::fstream *file = new std::fstream(path, fmode);
-    if (!file->is_open()) {
+    FileData *file = new FileData{std::fstream(path, fmode), path};
+    if (!file->stream.is_open()) {
         delete file;
         return makeResultErr(currentVM, "Failed to open file: " + path);
     }
@@ -56,12 +82,12 @@ static VMValue fileRead(int argCount, VMValue *args) {
         return nullptr;
 
     auto instance = receiver.asInstance();
-    std::fstream *file = static_cast<std::fstream *>(instance->nativeData);
-    if (!file || !file->is_open())
+    FileData *file = static_cast<FileData *>(instance->nativeData);
+    if (!file || !file->stream.is_open())
         return makeResultErr(currentVM, "File is not open");
 
     std::stringstream buffer;
-    buffer << file->rdbuf();
+    buffer << file->stream.rdbuf();
     return makeResultOk(currentVM, buffer.str());
 }
 
@@ -73,12 +99,12 @@ static VMValue fileWrite(int argCount, VMValue *args) {
         return false;
 
     auto instance = receiver.asInstance();
-    std::fstream *file = static_cast<std::fstream *>(instance->nativeData);
-    if (!file || !file->is_open())
+    FileData *file = static_cast<FileData *>(instance->nativeData);
+    if (!file || !file->stream.is_open())
         return makeResultErr(currentVM, "File is not open");
 
     std::string content = args[0].asString()->flatten();
-    *file << content;
+    file->stream << content;
     return makeResultOk(currentVM, true);
 }
 
@@ -90,13 +116,652 @@ static VMValue fileClose(int argCount, VMValue *args) {
         return false;
 
     auto instance = receiver.asInstance();
-    std::fstream *file = static_cast<std::fstream *>(instance->nativeData);
-    if (file && file->is_open()) {
-        file->close();
+    FileData *file = static_cast<FileData *>(instance->nativeData);
+    if (file && file->stream.is_open()) {
+        file->stream.close();
     }
     return makeResultOk(currentVM, true);
 }
 
+bool writeToFile(VMValue file, std::string_view data) {
+    if (!file.isInstance() || file.asInstance()->freeFn != freeFile)
+        return false;
+    FileData *target = static_cast<FileData *>(file.asInstance()->nativeData);
+    if (!target || !target->stream.is_open())
+        return false;
+    target->stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(target->stream);
+}
+
+bool filePath(VMValue file, std::string &path) {
+    if (!file.isInstance() || file.asInstance()->freeFn != freeFile)
+        return false;
+    FileData *data = static_cast<FileData *>(file.asInstance()->nativeData);
+    if (!data || !data->stream.is_open())
+        return false;
+    // Buffered writes must reach the file before it is read by descriptor
+    data->stream.flush();
+    path = data->path;
+    return true;
+}
+
+// copyTo(socket, offset?, length?): sends the file's bytes straight from
+// the kernel page cache, without loading them into a string
+static VMValue fileCopyTo(int argCount, VMValue *args) {
+    std::string path;
+    if (argCount < 1 || argCount > 3 || !filePath(args[-1], path))
+        return nullptr;
+    uint64_t offset = 0;
+    int64_t length = -1;
+    if (argCount >= 2) {
+        if (!args[1].isNumber() || args[1].asNumber() < 0)
+            return nullptr;
+        offset = static_cast<uint64_t>(args[1].asNumber());
+    }
+    if (argCount == 3) {
+        if (!args[2].isNumber() || args[2].asNumber() < 0)
+            return nullptr;
+        length = static_cast<int64_t>(args[2].asNumber());
+    }
+    std::string error;
+    int64_t sent = Net::sendFileToSocket(args[0], path, offset, length, error);
+    if (sent < 0)
+        return makeResultErr(currentVM, error);
+    return makeResultOk(currentVM, static_cast<double>(sent));
+}
+
+// First buffer for files stat reports no size for, as under /proc; the
+// read grows it until end of file
+constexpr size_t kUnknownSize = 64 * 1024;
+
+// One script-visible async call: its promise settles when every op has
+// finished. Slots whose file could not be opened carry the error instead.
+struct AsyncRequest {
+    ObjPromise *promise = nullptr;
+    std::vector<std::unique_ptr<AsyncIO::Op>> ops;
+    std::vector<std::string> errors;
+    size_t remaining = 0;
+    // readManyAsync settles with a list of Results instead of one
+    bool many = false;
+};
+
+static VMValue slotResult(AsyncRequest *request, size_t slot) {
+    if (!request->errors[slot].empty())
+        return makeResultErr(currentVM, request->errors[slot]);
+    AsyncIO::Op *op = request->ops[slot].get();
+    if (op->error)
+        return makeResultErr(currentVM, strerror(op->error));
+    if (op->kind == AsyncIO::Op::Kind::READ)
+        return makeResultOk(currentVM, std::move(op->buffer));
+    if (op->kind == AsyncIO::Op::Kind::WRITE)
+        return makeResultOk(currentVM, static_cast<double>(op->done));
+    return makeResultOk(currentVM, true);
+}
+
+static void finishRequest(VM *vm, AsyncRequest *request) {
+    VMValue value;
+    if (request->many) {
+        auto list = new ObjList(std::vector<VMValue>{});
+        for (size_t slot = 0; slot < request->errors.size(); slot++)
+            list->elements.push_back(slotResult(request, slot));
+        value = list;
+    } else {
+        value = slotResult(request, 0);
+    }
+    vm->pendingIO.erase(request->promise);
+    PromiseModule::settle(vm, request->promise, value);
+    delete request;
+}
+
+struct WatchData;
+static void watchReady(VM *vm, WatchData *data);
+
+static void pollIO(VM *vm, bool wait) {
+    std::vector<AsyncIO::Op *> done;
+    AsyncIO::Engine::current().reap(wait, done);
+    for (AsyncIO::Op *op : done) {
+        if (op->kind == AsyncIO::Op::Kind::POLL) {
+            watchReady(vm, static_cast<WatchData *>(op->owner));
+            continue;
+        }
+        AsyncRequest *request = static_cast<AsyncRequest *>(op->owner);
+        if (--request->remaining == 0)
+            finishRequest(vm, request);
+    }
+}
+
+// Adds a slot to the request, opening `path` synchronously; open errors
+// are recorded for the slot rather than failing the whole call
+static AsyncIO::Op *addSlot(AsyncRequest *request, const std::string &path, int flags, AsyncIO::Op::Kind kind) {
+    request->errors.emplace_back();
+    request->ops.emplace_back();
+    int fd = open(path.c_str(), flags | O_CLOEXEC | O_BINARY, 0644);
+    if (fd < 0) {
+        request->errors.back() = "Failed to open file: " + path + ": " + strerror(errno);
+        return nullptr;
+    }
+    auto op = std::make_unique<AsyncIO::Op>();
+    op->kind = kind;
+    op->fd = fd;
+    op->owner = request;
+    op->index = request->ops.size() - 1;
+    request->ops.back() = std::move(op);
+    return request->ops.back().get();
+}
+
+// Hands the request's ops to the engine in one batch and returns its
+// promise, already settled if nothing needed the kernel
+static VMValue submitRequest(AsyncRequest *request) {
+    VM *vm = currentVM;
+    request->promise = new ObjPromise();
+    std::vector<AsyncIO::Op *> batch;
+    for (auto &op : request->ops)
+        if (op)
+            batch.push_back(op.get());
+    request->remaining = batch.size();
+    VMValue promise = request->promise;
+    if (batch.empty()) {
+        finishRequest(vm, request);
+        return promise;
+    }
+    vm->pollIO = pollIO;
+    vm->pendingIO.insert(request->promise);
+    AsyncIO::Engine::current().submit(batch);
+    return promise;
+}
+
+static bool pathArg(VMValue value, std::string &path) {
+    if (value.isString()) {
+        path = value.asString()->flatten();
+        return true;
+    }
+    return filePath(value, path);
+}
+
+static void prepareRead(AsyncIO::Op *op) {
+    struct stat st;
+    size_t size = fstat(op->fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    // Files under /proc and the like report 0 but have content
+    op->toEof = size == 0;
+    op->buffer.resize(size ? size : kUnknownSize);
+}
+
+// readAsync(path|File): Promise of Result with the whole file
+static VMValue fileReadAsync(int argCount, VMValue *args) {
+    std::string path;
+    if (argCount != 1 || !pathArg(args[0], path))
+        return nullptr;
+    AsyncRequest *request = new AsyncRequest();
+    if (AsyncIO::Op *op = addSlot(request, path, O_RDONLY, AsyncIO::Op::Kind::READ))
+        prepareRead(op);
+    return submitRequest(request);
+}
+
+// readManyAsync(paths): Promise of a list of Results, submitted at once
+static VMValue fileReadManyAsync(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isList())
+        return nullptr;
+    for (VMValue path : args[0].asList()->elements)
+        if (!path.isString())
+            return nullptr;
+    AsyncRequest *request = new AsyncRequest();
+    request->many = true;
+    for (VMValue path : args[0].asList()->elements)
+        if (AsyncIO::Op *op = addSlot(request, path.asString()->flatten(), O_RDONLY, AsyncIO::Op::Kind::READ))
+            prepareRead(op);
+    return submitRequest(request);
+}
+
+// readAtAsync(path|File, offset, length): up to `length` bytes from `offset`
+static VMValue fileReadAtAsync(int argCount, VMValue *args) {
+    std::string path;
+    if (argCount != 3 || !pathArg(args[0], path) || !args[1].isNumber() || args[1].asNumber() < 0 ||
+        !args[2].isNumber() || args[2].asNumber() < 0)
+        return nullptr;
+    AsyncRequest *request = new AsyncRequest();
+    if (AsyncIO::Op *op = addSlot(request, path, O_RDONLY, AsyncIO::Op::Kind::READ)) {
+        // Reads stop at end of file anyway, so the buffer only has to
+        // reach it; files that report no size get kUnknownSize at most
+        struct stat st;
+        double size = fstat(op->fd, &st) == 0 && st.st_size > 0 ? static_cast<double>(st.st_size) : 0;
+        // Unknown sizes cap the offset at a value that still fits off_t
+        double offset = std::min(args[1].asNumber(), size ? size : 9e18);
+        double length = std::min(args[2].asNumber(), size ? size - offset : kUnknownSize);
+        if (length > AsyncIO::kMaxTransfer) {
+            close(op->fd);
+            request->ops.back().reset();
+            request->errors.back() = "Read too large: " + path;
+        } else {
+            op->offset = static_cast<uint64_t>(offset);
+            op->buffer.resize(static_cast<size_t>(length));
+        }
+    }
+    return submitRequest(request);
+}
+
+// writeAsync(path|File, data): replaces the file; Promise of Ok(bytes)
+static VMValue fileWriteAsync(int argCount, VMValue *args) {
+    std::string path;
+    if (argCount != 2 || !pathArg(args[0], path) || !args[1].isString())
+        return nullptr;
+    AsyncRequest *request = new AsyncRequest();
+    if (AsyncIO::Op *op = addSlot(request, path, O_WRONLY | O_CREAT | O_TRUNC, AsyncIO::Op::Kind::WRITE))
+        op->buffer = args[1].asString()->flatten();
+    return submitRequest(request);
+}
+
+// fsyncAsync(path|File): Promise of Ok(true) once the data is durable
+static VMValue fileFsyncAsync(int argCount, VMValue *args) {
+    std::string path;
+    if (argCount != 1 || !pathArg(args[0], path))
+        return nullptr;
+    AsyncRequest *request = new AsyncRequest();
+    addSlot(request, path, O_RDONLY, AsyncIO::Op::Kind::FSYNC);
+    return submitRequest(request);
+}
+
+// await(promise): blocks until an async file request settles and returns
+// its value; other promises are returned as they stand
+static VMValue fileAwait(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isPromise())
+        return nullptr;
+    VM *vm = currentVM;
+    ObjPromise *promise = args[0].asPromise();
+    while (!promise->resolved && vm->pendingIO.count(promise))
+        pollIO(vm, true);
+    return promise->resolved ? promise->value : VMValue(nullptr);
+}
+
+// "io_uring" or "threads"
+static VMValue fileAsyncBackend(int argCount, VMValue *args) {
+    (void)argCount;
+    (void)args;
+    return std::string(AsyncIO::Engine::current().name());
+}
+
+// --- FS: directories and metadata ---
+
+static VMValue fsOption(VMValue options, std::string_view name) {
+    if (!options.isMap())
+        return nullptr;
+    for (auto &[key, value] : options.asMap()->values) {
+        if (key.isString() && key.asString()->flatView() == name)
+            return value;
+    }
+    return nullptr;
+}
+
+// list(dir): sorted entry names
+static VMValue fsList(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    std::string path = args[0].asString()->flatten();
+    std::vector<Walk::DirEntry> entries;
+    if (int error = Walk::readDirectory(path, entries))
+        return makeResultErr(currentVM, "Cannot list " + path + ": " + strerror(error));
+    std::sort(entries.begin(), entries.end(),
+              [](const Walk::DirEntry &a, const Walk::DirEntry &b) { return a.name < b.name; });
+    auto names = new ObjList(std::vector<VMValue>{});
+    names->elements.reserve(entries.size());
+    for (Walk::DirEntry &entry : entries)
+        names->elements.push_back(std::move(entry.name));
+    return makeResultOk(currentVM, names);
+}
+
+// stat(path, followLinks = true): {"type", "size", "mtime", "mode"}
+static VMValue fsStat(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || (argCount == 2 && !args[1].isBool()))
+        return nullptr;
+    std::string path = args[0].asString()->flatten();
+    bool follow = argCount < 2 || args[1].asBool();
+    struct stat st;
+#ifndef _WIN32
+    int ret = follow ? stat(path.c_str(), &st) : lstat(path.c_str(), &st);
+#else
+    (void)follow;
+    int ret = stat(path.c_str(), &st);
+#endif
+    if (ret != 0)
+        return makeResultErr(currentVM, "Cannot stat " + path + ": " + strerror(errno));
+    const char *type = S_ISREG(st.st_mode)   ? "file"
+                       : S_ISDIR(st.st_mode) ? "dir"
+#ifndef _WIN32
+                       : S_ISLNK(st.st_mode) ? "link"
+#endif
+                                             : "other";
+#ifdef __linux__
+    double mtime = static_cast<double>(st.st_mtim.tv_sec) + static_cast<double>(st.st_mtim.tv_nsec) / 1e9;
+#else
+    double mtime = static_cast<double>(st.st_mtime);
+#endif
+    auto info = new ObjMap();
+    info->values[VMValue(std::string("type"))] = std::string(type);
+    info->values[VMValue(std::string("size"))] = static_cast<double>(st.st_size);
+    info->values[VMValue(std::string("mtime"))] = mtime;
+    info->values[VMValue(std::string("mode"))] = static_cast<double>(st.st_mode & 07777);
+    return makeResultOk(currentVM, info);
+}
+
+static void freeWalker(void *ptr) {
+    delete static_cast<Walk::Walker *>(ptr);
+}
+
+static Walk::Walker *unwrapWalker(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeWalker)
+        return nullptr;
+    return static_cast<Walk::Walker *>(value.asInstance()->nativeData);
+}
+
+// walk(root, {"glob", "followLinks", "threads"}): an FSWalk streaming
+// entries as a thread pool finds them
+static VMValue fsWalk(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || (argCount == 2 && !args[1].isMap()))
+        return nullptr;
+    std::string root = args[0].asString()->flatten();
+    Walk::WalkOptions options;
+    VMValue optionMap = argCount == 2 ? args[1] : VMValue(nullptr);
+    VMValue glob = fsOption(optionMap, "glob");
+    VMValue follow = fsOption(optionMap, "followLinks");
+    VMValue threads = fsOption(optionMap, "threads");
+    if ((!glob.isNil() && !glob.isString()) || (!follow.isNil() && !follow.isBool()) ||
+        (!threads.isNil() && (!threads.isNumber() || !(threads.asNumber() >= 0))))
+        return nullptr;
+    if (glob.isString())
+        options.glob = glob.asString()->flatten();
+    options.followLinks = follow.isBool() && follow.asBool();
+    if (threads.isNumber())
+        options.threads = static_cast<unsigned>(std::min<double>(threads.asNumber(), Walk::kMaxThreads));
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec))
+        return makeResultErr(currentVM, "Not a directory: " + root);
+    auto instance = new ObjInstance(currentVM->globals["FSWalk"].asClass());
+    instance->nativeData = new Walk::Walker(root, std::move(options));
+    instance->freeFn = freeWalker;
+    return makeResultOk(currentVM, instance);
+}
+
+static VMValue entryValue(Walk::Entry &entry) {
+    auto map = new ObjMap();
+    map->values[VMValue(std::string("path"))] = std::move(entry.path);
+    map->values[VMValue(std::string("type"))] = std::string(Walk::typeName(entry.type));
+    return map;
+}
+
+// next(): {"path", "type"} or nil once the walk is done
+static VMValue walkNext(int argCount, VMValue *args) {
+    (void)argCount;
+    Walk::Walker *walker = unwrapWalker(args[-1]);
+    Walk::Entry entry;
+    if (!walker || !walker->next(entry))
+        return nullptr;
+    return entryValue(entry);
+}
+
+static VMValue walkReadAll(int argCount, VMValue *args) {
+    (void)argCount;
+    Walk::Walker *walker = unwrapWalker(args[-1]);
+    if (!walker)
+        return nullptr;
+    auto entries = new ObjList(std::vector<VMValue>{});
+    Walk::Entry entry;
+    while (walker->next(entry))
+        entries->elements.push_back(entryValue(entry));
+    return entries;
+}
+
+// close(): stops the workers; entries not yet taken are dropped
+static VMValue walkClose(int argCount, VMValue *args) {
+    (void)argCount;
+    Walk::Walker *walker = unwrapWalker(args[-1]);
+    if (!walker)
+        return nullptr;
+    walker->cancel();
+    return makeResultOk(currentVM, true);
+}
+
+// --- FS: change notifications ---
+
+// A watcher and its undelivered events. nextAsync parks a POLL op on the
+// inotify descriptor in the async I/O engine, so waiting costs nothing
+// until the kernel has something to say.
+struct WatchData {
+    Watch::Watcher watcher;
+    std::deque<Watch::Event> queued;
+    AsyncIO::Op poll;
+    bool polling = false;
+    ObjPromise *waiting = nullptr;
+    // Closed, or collected by the GC, while the poll was in flight; the
+    // poll completes once the watches are gone and finishes the job
+    bool closing = false;
+    bool released = false;
+};
+
+static void freeWatcher(void *ptr) {
+    WatchData *data = static_cast<WatchData *>(ptr);
+    if (data->polling) {
+        data->released = true;
+        data->watcher.removeAll();
+    } else {
+        delete data;
+    }
+}
+
+static WatchData *unwrapWatcher(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeWatcher)
+        return nullptr;
+    return static_cast<WatchData *>(value.asInstance()->nativeData);
+}
+
+// timeoutMs as the optional only argument; waiting forever by default
+static bool timeoutArg(int argCount, VMValue *args, int &timeoutMs) {
+    timeoutMs = -1;
+    if (argCount == 0)
+        return true;
+    if (argCount != 1 || !args[0].isNumber())
+        return false;
+    if (args[0].asNumber() >= 0)
+        timeoutMs = static_cast<int>(args[0].asNumber());
+    return true;
+}
+
+static VMValue eventValue(Watch::Event &event) {
+    auto map = new ObjMap();
+    map->values[VMValue(std::string("path"))] = std::move(event.path);
+    map->values[VMValue(std::string("kind"))] = std::string(Watch::kindName(event.kind));
+    map->values[VMValue(std::string("dir"))] = event.dir;
+    return map;
+}
+
+static VMValue takeEvents(WatchData *data) {
+    auto events = new ObjList(std::vector<VMValue>{});
+    for (Watch::Event &event : data->queued)
+        events->elements.push_back(eventValue(event));
+    data->queued.clear();
+    return events;
+}
+
+static void startPoll(VM *vm, WatchData *data) {
+    data->poll = AsyncIO::Op();
+    data->poll.kind = AsyncIO::Op::Kind::POLL;
+    data->poll.fd = data->watcher.fd();
+    data->poll.owner = data;
+    data->polling = true;
+    vm->pollIO = pollIO;
+    AsyncIO::Engine::current().submit({&data->poll});
+}
+
+static void watchReady(VM *vm, WatchData *data) {
+    data->polling = false;
+    ObjPromise *promise = data->waiting;
+    if (data->released) {
+        vm->pendingIO.erase(promise);
+        PromiseModule::settle(vm, promise, nullptr);
+        delete data;
+        return;
+    }
+    if (data->closing) {
+        data->watcher.close();
+        data->queued.clear();
+    } else {
+        data->watcher.drain(data->queued);
+        // Everything merged away (a file came and went): keep waiting
+        if (data->queued.empty() && data->watcher.watching()) {
+            startPoll(vm, data);
+            return;
+        }
+    }
+    data->waiting = nullptr;
+    vm->pendingIO.erase(promise);
+    PromiseModule::settle(vm, promise, data->queued.empty() ? VMValue(nullptr) : takeEvents(data));
+}
+
+// watch(paths, recursive = false): an FSWatcher for a path or a list of
+// them. Directories report changes to their entries; files are tracked
+// by name, so atomic replacement by rename is seen.
+static VMValue fsWatch(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || (argCount == 2 && !args[1].isBool()))
+        return nullptr;
+    std::vector<std::string> paths;
+    if (args[0].isString()) {
+        paths.push_back(args[0].asString()->flatten());
+    } else if (args[0].isList()) {
+        for (VMValue path : args[0].asList()->elements) {
+            if (!path.isString())
+                return nullptr;
+            paths.push_back(path.asString()->flatten());
+        }
+    } else {
+        return nullptr;
+    }
+    bool recursive = argCount == 2 && args[1].asBool();
+
+    auto data = std::make_unique<WatchData>();
+    if (int error = data->watcher.open())
+        return makeResultErr(currentVM, std::string("Cannot watch files: ") + strerror(error));
+    for (const std::string &path : paths)
+        if (int error = data->watcher.add(path, recursive))
+            return makeResultErr(currentVM, "Cannot watch " + path + ": " + strerror(error));
+
+    auto instance = new ObjInstance(currentVM->globals["FSWatcher"].asClass());
+    instance->nativeData = data.release();
+    instance->freeFn = freeWatcher;
+    return makeResultOk(currentVM, instance);
+}
+
+// next(timeoutMs?): the next {"path", "kind", "dir"} event, or nil on
+// timeout or once nothing is left to watch
+static VMValue watcherNext(int argCount, VMValue *args) {
+    WatchData *data = unwrapWatcher(args[-1]);
+    int timeoutMs;
+    if (!data || !timeoutArg(argCount, args, timeoutMs))
+        return nullptr;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (data->queued.empty() && data->watcher.watching() && !data->closing) {
+        int waitMs = -1;
+        if (timeoutMs >= 0) {
+            auto left =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+                break;
+            waitMs = static_cast<int>(left.count());
+        }
+        if (!data->watcher.wait(waitMs))
+            break;
+        data->watcher.drain(data->queued);
+    }
+    if (data->queued.empty() || data->closing)
+        return nullptr;
+    VMValue event = eventValue(data->queued.front());
+    data->queued.pop_front();
+    return event;
+}
+
+// nextAsync(): Promise of the list of events that arrived together, or
+// of nil once closed. A pending call keeps the program running.
+static VMValue watcherNextAsync(int argCount, VMValue *args) {
+    (void)argCount;
+    WatchData *data = unwrapWatcher(args[-1]);
+    if (!data)
+        return nullptr;
+    if (data->waiting)
+        return data->waiting;
+    VM *vm = currentVM;
+    auto promise = new ObjPromise();
+    if (!data->closing)
+        data->watcher.drain(data->queued);
+    if (!data->queued.empty() || !data->watcher.watching() || data->closing) {
+        PromiseModule::settle(vm, promise, data->queued.empty() ? VMValue(nullptr) : takeEvents(data));
+        return promise;
+    }
+    data->waiting = promise;
+    vm->pendingIO.insert(promise);
+    startPoll(vm, data);
+    return promise;
+}
+
+// close(): removes the watches; a pending nextAsync settles with nil
+static VMValue watcherClose(int argCount, VMValue *args) {
+    (void)argCount;
+    WatchData *data = unwrapWatcher(args[-1]);
+    if (!data)
+        return nullptr;
+    data->queued.clear();
+    if (data->polling) {
+        data->closing = true;
+        data->watcher.removeAll();
+    } else {
+        data->watcher.close();
+    }
+    return makeResultOk(currentVM, true);
+}
+
+static void freeFollower(void *ptr) {
+    delete static_cast<Watch::Follower *>(ptr);
+}
+
+static Watch::Follower *unwrapFollower(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeFollower)
+        return nullptr;
+    return static_cast<Watch::Follower *>(value.asInstance()->nativeData);
+}
+
+// follow(path, fromStart = false): an FSFollower yielding lines appended
+// to `path` like `tail -F`. The file may not exist yet.
+static VMValue fsFollow(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 2 || !args[0].isString() || (argCount == 2 && !args[1].isBool()))
+        return nullptr;
+    std::string path = args[0].asString()->flatten();
+    auto follower = std::make_unique<Watch::Follower>(path, argCount == 2 && args[1].asBool());
+    if (int error = follower->open())
+        return makeResultErr(currentVM, "Cannot follow " + path + ": " + strerror(error));
+    auto instance = new ObjInstance(currentVM->globals["FSFollower"].asClass());
+    instance->nativeData = follower.release();
+    instance->freeFn = freeFollower;
+    return makeResultOk(currentVM, instance);
+}
+
+// next(timeoutMs?): the next complete line, or nil on timeout
+static VMValue followerNext(int argCount, VMValue *args) {
+    Watch::Follower *follower = unwrapFollower(args[-1]);
+    int timeoutMs;
+    if (!follower || !timeoutArg(argCount, args, timeoutMs))
+        return nullptr;
+    std::string line;
+    if (!follower->next(line, timeoutMs))
+        return nullptr;
+    return line;
+}
+
+static VMValue followerClose(int argCount, VMValue *args) {
+    (void)argCount;
+    Watch::Follower *follower = unwrapFollower(args[-1]);
+    if (!follower)
+        return nullptr;
+    follower->close();
+    return makeResultOk(currentVM, true);
+}
+
 static VMValue fileExists(int argCount, VMValue *args) {
     if (argCount != 1 || !args[0].isString())
         return false;
@@ -120,12 +785,45 @@ void registerAll(VM *vm) {
     fileClass->statics["open"] = new ObjNative("open", -1, fileOpen);
     fileClass->statics["exists"] = new ObjNative("exists", 1, fileExists);
     fileClass->statics["remove"] = new ObjNative("remove", 1, fileRemove);
+    fileClass->statics["readAsync"] = new ObjNative("readAsync", 1, fileReadAsync);
+    fileClass->statics["readManyAsync"] = new ObjNative("readManyAsync", 1, fileReadManyAsync);
+    fileClass->statics["readAtAsync"] = new ObjNative("readAtAsync", 3, fileReadAtAsync);
+    fileClass->statics["writeAsync"] = new ObjNative("writeAsync", 2, fileWriteAsync);
+    fileClass->statics["fsyncAsync"] = new ObjNative("fsyncAsync", 1, fileFsyncAsync);
+    fileClass->statics["await"] = new ObjNative("await", 1, fileAwait);
+    fileClass->statics["asyncBackend"] = new ObjNative("asyncBackend", 0, fileAsyncBackend);
 
     fileClass->methods["read"] = new ObjNative("read", 0, fileRead);
     fileClass->methods["write"] = new ObjNative("write", 1, fileWrite);
     fileClass->methods["close"] = new ObjNative("close", 0, fileClose);
+    fileClass->methods["copyTo"] = new ObjNative("copyTo", -1, fileCopyTo);
 
     vm->globals["File"] = fileClass;
+
+    auto fsClass = new ObjClass("FS");
+    fsClass->statics["list"] = new ObjNative("list", 1, fsList);
+    fsClass->statics["stat"] = new ObjNative("stat", -1, fsStat);
+    fsClass->statics["walk"] = new ObjNative("walk", -1, fsWalk);
+    fsClass->statics["watch"] = new ObjNative("watch", -1, fsWatch);
+    fsClass->statics["follow"] = new ObjNative("follow", -1, fsFollow);
+    vm->globals["FS"] = fsClass;
+
+    auto walkClass = new ObjClass("FSWalk");
+    walkClass->methods["next"] = new ObjNative("next", 0, walkNext);
+    walkClass->methods["readAll"] = new ObjNative("readAll", 0, walkReadAll);
+    walkClass->methods["close"] = new ObjNative("close", 0, walkClose);
+    vm->globals["FSWalk"] = walkClass;
+
+    auto watcherClass = new ObjClass("FSWatcher");
+    watcherClass->methods["next"] = new ObjNative("next", -1, watcherNext);
+    watcherClass->methods["nextAsync"] = new ObjNative("nextAsync", 0, watcherNextAsync);
+    watcherClass->methods["close"] = new ObjNative("close", 0, watcherClose);
+    vm->globals["FSWatcher"] = watcherClass;
+
+    auto followerClass = new ObjClass("FSFollower");
+    followerClass->methods["next"] = new ObjNative("next", -1, followerNext);
+    followerClass->methods["close"] = new ObjNative("close", 0, followerClose);
+    vm->globals["FSFollower"] = followerClass;
 }
 
 void registerSymbols(SymbolTable *scope) {
@@ -134,6 +832,14 @@ void registerSymbols(SymbolTable *scope) {
     sym.type = "class";
     sym.isConst = true;
     scope->define(sym);
+    sym.name = "FS";
+    scope->define(sym);
+    sym.name = "FSWalk";
+    scope->define(sym);
+    sym.name = "FSWatcher";
+    scope->define(sym);
+    sym.name = "FSFollower";
+    scope->define(sym);
 }
 
 } // namespace FS
@@ -3,9 +3,17 @@
 
 #include "../../symbol/SymbolTable.h"
 #include "../../vm/VM.h"
+#include <string>
+#include <string_view>
 
 namespace StdLib {
 namespace FS {
+// Writes `data` to a File instance; false if `file` is not an open File.
+bool writeToFile(VMValue file, std::string_view data);
+// Path of an open File instance, with its pending writes flushed; false
+// if `file` is not an open File.
+bool filePath(VMValue file, std::string &path);
+
 void registerAll(VM *vm);
 void registerSymbols(SymbolTable *scope);
 } // namespace FS
@@ -0,0 +1,446 @@
+#include "Walk.h"
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace StdLib {
+namespace Walk {
+
+// Entries handed to the consumer at a time, and how many may wait
+constexpr size_t kBatch = 256;
+constexpr size_t kMaxQueued = 8192;
+
+const char *typeName(EntryType type) {
+    switch (type) {
+    case EntryType::FILE:
+        return "file";
+    case EntryType::DIR:
+        return "dir";
+    case EntryType::LINK:
+        return "link";
+    default:
+        return "other";
+    }
+}
+
+#ifdef __linux__
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static EntryType typeFromMode(mode_t mode) {
+    if (S_ISREG(mode))
+        return EntryType::FILE;
+    if (S_ISDIR(mode))
+        return EntryType::DIR;
+    if (S_ISLNK(mode))
+        return EntryType::LINK;
+    return EntryType::OTHER;
+}
+
+// getdents64 hands back many entries per syscall with their types, so
+// most trees need no stat at all
+static int readDirectoryFd(int fd, std::vector<DirEntry> &entries) {
+    alignas(LinuxDirent64) char buffer[64 * 1024];
+    while (true) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return errno;
+        if (n == 0)
+            return 0;
+        for (long pos = 0; pos < n;) {
+            auto *d = reinterpret_cast<LinuxDirent64 *>(buffer + pos);
+            pos += d->d_reclen;
+            const char *name = d->d_name;
+            if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+                continue;
+            EntryType type;
+            switch (d->d_type) {
+            case DT_REG:
+                type = EntryType::FILE;
+                break;
+            case DT_DIR:
+                type = EntryType::DIR;
+                break;
+            case DT_LNK:
+                type = EntryType::LINK;
+                break;
+            case DT_UNKNOWN: {
+                // Some filesystems leave the type out
+                struct stat st;
+                type = fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 ? typeFromMode(st.st_mode) : EntryType::OTHER;
+                break;
+            }
+            default:
+                type = EntryType::OTHER;
+            }
+            entries.push_back({name, type});
+        }
+    }
+}
+#endif
+
+int readDirectory(const std::string &path, std::vector<DirEntry> &entries) {
+#ifdef __linux__
+    int fd = openat(AT_FDCWD, path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+    int error = readDirectoryFd(fd, entries);
+    close(fd);
+    return error;
+#else
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+        auto status = it->symlink_status(ec);
+        EntryType type = std::filesystem::is_regular_file(status) ? EntryType::FILE
+                         : std::filesystem::is_directory(status) ? EntryType::DIR
+                         : std::filesystem::is_symlink(status)   ? EntryType::LINK
+                                                                 : EntryType::OTHER;
+        entries.push_back({it->path().filename().string(), type});
+    }
+    return ec ? ec.value() : 0;
+#endif
+}
+
+// --- Glob ---
+
+static void expandBraces(const std::string &pattern, std::vector<std::string> &out) {
+    size_t open = std::string::npos;
+    int depth = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] == '\\') {
+            i++;
+        } else if (pattern[i] == '{') {
+            if (depth++ == 0)
+                open = i;
+        } else if (pattern[i] == '}' && depth > 0 && --depth == 0) {
+            std::vector<std::string> options;
+            size_t start = open + 1;
+            int inner = 0;
+            for (size_t j = open + 1; j < i; j++) {
+                if (pattern[j] == '\\')
+                    j++;
+                else if (pattern[j] == '{')
+                    inner++;
+                else if (pattern[j] == '}')
+                    inner--;
+                else if (pattern[j] == ',' && inner == 0) {
+                    options.push_back(pattern.substr(start, j - start));
+                    start = j + 1;
+                }
+            }
+            options.push_back(pattern.substr(start, i - start));
+            std::string head = pattern.substr(0, open);
+            std::string tail = pattern.substr(i + 1);
+            for (const std::string &option : options)
+                expandBraces(head + option + tail, out);
+            return;
+        }
+    }
+    out.push_back(pattern);
+}
+
+static std::vector<std::string_view> segments(std::string_view path) {
+    std::vector<std::string_view> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string_view::npos)
+            slash = path.size();
+        if (slash > start)
+            parts.push_back(path.substr(start, slash - start));
+        start = slash + 1;
+    }
+    return parts;
+}
+
+static bool matchClass(std::string_view pattern, size_t &p, char c) {
+    size_t i = p + 1;
+    bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    if (negate)
+        i++;
+    bool found = false;
+    bool first = true;
+    for (; i < pattern.size() && (first || pattern[i] != ']'); first = false) {
+        char lo = pattern[i];
+        char hi = lo;
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            hi = pattern[i + 2];
+            i += 3;
+        } else {
+            i++;
+        }
+        if (c >= lo && c <= hi)
+            found = true;
+    }
+    p = i + 1;
+    return found != negate;
+}
+
+// One path segment against one pattern segment; `*` backtracks to the
+// last star only, which is enough without '/' inside segments
+static bool matchSegment(std::string_view pattern, std::string_view name) {
+    size_t p = 0, n = 0;
+    size_t starP = std::string_view::npos, starN = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            starP = ++p;
+            starN = n;
+            continue;
+        }
+        if (p < pattern.size()) {
+            size_t next = p;
+            bool ok;
+            if (pattern[p] == '?') {
+                ok = true;
+                next = p + 1;
+            } else if (pattern[p] == '[' && pattern.find(']', p + 2) != std::string_view::npos) {
+                ok = matchClass(pattern, next, name[n]);
+            } else {
+                if (pattern[p] == '\\' && p + 1 < pattern.size())
+                    p++;
+                ok = pattern[p] == name[n];
+                next = p + 1;
+            }
+            if (ok) {
+                p = next;
+                n++;
+                continue;
+            }
+        }
+        if (starP == std::string_view::npos)
+            return false;
+        p = starP;
+        n = ++starN;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+static bool matchFrom(const std::vector<std::string> &pattern, size_t p, const std::vector<std::string_view> &path,
+                      size_t s) {
+    if (p == pattern.size())
+        return s == path.size();
+    if (pattern[p] == "**") {
+        for (size_t k = s; k <= path.size(); k++)
+            if (matchFrom(pattern, p + 1, path, k))
+                return true;
+        return false;
+    }
+    return s < path.size() && matchSegment(pattern[p], path[s]) && matchFrom(pattern, p + 1, path, s + 1);
+}
+
+static bool prefixFrom(const std::vector<std::string> &pattern, size_t p, const std::vector<std::string_view> &dir,
+                       size_t s) {
+    if (s == dir.size())
+        return p < pattern.size();
+    if (p == pattern.size())
+        return false;
+    if (pattern[p] == "**")
+        return true;
+    return matchSegment(pattern[p], dir[s]) && prefixFrom(pattern, p + 1, dir, s + 1);
+}
+
+Glob::Glob(std::string_view pattern) {
+    if (pattern.empty())
+        return;
+    std::vector<std::string> expanded;
+    expandBraces(std::string(pattern), expanded);
+    for (const std::string &alternative : expanded) {
+        std::vector<std::string> parts;
+        for (std::string_view part : segments(alternative))
+            parts.emplace_back(part);
+        alternatives.push_back(std::move(parts));
+    }
+}
+
+bool Glob::matches(std::string_view path) const {
+    if (alternatives.empty())
+        return true;
+    auto parts = segments(path);
+    for (const auto &pattern : alternatives)
+        if (matchFrom(pattern, 0, parts, 0))
+            return true;
+    return false;
+}
+
+bool Glob::mayContain(std::string_view path) const {
+    if (alternatives.empty())
+        return true;
+    auto parts = segments(path);
+    for (const auto &pattern : alternatives)
+        if (prefixFrom(pattern, 0, parts, 0))
+            return true;
+    return false;
+}
+
+void splitGlob(const std::string &pattern, std::string &base, std::string &glob) {
+    size_t wildcard = pattern.find_first_of("*?[{");
+    if (wildcard == std::string::npos) {
+        base = pattern;
+        glob.clear();
+        return;
+    }
+    size_t slash = pattern.rfind('/', wildcard);
+    if (slash == std::string::npos) {
+        base = ".";
+        glob = pattern;
+    } else {
+        base = slash == 0 ? "/" : pattern.substr(0, slash);
+        glob = pattern.substr(slash + 1);
+    }
+}
+
+// --- Walker ---
+
+Walker::Walker(std::string rootPath, WalkOptions walkOptions)
+    : root(std::move(rootPath)), options(std::move(walkOptions)), glob(options.glob) {
+    if (root.empty())
+        root = ".";
+    prefix = root.back() == '/' ? root : root + "/";
+    unsigned count = options.threads;
+    if (count == 0)
+        count = std::thread::hardware_concurrency();
+    count = std::clamp(count, 1u, kMaxThreads);
+    if (options.followLinks)
+        firstVisit(root);
+    pendingDirs.push_back("");
+    outstanding = 1;
+    for (unsigned i = 0; i < count; i++)
+        threads.emplace_back([this] { work(); });
+}
+
+Walker::~Walker() {
+    cancel();
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+void Walker::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    workReady.notify_all();
+    outputReady.notify_all();
+    outputSpace.notify_all();
+}
+
+bool Walker::next(Entry &entry) {
+    std::unique_lock<std::mutex> lock(mutex);
+    outputReady.wait(lock, [this] { return !output.empty() || outstanding == 0 || stopped; });
+    if (output.empty() || stopped)
+        return false;
+    entry = std::move(output.front());
+    output.pop_front();
+    if (output.size() + kBatch <= kMaxQueued)
+        outputSpace.notify_one();
+    return true;
+}
+
+// Symlinked directories can loop back on themselves; enter each once
+bool Walker::firstVisit(const std::string &path) {
+#ifdef __linux__
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    return visited.insert({(uint64_t)st.st_dev, (uint64_t)st.st_ino}).second;
+#else
+    std::error_code ec;
+    auto canonical = std::filesystem::canonical(path, ec).string();
+    if (ec)
+        return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    return visited.insert({std::hash<std::string>()(canonical), 0}).second;
+#endif
+}
+
+void Walker::publish(std::vector<Entry> &batch) {
+    if (batch.empty())
+        return;
+    std::unique_lock<std::mutex> lock(mutex);
+    outputSpace.wait(lock, [this] { return stopped || output.size() < kMaxQueued; });
+    for (Entry &entry : batch)
+        output.push_back(std::move(entry));
+    batch.clear();
+    outputReady.notify_one();
+}
+
+void Walker::scan(const std::string &relDir, std::vector<Entry> &batch, std::vector<std::string> &subdirs) {
+    std::vector<DirEntry> entries;
+    std::string dirPath = relDir.empty() ? root : prefix + relDir;
+    if (readDirectory(dirPath, entries) != 0)
+        return;
+    for (DirEntry &dirEntry : entries) {
+        std::string rel = relDir.empty() ? dirEntry.name : relDir + "/" + dirEntry.name;
+        EntryType type = dirEntry.type;
+        if (type == EntryType::LINK && options.followLinks) {
+            std::error_code ec;
+            auto status = std::filesystem::status(prefix + rel, ec);
+            if (!ec)
+                type = std::filesystem::is_directory(status) ? EntryType::DIR
+                       : std::filesystem::is_regular_file(status) ? EntryType::FILE
+                                                                  : EntryType::OTHER;
+        }
+        // With links followed, one directory can be reached by several paths
+        if (type == EntryType::DIR && options.followLinks && !firstVisit(prefix + rel))
+            continue;
+        if (type == EntryType::DIR && glob.mayContain(rel))
+            subdirs.push_back(rel);
+        if (glob.matches(rel)) {
+            batch.push_back({prefix + rel, type});
+            if (batch.size() >= kBatch)
+                publish(batch);
+        }
+    }
+}
+
+void Walker::work() {
+    std::vector<Entry> batch;
+    std::vector<std::string> subdirs;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workReady.wait(lock, [this] { return stopped || !pendingDirs.empty() || outstanding == 0; });
+        if (stopped || (pendingDirs.empty() && outstanding == 0))
+            return;
+        std::string dir = std::move(pendingDirs.front());
+        pendingDirs.pop_front();
+        lock.unlock();
+
+        scan(dir, batch, subdirs);
+        publish(batch);
+
+        lock.lock();
+        // Depth-first keeps the queue short on wide trees
+        for (auto it = subdirs.rbegin(); it != subdirs.rend(); ++it)
+            pendingDirs.push_front(std::move(*it));
+        outstanding += subdirs.size();
+        subdirs.clear();
+        if (--outstanding == 0) {
+            workReady.notify_all();
+            outputReady.notify_all();
+        } else if (!pendingDirs.empty()) {
+            workReady.notify_all();
+        }
+    }
+}
+
+} // namespace Walk
+} // namespace StdLib
@@ -0,0 +1,112 @@
+#ifndef TRYPILLIA_NATIVE_WALK_H
+#define TRYPILLIA_NATIVE_WALK_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Directory scanning shared by the FS script class and trypillia-test.
+// Pure C++: no VM types, so it can run on background threads.
+namespace StdLib {
+namespace Walk {
+
+enum class EntryType { FILE, DIR, LINK, OTHER };
+
+const char *typeName(EntryType type);
+
+struct DirEntry {
+    std::string name;
+    EntryType type;
+};
+
+// Reads one directory (without "." and ".."). Returns 0 or an errno value.
+int readDirectory(const std::string &path, std::vector<DirEntry> &entries);
+
+// Shell-style pattern over '/'-separated relative paths: `*` and `?`
+// within a segment, `[a-z]`/`[!a-z]` classes, `{a,b}` alternatives and
+// `**` for any number of directories. An empty pattern matches anything.
+class Glob {
+  public:
+    explicit Glob(std::string_view pattern = "");
+    bool matches(std::string_view path) const;
+    // Whether anything below directory `path` could match, so walks can
+    // skip subtrees the pattern never reaches.
+    bool mayContain(std::string_view path) const;
+    bool empty() const {
+        return alternatives.empty();
+    }
+
+  private:
+    std::vector<std::vector<std::string>> alternatives;
+};
+
+// Splits "src/**/*.cpp" into the literal directory "src" and the glob
+// "**/*.cpp"; patterns without wildcards keep an empty glob.
+void splitGlob(const std::string &pattern, std::string &base, std::string &glob);
+
+// Most worker threads a Walker starts
+constexpr unsigned kMaxThreads = 8;
+
+struct WalkOptions {
+    std::string glob;
+    bool followLinks = false;
+    // Worker threads, at most kMaxThreads; 0 picks one per core
+    unsigned threads = 0;
+};
+
+struct Entry {
+    std::string path;
+    EntryType type;
+};
+
+// Recursive listing of `root` produced by a pool of threads. Entries come
+// out in no particular order through next(), which blocks until one is
+// ready; workers pause once enough are queued, so huge trees stream in
+// bounded memory. Unreadable directories are skipped.
+class Walker {
+  public:
+    Walker(std::string root, WalkOptions options);
+    ~Walker();
+    Walker(const Walker &) = delete;
+    Walker &operator=(const Walker &) = delete;
+
+    bool next(Entry &entry);
+    // Stops the workers; next() then reports the end
+    void cancel();
+
+  private:
+    void work();
+    void scan(const std::string &relDir, std::vector<Entry> &batch, std::vector<std::string> &subdirs);
+    void publish(std::vector<Entry> &batch);
+    bool firstVisit(const std::string &path);
+
+    std::string root;
+    std::string prefix;
+    WalkOptions options;
+    Glob glob;
+
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable outputReady;
+    std::condition_variable outputSpace;
+    std::deque<std::string> pendingDirs;
+    std::deque<Entry> output;
+    // Directories queued or being scanned; the walk ends when it hits 0
+    size_t outstanding = 0;
+    bool stopped = false;
+    // Directories already entered, by (device, inode), when following links
+    std::set<std::pair<uint64_t, uint64_t>> visited;
+    std::vector<std::thread> threads;
+};
+
+} // namespace Walk
+} // namespace StdLib
+
+#endif
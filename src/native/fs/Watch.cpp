@@ -0,0 +1,427 @@
+#include "Watch.h"
+#include "Walk.h"
+#include <cerrno>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace StdLib {
+namespace Watch {
+
+constexpr size_t kReadChunk = 64 * 1024;
+
+const char *kindName(Event::Kind kind) {
+    switch (kind) {
+    case Event::Kind::CREATE:
+        return "create";
+    case Event::Kind::MODIFY:
+        return "modify";
+    case Event::Kind::DELETE:
+        return "delete";
+    default:
+        return "overflow";
+    }
+}
+
+static std::string trimSlash(std::string path) {
+    while (path.size() > 1 && path.back() == '/')
+        path.pop_back();
+    return path;
+}
+
+// An empty directory stands for the working directory, so names given
+// without one are reported back the same way
+static std::string join(const std::string &dir, const std::string &name) {
+    if (dir.empty())
+        return name;
+    return dir == "/" ? "/" + name : dir + "/" + name;
+}
+
+// Merges events for the same path, keeping the order paths first showed
+// up in: writes after a create stay a create, a delete followed by a
+// create (an editor replacing the file) is a modify, and something
+// created and deleted before anyone looked is dropped
+static void coalesce(std::deque<Event> &events) {
+    std::vector<Event> merged;
+    std::vector<bool> dropped;
+    std::unordered_map<std::string, size_t> index;
+    for (Event &event : events) {
+        auto it = event.kind == Event::Kind::OVERFLOW ? index.end() : index.find(event.path);
+        if (it == index.end()) {
+            if (event.kind != Event::Kind::OVERFLOW)
+                index.emplace(event.path, merged.size());
+            merged.push_back(std::move(event));
+            dropped.push_back(false);
+            continue;
+        }
+        Event &previous = merged[it->second];
+        if (previous.kind == Event::Kind::CREATE && event.kind == Event::Kind::DELETE) {
+            dropped[it->second] = true;
+            index.erase(it);
+            continue;
+        }
+        if (previous.kind == Event::Kind::CREATE)
+            event.kind = Event::Kind::CREATE;
+        else if (previous.kind == Event::Kind::DELETE && event.kind == Event::Kind::CREATE)
+            event.kind = Event::Kind::MODIFY;
+        previous.kind = event.kind;
+        previous.dir = event.dir;
+    }
+    events.clear();
+    for (size_t i = 0; i < merged.size(); i++)
+        if (!dropped[i])
+            events.push_back(std::move(merged[i]));
+}
+
+// --- Watcher ---
+
+#ifdef __linux__
+constexpr uint32_t kMask = IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |
+                           IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+Watcher::~Watcher() {
+    close();
+}
+
+int Watcher::open() {
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    return inotifyFd < 0 ? errno : 0;
+#else
+    return ENOSYS;
+#endif
+}
+
+int Watcher::watchDir(const std::string &dir, Target target) {
+#ifdef __linux__
+    int wd = inotify_add_watch(inotifyFd, dir.empty() ? "." : dir.c_str(), kMask);
+    if (wd < 0)
+        return errno;
+    auto [it, added] = targets.emplace(wd, target);
+    if (!added) {
+        // The kernel hands out one descriptor per directory, so watching
+        // it again widens what the existing target reports
+        Target &existing = it->second;
+        existing.all = existing.all || target.all;
+        existing.names.insert(target.names.begin(), target.names.end());
+        existing.recursive = existing.recursive || target.recursive;
+        existing.root = existing.root || target.root;
+    }
+    return 0;
+#else
+    (void)dir;
+    (void)target;
+    return ENOSYS;
+#endif
+}
+
+// Watches `dir` and every directory below it. Directories created while
+// the watches go in may be missed, as with any inotify tree watch.
+int Watcher::addTree(const std::string &dir, bool root, std::deque<Event> *found) {
+    Target target;
+    target.dir = dir;
+    target.all = true;
+    target.recursive = true;
+    target.root = root;
+    if (int error = watchDir(dir, target))
+        return error;
+    Walk::WalkOptions options;
+    // Trees appearing under a watch are usually small; keep that scan cheap
+    options.threads = found ? 1 : 0;
+    Walk::Walker walker(dir, options);
+    Walk::Entry entry;
+    while (walker.next(entry)) {
+        bool isDir = entry.type == Walk::EntryType::DIR;
+        if (found)
+            found->push_back({Event::Kind::CREATE, entry.path, isDir});
+        if (isDir) {
+            Target sub = target;
+            sub.dir = entry.path;
+            sub.root = false;
+            // It may be gone again already; nothing to watch then
+            watchDir(entry.path, sub);
+        }
+    }
+    return 0;
+}
+
+int Watcher::add(const std::string &path, bool recursive) {
+#ifdef __linux__
+    if (inotifyFd < 0)
+        return EBADF;
+    std::string clean = trimSlash(path);
+    struct stat st;
+    if (stat(clean.c_str(), &st) != 0)
+        return errno;
+    if (!S_ISDIR(st.st_mode))
+        return addName(clean);
+    if (recursive)
+        return addTree(clean, true, nullptr);
+    Target target;
+    target.dir = clean;
+    target.all = true;
+    target.root = true;
+    return watchDir(clean, target);
+#else
+    (void)path;
+    (void)recursive;
+    return ENOSYS;
+#endif
+}
+
+int Watcher::addName(const std::string &path) {
+    if (inotifyFd < 0)
+        return EBADF;
+    std::string clean = trimSlash(path);
+    size_t slash = clean.rfind('/');
+    Target target;
+    if (slash != std::string::npos)
+        target.dir = slash == 0 ? "/" : clean.substr(0, slash);
+    target.names.insert(slash == std::string::npos ? clean : clean.substr(slash + 1));
+    return watchDir(target.dir, target);
+}
+
+bool Watcher::wait(int timeoutMs) {
+#ifdef __linux__
+    if (inotifyFd < 0)
+        return false;
+    pollfd pfd{inotifyFd, POLLIN, 0};
+    int ready;
+    do
+        ready = poll(&pfd, 1, timeoutMs);
+    while (ready < 0 && errno == EINTR);
+    return ready > 0;
+#else
+    (void)timeoutMs;
+    return false;
+#endif
+}
+
+void Watcher::drain(std::deque<Event> &events) {
+#ifdef __linux__
+    if (inotifyFd < 0)
+        return;
+    alignas(inotify_event) char buffer[kReadChunk];
+    bool any = false;
+    while (true) {
+        ssize_t n = read(inotifyFd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        any = true;
+        for (ssize_t pos = 0; pos < n;) {
+            auto *event = reinterpret_cast<inotify_event *>(buffer + pos);
+            pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; callers should rescan what they track
+                events.push_back({Event::Kind::OVERFLOW, "", false});
+                continue;
+            }
+            auto it = targets.find(event->wd);
+            if (it == targets.end())
+                continue;
+            if (event->mask & IN_IGNORED) {
+                targets.erase(it);
+                continue;
+            }
+            const Target &target = it->second;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                if (target.root && target.all)
+                    events.push_back({Event::Kind::DELETE, target.dir, true});
+                // A moved root no longer lives at the path we report
+                if ((event->mask & IN_MOVE_SELF) && target.root) {
+                    inotify_rm_watch(inotifyFd, event->wd);
+                    targets.erase(it);
+                }
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+            std::string name = event->name;
+            if (!target.all && !target.names.count(name))
+                continue;
+            std::string path = join(target.dir, name);
+            bool isDir = event->mask & IN_ISDIR;
+            bool recursive = target.recursive;
+            Event::Kind kind = (event->mask & (IN_CREATE | IN_MOVED_TO))     ? Event::Kind::CREATE
+                               : (event->mask & (IN_DELETE | IN_MOVED_FROM)) ? Event::Kind::DELETE
+                                                                             : Event::Kind::MODIFY;
+            events.push_back({kind, path, isDir});
+            if (!isDir || !recursive)
+                continue;
+            if (event->mask & IN_MOVED_FROM) {
+                // Drop the moved subtree's watches now; if it landed inside
+                // the tree, IN_MOVED_TO watches it again under its new name
+                std::string prefix = path + "/";
+                for (auto sub = targets.begin(); sub != targets.end();) {
+                    if (sub->second.dir == path || sub->second.dir.compare(0, prefix.size(), prefix) == 0) {
+                        inotify_rm_watch(inotifyFd, sub->first);
+                        sub = targets.erase(sub);
+                    } else {
+                        ++sub;
+                    }
+                }
+            } else if (kind == Event::Kind::CREATE) {
+                addTree(path, false, &events);
+            }
+        }
+    }
+    if (any)
+        coalesce(events);
+#else
+    (void)events;
+#endif
+}
+
+void Watcher::removeAll() {
+#ifdef __linux__
+    for (auto &[wd, target] : targets)
+        inotify_rm_watch(inotifyFd, wd);
+#endif
+    targets.clear();
+}
+
+void Watcher::close() {
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        ::close(inotifyFd);
+#endif
+    inotifyFd = -1;
+    targets.clear();
+}
+
+// --- Follower ---
+
+Follower::Follower(std::string followPath, bool startAtBeginning)
+    : path(std::move(followPath)), fromStart(startAtBeginning) {}
+
+Follower::~Follower() {
+    close();
+}
+
+int Follower::open() {
+    if (int error = watcher.open())
+        return error;
+    if (int error = watcher.addName(path))
+        return error;
+    readAvailable();
+    // Whatever appears under the name from now on is new in full
+    fromStart = true;
+    return 0;
+}
+
+void Follower::split(bool flush) {
+    size_t start = 0;
+    size_t newline;
+    while ((newline = partial.find('\n', start)) != std::string::npos) {
+        lines.push_back(partial.substr(start, newline - start));
+        start = newline + 1;
+    }
+    partial.erase(0, start);
+    if (flush && !partial.empty()) {
+        lines.push_back(std::move(partial));
+        partial.clear();
+    }
+}
+
+void Follower::readToEnd() {
+#ifdef __linux__
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) < offset) {
+        // Truncated in place (copytruncate rotation): start over
+        offset = 0;
+        partial.clear();
+    }
+    char buffer[kReadChunk];
+    while (true) {
+        ssize_t n = pread(fd, buffer, sizeof(buffer), static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        offset += static_cast<uint64_t>(n);
+        partial.append(buffer, static_cast<size_t>(n));
+    }
+    split(false);
+#endif
+}
+
+void Follower::readAvailable() {
+#ifdef __linux__
+    while (true) {
+        if (fd < 0) {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return;
+            struct stat st;
+            fstat(fd, &st);
+            device = static_cast<uint64_t>(st.st_dev);
+            inode = static_cast<uint64_t>(st.st_ino);
+            offset = fromStart ? 0 : static_cast<uint64_t>(st.st_size);
+        }
+        readToEnd();
+        struct stat current;
+        bool present = stat(path.c_str(), &current) == 0;
+        if (present && static_cast<uint64_t>(current.st_dev) == device && static_cast<uint64_t>(current.st_ino) == inode)
+            return;
+        // Rotated away or removed. The old file has been read to its end,
+        // so finish its last line and move on to whatever has the name now.
+        split(true);
+        ::close(fd);
+        fd = -1;
+        if (!present)
+            return;
+    }
+#endif
+}
+
+bool Follower::next(std::string &line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!closed) {
+        if (lines.empty())
+            readAvailable();
+        if (!lines.empty()) {
+            line = std::move(lines.front());
+            lines.pop_front();
+            return true;
+        }
+        int waitMs = -1;
+        if (timeoutMs >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+                return false;
+            waitMs = static_cast<int>(left.count());
+        }
+        // The events only say that something changed; the file is the truth
+        if (watcher.wait(waitMs)) {
+            std::deque<Event> events;
+            watcher.drain(events);
+        } else {
+            return false;
+        }
+    }
+    return false;
+}
+
+void Follower::close() {
+    closed = true;
+    watcher.close();
+#ifdef __linux__
+    if (fd >= 0)
+        ::close(fd);
+#endif
+    fd = -1;
+}
+
+} // namespace Watch
+} // namespace StdLib
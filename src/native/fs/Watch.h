@@ -0,0 +1,109 @@
+#ifndef TRYPILLIA_NATIVE_WATCH_H
+#define TRYPILLIA_NATIVE_WATCH_H
+
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+// File change notifications on top of inotify. Like Walk, this is plain
+// C++ so the same descriptor can be polled from the VM or an I/O thread.
+namespace StdLib {
+namespace Watch {
+
+struct Event {
+    enum class Kind { CREATE, MODIFY, DELETE, OVERFLOW };
+    Kind kind;
+    std::string path;
+    bool dir = false;
+};
+
+const char *kindName(Event::Kind kind);
+
+class Watcher {
+  public:
+    Watcher() = default;
+    ~Watcher();
+    Watcher(const Watcher &) = delete;
+    Watcher &operator=(const Watcher &) = delete;
+
+    // Each returns 0 or an errno value (ENOSYS where inotify is missing)
+    int open();
+    // A directory (and with `recursive` everything below it) or a file
+    int add(const std::string &path, bool recursive);
+    // Just `path`, which need not exist yet. The parent directory is
+    // watched, so a file replaced by rename keeps reporting.
+    int addName(const std::string &path);
+
+    // Readable when events are waiting; -1 once closed
+    int fd() const {
+        return inotifyFd;
+    }
+    bool watching() const {
+        return !targets.empty();
+    }
+    // Blocks up to `timeoutMs` (forever if negative) for events
+    bool wait(int timeoutMs);
+    // Reads every queued event without blocking and merges them into
+    // `events`, so a burst of writes to one file becomes one MODIFY
+    void drain(std::deque<Event> &events);
+    // Drops every watch; the kernel then queues IN_IGNORED, which wakes
+    // anyone polling fd()
+    void removeAll();
+    void close();
+
+  private:
+    struct Target {
+        std::string dir;
+        // Report every entry, or only these names
+        bool all = false;
+        std::set<std::string> names;
+        bool recursive = false;
+        // Added by the caller rather than found by a recursive scan
+        bool root = false;
+    };
+
+    int watchDir(const std::string &dir, Target target);
+    int addTree(const std::string &dir, bool root, std::deque<Event> *found);
+
+    int inotifyFd = -1;
+    std::unordered_map<int, Target> targets;
+};
+
+// `tail -F`: yields lines appended to a file, reading only the new bytes.
+// Follows the name, so truncation, rotation and late creation are handled.
+class Follower {
+  public:
+    Follower(std::string path, bool fromStart);
+    ~Follower();
+    Follower(const Follower &) = delete;
+    Follower &operator=(const Follower &) = delete;
+
+    int open();
+    // The next complete line without its newline; false on timeout or
+    // once closed
+    bool next(std::string &line, int timeoutMs);
+    void close();
+
+  private:
+    void readAvailable();
+    void readToEnd();
+    void split(bool flush);
+
+    Watcher watcher;
+    std::string path;
+    bool fromStart;
+    bool closed = false;
+    int fd = -1;
+    uint64_t offset = 0;
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    std::string partial;
+    std::deque<std::string> lines;
+};
+
+} // namespace Watch
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,210 @@
+#include "Immutable.h"
+#include "../StdLib.h"
+#include <unordered_map>
+
+namespace StdLib {
+namespace ImmutableModule {
+
+static bool isFreezable(Obj *obj) {
+    return obj->type == ObjType::OBJ_LIST || obj->type == ObjType::OBJ_MAP || obj->type == ObjType::OBJ_SET ||
+           obj->type == ObjType::OBJ_INSTANCE;
+}
+
+// Marks every list, map, set and instance reachable from `root` as frozen.
+static void freezeGraph(VMValue root) {
+    std::vector<Obj *> pending;
+    auto visit = [&pending](VMValue value) {
+        if (!value.isObj())
+            return;
+        Obj *obj = value.asObj();
+        if (obj->isFrozen || !isFreezable(obj))
+            return;
+        obj->isFrozen = true;
+        pending.push_back(obj);
+    };
+
+    visit(root);
+    while (!pending.empty()) {
+        Obj *obj = pending.back();
+        pending.pop_back();
+        if (obj->type == ObjType::OBJ_LIST) {
+            for (auto &v : static_cast<ObjList *>(obj)->elements)
+                visit(v);
+        } else if (obj->type == ObjType::OBJ_MAP) {
+            for (auto &pair : static_cast<ObjMap *>(obj)->values) {
+                visit(pair.first);
+                visit(pair.second);
+            }
+        } else if (obj->type == ObjType::OBJ_SET) {
+            for (auto &v : static_cast<ObjSet *>(obj)->entries)
+                visit(v);
+        } else {
+            for (auto &pair : static_cast<ObjInstance *>(obj)->fields)
+                visit(pair.second);
+        }
+    }
+}
+
+// Objects built while this is alive are not linked into any VM heap.
+struct DetachedAllocation {
+    VM *saved;
+    DetachedAllocation() : saved(currentVM) {
+        currentVM = nullptr;
+    }
+    ~DetachedAllocation() {
+        currentVM = saved;
+    }
+};
+
+class RegionBuilder {
+  public:
+    explicit RegionBuilder(SharedRegion &region) : region(region) {
+    }
+
+    // Deep-copies plain data into the region; false for anything that
+    // cannot be shared between VMs (functions, classes, instances, ...).
+    bool copy(VMValue value, VMValue &out) {
+        if (!value.isObj()) {
+            out = value;
+            return true;
+        }
+        Obj *obj = value.asObj();
+        auto seen = copies.find(obj);
+        if (seen != copies.end()) {
+            out = seen->second;
+            return true;
+        }
+
+        switch (obj->type) {
+        case ObjType::OBJ_STRING: {
+            out = adopt(new ObjString(static_cast<ObjString *>(obj)->flatten()));
+            return true;
+        }
+        case ObjType::OBJ_LIST: {
+            auto source = static_cast<ObjList *>(obj);
+            auto list = new ObjList(std::vector<VMValue>());
+            out = adopt(list);
+            copies[obj] = out;
+            list->elements.resize(source->elements.size());
+            for (size_t i = 0; i < source->elements.size(); i++) {
+                if (!copy(source->elements[i], list->elements[i]))
+                    return false;
+            }
+            return true;
+        }
+        case ObjType::OBJ_MAP: {
+            auto source = static_cast<ObjMap *>(obj);
+            auto map = new ObjMap();
+            out = adopt(map);
+            copies[obj] = out;
+            for (auto &pair : source->values) {
+                VMValue key, val;
+                if (!copy(pair.first, key) || !copy(pair.second, val))
+                    return false;
+                map->values[key] = val;
+            }
+            return true;
+        }
+        case ObjType::OBJ_SET: {
+            auto source = static_cast<ObjSet *>(obj);
+            auto set = new ObjSet();
+            out = adopt(set);
+            copies[obj] = out;
+            set->reserve(source->size());
+            for (auto &member : source->entries) {
+                VMValue value;
+                if (!copy(member, value))
+                    return false;
+                set->insert(value);
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+  private:
+    VMValue adopt(Obj *obj) {
+        obj->isFrozen = true;
+        obj->isShared = true;
+        region.objects.push_back(obj);
+        return obj;
+    }
+
+    SharedRegion &region;
+    std::unordered_map<Obj *, VMValue> copies;
+};
+
+std::shared_ptr<SharedRegion> regionOf(VMValue value) {
+    if (!value.isObj() || !value.asObj()->isShared)
+        return nullptr;
+    auto it = currentVM->sharedRegions.find(value.asObj());
+    return it == currentVM->sharedRegions.end() ? nullptr : it->second;
+}
+
+VMValue adoptRegion(std::shared_ptr<SharedRegion> region) {
+    VMValue root = region->root;
+    if (root.isObj())
+        currentVM->sharedRegions[root.asObj()] = std::move(region);
+    return root;
+}
+
+static VMValue immutableFreeze(int argCount, VMValue *args) {
+    (void)argCount;
+    freezeGraph(args[0]);
+    return args[0];
+}
+
+static VMValue immutableIsFrozen(int argCount, VMValue *args) {
+    (void)argCount;
+    if (!args[0].isObj())
+        return true;
+    Obj *obj = args[0].asObj();
+    return obj->type == ObjType::OBJ_STRING || obj->isFrozen;
+}
+
+static VMValue immutableShare(int argCount, VMValue *args) {
+    (void)argCount;
+    if (!args[0].isObj())
+        return args[0];
+    if (regionOf(args[0]))
+        return args[0];
+
+    auto region = std::make_shared<SharedRegion>();
+    bool ok;
+    {
+        DetachedAllocation detached;
+        RegionBuilder builder(*region);
+        ok = builder.copy(args[0], region->root);
+    }
+    if (!ok)
+        return nullptr;
+    return adoptRegion(std::move(region));
+}
+
+static VMValue immutableIsShared(int argCount, VMValue *args) {
+    (void)argCount;
+    return args[0].isObj() && args[0].asObj()->isShared;
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto immutableClass = new ObjClass("Immutable");
+    immutableClass->statics["freeze"] = new ObjNative("freeze", 1, immutableFreeze);
+    immutableClass->statics["isFrozen"] = new ObjNative("isFrozen", 1, immutableIsFrozen);
+    immutableClass->statics["share"] = new ObjNative("share", 1, immutableShare);
+    immutableClass->statics["isShared"] = new ObjNative("isShared", 1, immutableIsShared);
+    vm->globals["Immutable"] = immutableClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "Immutable";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+}
+
+} // namespace ImmutableModule
+} // namespace StdLib
@@ -0,0 +1,33 @@
+#ifndef TRYPILLIA_IMMUTABLE_H
+#define TRYPILLIA_IMMUTABLE_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+#include <memory>
+#include <vector>
+
+// Deeply frozen object graph owned outside every VM heap. VMs hold it by
+// shared_ptr (VM::sharedRegions), so it is freed with the last of them.
+struct SharedRegion {
+    std::vector<Obj *> objects;
+    VMValue root;
+
+    ~SharedRegion() {
+        for (Obj *obj : objects)
+            delete obj;
+    }
+};
+
+namespace StdLib {
+namespace ImmutableModule {
+// Region whose root is `value` in the current VM, or null.
+std::shared_ptr<SharedRegion> regionOf(VMValue value);
+// Makes `region` reachable from the current VM and returns its root.
+VMValue adoptRegion(std::shared_ptr<SharedRegion> region);
+
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace ImmutableModule
+} // namespace StdLib
+
+#endif
@@ -1,114 +1,239 @@
 #include "Json.h"
+#include <algorithm>
 #include <cctype>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace StdLib {
 namespace Json {
 
-static std::string stringifyValue(const VMValue &val, int indent = -1, int currentIndent = 0) {
-    if (val.isNil())
-        return "null";
-    if (val.isBool())
-        return val.asBool() ? "true" : "false";
+struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+struct KeyEqual {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const {
+        return a == b;
+    }
+};
+
+
+// Public fields of a class with declared fields, sorted by name, plus a
+// lookup from JSON key to position. Built once per class, kept on the
+// class itself and reused by parseAs, parseListAs and stringify.
+struct FieldPlan {
+    size_t modifierCount = 0;
+    std::vector<std::string> fields;
+    std::unordered_map<std::string, size_t, KeyHash, KeyEqual> slots;
+};
+
+static void freePlan(void *ptr) {
+    delete static_cast<FieldPlan *>(ptr);
+}
+
+static bool planMatches(const FieldPlan &plan, const ObjClass *klass) {
+    if (plan.modifierCount != klass->fieldModifiers.size())
+        return false;
+    for (const auto &field : plan.fields) {
+        auto it = klass->fieldModifiers.find(field);
+        if (it == klass->fieldModifiers.end() || it->second != VMAccessModifier::PUBLIC)
+            return false;
+    }
+    return true;
+}
+
+static void buildPlan(FieldPlan &plan, const ObjClass *klass) {
+    plan = FieldPlan();
+    plan.modifierCount = klass->fieldModifiers.size();
+    for (const auto &[name, modifier] : klass->fieldModifiers) {
+        if (modifier == VMAccessModifier::PUBLIC)
+            plan.fields.push_back(name);
+    }
+    std::sort(plan.fields.begin(), plan.fields.end());
+    for (size_t i = 0; i < plan.fields.size(); i++)
+        plan.slots.emplace(plan.fields[i], i);
+}
+
+static const FieldPlan &planFor(ObjClass *klass) {
+    if (klass->freeCacheFn != freePlan) {
+        if (klass->nativeCache && klass->freeCacheFn)
+            klass->freeCacheFn(klass->nativeCache);
+        klass->nativeCache = new FieldPlan();
+        klass->freeCacheFn = freePlan;
+        buildPlan(*static_cast<FieldPlan *>(klass->nativeCache), klass);
+    }
+    FieldPlan &plan = *static_cast<FieldPlan *>(klass->nativeCache);
+    if (!planMatches(plan, klass))
+        buildPlan(plan, klass);
+    return plan;
+}
+
+static void appendQuoted(std::string &out, std::string_view s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"')
+            out += "\\\"";
+        else if (c == '\\')
+            out += "\\\\";
+        else if (c == '\n')
+            out += "\\n";
+        else if (c == '\r')
+            out += "\\r";
+        else if (c == '\t')
+            out += "\\t";
+        else if (c == '\b')
+            out += "\\b";
+        else if (c == '\f')
+            out += "\\f";
+        else
+            out += c;
+    }
+    out += '"';
+}
+
+static void appendNumber(std::string &out, double d) {
+    if (d == static_cast<double>(static_cast<long long>(d))) {
+        out += std::to_string(static_cast<long long>(d));
+        return;
+    }
+    std::stringstream ss;
+    ss << d;
+    out += ss.str();
+}
+
+static void appendIndent(std::string &out, int indent, int width) {
+    if (indent >= 0) {
+        out += '\n';
+        out.append(width, ' ');
+    }
+}
+
+// Deepest nesting parsed or written; deeper input is rejected rather
+// than recursed into, and a cycle of references hits it as well
+static const int MAX_DEPTH = 512;
+
+// Appends to `out` rather than returning pieces, so nested values do not
+// build and copy temporary strings. False when nesting exceeds MAX_DEPTH.
+static bool stringifyValue(const VMValue &val, std::string &out, int indent = -1, int currentIndent = 0,
+                           int depth = 0) {
+    if (val.isNil()) {
+        out += "null";
+        return true;
+    }
+    if (val.isBool()) {
+        out += val.asBool() ? "true" : "false";
+        return true;
+    }
     if (val.isNumber()) {
-        double d = val.asNumber();
-        if (d == static_cast<double>(static_cast<long long>(d))) {
-            return std::to_string(static_cast<long long>(d));
-        }
-        std::stringstream ss;
-        ss << d;
-        return ss.str();
+        appendNumber(out, val.asNumber());
+        return true;
     }
     if (val.isString()) {
-        std::string s = val.asString()->flatten();
-        std::string res = "\"";
-        for (char c : s) {
-            if (c == '"')
-                res += "\\\"";
-            else if (c == '\\')
-                res += "\\\\";
-            else if (c == '\n')
-                res += "\\n";
-            else if (c == '\r')
-                res += "\\r";
-            else if (c == '\t')
-                res += "\\t";
-            else if (c == '\b')
-                res += "\\b";
-            else if (c == '\f')
-                res += "\\f";
-            else
-                res += c;
-        }
-        res += "\"";
-        return res;
+        appendQuoted(out, val.asString()->flatView());
+        return true;
     }
+    if (depth > MAX_DEPTH)
+        return false;
+
+    int nextIndent = (indent >= 0) ? currentIndent + indent : 0;
+    const char *colon = (indent >= 0) ? ": " : ":";
 
-    std::string nl = (indent >= 0) ? "\n" : "";
-    std::string sp = (indent >= 0) ? " " : "";
-
-    if (val.isList()) {
-        auto list = val.asList();
-        if (list->elements.empty())
-            return "[]";
-
-        std::string res = "[" + nl;
-        int nextIndent = (indent >= 0) ? currentIndent + indent : 0;
-        std::string indentStr = (indent >= 0) ? std::string(nextIndent, ' ') : "";
-        std::string endIndentStr = (indent >= 0) ? std::string(currentIndent, ' ') : "";
-
-        for (size_t i = 0; i < list->elements.size(); ++i) {
-            res += indentStr + stringifyValue(list->elements[i], indent, nextIndent);
-            if (i < list->elements.size() - 1)
-                res += "," + nl;
-            else
-                res += nl;
+    if (val.isList() || val.isSet()) {
+        // Sets are exported as arrays in iteration order
+        const auto &elements = val.isList() ? val.asList()->elements : val.asSet()->entries;
+        if (elements.empty()) {
+            out += "[]";
+            return true;
         }
-        res += endIndentStr + "]";
-        return res;
+        out += '[';
+        for (size_t i = 0; i < elements.size(); ++i) {
+            if (i > 0)
+                out += ',';
+            appendIndent(out, indent, nextIndent);
+            if (!stringifyValue(elements[i], out, indent, nextIndent, depth + 1))
+                return false;
+        }
+        appendIndent(out, indent, currentIndent);
+        out += ']';
+        return true;
     }
     if (val.isMap()) {
         auto map = val.asMap();
-        if (map->values.empty())
-            return "{}";
-
-        std::string res = "{" + nl;
-        int nextIndent = (indent >= 0) ? currentIndent + indent : 0;
-        std::string indentStr = (indent >= 0) ? std::string(nextIndent, ' ') : "";
-        std::string endIndentStr = (indent >= 0) ? std::string(currentIndent, ' ') : "";
-
+        if (map->values.empty()) {
+            out += "{}";
+            return true;
+        }
+        out += '{';
         bool first = true;
         for (auto const &[k, v] : map->values) {
             if (!first)
-                res += "," + nl;
+                out += ',';
             first = false;
-
-            res += indentStr;
+            appendIndent(out, indent, nextIndent);
             if (k.isString()) {
-                res += stringifyValue(k, -1, 0) + ":" + sp + stringifyValue(v, indent, nextIndent);
+                appendQuoted(out, k.asString()->flatView());
             } else {
-                std::stringstream ss;
-                if (k.isNumber()) {
-                    double dk = k.asNumber();
-                    if (dk == static_cast<double>(static_cast<long long>(dk))) {
-                        ss << static_cast<long long>(dk);
-                    } else {
-                        ss << dk;
-                    }
-                } else if (k.isBool())
-                    ss << (k.asBool() ? "true" : "false");
+                out += '"';
+                if (k.isNumber())
+                    appendNumber(out, k.asNumber());
+                else if (k.isBool())
+                    out += k.asBool() ? "true" : "false";
                 else if (k.isNil())
-                    ss << "null";
-                res += "\"" + ss.str() + "\":" + sp + stringifyValue(v, indent, nextIndent);
+                    out += "null";
+                out += '"';
             }
+            out += colon;
+            if (!stringifyValue(v, out, indent, nextIndent, depth + 1))
+                return false;
         }
-        res += nl + endIndentStr + "}";
-        return res;
+        appendIndent(out, indent, currentIndent);
+        out += '}';
+        return true;
+    }
+    if (val.isInstance() && !val.asInstance()->nativeData) {
+        // Plain objects write their public declared fields in name order;
+        // classes without declarations write whatever fields they hold
+        auto instance = val.asInstance();
+        const FieldPlan &plan = planFor(instance->klass);
+        bool first = true;
+        auto writeField = [&](const std::string &name, const VMValue &value) {
+            out += first ? "{" : ",";
+            first = false;
+            appendIndent(out, indent, nextIndent);
+            appendQuoted(out, name);
+            out += colon;
+            return stringifyValue(value, out, indent, nextIndent, depth + 1);
+        };
+        if (!plan.fields.empty()) {
+            for (const auto &name : plan.fields) {
+                auto it = instance->fields.find(name);
+                if (!writeField(name, it != instance->fields.end() ? it->second : VMValue(nullptr)))
+                    return false;
+            }
+        } else if (instance->klass->fieldModifiers.empty()) {
+            for (const auto &[name, value] : instance->fields) {
+                if (!writeField(name, value))
+                    return false;
+            }
+        }
+        if (first) {
+            out += "{}";
+            return true;
+        }
+        appendIndent(out, indent, currentIndent);
+        out += '}';
+        return true;
     }
-    return "null"; // Default fallback
+    out += "null"; // Default fallback
+    return true;
 }
 
 static VMValue jsonStringify(int argCount, VMValue *args) {
@@ -118,23 +243,27 @@ static VMValue jsonStringify(int argCount, VMValue *args) {
     if (argCount == 2 && args[1].isNumber()) {
         indent = static_cast<int>(args[1].asNumber());
     }
-    return stringifyValue(args[0], indent, 0);
+    std::string out;
+    if (!stringifyValue(args[0], out, indent, 0))
+        return nullptr;
+    return out;
 }
 
 // Simple JSON Parser
 class JsonParser {
     const std::string &src;
     size_t pos = 0;
-    const int MAX_DEPTH = 512;
+    std::string keyBuffer;
 
     void skipWhitespace() {
         while (pos < src.length() && std::isspace(src[pos]))
             pos++;
     }
 
-    VMValue parseString() {
+    // Reads a quoted string into `res`, reusing its capacity.
+    void readString(std::string &res) {
         pos++; // skip "
-        std::string res;
+        res.clear();
         while (pos < src.length() && src[pos] != '"') {
             if (src[pos] == '\\' && pos + 1 < src.length()) {
                 pos++;
@@ -196,9 +325,74 @@ class JsonParser {
         }
         if (pos < src.length())
             pos++; // skip "
+    }
+
+    VMValue parseString() {
+        std::string res;
+        readString(res);
         return res;
     }
 
+    void skipString() {
+        pos++; // skip "
+        while (pos < src.length() && src[pos] != '"')
+            pos += (src[pos] == '\\') ? 2 : 1;
+        if (pos < src.length())
+            pos++; // skip "
+    }
+
+    // Steps over one value without building it.
+    bool skipValue(int depth) {
+        if (depth > MAX_DEPTH)
+            return false;
+        skipWhitespace();
+        if (pos >= src.length())
+            return false;
+        char c = src[pos];
+        if (c == '"') {
+            skipString();
+            return true;
+        }
+        if (c == '[' || c == '{') {
+            char close = c == '[' ? ']' : '}';
+            pos++;
+            skipWhitespace();
+            if (pos < src.length() && src[pos] == close) {
+                pos++;
+                return true;
+            }
+            while (pos < src.length()) {
+                if (c == '{') {
+                    skipWhitespace();
+                    if (pos >= src.length() || src[pos] != '"')
+                        return false;
+                    skipString();
+                    skipWhitespace();
+                    if (pos >= src.length() || src[pos] != ':')
+                        return false;
+                    pos++;
+                }
+                if (!skipValue(depth + 1))
+                    return false;
+                skipWhitespace();
+                if (pos < src.length() && src[pos] == ',') {
+                    pos++;
+                } else if (pos < src.length() && src[pos] == close) {
+                    pos++;
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+            return false;
+        }
+        size_t start = pos;
+        while (pos < src.length() && (std::isalnum(static_cast<unsigned char>(src[pos])) || src[pos] == '.' ||
+                                      src[pos] == '-' || src[pos] == '+'))
+            pos++;
+        return pos > start;
+    }
+
     VMValue parseNumber() {
         size_t start = pos;
         while (pos < src.length() && (std::isdigit(src[pos]) || src[pos] == '.' || src[pos] == '-' || src[pos] == 'e' ||
@@ -278,6 +472,90 @@ class JsonParser {
     JsonParser(const std::string &src) : src(src) {
     }
 
+    // Decodes an object straight into a new instance of `klass`. Keys that
+    // name a public declared field fill it; other keys are skipped without
+    // being decoded. The constructor is not run, and declared fields the
+    // object lacks are nil.
+    VMValue parseInstance(ObjClass *klass, const FieldPlan &plan, int depth = 0) {
+        if (depth > MAX_DEPTH)
+            return nullptr;
+        skipWhitespace();
+        if (pos >= src.length() || src[pos] != '{') {
+            skipValue(depth);
+            return nullptr;
+        }
+        pos++; // skip {
+
+        auto instance = new ObjInstance(klass);
+        instance->fields.reserve(plan.fields.size());
+        // Map nodes stay put as more are added, so each slot can be
+        // written through a pointer once its key is matched
+        std::vector<VMValue *> slots;
+        slots.reserve(plan.fields.size());
+        for (const auto &name : plan.fields)
+            slots.push_back(&instance->fields.emplace(name, VMValue(nullptr)).first->second);
+
+        skipWhitespace();
+        if (pos < src.length() && src[pos] == '}') {
+            pos++;
+            return instance;
+        }
+        while (pos < src.length()) {
+            skipWhitespace();
+            if (pos >= src.length() || src[pos] != '"')
+                break;
+            readString(keyBuffer);
+            skipWhitespace();
+            if (pos >= src.length() || src[pos] != ':')
+                break;
+            pos++;
+            auto slot = plan.slots.find(std::string_view(keyBuffer));
+            if (slot != plan.slots.end()) {
+                *slots[slot->second] = parseValue(depth + 1);
+            } else if (!skipValue(depth + 1)) {
+                break;
+            }
+            skipWhitespace();
+            if (pos < src.length() && src[pos] == ',') {
+                pos++;
+            } else if (pos < src.length() && src[pos] == '}') {
+                pos++;
+                break;
+            } else {
+                break;
+            }
+        }
+        return instance;
+    }
+
+    // Decodes an array whose elements are objects of `klass`; anything
+    // else in the array becomes nil.
+    VMValue parseInstanceList(ObjClass *klass, const FieldPlan &plan) {
+        skipWhitespace();
+        if (pos >= src.length() || src[pos] != '[')
+            return nullptr;
+        pos++; // skip [
+        std::vector<VMValue> elements;
+        skipWhitespace();
+        if (pos < src.length() && src[pos] == ']') {
+            pos++;
+            return new ObjList(elements);
+        }
+        while (pos < src.length()) {
+            elements.push_back(parseInstance(klass, plan, 1));
+            skipWhitespace();
+            if (pos < src.length() && src[pos] == ',') {
+                pos++;
+            } else if (pos < src.length() && src[pos] == ']') {
+                pos++;
+                break;
+            } else {
+                break;
+            }
+        }
+        return new ObjList(elements);
+    }
+
     VMValue parseValue(int depth = 0) {
         if (depth > MAX_DEPTH)
             return nullptr;
@@ -317,10 +595,44 @@ static VMValue jsonParse(int argCount, VMValue *args) {
     return parser.parseValue();
 }
 
+static ObjClass *targetClass(VMValue value) {
+    if (!value.isClass() || value.asClass()->isAbstract)
+        return nullptr;
+    return value.asClass();
+}
+
+static VMValue jsonParseAs(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isString())
+        return nullptr;
+    ObjClass *klass = targetClass(args[1]);
+    if (!klass)
+        return nullptr;
+    const std::string &jsonStr = args[0].asString()->flatView();
+    JsonParser parser(jsonStr);
+    return parser.parseInstance(klass, planFor(klass));
+}
+
+static VMValue jsonParseListAs(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isString())
+        return nullptr;
+    ObjClass *klass = targetClass(args[1]);
+    if (!klass)
+        return nullptr;
+    const std::string &jsonStr = args[0].asString()->flatView();
+    JsonParser parser(jsonStr);
+    return parser.parseInstanceList(klass, planFor(klass));
+}
+
+bool stringify(const VMValue &value, std::string &out) {
+    return stringifyValue(value, out);
+}
+
 void registerAll(VM *vm) {
     auto jsonClass = new ObjClass("Json");
     jsonClass->statics["stringify"] = new ObjNative("stringify", -1, jsonStringify);
     jsonClass->statics["parse"] = new ObjNative("parse", 1, jsonParse);
+    jsonClass->statics["parseAs"] = new ObjNative("parseAs", 2, jsonParseAs);
+    jsonClass->statics["parseListAs"] = new ObjNative("parseListAs", 2, jsonParseListAs);
     vm->globals["Json"] = jsonClass;
 }
 
@@ -3,9 +3,14 @@
 
 #include "../../symbol/SymbolTable.h"
 #include "../../vm/VM.h"
+#include <string>
 
 namespace StdLib {
 namespace Json {
+// Appends the compact text Json.stringify(value) would return. False, with
+// `out` partly written, when `value` nests deeper than 512 levels.
+bool stringify(const VMValue &value, std::string &out);
+
 void registerAll(VM *vm);
 void registerSymbols(SymbolTable *scope);
 } // namespace Json
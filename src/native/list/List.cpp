@@ -12,7 +12,7 @@ static VMValue listLength(int argCount, VMValue *args) {
 }
 
 static VMValue listPush(int argCount, VMValue *args) {
-    if (argCount != 2 || !args[0].isList())
+    if (argCount != 2 || !args[0].isList() || args[0].asList()->isFrozen)
         return nullptr;
     auto list = args[0].asList();
     list->elements.push_back(args[1]);
@@ -20,7 +20,7 @@ static VMValue listPush(int argCount, VMValue *args) {
 }
 
 static VMValue listPop(int argCount, VMValue *args) {
-    if (argCount != 1 || !args[0].isList())
+    if (argCount != 1 || !args[0].isList() || args[0].asList()->isFrozen)
         return nullptr;
     auto list = args[0].asList();
     if (list->elements.empty())
@@ -31,7 +31,7 @@ static VMValue listPop(int argCount, VMValue *args) {
 }
 
 static VMValue listInsert(int argCount, VMValue *args) {
-    if (argCount != 3 || !args[0].isList() || !args[1].isNumber())
+    if (argCount != 3 || !args[0].isList() || args[0].asList()->isFrozen || !args[1].isNumber())
         return nullptr;
     auto list = args[0].asList();
     int index = args[1].asNumber();
@@ -43,7 +43,7 @@ static VMValue listInsert(int argCount, VMValue *args) {
 }
 
 static VMValue listRemove(int argCount, VMValue *args) {
-    if (argCount != 2 || !args[0].isList() || !args[1].isNumber())
+    if (argCount != 2 || !args[0].isList() || args[0].asList()->isFrozen || !args[1].isNumber())
         return nullptr;
     auto list = args[0].asList();
     int index = args[1].asNumber();
@@ -56,7 +56,7 @@ static VMValue listRemove(int argCount, VMValue *args) {
 }
 
 static VMValue listReverse(int argCount, VMValue *args) {
-    if (argCount != 1 || !args[0].isList())
+    if (argCount != 1 || !args[0].isList() || args[0].asList()->isFrozen)
         return nullptr;
     auto list = args[0].asList();
     std::reverse(list->elements.begin(), list->elements.end());
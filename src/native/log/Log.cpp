@@ -0,0 +1,214 @@
+#include "Log.h"
+#include "../StdLib.h"
+#include "../json/Json.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace StdLib {
+namespace LogModule {
+
+// Logged in place of a value Json::stringify gives up on (a reference
+// cycle, or nesting past its depth limit)
+static const char *const kTooDeep = "<too deeply nested>";
+
+static void addField(Logging::Record &record, std::string_view key, VMValue value) {
+    if (value.isString()) {
+        record.addString(key, value.asString()->flatView());
+    } else if (value.isNumber()) {
+        record.addNumber(key, value.asNumber());
+    } else if (value.isBool()) {
+        record.addBool(key, value.asBool());
+    } else if (value.isNil()) {
+        record.addNil(key);
+    } else {
+        // Lists, maps and objects cannot cross to the writer thread, so
+        // they travel as JSON text
+        thread_local std::string json;
+        json.clear();
+        if (Json::stringify(value, json))
+            record.addJson(key, json);
+        else
+            record.addString(key, kTooDeep);
+    }
+}
+
+// Fields in key order, so lines read the same from call to call
+static void addFields(Logging::Record &record, ObjMap *map) {
+    thread_local std::vector<std::pair<std::string, VMValue>> fields;
+    fields.clear();
+    for (auto &[key, value] : map->values) {
+        if (key.isString()) {
+            fields.emplace_back(key.asString()->flatten(), value);
+        } else {
+            fields.emplace_back();
+            if (!Json::stringify(key, fields.back().first))
+                fields.back().first = kTooDeep;
+            fields.back().second = value;
+        }
+    }
+    std::sort(fields.begin(), fields.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    for (auto &[key, value] : fields)
+        addField(record, key, value);
+}
+
+// (message, fields?) for every level. The level is checked before the
+// arguments are looked at; a function message is only called when the
+// record will be written.
+static VMValue logAt(Logging::Level level, int argCount, VMValue *args) {
+    if (!Logging::enabled(level))
+        return nullptr;
+    if (argCount < 1 || argCount > 2 || (argCount == 2 && !args[1].isMap() && !args[1].isNil()))
+        return nullptr;
+    VMValue message = args[0];
+    VMValue fields = argCount == 2 ? args[1] : VMValue(nullptr);
+    if (message.isClosure())
+        message = currentVM->callClosure(message, 0, nullptr);
+    thread_local std::string text;
+    std::string_view view;
+    if (message.isString()) {
+        view = message.asString()->flatView();
+    } else {
+        text.clear();
+        if (!Json::stringify(message, text))
+            text = kTooDeep;
+        view = text;
+    }
+    Logging::Record &record = Logging::Record::current();
+    record.begin(level, view);
+    if (fields.isMap())
+        addFields(record, fields.asMap());
+    record.commit();
+    return nullptr;
+}
+
+static VMValue logDebug(int argCount, VMValue *args) {
+    return logAt(Logging::Level::DEBUG, argCount, args);
+}
+
+static VMValue logInfo(int argCount, VMValue *args) {
+    return logAt(Logging::Level::INFO, argCount, args);
+}
+
+static VMValue logWarn(int argCount, VMValue *args) {
+    return logAt(Logging::Level::WARN, argCount, args);
+}
+
+static VMValue logError(int argCount, VMValue *args) {
+    return logAt(Logging::Level::ERROR, argCount, args);
+}
+
+// enabled(level): whether records at `level` are written, for callers
+// that want to skip building fields altogether
+static VMValue logEnabled(int argCount, VMValue *args) {
+    Logging::Level level;
+    if (argCount != 1 || !args[0].isString() || !Logging::parseLevel(args[0].asString()->flatView(), level))
+        return nullptr;
+    return Logging::enabled(level);
+}
+
+// Non-negative, finite counts; ones past 2^64 saturate
+static bool countOption(VMValue value, uint64_t &out) {
+    if (!value.isNumber() || !(value.asNumber() >= 0) || !std::isfinite(value.asNumber()))
+        return false;
+    double d = value.asNumber();
+    out = d >= 18446744073709551616.0 ? UINT64_MAX : static_cast<uint64_t>(d);
+    return true;
+}
+
+// configure({"level", "path", "format", "maxBytes", "maxAgeSeconds",
+// "keep", "dropWhenFull", "flushMs"}): options not given keep their
+// current values
+static VMValue logConfigure(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isMap())
+        return nullptr;
+    Logging::Options options = Logging::currentOptions();
+    for (auto &[key, value] : args[0].asMap()->values) {
+        std::string name = key.isString() ? key.asString()->flatten() : "";
+        uint64_t count = 0;
+        if (name == "level") {
+            if (!value.isString() || !Logging::parseLevel(value.asString()->flatView(), options.level))
+                return makeResultErr(currentVM, "level must be \"debug\", \"info\", \"warn\", \"error\" or \"off\"");
+        } else if (name == "path") {
+            if (!value.isString() && !value.isNil())
+                return makeResultErr(currentVM, "path must be a string");
+            options.path = value.isString() ? value.asString()->flatten() : "";
+        } else if (name == "format") {
+            std::string format = value.isString() ? value.asString()->flatten() : "";
+            if (format != "text" && format != "json")
+                return makeResultErr(currentVM, "format must be \"text\" or \"json\"");
+            options.json = format == "json";
+        } else if (name == "maxBytes" || name == "maxAgeSeconds" || name == "keep" || name == "flushMs") {
+            if (!countOption(value, count))
+                return makeResultErr(currentVM, name + " must be a non-negative number");
+            if (name == "maxBytes")
+                options.maxBytes = count;
+            else if (name == "maxAgeSeconds")
+                options.maxAgeSeconds = count;
+            else if (name == "keep")
+                options.keep = static_cast<unsigned>(std::min<uint64_t>(count, Logging::kMaxKeep));
+            else
+                options.flushMs = static_cast<unsigned>(std::min<uint64_t>(count, Logging::kMaxFlushMs));
+        } else if (name == "dropWhenFull") {
+            if (!value.isBool())
+                return makeResultErr(currentVM, "dropWhenFull must be a bool");
+            options.dropWhenFull = value.asBool();
+        } else {
+            return makeResultErr(currentVM, "Unknown log option: " + name);
+        }
+    }
+    std::string error;
+    if (!Logging::configure(options, error))
+        return makeResultErr(currentVM, error);
+    return makeResultOk(currentVM, true);
+}
+
+// flush(): returns once everything logged so far has been written
+static VMValue logFlush(int argCount, VMValue *args) {
+    (void)argCount;
+    (void)args;
+    Logging::flush();
+    return makeResultOk(currentVM, true);
+}
+
+// stats(): {"written", "dropped"} since the process started
+static VMValue logStats(int argCount, VMValue *args) {
+    (void)argCount;
+    (void)args;
+    Logging::Stats stats = Logging::stats();
+    auto map = new ObjMap();
+    map->values[VMValue(std::string("written"))] = static_cast<double>(stats.written);
+    map->values[VMValue(std::string("dropped"))] = static_cast<double>(stats.dropped);
+    return map;
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto logClass = new ObjClass("Log");
+    logClass->statics["debug"] = new ObjNative("debug", -1, logDebug);
+    logClass->statics["info"] = new ObjNative("info", -1, logInfo);
+    logClass->statics["warn"] = new ObjNative("warn", -1, logWarn);
+    logClass->statics["error"] = new ObjNative("error", -1, logError);
+    logClass->statics["enabled"] = new ObjNative("enabled", 1, logEnabled);
+    logClass->statics["configure"] = new ObjNative("configure", 1, logConfigure);
+    logClass->statics["flush"] = new ObjNative("flush", 0, logFlush);
+    logClass->statics["stats"] = new ObjNative("stats", 0, logStats);
+    vm->globals["Log"] = logClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "Log";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+}
+
+} // namespace LogModule
+} // namespace StdLib
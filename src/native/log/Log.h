@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_LOG_H
+#define TRYPILLIA_LOG_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace LogModule {
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace LogModule
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,622 @@
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+namespace StdLib {
+namespace Logging {
+
+// Per-thread ring size; a record may take at most half of it
+constexpr size_t kBufferBytes = 256 * 1024;
+// Offset of the field count inside an encoded record
+constexpr size_t kFieldsAt = 1 + sizeof(int64_t);
+// Busy retries before a full buffer makes the caller sleep
+constexpr int kFullSpins = 64;
+
+std::atomic<uint8_t> threshold{static_cast<uint8_t>(Level::INFO)};
+
+const char *levelName(Level level) {
+    switch (level) {
+    case Level::DEBUG:
+        return "debug";
+    case Level::INFO:
+        return "info";
+    case Level::WARN:
+        return "warn";
+    case Level::ERROR:
+        return "error";
+    default:
+        return "off";
+    }
+}
+
+bool parseLevel(std::string_view name, Level &level) {
+    for (Level candidate : {Level::DEBUG, Level::INFO, Level::WARN, Level::ERROR, Level::OFF}) {
+        if (name == levelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Bytes move through the ring as a u32 length followed by the record.
+// Only the owning thread advances `tail` and only the writer advances
+// `head`, so neither side takes a lock.
+struct ThreadBuffer {
+    std::unique_ptr<char[]> data{new char[kBufferBytes]};
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    // Set when the thread exits; the writer forgets the buffer once empty
+    std::atomic<bool> retired{false};
+};
+
+static void copyIn(ThreadBuffer &buffer, uint64_t pos, const void *src, size_t n) {
+    size_t at = static_cast<size_t>(pos & (kBufferBytes - 1));
+    size_t first = std::min(n, kBufferBytes - at);
+    memcpy(buffer.data.get() + at, src, first);
+    memcpy(buffer.data.get(), static_cast<const char *>(src) + first, n - first);
+}
+
+static void copyOut(const ThreadBuffer &buffer, uint64_t pos, void *dst, size_t n) {
+    size_t at = static_cast<size_t>(pos & (kBufferBytes - 1));
+    size_t first = std::min(n, kBufferBytes - at);
+    memcpy(dst, buffer.data.get() + at, first);
+    memcpy(static_cast<char *>(dst) + first, buffer.data.get(), n - first);
+}
+
+static void appendQuoted(std::string &out, std::string_view s) {
+    out += '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out += escape;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+static void appendNumber(std::string &out, double value, bool json) {
+    if (value != value || value - value != 0) {
+        // NaN and infinities have no JSON spelling
+        out += json ? "null" : value != value ? "nan" : value > 0 ? "inf" : "-inf";
+        return;
+    }
+    char text[32];
+    std::to_chars_result result = value == static_cast<double>(static_cast<long long>(value))
+                                      ? std::to_chars(text, text + sizeof(text), static_cast<long long>(value))
+                                      : std::to_chars(text, text + sizeof(text), value);
+    out.append(text, result.ptr);
+}
+
+// Text lines quote a value only when it would not read back as one token
+static void appendBare(std::string &out, std::string_view s) {
+    bool plain = !s.empty();
+    for (unsigned char c : s)
+        if (c <= ' ' || c == '"' || c == '=')
+            plain = false;
+    if (plain)
+        out += s;
+    else
+        appendQuoted(out, s);
+}
+
+// Messages keep their spaces unquoted, but one holding a quote or a
+// control character is quoted so it cannot end the line or fake another
+static void appendMessage(std::string &out, std::string_view s) {
+    for (unsigned char c : s) {
+        if (c < ' ' || c == '"') {
+            appendQuoted(out, s);
+            return;
+        }
+    }
+    out += s;
+}
+
+// Cursor over one encoded record
+struct Reader {
+    const char *at;
+
+    template <typename T> T read() {
+        T value;
+        memcpy(&value, at, sizeof(T));
+        at += sizeof(T);
+        return value;
+    }
+    std::string_view text(size_t length) {
+        std::string_view view(at, length);
+        at += length;
+        return view;
+    }
+};
+
+class Writer {
+  public:
+    static Writer &instance() {
+        static Writer writer;
+        return writer;
+    }
+
+    ~Writer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running)
+                return;
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+        if (ownsFd)
+            ::close(fd);
+    }
+
+    std::shared_ptr<ThreadBuffer> attach() {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(buffer);
+        start();
+        return buffer;
+    }
+
+    void wake() {
+        wakeRequested.store(true, std::memory_order_relaxed);
+        wakeup.notify_one();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        uint64_t ticket = ++flushRequested;
+        wakeup.notify_one();
+        flushed.wait(lock, [&] { return flushDone >= ticket; });
+    }
+
+    bool configure(const Options &next, std::string &error) {
+        flush();
+        std::lock_guard<std::mutex> sink(sinkMutex);
+        int nextFd = 2;
+        uint64_t size = 0;
+        if (!next.path.empty()) {
+            nextFd = ::open(next.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (nextFd < 0) {
+                error = "Cannot open log file " + next.path + ": " + strerror(errno);
+                return false;
+            }
+            struct stat st;
+            if (fstat(nextFd, &st) == 0)
+                size = static_cast<uint64_t>(st.st_size);
+        }
+        if (ownsFd)
+            ::close(fd);
+        fd = nextFd;
+        ownsFd = !next.path.empty();
+        fileSize = size;
+        openedAt = nowSeconds();
+        options = next;
+        threshold.store(static_cast<uint8_t>(next.level), std::memory_order_relaxed);
+        dropWhenFull.store(next.dropWhenFull, std::memory_order_relaxed);
+        flushMs.store(std::max(1u, next.flushMs), std::memory_order_relaxed);
+        return true;
+    }
+
+    Options current() {
+        std::lock_guard<std::mutex> sink(sinkMutex);
+        return options;
+    }
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> dropWhenFull{false};
+
+  private:
+    struct Pending {
+        int64_t time;
+        size_t offset;
+    };
+
+    Writer() = default;
+
+    static int64_t nowSeconds() {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Called with `mutex` held
+    void start() {
+        if (running)
+            return;
+        running = true;
+        thread = std::thread([this] { run(); });
+    }
+
+    void run() {
+        std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeup.wait_for(lock, std::chrono::milliseconds(flushMs.load(std::memory_order_relaxed)), [this] {
+                return stopping || flushRequested != flushDone || wakeRequested.load(std::memory_order_relaxed);
+            });
+            wakeRequested.store(false, std::memory_order_relaxed);
+            uint64_t target = flushRequested;
+            bool stop = stopping;
+            snapshot = buffers;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> sink(sinkMutex);
+                drain(snapshot);
+            }
+            snapshot.clear();
+            lock.lock();
+            buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                         [](const std::shared_ptr<ThreadBuffer> &buffer) {
+                                             return buffer->retired.load(std::memory_order_acquire) &&
+                                                    buffer->head.load(std::memory_order_relaxed) ==
+                                                        buffer->tail.load(std::memory_order_acquire);
+                                         }),
+                          buffers.end());
+            flushDone = target;
+            flushed.notify_all();
+            if (stop)
+                return;
+        }
+    }
+
+    // Copies every queued record out of the rings, frees the space right
+    // away, then writes them in timestamp order across threads
+    void drain(const std::vector<std::shared_ptr<ThreadBuffer>> &snapshot) {
+        arena.clear();
+        pending.clear();
+        for (const auto &buffer : snapshot) {
+            uint64_t head = buffer->head.load(std::memory_order_relaxed);
+            uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+            while (head != tail) {
+                uint32_t length;
+                copyOut(*buffer, head, &length, sizeof(length));
+                size_t offset = arena.size();
+                arena.resize(offset + length);
+                copyOut(*buffer, head + sizeof(length), &arena[offset], length);
+                int64_t time;
+                memcpy(&time, arena.data() + offset + 1, sizeof(time));
+                pending.push_back({time, offset});
+                head += sizeof(length) + length;
+            }
+            buffer->head.store(head, std::memory_order_release);
+        }
+        if (pending.empty())
+            return;
+        std::stable_sort(pending.begin(), pending.end(),
+                         [](const Pending &a, const Pending &b) { return a.time < b.time; });
+        drainTime = nowSeconds();
+        for (const Pending &record : pending) {
+            line.clear();
+            format(arena.data() + record.offset);
+            emit();
+        }
+        writeOut();
+        written.fetch_add(pending.size(), std::memory_order_relaxed);
+    }
+
+    // "2026-01-02T03:04:05.678Z", reformatting the date only once a second
+    void appendTime(int64_t nanos) {
+        int64_t seconds = nanos / 1000000000;
+        if (seconds != stampSecond) {
+            time_t t = static_cast<time_t>(seconds);
+            struct tm parts;
+#ifndef _WIN32
+            gmtime_r(&t, &parts);
+#else
+            gmtime_s(&parts, &t);
+#endif
+            strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &parts);
+            stampSecond = seconds;
+        }
+        int millis = static_cast<int>(nanos / 1000000 % 1000);
+        line += stamp;
+        line += '.';
+        line += static_cast<char>('0' + millis / 100);
+        line += static_cast<char>('0' + millis / 10 % 10);
+        line += static_cast<char>('0' + millis % 10);
+        line += 'Z';
+    }
+
+    void format(const char *record) {
+        Reader reader{record};
+        Level level = static_cast<Level>(reader.read<uint8_t>());
+        int64_t time = reader.read<int64_t>();
+        uint16_t fields = reader.read<uint16_t>();
+        std::string_view message = reader.text(reader.read<uint32_t>());
+        bool json = options.json;
+        if (json) {
+            line += "{\"time\":\"";
+            appendTime(time);
+            line += "\",\"level\":\"";
+            line += levelName(level);
+            line += "\",\"msg\":";
+            appendQuoted(line, message);
+        } else {
+            appendTime(time);
+            static const char *const names[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+            line += ' ';
+            line += names[static_cast<int>(level)];
+            line += ' ';
+            appendMessage(line, message);
+        }
+        for (uint16_t i = 0; i < fields; i++) {
+            std::string_view key = reader.text(reader.read<uint16_t>());
+            char tag = reader.read<char>();
+            if (json) {
+                line += ',';
+                appendQuoted(line, key);
+                line += ':';
+            } else {
+                line += ' ';
+                appendBare(line, key);
+                line += '=';
+            }
+            switch (tag) {
+            case 's': {
+                std::string_view value = reader.text(reader.read<uint32_t>());
+                if (json)
+                    appendQuoted(line, value);
+                else
+                    appendBare(line, value);
+                break;
+            }
+            case 'j':
+                line += reader.text(reader.read<uint32_t>());
+                break;
+            case 'n':
+                appendNumber(line, reader.read<double>(), json);
+                break;
+            case 'b':
+                line += reader.read<uint8_t>() ? "true" : "false";
+                break;
+            default:
+                line += json ? "null" : "nil";
+                break;
+            }
+        }
+        line += json ? "}\n" : "\n";
+    }
+
+    // Queues `line` for the sink, rotating first if it would overflow the
+    // file or the file is too old
+    void emit() {
+        if (ownsFd && fileSize + out.size() > 0) {
+            bool full = options.maxBytes && fileSize + out.size() + line.size() > options.maxBytes;
+            bool old = options.maxAgeSeconds && drainTime - openedAt >= static_cast<int64_t>(options.maxAgeSeconds);
+            if (full || old) {
+                writeOut();
+                rotate();
+            }
+        }
+        out += line;
+    }
+
+    void writeOut() {
+        size_t done = 0;
+        while (done < out.size()) {
+#ifndef _WIN32
+            ssize_t n = ::write(fd, out.data() + done, out.size() - done);
+#else
+            int n = ::_write(fd, out.data() + done, static_cast<unsigned>(out.size() - done));
+#endif
+            if (n < 0 && errno == EINTR)
+                continue;
+            // Nowhere to report a failing log sink; the lines are lost
+            if (n <= 0)
+                break;
+            done += static_cast<size_t>(n);
+        }
+        fileSize += done;
+        out.clear();
+    }
+
+    // app.log -> app.log.1 -> app.log.2 ..., dropping the oldest
+    void rotate() {
+        ::close(fd);
+        const std::string &path = options.path;
+        if (options.keep == 0) {
+            std::remove(path.c_str());
+        } else {
+            for (unsigned i = options.keep; i > 1; i--)
+                std::rename((path + "." + std::to_string(i - 1)).c_str(), (path + "." + std::to_string(i)).c_str());
+            std::rename(path.c_str(), (path + ".1").c_str());
+        }
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            fd = 2;
+            ownsFd = false;
+        }
+        fileSize = 0;
+        openedAt = drainTime;
+    }
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable flushed;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::thread thread;
+    bool running = false;
+    bool stopping = false;
+    uint64_t flushRequested = 0;
+    uint64_t flushDone = 0;
+    std::atomic<bool> wakeRequested{false};
+    std::atomic<unsigned> flushMs{Options().flushMs};
+
+    // Sink state: used by the writer thread while draining and replaced by
+    // configure(), both under sinkMutex
+    std::mutex sinkMutex;
+    Options options;
+    int fd = 2;
+    bool ownsFd = false;
+    uint64_t fileSize = 0;
+    int64_t openedAt = 0;
+    int64_t drainTime = 0;
+    std::string arena;
+    std::vector<Pending> pending;
+    std::string line;
+    std::string out;
+    int64_t stampSecond = -1;
+    char stamp[32] = {};
+};
+
+struct BufferHandle {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~BufferHandle() {
+        if (buffer)
+            buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+static ThreadBuffer &threadBuffer() {
+    thread_local BufferHandle handle;
+    if (!handle.buffer)
+        handle.buffer = Writer::instance().attach();
+    return *handle.buffer;
+}
+
+bool configure(const Options &options, std::string &error) {
+    return Writer::instance().configure(options, error);
+}
+
+Options currentOptions() {
+    return Writer::instance().current();
+}
+
+void flush() {
+    Writer::instance().flush();
+}
+
+Stats stats() {
+    Writer &writer = Writer::instance();
+    return {writer.written.load(std::memory_order_relaxed), writer.dropped.load(std::memory_order_relaxed)};
+}
+
+// --- Record ---
+
+Record &Record::current() {
+    thread_local Record record;
+    return record;
+}
+
+void Record::addBytes(std::string_view value) {
+    uint32_t length = static_cast<uint32_t>(std::min<size_t>(value.size(), kBufferBytes));
+    bytes.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    bytes.append(value.data(), length);
+}
+
+void Record::addKey(std::string_view key, char tag) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(key.size(), UINT16_MAX));
+    bytes.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    bytes.append(key.data(), length);
+    bytes += tag;
+    fields++;
+}
+
+void Record::begin(Level level, std::string_view message) {
+    bytes.clear();
+    fields = 0;
+    bytes += static_cast<char>(level);
+    int64_t now =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    bytes.append(reinterpret_cast<const char *>(&now), sizeof(now));
+    // Field count, filled in by commit()
+    bytes.append(sizeof(uint16_t), '\0');
+    addBytes(message);
+}
+
+void Record::addString(std::string_view key, std::string_view value) {
+    addKey(key, 's');
+    addBytes(value);
+}
+
+void Record::addNumber(std::string_view key, double value) {
+    addKey(key, 'n');
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void Record::addBool(std::string_view key, bool value) {
+    addKey(key, 'b');
+    bytes += static_cast<char>(value ? 1 : 0);
+}
+
+void Record::addNil(std::string_view key) {
+    addKey(key, 'z');
+}
+
+void Record::addJson(std::string_view key, std::string_view json) {
+    addKey(key, 'j');
+    addBytes(json);
+}
+
+bool Record::commit() {
+    Writer &writer = Writer::instance();
+    uint16_t count = static_cast<uint16_t>(fields);
+    memcpy(&bytes[kFieldsAt], &count, sizeof(count));
+    uint32_t length = static_cast<uint32_t>(bytes.size());
+    size_t need = sizeof(length) + length;
+    if (need > kBufferBytes / 2 || fields > UINT16_MAX) {
+        writer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ThreadBuffer &buffer = threadBuffer();
+    uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+    for (int spins = 0; kBufferBytes - (tail - buffer.head.load(std::memory_order_acquire)) < need; spins++) {
+        if (writer.dropWhenFull.load(std::memory_order_relaxed)) {
+            writer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        writer.wake();
+        if (spins < kFullSpins)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    copyIn(buffer, tail, &length, sizeof(length));
+    copyIn(buffer, tail + sizeof(length), bytes.data(), length);
+    buffer.tail.store(tail + need, std::memory_order_release);
+    // Nudge the writer when the buffer passes half full rather than on
+    // every record; otherwise it wakes on its flush interval
+    uint64_t used = tail + need - buffer.head.load(std::memory_order_relaxed);
+    if (used >= kBufferBytes / 2 && used - need < kBufferBytes / 2)
+        writer.wake();
+    return true;
+}
+
+} // namespace Logging
+} // namespace StdLib
@@ -0,0 +1,90 @@
+#ifndef TRYPILLIA_NATIVE_LOGGER_H
+#define TRYPILLIA_NATIVE_LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Process-wide logging. Each thread encodes records into its own
+// single-producer ring buffer; one background thread, shared by the main
+// VM and every Worker, drains the rings, formats the lines and writes
+// them out. Plain C++ so that thread never touches VM objects.
+namespace StdLib {
+namespace Logging {
+
+enum class Level : uint8_t { DEBUG, INFO, WARN, ERROR, OFF };
+
+const char *levelName(Level level);
+bool parseLevel(std::string_view name, Level &level);
+
+// Least severe level that is written; read on every call, so inline
+extern std::atomic<uint8_t> threshold;
+
+inline bool enabled(Level level) {
+    return static_cast<uint8_t>(level) >= threshold.load(std::memory_order_relaxed);
+}
+
+struct Options {
+    Level level = Level::INFO;
+    // Empty writes to stderr
+    std::string path;
+    bool json = false;
+    // Rotate once the file would grow past this many bytes; 0 never
+    uint64_t maxBytes = 0;
+    // Rotate files older than this; 0 never
+    uint64_t maxAgeSeconds = 0;
+    // Rotated files kept as path.1 (newest) .. path.N, at most kMaxKeep
+    unsigned keep = 5;
+    // Drop records when this thread's buffer is full instead of waiting
+    bool dropWhenFull = false;
+    // Longest a record waits before being written, at most kMaxFlushMs
+    unsigned flushMs = 100;
+};
+
+// Each rotation renames every kept file, and the writer sleeps up to
+// flushMs between batches, so both are bounded
+constexpr unsigned kMaxKeep = 1000;
+constexpr unsigned kMaxFlushMs = 60000;
+
+// Applies `options` after writing out everything logged so far. Returns
+// false with `error` set if the file cannot be opened.
+bool configure(const Options &options, std::string &error);
+Options currentOptions();
+// Blocks until every record logged before the call has been written
+void flush();
+
+struct Stats {
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+};
+Stats stats();
+
+// One record under construction. Callers reuse the thread's instance from
+// current() so the hot path does not allocate once warmed up.
+class Record {
+  public:
+    static Record &current();
+
+    void begin(Level level, std::string_view message);
+    void addString(std::string_view key, std::string_view value);
+    void addNumber(std::string_view key, double value);
+    void addBool(std::string_view key, bool value);
+    void addNil(std::string_view key);
+    // `json` is already-encoded JSON, written as is
+    void addJson(std::string_view key, std::string_view json);
+    // Queues the record on this thread's buffer; false if it was dropped
+    bool commit();
+
+  private:
+    void addKey(std::string_view key, char tag);
+    void addBytes(std::string_view bytes);
+
+    std::string bytes;
+    uint32_t fields = 0;
+};
+
+} // namespace Logging
+} // namespace StdLib
+
+#endif
@@ -33,7 +33,7 @@ static VMValue mapHas(int argCount, VMValue *args) {
 }
 
 static VMValue mapRemove(int argCount, VMValue *args) {
-    if (argCount != 2 || !args[0].isMap())
+    if (argCount != 2 || !args[0].isMap() || args[0].asMap()->isFrozen)
         return nullptr;
     auto map = args[0].asMap();
     if (map->values.count(args[1]) > 0) {
@@ -45,7 +45,7 @@ static VMValue mapRemove(int argCount, VMValue *args) {
 }
 
 static VMValue mapSet(int argCount, VMValue *args) {
-    if (argCount != 3 || !args[0].isMap())
+    if (argCount != 3 || !args[0].isMap() || args[0].asMap()->isFrozen)
         return nullptr;
     auto map = args[0].asMap();
     map->values[args[1]] = args[2];
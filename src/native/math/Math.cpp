@@ -1,6 +1,9 @@
 #include "Math.h"
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
 namespace StdLib {
 namespace Math {
@@ -21,11 +24,151 @@ static VMValue mathRandom(int argCount, VMValue *args) {
     return (double)rand() / RAND_MAX;
 }
 
+static bool numberArgs(int argCount, VMValue *args, int expected) {
+    if (argCount != expected)
+        return false;
+    for (int i = 0; i < argCount; i++) {
+        if (!args[i].isNumber())
+            return false;
+    }
+    return true;
+}
+
+static VMValue mathSqrt(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 1))
+        return nullptr;
+    return std::sqrt(args[0].asNumber());
+}
+
+static VMValue mathAbs(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 1))
+        return nullptr;
+    return std::fabs(args[0].asNumber());
+}
+
+static VMValue mathFloor(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 1))
+        return nullptr;
+    return std::floor(args[0].asNumber());
+}
+
+static VMValue mathCeil(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 1))
+        return nullptr;
+    return std::ceil(args[0].asNumber());
+}
+
+static VMValue mathMin(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 2))
+        return nullptr;
+    return std::fmin(args[0].asNumber(), args[1].asNumber());
+}
+
+static VMValue mathMax(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 2))
+        return nullptr;
+    return std::fmax(args[0].asNumber(), args[1].asNumber());
+}
+
+static VMValue mathPow(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 2))
+        return nullptr;
+    return std::pow(args[0].asNumber(), args[1].asNumber());
+}
+
+static VMValue mathExp(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 1))
+        return nullptr;
+    return std::exp(args[0].asNumber());
+}
+
+static VMValue mathLog(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 1))
+        return nullptr;
+    return std::log(args[0].asNumber());
+}
+
+static VMValue mathAtan2(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 2))
+        return nullptr;
+    return std::atan2(args[0].asNumber(), args[1].asNumber());
+}
+
+static VMValue mathFma(int argCount, VMValue *args) {
+    if (!numberArgs(argCount, args, 3))
+        return nullptr;
+    return std::fma(args[0].asNumber(), args[1].asNumber(), args[2].asNumber());
+}
+
+// Math.map kernels. Numbers in a list are stored as plain doubles, so each
+// kernel is a straight loop over contiguous memory that the compiler can
+// vectorize.
+template <typename Op> static void mapKernel(const double *__restrict in, double *__restrict out, size_t n, Op op) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = op(in[i]);
+}
+
+static bool runMapKernel(const std::string &op, const double *in, double *out, size_t n) {
+    if (op == "sqrt")
+        mapKernel(in, out, n, [](double x) { return std::sqrt(x); });
+    else if (op == "abs")
+        mapKernel(in, out, n, [](double x) { return std::fabs(x); });
+    else if (op == "floor")
+        mapKernel(in, out, n, [](double x) { return std::floor(x); });
+    else if (op == "ceil")
+        mapKernel(in, out, n, [](double x) { return std::ceil(x); });
+    else if (op == "neg")
+        mapKernel(in, out, n, [](double x) { return -x; });
+    else if (op == "exp")
+        mapKernel(in, out, n, [](double x) { return std::exp(x); });
+    else if (op == "log")
+        mapKernel(in, out, n, [](double x) { return std::log(x); });
+    else if (op == "sin")
+        mapKernel(in, out, n, [](double x) { return std::sin(x); });
+    else if (op == "cos")
+        mapKernel(in, out, n, [](double x) { return std::cos(x); });
+    else
+        return false;
+    return true;
+}
+
+static VMValue mathMap(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isList() || !args[1].isString())
+        return nullptr;
+    const std::vector<VMValue> &elements = args[0].asList()->elements;
+    for (const VMValue &element : elements) {
+        if (!element.isNumber())
+            return nullptr;
+    }
+    static_assert(sizeof(VMValue) == sizeof(double), "numbers are stored unboxed");
+    std::vector<double> in(elements.size()), out(elements.size());
+    if (!elements.empty())
+        memcpy(in.data(), elements.data(), elements.size() * sizeof(double));
+    if (!runMapKernel(args[1].asString()->flatten(), in.data(), out.data(), in.size()))
+        return nullptr;
+    std::vector<VMValue> mapped(out.size());
+    if (!out.empty())
+        memcpy(mapped.data(), out.data(), out.size() * sizeof(double));
+    return new ObjList(mapped);
+}
+
 void registerAll(VM *vm) {
     auto mathClass = new ObjClass("Math");
     mathClass->statics["sin"] = new ObjNative("sin", 1, mathSin);
     mathClass->statics["cos"] = new ObjNative("cos", 1, mathCos);
     mathClass->statics["random"] = new ObjNative("random", 0, mathRandom);
+    mathClass->statics["sqrt"] = new ObjNative("sqrt", 1, mathSqrt);
+    mathClass->statics["abs"] = new ObjNative("abs", 1, mathAbs);
+    mathClass->statics["floor"] = new ObjNative("floor", 1, mathFloor);
+    mathClass->statics["ceil"] = new ObjNative("ceil", 1, mathCeil);
+    mathClass->statics["min"] = new ObjNative("min", 2, mathMin);
+    mathClass->statics["max"] = new ObjNative("max", 2, mathMax);
+    mathClass->statics["pow"] = new ObjNative("pow", 2, mathPow);
+    mathClass->statics["exp"] = new ObjNative("exp", 1, mathExp);
+    mathClass->statics["log"] = new ObjNative("log", 1, mathLog);
+    mathClass->statics["atan2"] = new ObjNative("atan2", 2, mathAtan2);
+    mathClass->statics["fma"] = new ObjNative("fma", 3, mathFma);
+    mathClass->statics["map"] = new ObjNative("map", 2, mathMap);
     mathClass->statics["PI"] = 3.14159265358979323846;
     vm->globals["Math"] = mathClass;
 }
@@ -0,0 +1,565 @@
+#include "MsgPack.h"
+#include "../../vm/runtime/GC.h"
+#include "../StdLib.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace StdLib {
+namespace MsgPackModule {
+
+constexpr int kMaxDepth = 512;
+// Only short keys are interned, and the table stops growing at this size
+constexpr size_t kMaxInternedKeyLength = 64;
+constexpr size_t kMaxInternedKeys = 4096;
+
+// ---- Encoding ----
+
+static void putBigEndian(std::string &out, uint64_t value, int bytes) {
+    char buf[8];
+    for (int i = bytes - 1; i >= 0; i--) {
+        buf[i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    out.append(buf, bytes);
+}
+
+static void putTagged(std::string &out, uint8_t tag, uint64_t value, int bytes) {
+    out += static_cast<char>(tag);
+    putBigEndian(out, value, bytes);
+}
+
+static void encodeNumber(double d, std::string &out) {
+    // Integral values take the smallest integer form; -0 stays a float
+    if (d == std::floor(d) && d >= -9223372036854775808.0 && d < 18446744073709551616.0 &&
+        !(d == 0 && std::signbit(d))) {
+        if (d >= 0) {
+            uint64_t u = static_cast<uint64_t>(d);
+            if (u <= 0x7f)
+                out += static_cast<char>(u);
+            else if (u <= 0xff)
+                putTagged(out, 0xcc, u, 1);
+            else if (u <= 0xffff)
+                putTagged(out, 0xcd, u, 2);
+            else if (u <= 0xffffffffu)
+                putTagged(out, 0xce, u, 4);
+            else
+                putTagged(out, 0xcf, u, 8);
+        } else {
+            int64_t i = static_cast<int64_t>(d);
+            if (i >= -32)
+                out += static_cast<char>(static_cast<uint8_t>(i));
+            else if (i >= INT8_MIN)
+                putTagged(out, 0xd0, static_cast<uint8_t>(i), 1);
+            else if (i >= INT16_MIN)
+                putTagged(out, 0xd1, static_cast<uint16_t>(i), 2);
+            else if (i >= INT32_MIN)
+                putTagged(out, 0xd2, static_cast<uint32_t>(i), 4);
+            else
+                putTagged(out, 0xd3, static_cast<uint64_t>(i), 8);
+        }
+        return;
+    }
+    float f = static_cast<float>(d);
+    if (static_cast<double>(f) == d) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        putTagged(out, 0xca, bits, 4);
+        return;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    putTagged(out, 0xcb, bits, 8);
+}
+
+static void encodeLength(std::string &out, size_t n, uint8_t fix, size_t fixMax, uint8_t tag8, uint8_t tag16,
+                         uint8_t tag32) {
+    if (n <= fixMax)
+        out += static_cast<char>(fix | n);
+    else if (tag8 && n <= 0xff)
+        putTagged(out, tag8, n, 1);
+    else if (n <= 0xffff)
+        putTagged(out, tag16, n, 2);
+    else
+        putTagged(out, tag32, n, 4);
+}
+
+// Same walk as Json's stringifyValue; unsupported values encode as nil.
+static bool encode(const VMValue &val, std::string &out, int depth) {
+    if (depth > kMaxDepth)
+        return false;
+    if (val.isNil()) {
+        out += static_cast<char>(0xc0);
+        return true;
+    }
+    if (val.isBool()) {
+        out += static_cast<char>(val.asBool() ? 0xc3 : 0xc2);
+        return true;
+    }
+    if (val.isNumber()) {
+        encodeNumber(val.asNumber(), out);
+        return true;
+    }
+    if (val.isString()) {
+        const std::string &s = val.asString()->flatView();
+        encodeLength(out, s.size(), 0xa0, 31, 0xd9, 0xda, 0xdb);
+        out += s;
+        return true;
+    }
+    if (val.isList() || val.isSet()) {
+        // Sets travel as arrays in iteration order
+        const auto &elements = val.isList() ? val.asList()->elements : val.asSet()->entries;
+        encodeLength(out, elements.size(), 0x90, 15, 0, 0xdc, 0xdd);
+        for (const auto &element : elements) {
+            if (!encode(element, out, depth + 1))
+                return false;
+        }
+        return true;
+    }
+    if (val.isMap()) {
+        const auto &values = val.asMap()->values;
+        encodeLength(out, values.size(), 0x80, 15, 0, 0xde, 0xdf);
+        for (const auto &[k, v] : values) {
+            if (!encode(k, out, depth + 1) || !encode(v, out, depth + 1))
+                return false;
+        }
+        return true;
+    }
+    out += static_cast<char>(0xc0);
+    return true;
+}
+
+bool encodeValue(VMValue value, std::string &out) {
+    return encode(value, out, 0);
+}
+
+// ---- Decoding ----
+
+enum class Status { OK, NEED_MORE, INVALID };
+
+enum class Kind { NIL, BOOL, NUMBER, STRING, ARRAY, MAP, SKIP };
+
+// One decoded type byte plus its payload length or scalar value.
+struct Header {
+    Kind kind = Kind::NIL;
+    bool flag = false;
+    double number = 0;
+    size_t length = 0;
+};
+
+struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+struct KeyEqual {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const {
+        return a == b;
+    }
+};
+
+// Map keys seen so far, so repeated keys share one string object.
+using KeyTable = std::unordered_map<std::string, VMValue, KeyHash, KeyEqual>;
+
+class Reader {
+    std::string_view src;
+    KeyTable &keys;
+
+    uint64_t readBigEndian(int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++)
+            value = (value << 8) | static_cast<uint8_t>(src[pos + i]);
+        pos += bytes;
+        return value;
+    }
+
+    Status need(size_t bytes) const {
+        return src.size() - pos >= bytes ? Status::OK : Status::NEED_MORE;
+    }
+
+    Status sized(Header &h, Kind kind, int bytes) {
+        if (need(bytes) != Status::OK)
+            return Status::NEED_MORE;
+        h.kind = kind;
+        h.length = readBigEndian(bytes);
+        return Status::OK;
+    }
+
+    Status number(Header &h, double value) {
+        h.kind = Kind::NUMBER;
+        h.number = value;
+        return Status::OK;
+    }
+
+    Status readHeader(Header &h) {
+        if (need(1) != Status::OK)
+            return Status::NEED_MORE;
+        uint8_t tag = static_cast<uint8_t>(src[pos++]);
+        if (tag <= 0x7f)
+            return number(h, tag);
+        if (tag >= 0xe0)
+            return number(h, static_cast<int8_t>(tag));
+        if ((tag & 0xf0) == 0x80) {
+            h.kind = Kind::MAP;
+            h.length = tag & 0x0f;
+            return Status::OK;
+        }
+        if ((tag & 0xf0) == 0x90) {
+            h.kind = Kind::ARRAY;
+            h.length = tag & 0x0f;
+            return Status::OK;
+        }
+        if ((tag & 0xe0) == 0xa0) {
+            h.kind = Kind::STRING;
+            h.length = tag & 0x1f;
+            return Status::OK;
+        }
+
+        int width = 0;
+        switch (tag) {
+        case 0xc0:
+            h.kind = Kind::NIL;
+            return Status::OK;
+        case 0xc2:
+        case 0xc3:
+            h.kind = Kind::BOOL;
+            h.flag = tag == 0xc3;
+            return Status::OK;
+        // bin 8/16/32 decode as strings, which are byte strings here
+        case 0xc4:
+        case 0xd9:
+            return sized(h, Kind::STRING, 1);
+        case 0xc5:
+        case 0xda:
+            return sized(h, Kind::STRING, 2);
+        case 0xc6:
+        case 0xdb:
+            return sized(h, Kind::STRING, 4);
+        case 0xdc:
+            return sized(h, Kind::ARRAY, 2);
+        case 0xdd:
+            return sized(h, Kind::ARRAY, 4);
+        case 0xde:
+            return sized(h, Kind::MAP, 2);
+        case 0xdf:
+            return sized(h, Kind::MAP, 4);
+        // Extension types are skipped and read as nil
+        case 0xc7:
+        case 0xc8:
+        case 0xc9: {
+            width = tag == 0xc7 ? 1 : tag == 0xc8 ? 2 : 4;
+            if (need(width + 1) != Status::OK)
+                return Status::NEED_MORE;
+            h.kind = Kind::SKIP;
+            h.length = readBigEndian(width) + 1;
+            return Status::OK;
+        }
+        case 0xd4:
+        case 0xd5:
+        case 0xd6:
+        case 0xd7:
+        case 0xd8:
+            h.kind = Kind::SKIP;
+            h.length = (size_t{1} << (tag - 0xd4)) + 1;
+            return Status::OK;
+        case 0xca: {
+            if (need(4) != Status::OK)
+                return Status::NEED_MORE;
+            uint32_t bits = static_cast<uint32_t>(readBigEndian(4));
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return number(h, f);
+        }
+        case 0xcb: {
+            if (need(8) != Status::OK)
+                return Status::NEED_MORE;
+            uint64_t bits = readBigEndian(8);
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            return number(h, d);
+        }
+        case 0xcc:
+        case 0xcd:
+        case 0xce:
+        case 0xcf:
+            width = 1 << (tag - 0xcc);
+            if (need(width) != Status::OK)
+                return Status::NEED_MORE;
+            return number(h, static_cast<double>(readBigEndian(width)));
+        case 0xd0:
+        case 0xd1:
+        case 0xd2:
+        case 0xd3: {
+            width = 1 << (tag - 0xd0);
+            if (need(width) != Status::OK)
+                return Status::NEED_MORE;
+            uint64_t raw = readBigEndian(width);
+            int shift = 64 - width * 8;
+            int64_t value = static_cast<int64_t>(raw << shift) >> shift;
+            return number(h, static_cast<double>(value));
+        }
+        default:
+            return Status::INVALID;
+        }
+    }
+
+    VMValue makeKey(std::string_view bytes) {
+        if (bytes.size() > kMaxInternedKeyLength)
+            return std::string(bytes);
+        auto it = keys.find(bytes);
+        if (it != keys.end())
+            return it->second;
+        VMValue key = std::string(bytes);
+        if (keys.size() < kMaxInternedKeys)
+            keys.emplace(std::string(bytes), key);
+        return key;
+    }
+
+  public:
+    size_t pos = 0;
+
+    Reader(std::string_view src, KeyTable &keys) : src(src), keys(keys) {
+    }
+
+    // Advances past one value without allocating, to find where it ends.
+    // Resumable: `open` holds the items still expected by each enclosing
+    // array or map, and on NEED_MORE pos is left at the start of the first
+    // incomplete item, so the next call continues from there.
+    Status skip(std::vector<size_t> &open) {
+        do {
+            if (open.size() > static_cast<size_t>(kMaxDepth))
+                return Status::INVALID;
+            size_t start = pos;
+            Header h;
+            Status status = readHeader(h);
+            if (status == Status::OK && (h.kind == Kind::STRING || h.kind == Kind::SKIP)) {
+                status = need(h.length);
+                if (status == Status::OK)
+                    pos += h.length;
+            }
+            if (status == Status::NEED_MORE)
+                pos = start;
+            if (status != Status::OK)
+                return status;
+            if (h.kind == Kind::ARRAY || h.kind == Kind::MAP) {
+                size_t items = h.kind == Kind::MAP ? h.length * 2 : h.length;
+                if (items > 0) {
+                    open.push_back(items);
+                    continue;
+                }
+            }
+            // One item done; it may complete its enclosing containers too
+            while (!open.empty() && --open.back() == 0)
+                open.pop_back();
+        } while (!open.empty());
+        return Status::OK;
+    }
+
+    Status decode(VMValue &out, int depth = 0, bool asKey = false) {
+        if (depth > kMaxDepth)
+            return Status::INVALID;
+        Header h;
+        Status status = readHeader(h);
+        if (status != Status::OK)
+            return status;
+        switch (h.kind) {
+        case Kind::NIL:
+            out = nullptr;
+            return Status::OK;
+        case Kind::BOOL:
+            out = h.flag;
+            return Status::OK;
+        case Kind::NUMBER:
+            out = h.number;
+            return Status::OK;
+        case Kind::SKIP:
+            if (need(h.length) != Status::OK)
+                return Status::NEED_MORE;
+            pos += h.length;
+            out = nullptr;
+            return Status::OK;
+        case Kind::STRING: {
+            if (need(h.length) != Status::OK)
+                return Status::NEED_MORE;
+            std::string_view bytes = src.substr(pos, h.length);
+            pos += h.length;
+            out = asKey ? makeKey(bytes) : VMValue(std::string(bytes));
+            return Status::OK;
+        }
+        case Kind::ARRAY: {
+            // Every element takes at least one byte; reject counts that
+            // could not fit before reserving for them
+            if (need(h.length) != Status::OK)
+                return Status::NEED_MORE;
+            std::vector<VMValue> elements;
+            elements.reserve(h.length);
+            for (size_t i = 0; i < h.length; i++) {
+                VMValue element;
+                status = decode(element, depth + 1);
+                if (status != Status::OK)
+                    return status;
+                elements.push_back(element);
+            }
+            out = new ObjList(elements);
+            return Status::OK;
+        }
+        case Kind::MAP: {
+            auto map = new ObjMap();
+            map->values.reserve(h.length < 4096 ? h.length : 4096);
+            for (size_t i = 0; i < h.length; i++) {
+                VMValue key, value;
+                status = decode(key, depth + 1, true);
+                if (status == Status::OK)
+                    status = decode(value, depth + 1);
+                if (status != Status::OK)
+                    return status;
+                map->values[key] = value;
+            }
+            out = map;
+            return Status::OK;
+        }
+        }
+        return Status::INVALID;
+    }
+};
+
+bool decodeValue(std::string_view bytes, VMValue &out) {
+    KeyTable keys;
+    Reader reader(bytes, keys);
+    return reader.decode(out) == Status::OK && reader.pos == bytes.size();
+}
+
+// ---- Streaming decoder ----
+
+struct Decoder {
+    std::string buffer;
+    size_t pos = 0;
+    // Scan state of the incomplete value at pos, kept between feeds so
+    // each byte is scanned once however many chunks the value spans
+    size_t scanned = 0;
+    std::vector<size_t> open;
+    KeyTable keys;
+};
+
+static void freeDecoder(void *ptr) {
+    delete static_cast<Decoder *>(ptr);
+}
+
+static void traceDecoder(void *ptr) {
+    for (auto &entry : static_cast<Decoder *>(ptr)->keys)
+        GC::markValue(entry.second);
+}
+
+static Decoder *unwrapDecoder(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeDecoder)
+        return nullptr;
+    return static_cast<Decoder *>(value.asInstance()->nativeData);
+}
+
+static VMValue msgpackEncode(int argCount, VMValue *args) {
+    if (argCount != 1)
+        return nullptr;
+    std::string out;
+    if (!encodeValue(args[0], out))
+        return nullptr;
+    return out;
+}
+
+static VMValue msgpackDecode(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    VMValue value;
+    if (!decodeValue(args[0].asString()->flatView(), value))
+        return nullptr;
+    return value;
+}
+
+static VMValue msgpackDecoder(int argCount, VMValue *args) {
+    (void)args;
+    if (argCount != 0)
+        return nullptr;
+    auto instance = new ObjInstance(currentVM->globals["MsgPackDecoder"].asClass());
+    instance->nativeData = new Decoder();
+    instance->freeFn = freeDecoder;
+    instance->traceFn = traceDecoder;
+    return instance;
+}
+
+// Appends a chunk and returns every value completed by it. A value is
+// only built once all of its bytes have arrived.
+static VMValue decoderFeed(int argCount, VMValue *args) {
+    Decoder *decoder = unwrapDecoder(args[-1]);
+    if (!decoder || argCount != 1 || !args[0].isString())
+        return nullptr;
+    decoder->buffer += args[0].asString()->flatView();
+
+    auto values = new ObjList(std::vector<VMValue>{});
+    while (decoder->pos < decoder->buffer.size()) {
+        std::string_view rest = std::string_view(decoder->buffer).substr(decoder->pos);
+        Reader scan(rest, decoder->keys);
+        scan.pos = decoder->scanned;
+        Status status = scan.skip(decoder->open);
+        if (status == Status::NEED_MORE) {
+            decoder->scanned = scan.pos;
+            break;
+        }
+        if (status == Status::INVALID) {
+            decoder->buffer.clear();
+            decoder->pos = 0;
+            decoder->scanned = 0;
+            decoder->open.clear();
+            return makeResultErr(currentVM, "Malformed MessagePack data");
+        }
+        decoder->scanned = 0;
+        Reader reader(rest.substr(0, scan.pos), decoder->keys);
+        VMValue value;
+        reader.decode(value);
+        values->elements.push_back(value);
+        decoder->pos += scan.pos;
+    }
+    decoder->buffer.erase(0, decoder->pos);
+    decoder->pos = 0;
+    return makeResultOk(currentVM, values);
+}
+
+static VMValue decoderPending(int argCount, VMValue *args) {
+    (void)argCount;
+    Decoder *decoder = unwrapDecoder(args[-1]);
+    if (!decoder)
+        return nullptr;
+    return static_cast<double>(decoder->buffer.size());
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto msgpackClass = new ObjClass("MsgPack");
+    msgpackClass->statics["encode"] = new ObjNative("encode", 1, msgpackEncode);
+    msgpackClass->statics["decode"] = new ObjNative("decode", 1, msgpackDecode);
+    msgpackClass->statics["decoder"] = new ObjNative("decoder", 0, msgpackDecoder);
+    vm->globals["MsgPack"] = msgpackClass;
+
+    auto decoderClass = new ObjClass("MsgPackDecoder");
+    decoderClass->methods["feed"] = new ObjNative("feed", 1, decoderFeed);
+    decoderClass->methods["pending"] = new ObjNative("pending", 0, decoderPending);
+    vm->globals["MsgPackDecoder"] = decoderClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.type = "class";
+    sym.isConst = true;
+    sym.name = "MsgPack";
+    scope->define(sym);
+    sym.name = "MsgPackDecoder";
+    scope->define(sym);
+}
+
+} // namespace MsgPackModule
+} // namespace StdLib
@@ -0,0 +1,24 @@
+#ifndef TRYPILLIA_MSGPACK_H
+#define TRYPILLIA_MSGPACK_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+#include <string>
+#include <string_view>
+
+namespace StdLib {
+namespace MsgPackModule {
+
+// Appends the MessagePack encoding of `value` to `out`. Fails (leaving
+// `out` partly written) when the graph nests deeper than the decoder
+// accepts, which is also how cycles are caught.
+bool encodeValue(VMValue value, std::string &out);
+// Decodes one value that must span all of `bytes`; false if malformed.
+bool decodeValue(std::string_view bytes, VMValue &out);
+
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace MsgPackModule
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,767 @@
+#include "NDArray.h"
+#include "../StdLib.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace StdLib {
+namespace NDArrayModule {
+
+// Strided view over shared float64 storage. Slices, transposes and reshapes
+// of contiguous arrays share `storage` with the array they came from.
+struct NDArrayData {
+    std::shared_ptr<std::vector<double>> storage;
+    size_t offset = 0;
+    std::vector<size_t> shape;
+    std::vector<ptrdiff_t> strides; // in elements, not bytes
+
+    size_t size() const {
+        size_t n = 1;
+        for (size_t dim : shape)
+            n *= dim;
+        return n;
+    }
+
+    bool isContiguous() const {
+        ptrdiff_t expected = 1;
+        for (size_t d = shape.size(); d-- > 0;) {
+            if (shape[d] != 1 && strides[d] != expected)
+                return false;
+            expected *= static_cast<ptrdiff_t>(shape[d]);
+        }
+        return true;
+    }
+
+    double *data() const {
+        return storage->data() + offset;
+    }
+};
+
+static std::vector<ptrdiff_t> contiguousStrides(const std::vector<size_t> &shape) {
+    std::vector<ptrdiff_t> strides(shape.size());
+    ptrdiff_t stride = 1;
+    for (size_t d = shape.size(); d-- > 0;) {
+        strides[d] = stride;
+        stride *= static_cast<ptrdiff_t>(shape[d]);
+    }
+    return strides;
+}
+
+// Largest element count whose byte size and strides stay representable
+static constexpr size_t kMaxElements = static_cast<size_t>(std::numeric_limits<ptrdiff_t>::max()) / sizeof(double);
+
+// Element count of `shape`, or false if it overflows or exceeds kMaxElements
+static bool elementCount(const std::vector<size_t> &shape, size_t &out) {
+    out = 1;
+    for (size_t dim : shape) {
+        if (dim == 0) {
+            out = 0;
+            return true;
+        }
+    }
+    for (size_t dim : shape) {
+        if (out > kMaxElements / dim)
+            return false;
+        out *= dim;
+    }
+    return true;
+}
+
+// nullptr when the shape is too large or the storage cannot be allocated
+static NDArrayData *allocate(const std::vector<size_t> &shape, double fill = 0.0) {
+    size_t count;
+    if (!elementCount(shape, count))
+        return nullptr;
+    auto data = std::make_unique<NDArrayData>();
+    data->shape = shape;
+    data->strides = contiguousStrides(shape);
+    try {
+        data->storage = std::make_shared<std::vector<double>>(count, fill);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+    return data.release();
+}
+
+static NDArrayData *view(const NDArrayData &source) {
+    return new NDArrayData(source);
+}
+
+static void freeArray(void *ptr) {
+    delete static_cast<NDArrayData *>(ptr);
+}
+
+static VMValue wrap(NDArrayData *data) {
+    if (!data)
+        return nullptr;
+    auto klass = currentVM->globals.find("NDArray");
+    if (klass == currentVM->globals.end() || !klass->second.isClass()) {
+        delete data;
+        return nullptr;
+    }
+    auto instance = new ObjInstance(klass->second.asClass());
+    instance->nativeData = data;
+    instance->freeFn = freeArray;
+    return instance;
+}
+
+static NDArrayData *unwrap(VMValue value) {
+    if (!value.isInstance())
+        return nullptr;
+    auto instance = value.asInstance();
+    if (instance->freeFn != freeArray)
+        return nullptr;
+    return static_cast<NDArrayData *>(instance->nativeData);
+}
+
+static bool toIndex(VMValue value, size_t &out) {
+    if (!value.isNumber())
+        return false;
+    double number = value.asNumber();
+    if (!(number >= 0) || number > static_cast<double>(kMaxElements) || number != std::floor(number))
+        return false;
+    out = static_cast<size_t>(number);
+    return true;
+}
+
+static bool readShape(VMValue value, std::vector<size_t> &shape) {
+    shape.clear();
+    size_t dim;
+    if (toIndex(value, dim)) {
+        shape.push_back(dim);
+        return true;
+    }
+    if (!value.isList())
+        return false;
+    for (const VMValue &element : value.asList()->elements) {
+        if (!toIndex(element, dim))
+            return false;
+        shape.push_back(dim);
+    }
+    size_t count;
+    return elementCount(shape, count);
+}
+
+// ------------------------------------------------------------
+// Strided iteration
+// ------------------------------------------------------------
+
+// Walks `shape` in row-major order and calls row(ptrs, innerStrides, n) once
+// per innermost row, so contiguous rows run as tight (vectorizable) loops.
+template <size_t N, typename RowFn>
+static void forEachRow(const std::vector<size_t> &shape, std::array<double *, N> ptrs,
+                       const std::array<std::vector<ptrdiff_t>, N> &strides, RowFn row) {
+    size_t ndim = shape.size();
+    if (ndim == 0) {
+        row(ptrs, std::array<ptrdiff_t, N>{}, 1);
+        return;
+    }
+    for (size_t dim : shape) {
+        if (dim == 0)
+            return;
+    }
+    std::array<ptrdiff_t, N> inner;
+    for (size_t k = 0; k < N; k++)
+        inner[k] = strides[k][ndim - 1];
+    std::vector<size_t> index(ndim - 1, 0);
+    while (true) {
+        row(ptrs, inner, shape[ndim - 1]);
+        size_t d = ndim - 1;
+        while (true) {
+            if (d == 0)
+                return;
+            d--;
+            index[d]++;
+            for (size_t k = 0; k < N; k++)
+                ptrs[k] += strides[k][d];
+            if (index[d] < shape[d])
+                break;
+            for (size_t k = 0; k < N; k++)
+                ptrs[k] -= strides[k][d] * static_cast<ptrdiff_t>(shape[d]);
+            index[d] = 0;
+        }
+    }
+}
+
+static NDArrayData *contiguousCopy(const NDArrayData &source) {
+    NDArrayData *out = allocate(source.shape);
+    if (!out)
+        return nullptr;
+    // Transposed 2-D views are copied tile by tile so that both the reads
+    // and the writes stay within a few cache lines.
+    if (source.shape.size() == 2 && source.strides[0] == 1 && source.shape[0] > 1) {
+        constexpr size_t TILE = 32;
+        size_t rows = source.shape[0], cols = source.shape[1];
+        ptrdiff_t colStride = source.strides[1];
+        const double *in = source.data();
+        double *dst = out->data();
+        for (size_t ii = 0; ii < rows; ii += TILE) {
+            for (size_t jj = 0; jj < cols; jj += TILE) {
+                size_t iEnd = std::min(ii + TILE, rows), jEnd = std::min(jj + TILE, cols);
+                for (size_t j = jj; j < jEnd; j++) {
+                    for (size_t i = ii; i < iEnd; i++)
+                        dst[i * cols + j] = in[i + j * colStride];
+                }
+            }
+        }
+        return out;
+    }
+    forEachRow<2>(source.shape, {out->data(), source.data()}, {out->strides, source.strides},
+                  [](std::array<double *, 2> p, std::array<ptrdiff_t, 2> s, size_t n) {
+                      if (s[1] == 1) {
+                          std::copy(p[1], p[1] + n, p[0]);
+                      } else {
+                          for (size_t i = 0; i < n; i++)
+                              p[0][i] = p[1][i * s[1]];
+                      }
+                  });
+    return out;
+}
+
+// ------------------------------------------------------------
+// Element-wise operations with broadcasting
+// ------------------------------------------------------------
+
+static bool broadcastShape(const std::vector<size_t> &a, const std::vector<size_t> &b, std::vector<size_t> &out) {
+    size_t ndim = std::max(a.size(), b.size());
+    out.assign(ndim, 1);
+    for (size_t i = 0; i < ndim; i++) {
+        size_t da = i < a.size() ? a[a.size() - 1 - i] : 1;
+        size_t db = i < b.size() ? b[b.size() - 1 - i] : 1;
+        if (da != db && da != 1 && db != 1)
+            return false;
+        out[ndim - 1 - i] = da == 1 ? db : da;
+    }
+    return true;
+}
+
+// Strides of `source` stretched to `shape`: broadcast dimensions get stride 0
+static std::vector<ptrdiff_t> broadcastStrides(const NDArrayData &source, const std::vector<size_t> &shape) {
+    std::vector<ptrdiff_t> strides(shape.size(), 0);
+    size_t shift = shape.size() - source.shape.size();
+    for (size_t d = 0; d < source.shape.size(); d++) {
+        if (source.shape[d] != 1)
+            strides[d + shift] = source.strides[d];
+    }
+    return strides;
+}
+
+template <typename Op> static NDArrayData *binaryOp(const NDArrayData &a, const NDArrayData &b, Op op) {
+    std::vector<size_t> shape;
+    if (!broadcastShape(a.shape, b.shape, shape))
+        return nullptr;
+    NDArrayData *out = allocate(shape);
+    if (!out)
+        return nullptr;
+    forEachRow<3>(shape, {out->data(), a.data(), b.data()},
+                  {out->strides, broadcastStrides(a, shape), broadcastStrides(b, shape)},
+                  [&op](std::array<double *, 3> p, std::array<ptrdiff_t, 3> s, size_t n) {
+                      double *__restrict dst = p[0];
+                      const double *x = p[1], *y = p[2];
+                      if (s[1] == 1 && s[2] == 1) {
+                          for (size_t i = 0; i < n; i++)
+                              dst[i] = op(x[i], y[i]);
+                      } else if (s[1] == 1 && s[2] == 0) {
+                          double yv = *y;
+                          for (size_t i = 0; i < n; i++)
+                              dst[i] = op(x[i], yv);
+                      } else if (s[1] == 0 && s[2] == 1) {
+                          double xv = *x;
+                          for (size_t i = 0; i < n; i++)
+                              dst[i] = op(xv, y[i]);
+                      } else {
+                          for (size_t i = 0; i < n; i++)
+                              dst[i] = op(x[i * s[1]], y[i * s[2]]);
+                      }
+                  });
+    return out;
+}
+
+// Right-hand operand of an element-wise method: an NDArray or a number
+static std::unique_ptr<NDArrayData> operand(VMValue value) {
+    if (NDArrayData *array = unwrap(value))
+        return std::make_unique<NDArrayData>(*array);
+    if (!value.isNumber())
+        return nullptr;
+    std::unique_ptr<NDArrayData> scalar(allocate({}, value.asNumber()));
+    return scalar;
+}
+
+template <typename Op> static VMValue elementwise(int argCount, VMValue *args, Op op) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 1 || !self)
+        return nullptr;
+    auto other = operand(args[0]);
+    if (!other)
+        return nullptr;
+    return wrap(binaryOp(*self, *other, op));
+}
+
+static VMValue ndAdd(int argCount, VMValue *args) {
+    return elementwise(argCount, args, [](double x, double y) { return x + y; });
+}
+
+static VMValue ndSub(int argCount, VMValue *args) {
+    return elementwise(argCount, args, [](double x, double y) { return x - y; });
+}
+
+static VMValue ndMul(int argCount, VMValue *args) {
+    return elementwise(argCount, args, [](double x, double y) { return x * y; });
+}
+
+static VMValue ndDiv(int argCount, VMValue *args) {
+    return elementwise(argCount, args, [](double x, double y) { return x / y; });
+}
+
+// ------------------------------------------------------------
+// Reductions
+// ------------------------------------------------------------
+
+struct Reducer {
+    double init;
+    double (*combine)(double, double);
+    bool mean;
+};
+
+static double reduceRow(const Reducer &reducer, const double *p, ptrdiff_t stride, size_t n) {
+    double acc = reducer.init;
+    if (stride == 1) {
+        for (size_t i = 0; i < n; i++)
+            acc = reducer.combine(acc, p[i]);
+    } else {
+        for (size_t i = 0; i < n; i++)
+            acc = reducer.combine(acc, p[i * stride]);
+    }
+    return acc;
+}
+
+// reduce() over every element, or reduce(axis) into an array with that axis removed
+static VMValue reduce(int argCount, VMValue *args, const Reducer &reducer) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (!self || argCount > 1)
+        return nullptr;
+
+    if (argCount == 0) {
+        double acc = reducer.init;
+        forEachRow<1>(self->shape, {self->data()}, {self->strides},
+                      [&](std::array<double *, 1> p, std::array<ptrdiff_t, 1> s, size_t n) {
+                          acc = reducer.combine(acc, reduceRow(reducer, p[0], s[0], n));
+                      });
+        if (reducer.mean)
+            acc /= static_cast<double>(self->size());
+        return acc;
+    }
+
+    size_t axis;
+    if (!toIndex(args[0], axis) || axis >= self->shape.size())
+        return nullptr;
+    // Move the reduced axis last so each innermost row is one output element
+    std::vector<size_t> shape, outShape;
+    std::vector<ptrdiff_t> strides;
+    for (size_t d = 0; d < self->shape.size(); d++) {
+        if (d == axis)
+            continue;
+        shape.push_back(self->shape[d]);
+        outShape.push_back(self->shape[d]);
+        strides.push_back(self->strides[d]);
+    }
+    shape.push_back(self->shape[axis]);
+    strides.push_back(self->strides[axis]);
+
+    NDArrayData *out = allocate(outShape, reducer.init);
+    if (!out)
+        return nullptr;
+    std::vector<ptrdiff_t> outStrides = out->strides;
+    outStrides.push_back(0);
+    size_t count = self->shape[axis];
+    forEachRow<2>(shape, {self->data(), out->data()}, {strides, outStrides},
+                  [&](std::array<double *, 2> p, std::array<ptrdiff_t, 2> s, size_t n) {
+                      double acc = reduceRow(reducer, p[0], s[0], n);
+                      *p[1] = reducer.mean ? acc / static_cast<double>(count) : acc;
+                  });
+    return wrap(out);
+}
+
+static double addValues(double a, double b) {
+    return a + b;
+}
+
+static double minValue(double a, double b) {
+    return b < a ? b : a;
+}
+
+static double maxValue(double a, double b) {
+    return b > a ? b : a;
+}
+
+static VMValue ndSum(int argCount, VMValue *args) {
+    return reduce(argCount, args, {0.0, addValues, false});
+}
+
+static VMValue ndMean(int argCount, VMValue *args) {
+    return reduce(argCount, args, {0.0, addValues, true});
+}
+
+static VMValue ndMin(int argCount, VMValue *args) {
+    return reduce(argCount, args, {std::numeric_limits<double>::infinity(), minValue, false});
+}
+
+static VMValue ndMax(int argCount, VMValue *args) {
+    return reduce(argCount, args, {-std::numeric_limits<double>::infinity(), maxValue, false});
+}
+
+// ------------------------------------------------------------
+// Matrix multiply
+// ------------------------------------------------------------
+
+static constexpr size_t MATMUL_BLOCK = 64;
+
+// C[rowBegin..rowEnd) += A * B for contiguous row-major A (M x K), B (K x N).
+// Blocking keeps a BLOCK x BLOCK tile of B hot in cache while the innermost
+// loop streams over contiguous rows of B and C.
+static void matmulRows(const double *a, const double *b, double *c, size_t rowBegin, size_t rowEnd, size_t K,
+                       size_t N) {
+    for (size_t ii = rowBegin; ii < rowEnd; ii += MATMUL_BLOCK) {
+        size_t iEnd = std::min(ii + MATMUL_BLOCK, rowEnd);
+        for (size_t kk = 0; kk < K; kk += MATMUL_BLOCK) {
+            size_t kEnd = std::min(kk + MATMUL_BLOCK, K);
+            for (size_t jj = 0; jj < N; jj += MATMUL_BLOCK) {
+                size_t jEnd = std::min(jj + MATMUL_BLOCK, N);
+                for (size_t i = ii; i < iEnd; i++) {
+                    double *__restrict cRow = c + i * N;
+                    for (size_t k = kk; k < kEnd; k++) {
+                        double aik = a[i * K + k];
+                        const double *__restrict bRow = b + k * N;
+                        for (size_t j = jj; j < jEnd; j++)
+                            cRow[j] += aik * bRow[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static VMValue ndMatmul(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    NDArrayData *other = argCount == 1 ? unwrap(args[0]) : nullptr;
+    if (!self || !other || self->shape.size() != 2 || other->shape.size() != 2 ||
+        self->shape[1] != other->shape[0])
+        return nullptr;
+
+    std::unique_ptr<NDArrayData> aCopy, bCopy;
+    const NDArrayData *a = self, *b = other;
+    if (!a->isContiguous()) {
+        aCopy.reset(contiguousCopy(*a));
+        if (!aCopy)
+            return nullptr;
+        a = aCopy.get();
+    }
+    if (!b->isContiguous()) {
+        bCopy.reset(contiguousCopy(*b));
+        if (!bCopy)
+            return nullptr;
+        b = bCopy.get();
+    }
+
+    size_t M = a->shape[0], K = a->shape[1], N = b->shape[1];
+    NDArrayData *out = allocate({M, N});
+    if (!out)
+        return nullptr;
+    const double *aData = a->data(), *bData = b->data();
+    double *cData = out->data();
+
+    // Large products are split by row blocks across hardware threads
+    unsigned threads = 1;
+    if (M * N * K >= (1u << 21))
+        threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(),
+                                                  static_cast<unsigned>((M + MATMUL_BLOCK - 1) / MATMUL_BLOCK)));
+    if (threads <= 1) {
+        matmulRows(aData, bData, cData, 0, M, K, N);
+        return wrap(out);
+    }
+    size_t rowsPerThread = (M + threads - 1) / threads;
+    rowsPerThread = (rowsPerThread + MATMUL_BLOCK - 1) / MATMUL_BLOCK * MATMUL_BLOCK;
+    std::vector<std::thread> pool;
+    for (size_t begin = 0; begin < M; begin += rowsPerThread) {
+        size_t end = std::min(begin + rowsPerThread, M);
+        pool.emplace_back(matmulRows, aData, bData, cData, begin, end, K, N);
+    }
+    for (auto &thread : pool)
+        thread.join();
+    return wrap(out);
+}
+
+// ------------------------------------------------------------
+// Views
+// ------------------------------------------------------------
+
+static VMValue ndTranspose(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 0 || !self)
+        return nullptr;
+    NDArrayData *out = view(*self);
+    std::reverse(out->shape.begin(), out->shape.end());
+    std::reverse(out->strides.begin(), out->strides.end());
+    return wrap(out);
+}
+
+// slice(axis, start, end, step = 1)
+static VMValue ndSlice(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (!self || argCount < 3 || argCount > 4)
+        return nullptr;
+    size_t axis, start, end, step = 1;
+    if (!toIndex(args[0], axis) || !toIndex(args[1], start) || !toIndex(args[2], end) ||
+        (argCount == 4 && !toIndex(args[3], step)) || axis >= self->shape.size() || step == 0)
+        return nullptr;
+    end = std::min(end, self->shape[axis]);
+    start = std::min(start, end);
+
+    NDArrayData *out = view(*self);
+    out->offset += start * self->strides[axis];
+    out->shape[axis] = (end - start + step - 1) / step;
+    out->strides[axis] *= static_cast<ptrdiff_t>(step);
+    return wrap(out);
+}
+
+static VMValue ndReshape(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    std::vector<size_t> shape;
+    if (argCount != 1 || !self || !readShape(args[0], shape))
+        return nullptr;
+    NDArrayData *out = self->isContiguous() ? view(*self) : contiguousCopy(*self);
+    if (!out)
+        return nullptr;
+    out->shape = shape;
+    if (out->size() != self->size()) {
+        delete out;
+        return nullptr;
+    }
+    out->strides = contiguousStrides(shape);
+    return wrap(out);
+}
+
+static VMValue ndCopy(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 0 || !self)
+        return nullptr;
+    return wrap(contiguousCopy(*self));
+}
+
+// ------------------------------------------------------------
+// Element access and metadata
+// ------------------------------------------------------------
+
+static double *elementAt(NDArrayData *self, VMValue *indices, int count) {
+    if (count != static_cast<int>(self->shape.size()))
+        return nullptr;
+    double *p = self->data();
+    for (int d = 0; d < count; d++) {
+        size_t index;
+        if (!toIndex(indices[d], index) || index >= self->shape[d])
+            return nullptr;
+        p += static_cast<ptrdiff_t>(index) * self->strides[d];
+    }
+    return p;
+}
+
+static VMValue ndGet(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (!self)
+        return nullptr;
+    double *p = elementAt(self, args, argCount);
+    if (!p)
+        return nullptr;
+    return *p;
+}
+
+// set(i, j, ..., value) writes through to every view sharing the storage
+static VMValue ndSet(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (!self || argCount < 1 || !args[argCount - 1].isNumber())
+        return nullptr;
+    double *p = elementAt(self, args, argCount - 1);
+    if (!p)
+        return nullptr;
+    *p = args[argCount - 1].asNumber();
+    return args[-1];
+}
+
+static VMValue ndShape(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 0 || !self)
+        return nullptr;
+    std::vector<VMValue> dims;
+    for (size_t dim : self->shape)
+        dims.push_back(static_cast<double>(dim));
+    return new ObjList(dims);
+}
+
+static VMValue ndNdim(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 0 || !self)
+        return nullptr;
+    return static_cast<double>(self->shape.size());
+}
+
+static VMValue ndSize(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 0 || !self)
+        return nullptr;
+    return static_cast<double>(self->size());
+}
+
+// ------------------------------------------------------------
+// ObjList interop
+// ------------------------------------------------------------
+
+static VMValue exportList(const NDArrayData &self, size_t dim, const double *p) {
+    if (dim == self.shape.size())
+        return *p;
+    std::vector<VMValue> elements;
+    elements.reserve(self.shape[dim]);
+    for (size_t i = 0; i < self.shape[dim]; i++)
+        elements.push_back(exportList(self, dim + 1, p + static_cast<ptrdiff_t>(i) * self.strides[dim]));
+    return new ObjList(elements);
+}
+
+static VMValue ndToList(int argCount, VMValue *args) {
+    NDArrayData *self = unwrap(args[-1]);
+    if (argCount != 0 || !self)
+        return nullptr;
+    return exportList(*self, 0, self->data());
+}
+
+static bool importList(VMValue value, const std::vector<size_t> &shape, size_t dim, std::vector<double> &out) {
+    if (dim == shape.size()) {
+        if (!value.isNumber())
+            return false;
+        out.push_back(value.asNumber());
+        return true;
+    }
+    if (!value.isList() || value.asList()->elements.size() != shape[dim])
+        return false;
+    for (const VMValue &element : value.asList()->elements) {
+        if (!importList(element, shape, dim + 1, out))
+            return false;
+    }
+    return true;
+}
+
+// NDArray.fromList([[1, 2], [3, 4]]): the shape is taken from the first
+// element at each depth and every other element must match it.
+static VMValue ndFromList(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isList())
+        return nullptr;
+    std::vector<size_t> shape;
+    for (VMValue level = args[0]; level.isList();) {
+        auto &elements = level.asList()->elements;
+        shape.push_back(elements.size());
+        if (elements.empty())
+            break;
+        level = elements[0];
+    }
+    std::vector<double> values;
+    if (!importList(args[0], shape, 0, values))
+        return nullptr;
+    NDArrayData *data = allocate(shape);
+    if (!data)
+        return nullptr;
+    std::copy(values.begin(), values.end(), data->data());
+    return wrap(data);
+}
+
+static VMValue ndZeros(int argCount, VMValue *args) {
+    std::vector<size_t> shape;
+    if (argCount != 1 || !readShape(args[0], shape))
+        return nullptr;
+    return wrap(allocate(shape));
+}
+
+static VMValue ndOnes(int argCount, VMValue *args) {
+    std::vector<size_t> shape;
+    if (argCount != 1 || !readShape(args[0], shape))
+        return nullptr;
+    return wrap(allocate(shape, 1.0));
+}
+
+static VMValue ndFull(int argCount, VMValue *args) {
+    std::vector<size_t> shape;
+    if (argCount != 2 || !readShape(args[0], shape) || !args[1].isNumber())
+        return nullptr;
+    return wrap(allocate(shape, args[1].asNumber()));
+}
+
+// arange(stop) or arange(start, stop, step = 1)
+static VMValue ndArange(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 3)
+        return nullptr;
+    for (int i = 0; i < argCount; i++) {
+        if (!args[i].isNumber())
+            return nullptr;
+    }
+    double start = argCount == 1 ? 0.0 : args[0].asNumber();
+    double stop = argCount == 1 ? args[0].asNumber() : args[1].asNumber();
+    double step = argCount == 3 ? args[2].asNumber() : 1.0;
+    if (step == 0 || !std::isfinite(start) || !std::isfinite(stop))
+        return nullptr;
+    double count = std::ceil((stop - start) / step);
+    if (!(count <= static_cast<double>(kMaxElements)))
+        return nullptr;
+    NDArrayData *data = allocate({count > 0 ? static_cast<size_t>(count) : 0});
+    if (!data)
+        return nullptr;
+    double *p = data->data();
+    for (size_t i = 0; i < data->shape[0]; i++)
+        p[i] = start + static_cast<double>(i) * step;
+    return wrap(data);
+}
+
+void registerAll(VM *vm) {
+    auto ndClass = new ObjClass("NDArray");
+
+    ndClass->statics["fromList"] = new ObjNative("fromList", 1, ndFromList);
+    ndClass->statics["zeros"] = new ObjNative("zeros", 1, ndZeros);
+    ndClass->statics["ones"] = new ObjNative("ones", 1, ndOnes);
+    ndClass->statics["full"] = new ObjNative("full", 2, ndFull);
+    ndClass->statics["arange"] = new ObjNative("arange", -1, ndArange);
+
+    ndClass->methods["shape"] = new ObjNative("shape", 0, ndShape);
+    ndClass->methods["ndim"] = new ObjNative("ndim", 0, ndNdim);
+    ndClass->methods["size"] = new ObjNative("size", 0, ndSize);
+    ndClass->methods["get"] = new ObjNative("get", -1, ndGet);
+    ndClass->methods["set"] = new ObjNative("set", -1, ndSet);
+    ndClass->methods["toList"] = new ObjNative("toList", 0, ndToList);
+    ndClass->methods["add"] = new ObjNative("add", 1, ndAdd);
+    ndClass->methods["sub"] = new ObjNative("sub", 1, ndSub);
+    ndClass->methods["mul"] = new ObjNative("mul", 1, ndMul);
+    ndClass->methods["div"] = new ObjNative("div", 1, ndDiv);
+    ndClass->methods["sum"] = new ObjNative("sum", -1, ndSum);
+    ndClass->methods["mean"] = new ObjNative("mean", -1, ndMean);
+    ndClass->methods["min"] = new ObjNative("min", -1, ndMin);
+    ndClass->methods["max"] = new ObjNative("max", -1, ndMax);
+    ndClass->methods["matmul"] = new ObjNative("matmul", 1, ndMatmul);
+    ndClass->methods["transpose"] = new ObjNative("transpose", 0, ndTranspose);
+    ndClass->methods["slice"] = new ObjNative("slice", -1, ndSlice);
+    ndClass->methods["reshape"] = new ObjNative("reshape", 1, ndReshape);
+    ndClass->methods["copy"] = new ObjNative("copy", 0, ndCopy);
+
+    vm->globals["NDArray"] = ndClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "NDArray";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+}
+
+} // namespace NDArrayModule
+} // namespace StdLib
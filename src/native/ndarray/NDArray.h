@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_NDARRAY_H
+#define TRYPILLIA_NDARRAY_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace NDArrayModule {
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace NDArrayModule
+} // namespace StdLib
+
+#endif
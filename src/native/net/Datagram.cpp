@@ -0,0 +1,527 @@
+#include "Datagram.h"
+#include "../StdLib.h"
+#include "Net.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace StdLib {
+namespace DatagramModule {
+
+#ifndef _WIN32
+
+constexpr size_t kMaxDatagram = 65536;
+// sendmmsg/recvmmsg move at most this many datagrams per call (UIO_MAXIOV)
+constexpr size_t kMaxBatch = 1024;
+constexpr size_t kDefaultBatch = 64;
+constexpr size_t kDefaultBatchBytes = 2048;
+
+struct DatagramData {
+    int fd = -1;
+    int family = AF_INET;
+    // Path this socket is bound to, removed again on close
+    std::string boundPath;
+    // Last resolved peer, so repeated sends skip the resolver
+    std::string cachedHost;
+    int cachedPort = -1;
+    sockaddr_storage cachedAddr{};
+    socklen_t cachedLen = 0;
+    // Reused receive buffers for recvBatch
+    std::vector<char> batchBuffer;
+#ifdef __linux__
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> vectors;
+#endif
+
+    void close() {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+        if (!boundPath.empty())
+            unlink(boundPath.c_str());
+        boundPath.clear();
+    }
+
+    ~DatagramData() {
+        close();
+    }
+};
+
+static void freeDatagram(void *ptr) {
+    delete static_cast<DatagramData *>(ptr);
+}
+
+static DatagramData *unwrapDatagram(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeDatagram)
+        return nullptr;
+    DatagramData *data = static_cast<DatagramData *>(value.asInstance()->nativeData);
+    return data && data->fd >= 0 ? data : nullptr;
+}
+
+static bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static VMValue errnoErr(const std::string &what) {
+    return makeResultErr(currentVM, what + ": " + strerror(errno));
+}
+
+static bool unixAddress(const std::string &path, sockaddr_storage &addr, socklen_t &len) {
+    sockaddr_un *un = reinterpret_cast<sockaddr_un *>(&addr);
+    if (path.empty() || path.size() >= sizeof(un->sun_path))
+        return false;
+    memset(&addr, 0, sizeof(addr));
+    un->sun_family = AF_UNIX;
+    memcpy(un->sun_path, path.data(), path.size());
+    len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    return true;
+}
+
+static bool resolveHost(DatagramData *data, const std::string &host, int port, sockaddr_storage &addr,
+                        socklen_t &len) {
+    if (port < 0 || port > 65535)
+        return false;
+    if (data->cachedPort == port && data->cachedHost == host) {
+        addr = data->cachedAddr;
+        len = data->cachedLen;
+        return true;
+    }
+    memset(&addr, 0, sizeof(addr));
+    if (data->family == AF_INET6) {
+        sockaddr_in6 *in6 = reinterpret_cast<sockaddr_in6 *>(&addr);
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(static_cast<uint16_t>(port));
+        len = sizeof(sockaddr_in6);
+        if (inet_pton(AF_INET6, host.c_str(), &in6->sin6_addr) != 1) {
+            struct addrinfo hints {};
+            struct addrinfo *list = nullptr;
+            hints.ai_family = AF_INET6;
+            hints.ai_socktype = SOCK_DGRAM;
+            if (getaddrinfo(host.c_str(), nullptr, &hints, &list) != 0 || !list)
+                return false;
+            in6->sin6_addr = reinterpret_cast<sockaddr_in6 *>(list->ai_addr)->sin6_addr;
+            freeaddrinfo(list);
+        }
+    } else {
+        sockaddr_in *in4 = reinterpret_cast<sockaddr_in *>(&addr);
+        in4->sin_family = AF_INET;
+        in4->sin_port = htons(static_cast<uint16_t>(port));
+        len = sizeof(sockaddr_in);
+        if (inet_pton(AF_INET, host.c_str(), &in4->sin_addr) != 1) {
+            struct addrinfo hints {};
+            struct addrinfo *list = nullptr;
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_DGRAM;
+            if (getaddrinfo(host.c_str(), nullptr, &hints, &list) != 0 || !list)
+                return false;
+            in4->sin_addr = reinterpret_cast<sockaddr_in *>(list->ai_addr)->sin_addr;
+            freeaddrinfo(list);
+        }
+    }
+    data->cachedHost = host;
+    data->cachedPort = port;
+    data->cachedAddr = addr;
+    data->cachedLen = len;
+    return true;
+}
+
+// Destination from trailing arguments: (host, port) for UDP, (path) for
+// Unix sockets.
+static bool peerArgs(DatagramData *data, int argCount, VMValue *args, sockaddr_storage &addr, socklen_t &len) {
+    if (data->family == AF_UNIX)
+        return argCount == 1 && args[0].isString() && unixAddress(args[0].asString()->flatten(), addr, len);
+    int port;
+    return argCount == 2 && args[0].isString() && Net::portArg(args[1], port) &&
+           resolveHost(data, args[0].asString()->flatten(), port, addr, len);
+}
+
+static VMValue describeAddress(const sockaddr_storage &addr, socklen_t len) {
+    auto map = new ObjMap();
+    if (addr.ss_family == AF_UNIX) {
+        const sockaddr_un *un = reinterpret_cast<const sockaddr_un *>(&addr);
+        size_t max = len > offsetof(sockaddr_un, sun_path) ? len - offsetof(sockaddr_un, sun_path) : 0;
+        map->values[VMValue(std::string("path"))] = std::string(un->sun_path, strnlen(un->sun_path, max));
+        return map;
+    }
+    char host[INET6_ADDRSTRLEN] = {0};
+    int port = 0;
+    if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6 *in6 = reinterpret_cast<const sockaddr_in6 *>(&addr);
+        inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+        port = ntohs(in6->sin6_port);
+    } else {
+        const sockaddr_in *in4 = reinterpret_cast<const sockaddr_in *>(&addr);
+        inet_ntop(AF_INET, &in4->sin_addr, host, sizeof(host));
+        port = ntohs(in4->sin_port);
+    }
+    map->values[VMValue(std::string("host"))] = std::string(host);
+    map->values[VMValue(std::string("port"))] = static_cast<double>(port);
+    return map;
+}
+
+static VMValue wrap(DatagramData *data) {
+    auto instance = new ObjInstance(currentVM->globals["Datagram"].asClass());
+    instance->nativeData = data;
+    instance->freeFn = freeDatagram;
+    return makeResultOk(currentVM, instance);
+}
+
+// Datagram.udp(port?, host?): bound when a port is given (0 picks one)
+static VMValue datagramUdp(int argCount, VMValue *args) {
+    if (argCount > 2 || (argCount >= 1 && !args[0].isNumber() && !args[0].isNil()) ||
+        (argCount == 2 && !args[1].isString()))
+        return nullptr;
+    DatagramData *data = new DatagramData();
+    sockaddr_storage addr{};
+    socklen_t len = 0;
+    bool bindIt = argCount >= 1 && args[0].isNumber();
+    if (bindIt) {
+        std::string host = argCount == 2 ? args[1].asString()->flatten() : "0.0.0.0";
+        data->family = host.find(':') != std::string::npos ? AF_INET6 : AF_INET;
+        int port;
+        if (!Net::portArg(args[0], port) || !resolveHost(data, host, port, addr, len)) {
+            delete data;
+            return makeResultErr(currentVM, "Invalid address");
+        }
+    }
+    data->fd = socket(data->family, SOCK_DGRAM, 0);
+    if (data->fd < 0) {
+        delete data;
+        return errnoErr("Socket failed");
+    }
+    if (bindIt && bind(data->fd, reinterpret_cast<sockaddr *>(&addr), len) != 0) {
+        VMValue err = errnoErr("Bind failed");
+        delete data;
+        return err;
+    }
+    return wrap(data);
+}
+
+// Datagram.unix(path?): bound to `path` when given
+static VMValue datagramUnix(int argCount, VMValue *args) {
+    if (argCount > 1 || (argCount == 1 && !args[0].isString()))
+        return nullptr;
+    DatagramData *data = new DatagramData();
+    data->family = AF_UNIX;
+    data->fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (data->fd < 0) {
+        delete data;
+        return errnoErr("Socket failed");
+    }
+    if (argCount == 1) {
+        std::string path = args[0].asString()->flatten();
+        sockaddr_storage addr;
+        socklen_t len;
+        if (!unixAddress(path, addr, len)) {
+            delete data;
+            return makeResultErr(currentVM, "Invalid socket path");
+        }
+        // A socket file left behind by an earlier process would block bind
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+            unlink(path.c_str());
+        if (bind(data->fd, reinterpret_cast<sockaddr *>(&addr), len) != 0) {
+            VMValue err = errnoErr("Bind failed");
+            delete data;
+            return err;
+        }
+        data->boundPath = path;
+    }
+    return wrap(data);
+}
+
+static VMValue datagramConnect(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!data || !peerArgs(data, argCount, args, addr, len))
+        return nullptr;
+    if (connect(data->fd, reinterpret_cast<sockaddr *>(&addr), len) != 0)
+        return errnoErr("Connect failed");
+    return makeResultOk(currentVM, true);
+}
+
+static VMValue datagramSend(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    if (!data || argCount != 1 || !args[0].isString())
+        return nullptr;
+    const std::string &payload = args[0].asString()->flatView();
+    if (send(data->fd, payload.data(), payload.size(), 0) < 0)
+        return wouldBlock() ? makeResultOk(currentVM, false) : errnoErr("Send failed");
+    return makeResultOk(currentVM, true);
+}
+
+static VMValue datagramSendTo(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!data || argCount < 1 || !args[0].isString() || !peerArgs(data, argCount - 1, args + 1, addr, len))
+        return nullptr;
+    const std::string &payload = args[0].asString()->flatView();
+    if (sendto(data->fd, payload.data(), payload.size(), 0, reinterpret_cast<sockaddr *>(&addr), len) < 0)
+        return wouldBlock() ? makeResultOk(currentVM, false) : errnoErr("Send failed");
+    return makeResultOk(currentVM, true);
+}
+
+static bool sizeArg(int argCount, VMValue *args, int index, size_t fallback, size_t max, size_t &out) {
+    out = fallback;
+    if (argCount <= index)
+        return true;
+    if (!args[index].isNumber() || !(args[index].asNumber() >= 1)) // also rejects NaN
+        return false;
+    double requested = args[index].asNumber();
+    out = requested >= static_cast<double>(max) ? max : static_cast<size_t>(requested);
+    return true;
+}
+
+// One datagram; Ok(nil) when the socket is non-blocking and none is queued
+static VMValue datagramRecv(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    size_t max;
+    if (!data || argCount > 1 || !sizeArg(argCount, args, 0, kMaxDatagram, kMaxDatagram, max))
+        return nullptr;
+    std::string payload(max, '\0');
+    ssize_t n = recv(data->fd, payload.data(), max, 0);
+    if (n < 0)
+        return wouldBlock() ? makeResultOk(currentVM, nullptr) : errnoErr("Receive failed");
+    payload.resize(static_cast<size_t>(n));
+    return makeResultOk(currentVM, payload);
+}
+
+static VMValue datagramRecvFrom(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    size_t max;
+    if (!data || argCount > 1 || !sizeArg(argCount, args, 0, kMaxDatagram, kMaxDatagram, max))
+        return nullptr;
+    std::string payload(max, '\0');
+    sockaddr_storage addr{};
+    socklen_t len = sizeof(addr);
+    ssize_t n = recvfrom(data->fd, payload.data(), max, 0, reinterpret_cast<sockaddr *>(&addr), &len);
+    if (n < 0)
+        return wouldBlock() ? makeResultOk(currentVM, nullptr) : errnoErr("Receive failed");
+    payload.resize(static_cast<size_t>(n));
+    VMValue sender = describeAddress(addr, len);
+    sender.asMap()->values[VMValue(std::string("data"))] = payload;
+    return makeResultOk(currentVM, sender);
+}
+
+// sendBatch(messages, host?, port?) / sendBatch(messages, path?): sends
+// every string in `messages`, many per syscall where sendmmsg exists.
+// Returns Ok(count sent); a non-blocking socket may stop early.
+static VMValue datagramSendBatch(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    if (!data || argCount < 1 || !args[0].isList())
+        return nullptr;
+    sockaddr_storage addr;
+    socklen_t len = 0;
+    bool addressed = argCount > 1;
+    if (addressed && !peerArgs(data, argCount - 1, args + 1, addr, len))
+        return nullptr;
+    auto &messages = args[0].asList()->elements;
+    for (auto &message : messages) {
+        if (!message.isString())
+            return nullptr;
+    }
+
+    size_t sent = 0;
+#ifdef __linux__
+    size_t chunk = std::min(messages.size(), kMaxBatch);
+    data->headers.resize(chunk);
+    data->vectors.resize(chunk);
+    while (sent < messages.size()) {
+        size_t count = std::min(messages.size() - sent, kMaxBatch);
+        for (size_t i = 0; i < count; i++) {
+            const std::string &payload = messages[sent + i].asString()->flatView();
+            data->vectors[i].iov_base = const_cast<char *>(payload.data());
+            data->vectors[i].iov_len = payload.size();
+            mmsghdr &header = data->headers[i];
+            memset(&header, 0, sizeof(header));
+            header.msg_hdr.msg_iov = &data->vectors[i];
+            header.msg_hdr.msg_iovlen = 1;
+            if (addressed) {
+                header.msg_hdr.msg_name = &addr;
+                header.msg_hdr.msg_namelen = len;
+            }
+        }
+        int n = sendmmsg(data->fd, data->headers.data(), static_cast<unsigned>(count), 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (wouldBlock())
+                break;
+            return errnoErr("Send failed");
+        }
+        sent += static_cast<size_t>(n);
+    }
+#else
+    for (; sent < messages.size(); sent++) {
+        const std::string &payload = messages[sent].asString()->flatView();
+        ssize_t n = addressed ? sendto(data->fd, payload.data(), payload.size(), 0,
+                                       reinterpret_cast<sockaddr *>(&addr), len)
+                              : send(data->fd, payload.data(), payload.size(), 0);
+        if (n < 0) {
+            if (wouldBlock())
+                break;
+            return errnoErr("Send failed");
+        }
+    }
+#endif
+    return makeResultOk(currentVM, static_cast<double>(sent));
+}
+
+// recvBatch(max?, maxBytes?): waits for one datagram, then takes up to
+// `max` that are already queued, in one syscall where recvmmsg exists.
+// Longer datagrams are truncated to `maxBytes`.
+static VMValue datagramRecvBatch(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    size_t count, size;
+    if (!data || argCount > 2 || !sizeArg(argCount, args, 0, kDefaultBatch, kMaxBatch, count) ||
+        !sizeArg(argCount, args, 1, kDefaultBatchBytes, kMaxDatagram, size))
+        return nullptr;
+    data->batchBuffer.resize(count * size);
+    auto received = new ObjList(std::vector<VMValue>{});
+
+#ifdef __linux__
+    data->headers.resize(count);
+    data->vectors.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        data->vectors[i].iov_base = data->batchBuffer.data() + i * size;
+        data->vectors[i].iov_len = size;
+        mmsghdr &header = data->headers[i];
+        memset(&header, 0, sizeof(header));
+        header.msg_hdr.msg_iov = &data->vectors[i];
+        header.msg_hdr.msg_iovlen = 1;
+    }
+    int n;
+    do {
+        n = recvmmsg(data->fd, data->headers.data(), static_cast<unsigned>(count), MSG_WAITFORONE, nullptr);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return wouldBlock() ? makeResultOk(currentVM, received) : errnoErr("Receive failed");
+    received->elements.reserve(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++)
+        received->elements.push_back(std::string(data->batchBuffer.data() + i * size, data->headers[i].msg_len));
+#else
+    for (size_t i = 0; i < count; i++) {
+        ssize_t n = recv(data->fd, data->batchBuffer.data(), size, i == 0 ? 0 : MSG_DONTWAIT);
+        if (n < 0) {
+            if (wouldBlock())
+                break;
+            if (i == 0)
+                return errnoErr("Receive failed");
+            break;
+        }
+        received->elements.push_back(std::string(data->batchBuffer.data(), static_cast<size_t>(n)));
+    }
+#endif
+    return makeResultOk(currentVM, received);
+}
+
+VMValue localAddress(int fd) {
+    sockaddr_storage addr{};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+        return nullptr;
+    return describeAddress(addr, len);
+}
+
+static VMValue datagramLocalAddress(int argCount, VMValue *args) {
+    (void)argCount;
+    DatagramData *data = unwrapDatagram(args[-1]);
+    if (!data)
+        return nullptr;
+    return localAddress(data->fd);
+}
+
+static VMValue datagramSetBlocking(int argCount, VMValue *args) {
+    DatagramData *data = unwrapDatagram(args[-1]);
+    if (!data || argCount != 1 || !args[0].isBool())
+        return nullptr;
+    int flags = fcntl(data->fd, F_GETFL, 0);
+    flags = args[0].asBool() ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+    return fcntl(data->fd, F_SETFL, flags) == 0;
+}
+
+// The descriptor, for registering with an external poller
+static VMValue datagramFd(int argCount, VMValue *args) {
+    (void)argCount;
+    DatagramData *data = unwrapDatagram(args[-1]);
+    if (!data)
+        return nullptr;
+    return static_cast<double>(data->fd);
+}
+
+static VMValue datagramClose(int argCount, VMValue *args) {
+    (void)argCount;
+    DatagramData *data = unwrapDatagram(args[-1]);
+    if (data)
+        data->close();
+    return makeResultOk(currentVM, true);
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto cls = new ObjClass("Datagram");
+    cls->statics["udp"] = new ObjNative("udp", -1, datagramUdp);
+    cls->statics["unix"] = new ObjNative("unix", -1, datagramUnix);
+    cls->methods["connect"] = new ObjNative("connect", -1, datagramConnect);
+    cls->methods["send"] = new ObjNative("send", 1, datagramSend);
+    cls->methods["sendTo"] = new ObjNative("sendTo", -1, datagramSendTo);
+    cls->methods["recv"] = new ObjNative("recv", -1, datagramRecv);
+    cls->methods["recvFrom"] = new ObjNative("recvFrom", -1, datagramRecvFrom);
+    cls->methods["sendBatch"] = new ObjNative("sendBatch", -1, datagramSendBatch);
+    cls->methods["recvBatch"] = new ObjNative("recvBatch", -1, datagramRecvBatch);
+    cls->methods["localAddress"] = new ObjNative("localAddress", 0, datagramLocalAddress);
+    cls->methods["setBlocking"] = new ObjNative("setBlocking", 1, datagramSetBlocking);
+    cls->methods["fd"] = new ObjNative("fd", 0, datagramFd);
+    cls->methods["close"] = new ObjNative("close", 0, datagramClose);
+    vm->globals["Datagram"] = cls;
+}
+
+#else
+
+VMValue localAddress(int fd) {
+    (void)fd;
+    return nullptr;
+}
+
+static VMValue datagramUnsupported(int argCount, VMValue *args) {
+    (void)argCount;
+    (void)args;
+    return makeResultErr(currentVM, "Datagram sockets are not supported on this platform");
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto cls = new ObjClass("Datagram");
+    cls->statics["udp"] = new ObjNative("udp", -1, datagramUnsupported);
+    cls->statics["unix"] = new ObjNative("unix", -1, datagramUnsupported);
+    vm->globals["Datagram"] = cls;
+}
+
+#endif
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.type = "class";
+    sym.isConst = true;
+    sym.name = "Datagram";
+    scope->define(sym);
+}
+
+} // namespace DatagramModule
+} // namespace StdLib
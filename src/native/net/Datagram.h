@@ -0,0 +1,18 @@
+#ifndef TRYPILLIA_DATAGRAM_H
+#define TRYPILLIA_DATAGRAM_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace DatagramModule {
+// Address descriptor `fd` is bound to: {"host", "port"} for IP sockets,
+// {"path"} for Unix ones; nil if it cannot be read.
+VMValue localAddress(int fd);
+
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace DatagramModule
+} // namespace StdLib
+
+#endif
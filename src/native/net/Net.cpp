@@ -1,5 +1,11 @@
 #include "Net.h"
 #include "../StdLib.h"
+#include "../fs/FS.h"
+#include "../string/StringKernels.h"
+#include "Datagram.h"
+#include "Tls.h"
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -11,9 +17,73 @@
 #include <mbedtls/net_sockets.h>
 #include <mbedtls/ssl.h>
 
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
 namespace StdLib {
 namespace Net {
 
+bool reusePort = false;
+std::atomic<uint64_t> *acceptedConnections = nullptr;
+
+bool portArg(VMValue value, int &port) {
+    if (!value.isNumber() || !(value.asNumber() >= 0 && value.asNumber() <= 65535))
+        return false;
+    port = static_cast<int>(value.asNumber());
+    return true;
+}
+
+int bindListener(mbedtls_net_context *ctx, int port) {
+    std::string service = std::to_string(port);
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+    if (reusePort) {
+        struct addrinfo hints;
+        struct addrinfo *list = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        hints.ai_flags = AI_PASSIVE;
+        if (getaddrinfo(nullptr, service.c_str(), &hints, &list) != 0)
+            return -1;
+        int result = -1;
+        for (struct addrinfo *cur = list; cur != nullptr; cur = cur->ai_next) {
+            int fd = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+            if (fd < 0)
+                continue;
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+            if (bind(fd, cur->ai_addr, cur->ai_addrlen) != 0 || listen(fd, SOMAXCONN) != 0) {
+                close(fd);
+                continue;
+            }
+            ctx->fd = fd;
+            result = 0;
+            break;
+        }
+        freeaddrinfo(list);
+        return result;
+    }
+#endif
+    return mbedtls_net_bind(ctx, NULL, service.c_str(), MBEDTLS_NET_PROTO_TCP);
+}
+
+void countAccepted() {
+    if (acceptedConnections)
+        acceptedConnections->fetch_add(1, std::memory_order_relaxed);
+}
+
 static bool parseUrl(const std::string &url, std::string &host, int &port, std::string &path) {
     size_t pos = 0;
     if (url.find("http://") == 0) {
@@ -179,23 +249,180 @@ static VMValue httpPost(int argCount, VMValue *args) {
     return makeResultOk(currentVM, body != std::string::npos ? res.substr(body + 4) : res);
 }
 
+// Bytes pulled from the connection per read into the inbox
+constexpr size_t kReadChunk = 16384;
+// readLine/readUntil give up on records longer than this by default
+constexpr size_t kMaxRecord = 1 << 20;
+
 struct SocketData {
     mbedtls_net_context fd;
+    // Received bytes not yet handed to the script, from inboxPos on
+    std::string inbox;
+    size_t inboxPos = 0;
+    // Bytes after inboxPos already searched for the current delimiter
+    size_t scanned = 0;
+    // Delimiter ending a record that was too long; its remaining bytes
+    // are dropped by the next readLine/readUntil. Empty when not skipping
+    std::string skipThrough;
+    // Set on TLS listeners; accepted sockets get their own session
+    std::shared_ptr<Tls::ServerConfig> tlsConfig;
+    std::unique_ptr<Tls::Connection> tls;
+    // Path a Unix listener is bound to, removed again on close
+    std::string boundPath;
 };
 static void freeSocket(void *data) {
     if (data) {
-        mbedtls_net_free(&((SocketData *)data)->fd);
-        delete (SocketData *)data;
+        SocketData *sock = (SocketData *)data;
+        if (sock->tls)
+            sock->tls->closeNotify();
+        sock->tls.reset();
+        mbedtls_net_free(&sock->fd);
+#ifndef _WIN32
+        if (!sock->boundPath.empty())
+            unlink(sock->boundPath.c_str());
+#endif
+        delete sock;
+    }
+}
+
+// Plain or TLS transfer with mbedtls_net_recv/send conventions
+static int socketReadRaw(SocketData *sock, unsigned char *buf, size_t len) {
+    return sock->tls ? sock->tls->read(buf, len) : mbedtls_net_recv(&sock->fd, buf, len);
+}
+
+static int socketWriteRaw(SocketData *sock, const unsigned char *buf, size_t len) {
+    return sock->tls ? sock->tls->write(buf, len) : mbedtls_net_send(&sock->fd, buf, len);
+}
+
+// One write may take only part of the buffer: a TLS write stops after
+// one record (16 KiB) and a plain send can be short, so loop to the end
+static bool socketWriteAll(SocketData *sock, const unsigned char *p, size_t left) {
+    while (left > 0) {
+        int sent = socketWriteRaw(sock, p, left);
+        if (sent <= 0)
+            return false;
+        p += sent;
+        left -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool sendToSocket(VMValue socket, std::string_view data) {
+    if (!socket.isInstance() || socket.asInstance()->freeFn != freeSocket || !socket.asInstance()->nativeData)
+        return false;
+    SocketData *sock = (SocketData *)socket.asInstance()->nativeData;
+    return socketWriteAll(sock, (const unsigned char *)data.data(), data.size());
+}
+
+#ifndef _WIN32
+// Linux moves plaintext bytes file-to-socket inside the kernel. TLS
+// sockets, and kernels that refuse sendfile for this pair, get the file
+// in record-sized chunks through a stack buffer; either way the data
+// never becomes a VM string.
+static int64_t streamFile(SocketData *sock, int fd, uint64_t offset, uint64_t length, std::string &error) {
+    uint64_t sent = 0;
+#ifdef __linux__
+    bool useSendfile = !sock->tls;
+#endif
+    unsigned char chunk[kReadChunk];
+    while (sent < length) {
+        size_t want = (size_t)std::min<uint64_t>(length - sent, 1 << 30);
+        ssize_t n;
+#ifdef __linux__
+        if (useSendfile) {
+            off_t pos = (off_t)(offset + sent);
+            n = sendfile(sock->fd.fd, fd, &pos, want);
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS) && sent == 0) {
+                useSendfile = false;
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n < 0) {
+                error = std::string("Send failed: ") + strerror(errno);
+                return -1;
+            }
+            if (n == 0)
+                break;
+            sent += (uint64_t)n;
+            continue;
+        }
+#endif
+        n = pread(fd, chunk, std::min(want, sizeof(chunk)), (off_t)(offset + sent));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            error = std::string("Read failed: ") + strerror(errno);
+            return -1;
+        }
+        if (n == 0)
+            break;
+        size_t done = 0;
+        while (done < (size_t)n) {
+            int w = socketWriteRaw(sock, chunk + done, (size_t)n - done);
+            if (w == MBEDTLS_ERR_SSL_WANT_READ || w == MBEDTLS_ERR_SSL_WANT_WRITE)
+                return (int64_t)(sent + done);
+            if (w <= 0) {
+                error = "Send failed";
+                return -1;
+            }
+            done += (size_t)w;
+        }
+        sent += (uint64_t)n;
+    }
+    return (int64_t)sent;
+}
+#endif
+
+int64_t sendFileToSocket(VMValue socket, const std::string &path, uint64_t offset, int64_t length,
+                         std::string &error) {
+    if (!socket.isInstance() || socket.asInstance()->freeFn != freeSocket || !socket.asInstance()->nativeData) {
+        error = "Socket is not open";
+        return -1;
+    }
+#ifdef _WIN32
+    (void)path;
+    (void)offset;
+    (void)length;
+    error = "sendFile is not supported on this platform";
+    return -1;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        error = "Not a regular file: " + path;
+        return -1;
     }
+    uint64_t size = (uint64_t)st.st_size;
+    if (offset > size) {
+        close(fd);
+        error = "Offset past end of file";
+        return -1;
+    }
+    uint64_t count = size - offset;
+    if (length >= 0 && (uint64_t)length < count)
+        count = (uint64_t)length;
+    int64_t sent = streamFile((SocketData *)socket.asInstance()->nativeData, fd, offset, count, error);
+    close(fd);
+    return sent;
+#endif
 }
 
 static VMValue socketConnect(int argCount, VMValue *args) {
-    if (argCount != 2 || !args[0].isString() || !args[1].isNumber())
+    int port;
+    if (argCount != 2 || !args[0].isString() || !portArg(args[1], port))
         return nullptr;
     SocketData *data = new SocketData();
     mbedtls_net_init(&data->fd);
-    if (mbedtls_net_connect(&data->fd, args[0].asString()->flatten().c_str(),
-                            std::to_string((int)args[1].asNumber()).c_str(), MBEDTLS_NET_PROTO_TCP) != 0) {
+    if (mbedtls_net_connect(&data->fd, args[0].asString()->flatten().c_str(), std::to_string(port).c_str(),
+                            MBEDTLS_NET_PROTO_TCP) != 0) {
         delete data;
         return makeResultErr(currentVM, "Connect failed");
     }
@@ -207,20 +434,101 @@ static VMValue socketConnect(int argCount, VMValue *args) {
 
 // TCP Server Support
 static VMValue socketListen(int argCount, VMValue *args) {
-    if (argCount != 1 || !args[0].isNumber())
+    int port;
+    if (argCount != 1 || !portArg(args[0], port))
+        return nullptr;
+    SocketData *data = new SocketData();
+    mbedtls_net_init(&data->fd);
+    if (bindListener(&data->fd, port) != 0) {
+        delete data;
+        return makeResultErr(currentVM, "Bind failed");
+    }
+    auto inst = new ObjInstance(currentVM->globals["Socket"].asClass());
+    inst->nativeData = data;
+    inst->freeFn = freeSocket;
+    return makeResultOk(currentVM, inst);
+}
+
+// listenTls(port, options): a listener whose accepted sockets speak TLS
+static VMValue socketListenTls(int argCount, VMValue *args) {
+    int port;
+    if (argCount != 2 || !portArg(args[0], port) || !args[1].isMap())
         return nullptr;
+    std::string error;
+    auto config = Tls::serverConfig(args[1], error);
+    if (!config)
+        return makeResultErr(currentVM, error);
     SocketData *data = new SocketData();
     mbedtls_net_init(&data->fd);
-    if (mbedtls_net_bind(&data->fd, NULL, std::to_string((int)args[0].asNumber()).c_str(), MBEDTLS_NET_PROTO_TCP) !=
-        0) {
+    if (bindListener(&data->fd, port) != 0) {
         delete data;
         return makeResultErr(currentVM, "Bind failed");
     }
+    data->tlsConfig = std::move(config);
+    auto inst = new ObjInstance(currentVM->globals["Socket"].asClass());
+    inst->nativeData = data;
+    inst->freeFn = freeSocket;
+    return makeResultOk(currentVM, inst);
+}
+
+#ifndef _WIN32
+// Unix-domain stream sockets share the Socket API; mbedTLS only ever sees
+// the descriptor.
+static int unixSocket(const std::string &path, sockaddr_un &addr) {
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.data(), path.size());
+    return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+static VMValue socketConnectUnix(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    sockaddr_un addr;
+    int fd = unixSocket(args[0].asString()->flatten(), addr);
+    if (fd < 0)
+        return makeResultErr(currentVM, "Invalid socket path");
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return makeResultErr(currentVM, "Connect failed");
+    }
+    SocketData *data = new SocketData();
+    mbedtls_net_init(&data->fd);
+    data->fd.fd = fd;
+    auto inst = new ObjInstance(currentVM->globals["Socket"].asClass());
+    inst->nativeData = data;
+    inst->freeFn = freeSocket;
+    return makeResultOk(currentVM, inst);
+}
+
+static VMValue socketListenUnix(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    std::string path = args[0].asString()->flatten();
+    sockaddr_un addr;
+    int fd = unixSocket(path, addr);
+    if (fd < 0)
+        return makeResultErr(currentVM, "Invalid socket path");
+    // A socket file left by an earlier process would make bind fail
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path.c_str());
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return makeResultErr(currentVM, "Bind failed");
+    }
+    SocketData *data = new SocketData();
+    mbedtls_net_init(&data->fd);
+    data->fd.fd = fd;
+    data->boundPath = path;
     auto inst = new ObjInstance(currentVM->globals["Socket"].asClass());
     inst->nativeData = data;
     inst->freeFn = freeSocket;
     return makeResultOk(currentVM, inst);
 }
+#endif
 
 static VMValue socketAccept(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
@@ -231,6 +539,10 @@ static VMValue socketAccept(int argCount, VMValue *args) {
         delete clientData;
         return nullptr;
     }
+    countAccepted();
+    // The handshake runs on first use, or explicitly through handshake()
+    if (data->tlsConfig)
+        clientData->tls = std::make_unique<Tls::Connection>(data->tlsConfig, &clientData->fd);
     auto clientInst = new ObjInstance(currentVM->globals["Socket"].asClass());
     clientInst->nativeData = clientData;
     clientInst->freeFn = freeSocket;
@@ -241,21 +553,291 @@ static VMValue socketSend(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
     SocketData *data = (SocketData *)inst->nativeData;
     std::string p = args[0].asString()->flatten();
-    return makeResultOk(currentVM, mbedtls_net_send(&data->fd, (const unsigned char *)p.c_str(), p.length()) >= 0);
+    if (!socketWriteAll(data, (const unsigned char *)p.c_str(), p.length()))
+        return makeResultErr(currentVM, "Send failed");
+    return makeResultOk(currentVM, true);
 }
 
 static VMValue socketRecv(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
     SocketData *data = (SocketData *)inst->nativeData;
-    unsigned char buf[4096];
-    int ret = mbedtls_net_recv(&data->fd, buf, 4096);
-    return makeResultOk(currentVM, ret > 0 ? std::string((char *)buf, ret) : "");
+    // NaN fails the >= test; huge sizes are cut to the 64 KiB read below before the cast
+    size_t size = argCount >= 1 && args[0].isNumber() && args[0].asNumber() >= 1
+                      ? (size_t)std::min(args[0].asNumber(), 65536.0)
+                      : 4096;
+    // Bytes already buffered by the read* methods come first
+    if (data->inboxPos < data->inbox.size()) {
+        size_t n = std::min(size, data->inbox.size() - data->inboxPos);
+        std::string chunk = data->inbox.substr(data->inboxPos, n);
+        data->inboxPos += n;
+        data->scanned = 0;
+        return makeResultOk(currentVM, chunk);
+    }
+    std::string buf(std::min<size_t>(size, 65536), '\0');
+    int ret = socketReadRaw(data, (unsigned char *)buf.data(), buf.size());
+    buf.resize(ret > 0 ? (size_t)ret : 0);
+    return makeResultOk(currentVM, buf);
+}
+
+enum class Fill { DATA, WOULD_BLOCK, CLOSED };
+
+// Appends the next chunk from the connection to the inbox, first
+// dropping consumed bytes once they make up half of it.
+static Fill fillInbox(SocketData *data) {
+    if (data->inboxPos > 0 && data->inboxPos * 2 >= data->inbox.size()) {
+        data->inbox.erase(0, data->inboxPos);
+        data->inboxPos = 0;
+    }
+    size_t old = data->inbox.size();
+    data->inbox.resize(old + kReadChunk);
+    int ret = socketReadRaw(data, (unsigned char *)data->inbox.data() + old, kReadChunk);
+    data->inbox.resize(old + (ret > 0 ? (size_t)ret : 0));
+    if (ret > 0)
+        return Fill::DATA;
+    return ret == MBEDTLS_ERR_SSL_WANT_READ ? Fill::WOULD_BLOCK : Fill::CLOSED;
+}
+
+static std::string takeInbox(SocketData *data, size_t n, size_t skip) {
+    std::string out = data->inbox.substr(data->inboxPos, n);
+    data->inboxPos += n + skip;
+    data->scanned = 0;
+    if (data->inboxPos == data->inbox.size()) {
+        data->inbox.clear();
+        data->inboxPos = 0;
+    }
+    return out;
+}
+
+// Drops buffered bytes of an oversized record up to and including its
+// delimiter, keeping the last delim-1 bytes when the delimiter has not
+// arrived yet since they may start it. True once the record is gone.
+static bool skipOversized(SocketData *data) {
+    std::string_view pending = std::string_view(data->inbox).substr(data->inboxPos);
+    size_t at = StringKernels::find(pending, data->skipThrough, 0);
+    if (at != StringKernels::npos) {
+        takeInbox(data, 0, at + data->skipThrough.size());
+        data->skipThrough.clear();
+        return true;
+    }
+    size_t keep = std::min(pending.size(), data->skipThrough.size() - 1);
+    takeInbox(data, 0, pending.size() - keep);
+    return false;
+}
+
+// Record up to (not including) `delim`. At end of stream the unterminated
+// remainder is returned, then nil; a non-blocking socket without a full
+// record also gives nil and keeps what it has. A record longer than
+// `limit` gives Err and is discarded, so the next read starts after it.
+static VMValue readRecord(SocketData *data, std::string_view delim, size_t limit) {
+    for (;;) {
+        if (!data->skipThrough.empty() && !skipOversized(data)) {
+            Fill fill = fillInbox(data);
+            if (fill == Fill::WOULD_BLOCK)
+                return makeResultOk(currentVM, nullptr);
+            if (fill == Fill::CLOSED) {
+                data->skipThrough.clear();
+                takeInbox(data, 0, data->inbox.size() - data->inboxPos);
+                return makeResultOk(currentVM, nullptr);
+            }
+            continue;
+        }
+        std::string_view pending = std::string_view(data->inbox).substr(data->inboxPos);
+        size_t at = StringKernels::find(pending, delim, data->scanned);
+        if (at != StringKernels::npos) {
+            if (at > limit) {
+                takeInbox(data, 0, at + delim.size());
+                return makeResultErr(currentVM, "Record too long");
+            }
+            return makeResultOk(currentVM, takeInbox(data, at, delim.size()));
+        }
+        // A delimiter split across reads starts in the last delim-1 bytes
+        data->scanned = pending.size() >= delim.size() ? pending.size() - delim.size() + 1 : 0;
+        if (pending.size() > limit) {
+            data->skipThrough = std::string(delim);
+            skipOversized(data);
+            return makeResultErr(currentVM, "Record too long");
+        }
+        Fill fill = fillInbox(data);
+        if (fill == Fill::WOULD_BLOCK)
+            return makeResultOk(currentVM, nullptr);
+        if (fill == Fill::CLOSED) {
+            if (data->inboxPos == data->inbox.size())
+                return makeResultOk(currentVM, nullptr);
+            return makeResultOk(currentVM, takeInbox(data, data->inbox.size() - data->inboxPos, 0));
+        }
+    }
+}
+
+static SocketData *openSocket(VMValue receiver) {
+    if (!receiver.isInstance() || receiver.asInstance()->freeFn != freeSocket)
+        return nullptr;
+    return (SocketData *)receiver.asInstance()->nativeData;
+}
+
+static bool limitArg(int argCount, VMValue *args, int index, size_t &limit) {
+    limit = kMaxRecord;
+    if (argCount <= index)
+        return true;
+    if (!args[index].isNumber() || !(args[index].asNumber() >= 0)) // also rejects NaN
+        return false;
+    // Past any buffer that could be allocated; also keeps infinity out of the cast
+    limit = (size_t)std::min(args[index].asNumber(), 1e18);
+    return true;
+}
+
+// readLine(maxBytes?): next line without its "\n" or "\r\n"
+static VMValue socketReadLine(int argCount, VMValue *args) {
+    SocketData *data = openSocket(args[-1]);
+    size_t limit;
+    if (!data || argCount > 1 || !limitArg(argCount, args, 0, limit))
+        return nullptr;
+    VMValue result = readRecord(data, "\n", limit);
+    // Err results have no value to trim
+    auto &fields = result.asInstance()->fields;
+    auto line = fields.find("value");
+    if (line != fields.end() && line->second.isString()) {
+        const std::string &text = line->second.asString()->flatView();
+        if (!text.empty() && text.back() == '\r')
+            line->second = text.substr(0, text.size() - 1);
+    }
+    return result;
+}
+
+// readUntil(delim, maxBytes?): bytes up to `delim`, which is consumed
+static VMValue socketReadUntil(int argCount, VMValue *args) {
+    SocketData *data = openSocket(args[-1]);
+    size_t limit;
+    if (!data || argCount < 1 || argCount > 2 || !args[0].isString() || args[0].asString()->flatView().empty() ||
+        !limitArg(argCount, args, 1, limit))
+        return nullptr;
+    std::string delim = args[0].asString()->flatten();
+    return readRecord(data, delim, limit);
+}
+
+// readExactly(n, maxBytes?): exactly n bytes; Err if the stream ends
+// first or n is over the limit
+static VMValue socketReadExactly(int argCount, VMValue *args) {
+    SocketData *data = openSocket(args[-1]);
+    size_t limit;
+    if (!data || argCount < 1 || argCount > 2 || !args[0].isNumber() || !(args[0].asNumber() >= 0) ||
+        !limitArg(argCount, args, 1, limit))
+        return nullptr;
+    if (args[0].asNumber() > (double)limit)
+        return makeResultErr(currentVM, "Record too long");
+    size_t n = (size_t)args[0].asNumber();
+    while (data->inbox.size() - data->inboxPos < n) {
+        if (data->inbox.capacity() < data->inboxPos + n)
+            data->inbox.reserve(data->inboxPos + n);
+        Fill fill = fillInbox(data);
+        if (fill == Fill::WOULD_BLOCK)
+            return makeResultOk(currentVM, nullptr);
+        if (fill == Fill::CLOSED)
+            return makeResultErr(currentVM, "Connection closed");
+    }
+    return makeResultOk(currentVM, takeInbox(data, n, 0));
+}
+
+// Everything buffered, or one read's worth when the buffer is empty
+static VMValue socketReadAvailable(int argCount, VMValue *args) {
+    (void)argCount;
+    SocketData *data = openSocket(args[-1]);
+    if (!data)
+        return nullptr;
+    if (data->inboxPos == data->inbox.size()) {
+        Fill fill = fillInbox(data);
+        if (fill == Fill::WOULD_BLOCK)
+            return makeResultOk(currentVM, "");
+        if (fill == Fill::CLOSED)
+            return makeResultOk(currentVM, nullptr);
+    }
+    return makeResultOk(currentVM, takeInbox(data, data->inbox.size() - data->inboxPos, 0));
+}
+
+static VMValue socketSetBlocking(int argCount, VMValue *args) {
+    auto inst = args[-1].asInstance();
+    if (argCount != 1 || !args[0].isBool() || !inst->nativeData)
+        return nullptr;
+    mbedtls_net_context *fd = &((SocketData *)inst->nativeData)->fd;
+    return (args[0].asBool() ? mbedtls_net_set_block(fd) : mbedtls_net_set_nonblock(fd)) == 0;
+}
+
+// The descriptor, for registering with an external poller
+static VMValue socketFd(int argCount, VMValue *args) {
+    auto inst = args[-1].asInstance();
+    if (!inst->nativeData)
+        return nullptr;
+    return static_cast<double>(((SocketData *)inst->nativeData)->fd.fd);
+}
+
+// localAddress(): {"host", "port"} or {"path"}; finds the port a
+// listener bound to port 0 was given
+static VMValue socketLocalAddress(int argCount, VMValue *args) {
+    (void)argCount;
+    SocketData *data = openSocket(args[-1]);
+    if (!data)
+        return nullptr;
+    return DatagramModule::localAddress(data->fd.fd);
+}
+
+// sendFile(path|File, offset?, length?): Ok(bytes sent)
+static VMValue socketSendFile(int argCount, VMValue *args) {
+    if (argCount < 1 || argCount > 3)
+        return nullptr;
+    std::string path;
+    if (args[0].isString())
+        path = args[0].asString()->flatten();
+    else if (!FS::filePath(args[0], path))
+        return nullptr;
+    uint64_t offset = 0;
+    int64_t length = -1;
+    // NaN fails the checks; huge values saturate instead of overflowing the casts
+    if (argCount >= 2) {
+        if (!args[1].isNumber() || !(args[1].asNumber() >= 0))
+            return nullptr;
+        offset = (uint64_t)std::min(args[1].asNumber(), 1e18);
+    }
+    if (argCount == 3) {
+        if (!args[2].isNumber() || !(args[2].asNumber() >= 0))
+            return nullptr;
+        length = (int64_t)std::min(args[2].asNumber(), 1e18);
+    }
+    std::string error;
+    int64_t sent = sendFileToSocket(args[-1], path, offset, length, error);
+    if (sent < 0)
+        return makeResultErr(currentVM, error);
+    return makeResultOk(currentVM, (double)sent);
+}
+
+// handshake(): Ok(true) once a TLS session is up, Ok(false) while a
+// non-blocking socket still waits for the peer; plain sockets are always up
+static VMValue socketHandshake(int argCount, VMValue *args) {
+    (void)argCount;
+    SocketData *data = openSocket(args[-1]);
+    if (!data)
+        return nullptr;
+    if (!data->tls)
+        return makeResultOk(currentVM, true);
+    int ret = data->tls->handshake();
+    if (ret == 0)
+        return makeResultOk(currentVM, true);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+        return makeResultOk(currentVM, false);
+    return makeResultErr(currentVM, "TLS handshake failed: " + Tls::errorText(ret));
+}
+
+// Protocol the client picked through ALPN, or nil
+static VMValue socketAlpn(int argCount, VMValue *args) {
+    (void)argCount;
+    SocketData *data = openSocket(args[-1]);
+    if (!data || !data->tls || !data->tls->alpn())
+        return nullptr;
+    return std::string(data->tls->alpn());
 }
 
 static VMValue socketClose(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
     if (inst->nativeData) {
-        mbedtls_net_free(&((SocketData *)inst->nativeData)->fd);
+        freeSocket(inst->nativeData);
         inst->nativeData = nullptr;
     }
     return makeResultOk(currentVM, true);
@@ -271,10 +853,25 @@ void registerAll(VM *vm) {
     auto sock = new ObjClass("Socket");
     sock->statics["connect"] = new ObjNative("connect", 2, socketConnect);
     sock->statics["listen"] = new ObjNative("listen", 1, socketListen);
+    sock->statics["listenTls"] = new ObjNative("listenTls", 2, socketListenTls);
     sock->methods["accept"] = new ObjNative("accept", 0, socketAccept);
     sock->methods["send"] = new ObjNative("send", 1, socketSend);
+    sock->methods["sendFile"] = new ObjNative("sendFile", -1, socketSendFile);
     sock->methods["recv"] = new ObjNative("recv", -1, socketRecv);
+    sock->methods["readLine"] = new ObjNative("readLine", -1, socketReadLine);
+    sock->methods["readUntil"] = new ObjNative("readUntil", -1, socketReadUntil);
+    sock->methods["readExactly"] = new ObjNative("readExactly", -1, socketReadExactly);
+    sock->methods["readAvailable"] = new ObjNative("readAvailable", 0, socketReadAvailable);
     sock->methods["close"] = new ObjNative("close", 0, socketClose);
+    sock->methods["setBlocking"] = new ObjNative("setBlocking", 1, socketSetBlocking);
+    sock->methods["fd"] = new ObjNative("fd", 0, socketFd);
+    sock->methods["localAddress"] = new ObjNative("localAddress", 0, socketLocalAddress);
+    sock->methods["handshake"] = new ObjNative("handshake", 0, socketHandshake);
+    sock->methods["alpn"] = new ObjNative("alpn", 0, socketAlpn);
+#ifndef _WIN32
+    sock->statics["connectUnix"] = new ObjNative("connectUnix", 1, socketConnectUnix);
+    sock->statics["listenUnix"] = new ObjNative("listenUnix", 1, socketListenUnix);
+#endif
     vm->globals["Socket"] = sock;
 }
 
@@ -3,9 +3,37 @@
 
 #include "../../symbol/SymbolTable.h"
 #include "../../vm/VM.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+struct mbedtls_net_context;
 
 namespace StdLib {
 namespace Net {
+// Set in `trypillia serve` workers: listeners bind with SO_REUSEPORT so
+// every worker process accepts on the same port.
+extern bool reusePort;
+// Connections accepted by this process, for the serve supervisor's stats.
+extern std::atomic<uint64_t> *acceptedConnections;
+
+// Binds and listens on `port` on all interfaces. Returns 0 on success.
+int bindListener(mbedtls_net_context *ctx, int port);
+// Reads a port argument: a number in [0, 65535]. False for anything else,
+// NaN and infinities included, before any integer conversion happens.
+bool portArg(VMValue value, int &port);
+void countAccepted();
+// Sends all of `data` on a Socket instance; false if `socket` is not a
+// connected Socket or the peer went away.
+bool sendToSocket(VMValue socket, std::string_view data);
+// Sends `length` bytes of the file at `path` from `offset` (the rest of
+// the file when negative) without copying them through the VM. Returns
+// the bytes sent, fewer if a non-blocking socket fills up, or -1 with
+// `error` set.
+int64_t sendFileToSocket(VMValue socket, const std::string &path, uint64_t offset, int64_t length,
+                         std::string &error);
+
 void registerAll(VM *vm);
 void registerSymbols(SymbolTable *scope);
 } // namespace Net
@@ -0,0 +1,315 @@
+#include "Tls.h"
+#include <map>
+#include <mutex>
+#include <sys/stat.h>
+
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/error.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/ssl_cache.h>
+#include <mbedtls/ssl_ticket.h>
+#include <mbedtls/x509_crt.h>
+#include <psa/crypto.h>
+
+namespace StdLib {
+namespace Tls {
+
+// Session tickets stay valid for a day
+constexpr uint32_t kTicketLifetime = 86400;
+
+namespace {
+
+// One DRBG for every config and worker thread; mbedTLS may be built
+// without its own threading layer, so access goes through a mutex.
+std::once_flag randomOnce;
+std::mutex randomMutex;
+mbedtls_entropy_context entropy;
+mbedtls_ctr_drbg_context drbg;
+bool randomReady = false;
+
+bool initRandom() {
+    std::call_once(randomOnce, [] {
+        psa_crypto_init();
+        mbedtls_entropy_init(&entropy);
+        mbedtls_ctr_drbg_init(&drbg);
+        randomReady = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                            (const unsigned char *)"trypillia-tls", 13) == 0;
+    });
+    return randomReady;
+}
+
+int lockedRandom(void *, unsigned char *out, size_t len) {
+    std::lock_guard<std::mutex> lock(randomMutex);
+    return mbedtls_ctr_drbg_random(&drbg, out, len);
+}
+
+std::string describe(int code) {
+    char text[128];
+    mbedtls_strerror(code, text, sizeof(text));
+    return text;
+}
+
+VMValue option(VMValue options, const char *name) {
+    for (auto &[key, value] : options.asMap()->values) {
+        if (key.isString() && key.asString()->flatView() == name)
+            return value;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+struct ServerConfig {
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt cert;
+    mbedtls_pk_context key;
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_context cache;
+    std::mutex cacheMutex;
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_ticket_context tickets;
+    std::mutex ticketMutex;
+#endif
+    // ALPN names and the null-terminated list mbedTLS keeps pointing at
+    std::vector<std::string> alpn;
+    std::vector<const char *> alpnList;
+
+    ServerConfig() {
+        mbedtls_ssl_config_init(&conf);
+        mbedtls_x509_crt_init(&cert);
+        mbedtls_pk_init(&key);
+#if defined(MBEDTLS_SSL_CACHE_C)
+        mbedtls_ssl_cache_init(&cache);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_ticket_init(&tickets);
+#endif
+    }
+
+    ~ServerConfig() {
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_ticket_free(&tickets);
+#endif
+#if defined(MBEDTLS_SSL_CACHE_C)
+        mbedtls_ssl_cache_free(&cache);
+#endif
+        mbedtls_pk_free(&key);
+        mbedtls_x509_crt_free(&cert);
+        mbedtls_ssl_config_free(&conf);
+    }
+};
+
+// Connections on different worker threads share a config, so the cache
+// and ticket callbacks serialise on the config's own locks.
+#if defined(MBEDTLS_SSL_CACHE_C)
+static int cacheGet(void *data, unsigned char const *id, size_t idLen, mbedtls_ssl_session *session) {
+    ServerConfig *config = static_cast<ServerConfig *>(data);
+    std::lock_guard<std::mutex> lock(config->cacheMutex);
+    return mbedtls_ssl_cache_get(&config->cache, id, idLen, session);
+}
+
+static int cacheSet(void *data, unsigned char const *id, size_t idLen, const mbedtls_ssl_session *session) {
+    ServerConfig *config = static_cast<ServerConfig *>(data);
+    std::lock_guard<std::mutex> lock(config->cacheMutex);
+    return mbedtls_ssl_cache_set(&config->cache, id, idLen, session);
+}
+#endif
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+static int ticketWrite(void *data, const mbedtls_ssl_session *session, unsigned char *start, const unsigned char *end,
+                       size_t *written, uint32_t *lifetime) {
+    ServerConfig *config = static_cast<ServerConfig *>(data);
+    std::lock_guard<std::mutex> lock(config->ticketMutex);
+    return mbedtls_ssl_ticket_write(&config->tickets, session, start, end, written, lifetime);
+}
+
+static int ticketParse(void *data, mbedtls_ssl_session *session, unsigned char *buf, size_t len) {
+    ServerConfig *config = static_cast<ServerConfig *>(data);
+    std::lock_guard<std::mutex> lock(config->ticketMutex);
+    return mbedtls_ssl_ticket_parse(&config->tickets, session, buf, len);
+}
+#endif
+
+static std::shared_ptr<ServerConfig> buildConfig(const std::string &certPath, const std::string &keyPath,
+                                                 const std::string &password, const std::vector<std::string> &alpn,
+                                                 std::string &error) {
+    auto config = std::make_shared<ServerConfig>();
+    int ret;
+    if ((ret = mbedtls_x509_crt_parse_file(&config->cert, certPath.c_str())) != 0) {
+        error = "Cannot load certificate " + certPath + ": " + describe(ret);
+        return nullptr;
+    }
+    if ((ret = mbedtls_pk_parse_keyfile(&config->key, keyPath.c_str(), password.empty() ? nullptr : password.c_str(),
+                                        lockedRandom, nullptr)) != 0) {
+        error = "Cannot load key " + keyPath + ": " + describe(ret);
+        return nullptr;
+    }
+    if ((ret = mbedtls_ssl_config_defaults(&config->conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0 ||
+        (ret = mbedtls_ssl_conf_own_cert(&config->conf, &config->cert, &config->key)) != 0) {
+        error = "TLS setup failed: " + describe(ret);
+        return nullptr;
+    }
+    mbedtls_ssl_conf_rng(&config->conf, lockedRandom, nullptr);
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_conf_session_cache(&config->conf, config.get(), cacheGet, cacheSet);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if ((ret = mbedtls_ssl_ticket_setup(&config->tickets, lockedRandom, nullptr, MBEDTLS_CIPHER_AES_256_GCM,
+                                        kTicketLifetime)) != 0) {
+        error = "TLS ticket setup failed: " + describe(ret);
+        return nullptr;
+    }
+    mbedtls_ssl_conf_session_tickets_cb(&config->conf, ticketWrite, ticketParse, config.get());
+#endif
+#if defined(MBEDTLS_SSL_ALPN)
+    if (!alpn.empty()) {
+        config->alpn = alpn;
+        for (const std::string &name : config->alpn)
+            config->alpnList.push_back(name.c_str());
+        config->alpnList.push_back(nullptr);
+        if ((ret = mbedtls_ssl_conf_alpn_protocols(&config->conf, config->alpnList.data())) != 0) {
+            error = "Invalid ALPN list: " + describe(ret);
+            return nullptr;
+        }
+    }
+#endif
+    return config;
+}
+
+struct CachedConfig {
+    std::string stamp;
+    std::shared_ptr<ServerConfig> config;
+};
+
+// Identifies one version of a file: replacing or rewriting it changes
+// the inode, size or modification time. Empty when it cannot be read.
+static std::string fileStamp(const std::string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return "";
+    std::string stamp = std::to_string(st.st_ino) + ':' + std::to_string(st.st_size) + ':' +
+                        std::to_string(static_cast<long long>(st.st_mtime));
+#ifdef __linux__
+    stamp += '.' + std::to_string(st.st_mtim.tv_nsec);
+#endif
+    return stamp;
+}
+
+std::shared_ptr<ServerConfig> serverConfig(VMValue options, std::string &error) {
+    if (!options.isMap()) {
+        error = "TLS options must be a map";
+        return nullptr;
+    }
+    VMValue cert = option(options, "cert");
+    VMValue key = option(options, "key");
+    VMValue password = option(options, "password");
+    VMValue alpnValue = option(options, "alpn");
+    if (!cert.isString() || !key.isString() || (!password.isNil() && !password.isString()) ||
+        (!alpnValue.isNil() && !alpnValue.isList())) {
+        error = "TLS options need \"cert\" and \"key\" paths";
+        return nullptr;
+    }
+    std::vector<std::string> alpn;
+    if (alpnValue.isList()) {
+        for (VMValue name : alpnValue.asList()->elements) {
+            if (!name.isString() || name.asString()->flatView().empty() || name.asString()->flatView().size() > 255) {
+                error = "ALPN names must be non-empty strings";
+                return nullptr;
+            }
+            alpn.push_back(name.asString()->flatten());
+        }
+    }
+    if (!initRandom()) {
+        error = "Cannot seed the TLS random generator";
+        return nullptr;
+    }
+
+    // Listeners with the same files share one config, and with it the
+    // session cache and ticket key. A renewed certificate or key at the
+    // same path changes the stamp, so the next listener loads it afresh
+    // while listeners already running keep the config they started with.
+    std::string certPath = cert.asString()->flatten();
+    std::string keyPath = key.asString()->flatten();
+    std::string cacheKey = certPath + '\0' + keyPath;
+    for (const std::string &name : alpn)
+        cacheKey += '\0' + name;
+    std::string stamp = fileStamp(certPath) + '\0' + fileStamp(keyPath);
+    static std::mutex configsMutex;
+    static std::map<std::string, CachedConfig> configs;
+    std::lock_guard<std::mutex> lock(configsMutex);
+    auto found = configs.find(cacheKey);
+    if (found != configs.end() && found->second.stamp == stamp)
+        return found->second.config;
+    auto config =
+        buildConfig(certPath, keyPath, password.isString() ? password.asString()->flatten() : "", alpn, error);
+    if (config)
+        configs[cacheKey] = {stamp, config};
+    return config;
+}
+
+Connection::Connection(std::shared_ptr<ServerConfig> cfg, mbedtls_net_context *fd) : config(std::move(cfg)) {
+    mbedtls_ssl_init(&ssl);
+    setupResult = mbedtls_ssl_setup(&ssl, &config->conf);
+    mbedtls_ssl_set_bio(&ssl, fd, mbedtls_net_send, mbedtls_net_recv, nullptr);
+}
+
+Connection::~Connection() {
+    mbedtls_ssl_free(&ssl);
+}
+
+int Connection::handshake() {
+    if (done)
+        return 0;
+    if (setupResult != 0)
+        return setupResult;
+    int ret = mbedtls_ssl_handshake(&ssl);
+    if (ret == 0)
+        done = true;
+    return ret;
+}
+
+static bool wouldBlock(int ret) {
+    return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int Connection::read(unsigned char *buf, size_t len) {
+    int ret = handshake();
+    if (ret == 0)
+        ret = mbedtls_ssl_read(&ssl, buf, len);
+    if (wouldBlock(ret))
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+        return 0;
+    return ret;
+}
+
+int Connection::write(const unsigned char *buf, size_t len) {
+    int ret = handshake();
+    if (ret == 0)
+        ret = mbedtls_ssl_write(&ssl, buf, len);
+    return wouldBlock(ret) ? MBEDTLS_ERR_SSL_WANT_WRITE : ret;
+}
+
+void Connection::closeNotify() {
+    if (done)
+        mbedtls_ssl_close_notify(&ssl);
+}
+
+const char *Connection::alpn() const {
+#if defined(MBEDTLS_SSL_ALPN)
+    return done ? mbedtls_ssl_get_alpn_protocol(&ssl) : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+std::string errorText(int code) {
+    return describe(code);
+}
+
+} // namespace Tls
+} // namespace StdLib
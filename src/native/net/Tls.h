@@ -0,0 +1,63 @@
+#ifndef TRYPILLIA_NATIVE_TLS_H
+#define TRYPILLIA_NATIVE_TLS_H
+
+#include "../../vm/VM.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+
+// Server-side TLS on top of the linked mbedTLS. Listeners share one
+// ssl_config per certificate/key/ALPN combination, loaded on first use
+// together with a session cache and a ticket key, so clients can resume.
+namespace StdLib {
+namespace Tls {
+
+struct ServerConfig;
+
+// Builds (or reuses) the config described by a script options map:
+// {"cert": path, "key": path, "password"?: String, "alpn"?: [String]}.
+// Returns null with `error` set when the options or files are bad.
+std::shared_ptr<ServerConfig> serverConfig(VMValue options, std::string &error);
+
+// Human-readable text for an mbedTLS error code
+std::string errorText(int code);
+
+// One server-side TLS session over an accepted connection. The
+// handshake runs on demand, so the same calls work on blocking sockets
+// and inside a poll loop on non-blocking ones.
+class Connection {
+  public:
+    Connection(std::shared_ptr<ServerConfig> config, mbedtls_net_context *fd);
+    ~Connection();
+    Connection(const Connection &) = delete;
+    Connection &operator=(const Connection &) = delete;
+
+    // 0 once established, MBEDTLS_ERR_SSL_WANT_READ/WANT_WRITE while it
+    // needs the socket to become ready, another negative code on failure.
+    int handshake();
+    // mbedtls_net_recv/send conventions: bytes moved, 0 at end of stream,
+    // MBEDTLS_ERR_SSL_WANT_READ when a non-blocking socket would block.
+    int read(unsigned char *buf, size_t len);
+    int write(const unsigned char *buf, size_t len);
+    void closeNotify();
+
+    bool established() const {
+        return done;
+    }
+    // Protocol chosen by ALPN, or null
+    const char *alpn() const;
+
+  private:
+    std::shared_ptr<ServerConfig> config;
+    mbedtls_ssl_context ssl;
+    int setupResult = 0;
+    bool done = false;
+};
+
+} // namespace Tls
+} // namespace StdLib
+
+#endif
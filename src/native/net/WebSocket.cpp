@@ -1,6 +1,9 @@
 #include "WebSocket.h"
 #include "../StdLib.h"
+#include "../compress/Deflate.h"
 #include "../crypto/Crypto.h"
+#include "Net.h"
+#include "Tls.h"
 #include <cstring>
 #include <iostream>
 #include <mbedtls/net_sockets.h>
@@ -10,11 +13,26 @@
 namespace StdLib {
 namespace WebSocketModule {
 
+// Inflated messages larger than this are rejected
+constexpr size_t kMaxInflatedMessage = 16 * 1024 * 1024;
+// Shorter messages are not worth compressing
+constexpr size_t kMinDeflateSize = 64;
+
 struct WSServerData {
     mbedtls_net_context fd;
+    // Offer permessage-deflate (RFC 7692) to clients that ask for it
+    bool deflate = false;
+    // Set for wss:// servers
+    std::shared_ptr<Tls::ServerConfig> tls;
 };
 struct WSClientData {
     mbedtls_net_context fd;
+    std::unique_ptr<Tls::Connection> tls;
+    bool deflate = false;
+    // The client asked us not to keep compression context between messages
+    bool resetPerMessage = false;
+    Deflate::Deflater deflater;
+    Deflate::Inflater inflater;
 };
 
 static void freeServer(void *data) {
@@ -26,20 +44,68 @@ static void freeServer(void *data) {
 
 static void freeClient(void *data) {
     if (data) {
-        mbedtls_net_free(&((WSClientData *)data)->fd);
-        delete (WSClientData *)data;
+        WSClientData *client = (WSClientData *)data;
+        if (client->tls)
+            client->tls->closeNotify();
+        client->tls.reset();
+        mbedtls_net_free(&client->fd);
+        delete client;
     }
 }
 
+static int wsRead(WSClientData *data, uint8_t *buf, size_t len) {
+    return data->tls ? data->tls->read(buf, len) : mbedtls_net_recv(&data->fd, buf, len);
+}
+
+// Writes all of `buf`; a TLS write covers one record (16 KiB) at most
+static bool wsWrite(WSClientData *data, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        int sent = data->tls ? data->tls->write(buf, len) : mbedtls_net_send(&data->fd, buf, len);
+        if (sent <= 0)
+            return false;
+        buf += sent;
+        len -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Frame fields can straddle reads, and TLS records more often than not
+static bool readFull(WSClientData *data, uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        int r = wsRead(data, buf + total, len - total);
+        if (r <= 0)
+            return false;
+        total += static_cast<size_t>(r);
+    }
+    return true;
+}
+
 static VMValue wsServerCreate(int argCount, VMValue *args) {
-    if (argCount != 1 || !args[0].isNumber())
+    if (argCount < 1 || argCount > 2 || !args[0].isNumber())
         return makeResultErr(currentVM, "Invalid port");
     int port = (int)args[0].asNumber();
+    bool deflate = false;
+    std::shared_ptr<Tls::ServerConfig> tls;
+    if (argCount == 2 && args[1].isMap()) {
+        for (auto &[key, value] : args[1].asMap()->values) {
+            if (key.isString() && key.asString()->flatView() == "deflate")
+                deflate = value.isBool() && value.asBool();
+            if (key.isString() && key.asString()->flatView() == "tls") {
+                std::string error;
+                tls = Tls::serverConfig(value, error);
+                if (!tls)
+                    return makeResultErr(currentVM, error);
+            }
+        }
+    }
 
     WSServerData *data = new WSServerData();
     mbedtls_net_init(&data->fd);
+    data->deflate = deflate;
+    data->tls = std::move(tls);
 
-    if (mbedtls_net_bind(&data->fd, NULL, std::to_string(port).c_str(), MBEDTLS_NET_PROTO_TCP) != 0) {
+    if (Net::bindListener(&data->fd, port) != 0) {
         delete data;
         return makeResultErr(currentVM, "Bind failed");
     }
@@ -59,20 +125,70 @@ static std::string extractHeader(const std::string &request, const std::string &
     return (end == std::string::npos) ? "" : request.substr(pos, end - pos);
 }
 
+static std::string trim(const std::string &text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos)
+        return "";
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+// Picks the first permessage-deflate offer we can honour. Our window is
+// always 32 KiB, so offers limiting the server window are declined.
+static bool negotiateDeflate(const std::string &header, bool &noContextTakeover) {
+    std::stringstream offers(header);
+    std::string offer;
+    while (std::getline(offers, offer, ',')) {
+        std::stringstream params(offer);
+        std::string param;
+        std::getline(params, param, ';');
+        if (trim(param) != "permessage-deflate")
+            continue;
+        bool usable = true;
+        bool reset = false;
+        while (std::getline(params, param, ';')) {
+            std::string name = trim(param.substr(0, param.find('=')));
+            if (name == "server_no_context_takeover")
+                reset = true;
+            else if (name != "client_no_context_takeover" && name != "client_max_window_bits")
+                usable = false;
+        }
+        if (usable) {
+            noContextTakeover = reset;
+            return true;
+        }
+    }
+    return false;
+}
+
 static VMValue wsServerAccept(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
     WSServerData *data = (WSServerData *)inst->nativeData;
 
-    mbedtls_net_context client_fd;
-    mbedtls_net_init(&client_fd);
-    if (mbedtls_net_accept(&data->fd, &client_fd, NULL, 0, NULL) != 0) {
+    WSClientData *clientData = new WSClientData();
+    mbedtls_net_init(&clientData->fd);
+    if (mbedtls_net_accept(&data->fd, &clientData->fd, NULL, 0, NULL) != 0) {
+        delete clientData;
         return makeResultErr(currentVM, "Accept failed");
     }
+    Net::countAccepted();
+
+    if (data->tls) {
+        clientData->tls = std::make_unique<Tls::Connection>(data->tls, &clientData->fd);
+        int ret;
+        do
+            ret = clientData->tls->handshake();
+        while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+        if (ret != 0) {
+            freeClient(clientData);
+            return makeResultErr(currentVM, "TLS handshake failed: " + Tls::errorText(ret));
+        }
+    }
 
     unsigned char buffer[4096] = {0};
-    int ret = mbedtls_net_recv(&client_fd, buffer, 4095);
+    int ret = wsRead(clientData, buffer, 4095);
     if (ret <= 0) {
-        mbedtls_net_free(&client_fd);
+        freeClient(clientData);
         return makeResultErr(currentVM, "Handshake read failed");
     }
 
@@ -80,8 +196,8 @@ static VMValue wsServerAccept(int argCount, VMValue *args) {
     std::string wsKey = extractHeader(request, "Sec-WebSocket-Key");
     if (wsKey.empty()) {
         const char *bad = "HTTP/1.1 400 Bad Request\r\n\r\n";
-        mbedtls_net_send(&client_fd, (const unsigned char *)bad, strlen(bad));
-        mbedtls_net_free(&client_fd);
+        wsWrite(clientData, (const unsigned char *)bad, strlen(bad));
+        freeClient(clientData);
         return makeResultErr(currentVM, "Not a websocket");
     }
 
@@ -91,12 +207,20 @@ static VMValue wsServerAccept(int argCount, VMValue *args) {
     VMValue res = shaFn->function(1, shaArg);
 
     std::string acceptKey = res.asInstance()->fields["value"].asString()->flatten();
+    bool resetPerMessage = false;
+    bool deflate =
+        data->deflate && negotiateDeflate(extractHeader(request, "Sec-WebSocket-Extensions"), resetPerMessage);
     std::string response =
         "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: " +
-        acceptKey + "\r\n\r\n";
-    mbedtls_net_send(&client_fd, (const unsigned char *)response.c_str(), response.length());
+        acceptKey + "\r\n";
+    if (deflate)
+        response += std::string("Sec-WebSocket-Extensions: permessage-deflate") +
+                    (resetPerMessage ? "; server_no_context_takeover" : "") + "\r\n";
+    response += "\r\n";
+    wsWrite(clientData, (const unsigned char *)response.c_str(), response.length());
 
-    WSClientData *clientData = new WSClientData{client_fd};
+    clientData->deflate = deflate;
+    clientData->resetPerMessage = resetPerMessage;
     auto wsInst = new ObjInstance(currentVM->globals["WebSocket"].asClass());
     wsInst->nativeData = clientData;
     wsInst->freeFn = freeClient;
@@ -108,6 +232,17 @@ static VMValue wsSend(int argCount, VMValue *args) {
     WSClientData *data = (WSClientData *)inst->nativeData;
     std::string msg = args[0].asString()->flatten();
     std::vector<uint8_t> frame = {0x81};
+    if (data->deflate && msg.length() >= kMinDeflateSize) {
+        // Compressed messages drop the sync flush tail and set RSV1
+        std::string packed;
+        data->deflater.write(msg, packed);
+        data->deflater.flush(packed);
+        packed.resize(packed.size() - 4);
+        if (data->resetPerMessage)
+            data->deflater = Deflate::Deflater();
+        msg = std::move(packed);
+        frame[0] |= 0x40;
+    }
     size_t len = msg.length();
 
     if (len <= 125)
@@ -123,17 +258,20 @@ static VMValue wsSend(int argCount, VMValue *args) {
     }
 
     frame.insert(frame.end(), msg.begin(), msg.end());
-    return makeResultOk(currentVM, mbedtls_net_send(&data->fd, frame.data(), frame.size()) >= 0);
+    if (!wsWrite(data, frame.data(), frame.size()))
+        return makeResultErr(currentVM, "Send failed");
+    return makeResultOk(currentVM, true);
 }
 
 static VMValue wsRecv(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
     WSClientData *data = (WSClientData *)inst->nativeData;
     uint8_t header[2];
-    if (mbedtls_net_recv(&data->fd, header, 2) <= 0)
+    if (!readFull(data, header, 2))
         return makeResultErr(currentVM, "Closed");
 
     uint8_t opcode = header[0] & 0x0F;
+    bool compressed = (header[0] & 0x40) != 0;
     bool masked = (header[1] & 0x80) != 0;
     uint64_t len = header[1] & 0x7F;
 
@@ -142,41 +280,57 @@ static VMValue wsRecv(int argCount, VMValue *args) {
 
     if (len == 126) {
         uint8_t ext[2];
-        mbedtls_net_recv(&data->fd, ext, 2);
+        if (!readFull(data, ext, 2))
+            return makeResultErr(currentVM, "Read error");
         len = (uint64_t(ext[0]) << 8) | ext[1];
     } else if (len == 127) {
         uint8_t ext[8];
-        mbedtls_net_recv(&data->fd, ext, 8);
+        if (!readFull(data, ext, 8))
+            return makeResultErr(currentVM, "Read error");
         len = 0;
         for (int i = 0; i < 8; i++)
             len = (len << 8) | ext[i];
     }
 
     uint8_t mask[4] = {0};
-    if (masked)
-        mbedtls_net_recv(&data->fd, mask, 4);
+    if (masked && !readFull(data, mask, 4))
+        return makeResultErr(currentVM, "Read error");
 
     std::vector<uint8_t> payload(static_cast<size_t>(len));
-    size_t total = 0;
-    while (total < len) {
-        int r = mbedtls_net_recv(&data->fd, payload.data() + total, static_cast<size_t>(len - total));
-        if (r <= 0)
-            return makeResultErr(currentVM, "Read error");
-        total += static_cast<size_t>(r);
-    }
+    if (!readFull(data, payload.data(), payload.size()))
+        return makeResultErr(currentVM, "Read error");
 
     if (masked)
         for (size_t i = 0; i < static_cast<size_t>(len); i++)
             payload[i] ^= mask[i % 4];
-    return makeResultOk(currentVM, std::string(payload.begin(), payload.end()));
+    if (!compressed)
+        return makeResultOk(currentVM, std::string(payload.begin(), payload.end()));
+    if (!data->deflate)
+        return makeResultErr(currentVM, "Unexpected compressed message");
+
+    // Restore the sync flush tail the sender removed
+    static const uint8_t tail[4] = {0x00, 0x00, 0xff, 0xff};
+    payload.insert(payload.end(), tail, tail + 4);
+    std::string message;
+    size_t consumed = 0;
+    auto status = data->inflater.inflate(std::string_view((const char *)payload.data(), payload.size()), message,
+                                         consumed, kMaxInflatedMessage);
+    if (status == Deflate::Inflater::Status::TOO_LARGE)
+        return makeResultErr(currentVM, "Message too large");
+    if (status == Deflate::Inflater::Status::INVALID)
+        return makeResultErr(currentVM, "Malformed compressed message");
+    // A final block ends the sender's stream; the next message starts afresh
+    if (status == Deflate::Inflater::Status::DONE)
+        data->inflater = Deflate::Inflater();
+    return makeResultOk(currentVM, message);
 }
 
 static VMValue wsClose(int argCount, VMValue *args) {
     auto inst = args[-1].asInstance();
     if (inst->nativeData) {
         uint8_t frame[] = {0x88, 0x00};
-        mbedtls_net_send(&((WSClientData *)inst->nativeData)->fd, frame, 2);
-        mbedtls_net_free(&((WSClientData *)inst->nativeData)->fd);
+        wsWrite((WSClientData *)inst->nativeData, frame, 2);
+        freeClient(inst->nativeData);
         inst->nativeData = nullptr;
     }
     return makeResultOk(currentVM, true);
@@ -185,7 +339,7 @@ static VMValue wsClose(int argCount, VMValue *args) {
 void registerAll(VM *vm) {
     currentVM = vm;
     auto srv = new ObjClass("WebSocketServer");
-    srv->statics["create"] = new ObjNative("create", 1, wsServerCreate);
+    srv->statics["create"] = new ObjNative("create", -1, wsServerCreate);
     srv->methods["accept"] = new ObjNative("accept", 0, wsServerAccept);
     vm->globals["WebSocketServer"] = srv;
 
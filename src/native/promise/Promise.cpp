@@ -4,16 +4,9 @@
 namespace StdLib {
 namespace PromiseModule {
 
-static VMValue resolveNative(int argCount, VMValue *args) {
-    if (argCount < 1) return nullptr;
-    VM *vm = currentVM;
-    auto it = vm->globals.find("__promise_pending");
-    if (it == vm->globals.end() || !it->second.isPromise()) return nullptr;
-    ObjPromise *promise = it->second.asPromise();
-    if (promise->resolved) return nullptr;
-    promise->value = args[0];
+void settle(VM *vm, ObjPromise *promise, VMValue value) {
+    promise->value = value;
     promise->resolved = true;
-    vm->globals.erase("__promise_pending");
 
     auto handlers = std::move(promise->thenHandlers);
     promise->thenHandlers.clear();
@@ -25,7 +18,17 @@ static VMValue resolveNative(int argCount, VMValue *args) {
         pm.inputValue = promise->value;
         vm->promiseMicrotasks.push_back(pm);
     }
+}
 
+static VMValue resolveNative(int argCount, VMValue *args) {
+    if (argCount < 1) return nullptr;
+    VM *vm = currentVM;
+    auto it = vm->globals.find("__promise_pending");
+    if (it == vm->globals.end() || !it->second.isPromise()) return nullptr;
+    ObjPromise *promise = it->second.asPromise();
+    if (promise->resolved) return nullptr;
+    vm->eraseGlobal("__promise_pending");
+    settle(vm, promise, args[0]);
     return nullptr;
 }
 
@@ -38,7 +41,7 @@ static VMValue rejectNative(int argCount, VMValue *args) {
     if (promise->resolved) return nullptr;
     promise->value = args[0];
     promise->resolved = true;
-    vm->globals.erase("__promise_pending");
+    vm->eraseGlobal("__promise_pending");
 
     auto handlers = std::move(promise->thenHandlers);
     promise->thenHandlers.clear();
@@ -120,7 +123,7 @@ static VMValue promiseConstructor(int argCount, VMValue *args) {
     vm->callClosure(VMValue(executor), 2, &resolveVal);
 
     if (vm->globals.count("__promise_pending"))
-        vm->globals.erase("__promise_pending");
+        vm->eraseGlobal("__promise_pending");
 
     return VMValue(promise);
 }
@@ -8,6 +8,9 @@ namespace StdLib {
 namespace PromiseModule {
 void registerSymbols(SymbolTable *scope);
 void registerAll(VM *vm);
+// Fulfils `promise` with `value` and queues its then-handlers; used by
+// natives that complete work after returning the promise.
+void settle(VM *vm, ObjPromise *promise, VMValue value);
 } // namespace PromiseModule
 } // namespace StdLib
 
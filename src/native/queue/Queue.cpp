@@ -0,0 +1,356 @@
+#include "Queue.h"
+#include "../../vm/runtime/GC.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace StdLib {
+namespace QueueModule {
+
+// Ring buffer with a power-of-two capacity; `head` is the front slot.
+struct DequeData {
+    std::vector<VMValue> ring;
+    size_t head = 0;
+    size_t count = 0;
+
+    VMValue &at(size_t i) {
+        return ring[(head + i) & (ring.size() - 1)];
+    }
+
+    void grow() {
+        std::vector<VMValue> next(std::max<size_t>(8, ring.size() * 2), VMValue(nullptr));
+        for (size_t i = 0; i < count; i++)
+            next[i] = at(i);
+        ring.swap(next);
+        head = 0;
+    }
+};
+
+struct HeapEntry {
+    double priority;
+    uint64_t seq;
+    VMValue value;
+};
+
+// 4-ary min-heap. Without a comparator entries are ordered by numeric
+// priority and then by insertion, so equal priorities pop FIFO.
+struct PriorityQueueData {
+    std::vector<HeapEntry> heap;
+    VMValue comparator = nullptr;
+    uint64_t nextSeq = 0;
+    // Set while the comparator runs; the queue refuses changes meanwhile
+    bool busy = false;
+    // Values held outside `heap` during a sift or pop. The comparator can
+    // trigger a collection, so they are traced with the heap.
+    std::vector<VMValue> lifted;
+};
+
+static void freeDeque(void *ptr) {
+    delete static_cast<DequeData *>(ptr);
+}
+
+static void traceDeque(void *ptr) {
+    DequeData *deque = static_cast<DequeData *>(ptr);
+    for (size_t i = 0; i < deque->count; i++)
+        GC::markValue(deque->at(i));
+}
+
+static void freePriorityQueue(void *ptr) {
+    delete static_cast<PriorityQueueData *>(ptr);
+}
+
+static void tracePriorityQueue(void *ptr) {
+    PriorityQueueData *queue = static_cast<PriorityQueueData *>(ptr);
+    GC::markValue(queue->comparator);
+    for (auto &entry : queue->heap)
+        GC::markValue(entry.value);
+    for (auto &value : queue->lifted)
+        GC::markValue(value);
+}
+
+static DequeData *unwrapDeque(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freeDeque)
+        return nullptr;
+    return static_cast<DequeData *>(value.asInstance()->nativeData);
+}
+
+static PriorityQueueData *unwrapPriorityQueue(VMValue value) {
+    if (!value.isInstance() || value.asInstance()->freeFn != freePriorityQueue)
+        return nullptr;
+    return static_cast<PriorityQueueData *>(value.asInstance()->nativeData);
+}
+
+static VMValue dequeCreate(int argCount, VMValue *args) {
+    if (argCount > 1 || (argCount == 1 && !args[0].isList()))
+        return nullptr;
+    auto deque = new DequeData();
+    if (argCount == 1) {
+        for (const auto &value : args[0].asList()->elements) {
+            if (deque->count == deque->ring.size())
+                deque->grow();
+            deque->at(deque->count++) = value;
+        }
+    }
+    auto instance = new ObjInstance(currentVM->globals["Deque"].asClass());
+    instance->nativeData = deque;
+    instance->freeFn = freeDeque;
+    instance->traceFn = traceDeque;
+    return instance;
+}
+
+static VMValue dequePushBack(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque)
+        return nullptr;
+    if (deque->count == deque->ring.size())
+        deque->grow();
+    deque->at(deque->count++) = args[0];
+    return static_cast<double>(deque->count);
+}
+
+static VMValue dequePushFront(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque)
+        return nullptr;
+    if (deque->count == deque->ring.size())
+        deque->grow();
+    deque->head = (deque->head - 1) & (deque->ring.size() - 1);
+    deque->at(0) = args[0];
+    deque->count++;
+    return static_cast<double>(deque->count);
+}
+
+static VMValue dequePopBack(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque || deque->count == 0)
+        return nullptr;
+    VMValue &slot = deque->at(--deque->count);
+    VMValue value = slot;
+    slot = nullptr;
+    return value;
+}
+
+static VMValue dequePopFront(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque || deque->count == 0)
+        return nullptr;
+    VMValue &slot = deque->at(0);
+    VMValue value = slot;
+    slot = nullptr;
+    deque->head = (deque->head + 1) & (deque->ring.size() - 1);
+    deque->count--;
+    return value;
+}
+
+static VMValue dequePeekFront(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque || deque->count == 0)
+        return nullptr;
+    return deque->at(0);
+}
+
+static VMValue dequePeekBack(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque || deque->count == 0)
+        return nullptr;
+    return deque->at(deque->count - 1);
+}
+
+static VMValue dequeGet(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque || !args[0].isNumber())
+        return nullptr;
+    double i = args[0].asNumber();
+    if (i < 0 || i >= static_cast<double>(deque->count))
+        return nullptr;
+    return deque->at(static_cast<size_t>(i));
+}
+
+static VMValue dequeSize(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque)
+        return nullptr;
+    return static_cast<double>(deque->count);
+}
+
+static VMValue dequeClear(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque)
+        return nullptr;
+    std::fill(deque->ring.begin(), deque->ring.end(), VMValue(nullptr));
+    deque->head = 0;
+    deque->count = 0;
+    return args[-1];
+}
+
+static VMValue dequeToList(int argCount, VMValue *args) {
+    (void)argCount;
+    DequeData *deque = unwrapDeque(args[-1]);
+    if (!deque)
+        return nullptr;
+    std::vector<VMValue> elements;
+    elements.reserve(deque->count);
+    for (size_t i = 0; i < deque->count; i++)
+        elements.push_back(deque->at(i));
+    return new ObjList(elements);
+}
+
+static bool before(PriorityQueueData *queue, const HeapEntry &a, const HeapEntry &b) {
+    if (queue->comparator.isNil())
+        return a.priority < b.priority || (a.priority == b.priority && a.seq < b.seq);
+    VMValue pair[2] = {a.value, b.value};
+    queue->busy = true;
+    VMValue result = currentVM->callClosure(queue->comparator, 2, pair);
+    queue->busy = false;
+    return result.isBool() ? result.asBool() : !result.isNil();
+}
+
+static void siftUp(PriorityQueueData *queue, size_t i) {
+    HeapEntry entry = queue->heap[i];
+    queue->lifted.push_back(entry.value);
+    while (i > 0) {
+        size_t parent = (i - 1) / 4;
+        if (!before(queue, entry, queue->heap[parent]))
+            break;
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = entry;
+    queue->lifted.pop_back();
+}
+
+static void siftDown(PriorityQueueData *queue, size_t i) {
+    HeapEntry entry = queue->heap[i];
+    queue->lifted.push_back(entry.value);
+    size_t n = queue->heap.size();
+    for (;;) {
+        size_t first = 4 * i + 1;
+        if (first >= n)
+            break;
+        size_t best = first;
+        for (size_t c = first + 1; c < std::min(first + 4, n); c++) {
+            if (before(queue, queue->heap[c], queue->heap[best]))
+                best = c;
+        }
+        if (!before(queue, queue->heap[best], entry))
+            break;
+        queue->heap[i] = queue->heap[best];
+        i = best;
+    }
+    queue->heap[i] = entry;
+    queue->lifted.pop_back();
+}
+
+// PriorityQueue.create(less?) orders by numeric priority, or by the
+// closure less(a, b) returning true when a should pop before b.
+static VMValue priorityQueueCreate(int argCount, VMValue *args) {
+    if (argCount > 1 || (argCount == 1 && !args[0].isClosure()))
+        return nullptr;
+    auto queue = new PriorityQueueData();
+    if (argCount == 1)
+        queue->comparator = args[0];
+    auto instance = new ObjInstance(currentVM->globals["PriorityQueue"].asClass());
+    instance->nativeData = queue;
+    instance->freeFn = freePriorityQueue;
+    instance->traceFn = tracePriorityQueue;
+    return instance;
+}
+
+// push(value, priority) with numeric priorities (a number value may omit
+// the priority), or push(value) with a comparator.
+static VMValue priorityQueuePush(int argCount, VMValue *args) {
+    PriorityQueueData *queue = unwrapPriorityQueue(args[-1]);
+    if (!queue || queue->busy || argCount < 1 || argCount > 2)
+        return nullptr;
+    HeapEntry entry{0, queue->nextSeq++, args[0]};
+    if (queue->comparator.isNil()) {
+        VMValue priority = argCount == 2 ? args[1] : args[0];
+        if (!priority.isNumber())
+            return nullptr;
+        entry.priority = priority.asNumber();
+    } else if (argCount != 1) {
+        return nullptr;
+    }
+    queue->heap.push_back(entry);
+    siftUp(queue, queue->heap.size() - 1);
+    return static_cast<double>(queue->heap.size());
+}
+
+static VMValue priorityQueuePop(int argCount, VMValue *args) {
+    (void)argCount;
+    PriorityQueueData *queue = unwrapPriorityQueue(args[-1]);
+    if (!queue || queue->busy || queue->heap.empty())
+        return nullptr;
+    VMValue top = queue->heap.front().value;
+    queue->heap.front() = queue->heap.back();
+    queue->heap.pop_back();
+    if (!queue->heap.empty()) {
+        queue->lifted.push_back(top);
+        siftDown(queue, 0);
+        queue->lifted.pop_back();
+    }
+    return top;
+}
+
+static VMValue priorityQueuePeek(int argCount, VMValue *args) {
+    (void)argCount;
+    PriorityQueueData *queue = unwrapPriorityQueue(args[-1]);
+    if (!queue || queue->heap.empty())
+        return nullptr;
+    return queue->heap.front().value;
+}
+
+static VMValue priorityQueueSize(int argCount, VMValue *args) {
+    (void)argCount;
+    PriorityQueueData *queue = unwrapPriorityQueue(args[-1]);
+    if (!queue)
+        return nullptr;
+    return static_cast<double>(queue->heap.size());
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto dequeClass = new ObjClass("Deque");
+    dequeClass->statics["create"] = new ObjNative("create", -1, dequeCreate);
+    dequeClass->methods["pushBack"] = new ObjNative("pushBack", 1, dequePushBack);
+    dequeClass->methods["pushFront"] = new ObjNative("pushFront", 1, dequePushFront);
+    dequeClass->methods["popBack"] = new ObjNative("popBack", 0, dequePopBack);
+    dequeClass->methods["popFront"] = new ObjNative("popFront", 0, dequePopFront);
+    dequeClass->methods["peekFront"] = new ObjNative("peekFront", 0, dequePeekFront);
+    dequeClass->methods["peekBack"] = new ObjNative("peekBack", 0, dequePeekBack);
+    dequeClass->methods["get"] = new ObjNative("get", 1, dequeGet);
+    dequeClass->methods["size"] = new ObjNative("size", 0, dequeSize);
+    dequeClass->methods["clear"] = new ObjNative("clear", 0, dequeClear);
+    dequeClass->methods["toList"] = new ObjNative("toList", 0, dequeToList);
+    vm->globals["Deque"] = dequeClass;
+
+    auto queueClass = new ObjClass("PriorityQueue");
+    queueClass->statics["create"] = new ObjNative("create", -1, priorityQueueCreate);
+    queueClass->methods["push"] = new ObjNative("push", -1, priorityQueuePush);
+    queueClass->methods["pop"] = new ObjNative("pop", 0, priorityQueuePop);
+    queueClass->methods["peek"] = new ObjNative("peek", 0, priorityQueuePeek);
+    queueClass->methods["size"] = new ObjNative("size", 0, priorityQueueSize);
+    vm->globals["PriorityQueue"] = queueClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "Deque";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+    sym.name = "PriorityQueue";
+    scope->define(sym);
+}
+
+} // namespace QueueModule
+} // namespace StdLib
@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_QUEUE_H
+#define TRYPILLIA_QUEUE_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace QueueModule {
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace QueueModule
+} // namespace StdLib
+
+#endif
@@ -0,0 +1,181 @@
+#include "Set.h"
+#include <utility>
+
+namespace StdLib {
+namespace SetModule {
+
+static ObjSet *fromElements(const std::vector<VMValue> &elements) {
+    auto set = new ObjSet();
+    set->reserve(elements.size());
+    for (const auto &value : elements)
+        set->insert(value);
+    return set;
+}
+
+// Copies the table as-is instead of re-hashing every member.
+static ObjSet *copyOf(const ObjSet *source) {
+    auto set = new ObjSet();
+    set->entries = source->entries;
+    set->hashes = source->hashes;
+    set->slots = source->slots;
+    return set;
+}
+
+// Right-hand side of a set operation: a set, or a list taken as one.
+static ObjSet *operand(VMValue value) {
+    if (value.isSet())
+        return value.asSet();
+    if (value.isList())
+        return fromElements(value.asList()->elements);
+    return nullptr;
+}
+
+static VMValue setCreate(int argCount, VMValue *args) {
+    if (argCount == 0)
+        return new ObjSet();
+    if (argCount != 1 || !args[0].isList())
+        return nullptr;
+    return fromElements(args[0].asList()->elements);
+}
+
+static VMValue setSize(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isSet())
+        return nullptr;
+    return static_cast<double>(args[0].asSet()->size());
+}
+
+static VMValue setHas(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet())
+        return nullptr;
+    return args[0].asSet()->contains(args[1]);
+}
+
+static VMValue setAdd(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet() || args[0].asSet()->isFrozen)
+        return nullptr;
+    return args[0].asSet()->insert(args[1]);
+}
+
+static VMValue setRemove(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet() || args[0].asSet()->isFrozen)
+        return nullptr;
+    return args[0].asSet()->erase(args[1]);
+}
+
+static VMValue setClear(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isSet() || args[0].asSet()->isFrozen)
+        return nullptr;
+    args[0].asSet()->clear();
+    return args[0];
+}
+
+static VMValue setToList(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isSet())
+        return nullptr;
+    return new ObjList(args[0].asSet()->entries);
+}
+
+// Copies the larger operand and inserts the smaller one into it; members
+// of the larger operand come first.
+static VMValue setUnion(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet())
+        return nullptr;
+    ObjSet *a = args[0].asSet();
+    ObjSet *b = operand(args[1]);
+    if (!b)
+        return nullptr;
+    if (a->size() < b->size())
+        std::swap(a, b);
+    ObjSet *result = copyOf(a);
+    result->reserve(a->size() + b->size());
+    for (const auto &value : b->entries)
+        result->insert(value);
+    return result;
+}
+
+// Probes the larger operand with each member of the smaller one.
+static VMValue setIntersection(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet())
+        return nullptr;
+    ObjSet *a = args[0].asSet();
+    ObjSet *b = operand(args[1]);
+    if (!b)
+        return nullptr;
+    if (a->size() > b->size())
+        std::swap(a, b);
+    auto result = new ObjSet();
+    for (const auto &value : a->entries) {
+        if (b->contains(value))
+            result->insert(value);
+    }
+    return result;
+}
+
+// Members of the receiver that are not in the argument. When the argument
+// is the smaller side, its members are removed from a copy instead.
+static VMValue setDifference(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet())
+        return nullptr;
+    ObjSet *a = args[0].asSet();
+    ObjSet *b = operand(args[1]);
+    if (!b)
+        return nullptr;
+    if (b->size() < a->size()) {
+        ObjSet *result = copyOf(a);
+        for (const auto &value : b->entries)
+            result->erase(value);
+        return result;
+    }
+    auto result = new ObjSet();
+    for (const auto &value : a->entries) {
+        if (!b->contains(value))
+            result->insert(value);
+    }
+    return result;
+}
+
+static VMValue setIsSubset(int argCount, VMValue *args) {
+    if (argCount != 2 || !args[0].isSet())
+        return nullptr;
+    ObjSet *a = args[0].asSet();
+    ObjSet *b = operand(args[1]);
+    if (!b)
+        return nullptr;
+    if (a->size() > b->size())
+        return false;
+    for (const auto &value : a->entries) {
+        if (!b->contains(value))
+            return false;
+    }
+    return true;
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto setClass = new ObjClass("Set");
+
+    setClass->statics["create"] = new ObjNative("create", -1, setCreate);
+    setClass->statics["size"] = new ObjNative("size", 1, setSize);
+    setClass->statics["has"] = new ObjNative("has", 2, setHas);
+    setClass->statics["add"] = new ObjNative("add", 2, setAdd);
+    setClass->statics["remove"] = new ObjNative("remove", 2, setRemove);
+    setClass->statics["clear"] = new ObjNative("clear", 1, setClear);
+    setClass->statics["toList"] = new ObjNative("toList", 1, setToList);
+    setClass->statics["union"] = new ObjNative("union", 2, setUnion);
+    setClass->statics["intersection"] = new ObjNative("intersection", 2, setIntersection);
+    setClass->statics["difference"] = new ObjNative("difference", 2, setDifference);
+    setClass->statics["isSubset"] = new ObjNative("isSubset", 2, setIsSubset);
+
+    vm->globals["Set"] = setClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "Set";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+}
+
+} // namespace SetModule
+} // namespace StdLib
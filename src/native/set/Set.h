@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_SET_H
+#define TRYPILLIA_SET_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace SetModule {
+void registerSymbols(SymbolTable *scope);
+void registerAll(VM *vm);
+} // namespace SetModule
+} // namespace StdLib
+
+#endif
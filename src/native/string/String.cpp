@@ -1,7 +1,8 @@
 #include "String.h"
-#include <algorithm>
-#include <cctype>
+#include "StringKernels.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace StdLib {
 namespace StringModule {
@@ -28,88 +29,109 @@ static VMValue stringSubstring(int argCount, VMValue *args) {
 static VMValue stringToUpper(int argCount, VMValue *args) {
     if (argCount != 1 || !args[0].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
-    for (char &c : str)
-        c = std::toupper(c);
-    return str;
+    return StringKernels::toUpper(args[0].asString()->flatView());
 }
 
 static VMValue stringToLower(int argCount, VMValue *args) {
     if (argCount != 1 || !args[0].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
-    for (char &c : str)
-        c = std::tolower(c);
-    return str;
+    return StringKernels::toLower(args[0].asString()->flatView());
 }
 
 static VMValue stringTrim(int argCount, VMValue *args) {
     if (argCount != 1 || !args[0].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
+    std::string_view str = args[0].asString()->flatView();
+    std::string_view trimmed = StringKernels::trim(str);
+    if (trimmed.size() == str.size())
+        return args[0];
+    return std::string(trimmed);
+}
 
-    auto start = str.begin();
-    while (start != str.end() && std::isspace(*start)) {
-        start++;
+// Appends the pieces of `str` around `delim` to `list`, producing at most
+// `limit` pieces; the last one keeps the unsplit remainder. An empty
+// delimiter splits into UTF-8 characters.
+static void splitInto(ObjList *list, std::string_view str, std::string_view delim, size_t limit) {
+    auto &out = list->elements;
+    size_t start = 0;
+    if (delim.empty()) {
+        while (start < str.size() && out.size() + 1 < limit) {
+            size_t next = start + 1;
+            while (next < str.size() && (static_cast<unsigned char>(str[next]) & 0xC0) == 0x80)
+                next++;
+            out.push_back(std::string(str.substr(start, next - start)));
+            start = next;
+        }
+        if (start < str.size())
+            out.push_back(std::string(str.substr(start)));
+        return;
     }
 
-    auto end = str.end();
-    do {
-        end--;
-    } while (std::distance(start, end) > 0 && std::isspace(*end));
-
-    return std::string(start, end + 1);
+    size_t end;
+    while (out.size() + 1 < limit && (end = StringKernels::find(str, delim, start)) != StringKernels::npos) {
+        out.push_back(std::string(str.substr(start, end - start)));
+        start = end + delim.size();
+    }
+    out.push_back(std::string(str.substr(start)));
 }
 
 static VMValue stringSplit(int argCount, VMValue *args) {
     if (argCount != 2 || !args[0].isString() || !args[1].isString())
         return nullptr;
 
-    std::string str = args[0].asString()->flatten();
-    std::string delim = args[1].asString()->flatten();
-
     auto list = new ObjList(std::vector<VMValue>{});
-    size_t start = 0;
-    size_t end = str.find(delim);
+    splitInto(list, args[0].asString()->flatView(), args[1].asString()->flatView(), SIZE_MAX);
+    return list;
+}
 
-    while (end != std::string::npos) {
-        list->elements.push_back(str.substr(start, end - start));
-        start = end + delim.length();
-        end = str.find(delim, start);
-    }
-    list->elements.push_back(str.substr(start));
+static VMValue stringSplitLimit(int argCount, VMValue *args) {
+    if (argCount != 3 || !args[0].isString() || !args[1].isString() || !args[2].isNumber())
+        return nullptr;
+    double limit = args[2].asNumber();
+    if (!(limit >= 1)) // also rejects NaN
+        return nullptr;
+    // Past any string length; also keeps infinity out of the cast
+    size_t parts = limit >= 1e18 ? SIZE_MAX : static_cast<size_t>(limit);
 
+    auto list = new ObjList(std::vector<VMValue>{});
+    splitInto(list, args[0].asString()->flatView(), args[1].asString()->flatView(), parts);
     return list;
 }
 
-static VMValue stringReplace(int argCount, VMValue *args) {
+// Replaces every occurrence in one left-to-right pass, copying each
+// unmatched span once.
+static VMValue stringReplaceAll(int argCount, VMValue *args) {
     if (argCount != 3 || !args[0].isString() || !args[1].isString() || !args[2].isString())
         return nullptr;
 
-    std::string str = args[0].asString()->flatten();
-    std::string search = args[1].asString()->flatten();
-    std::string replace = args[2].asString()->flatten();
+    std::string_view str = args[0].asString()->flatView();
+    std::string_view search = args[1].asString()->flatView();
+    std::string_view replace = args[2].asString()->flatView();
 
     if (search.empty())
-        return str;
+        return args[0];
 
-    size_t pos = 0;
-    while ((pos = str.find(search, pos)) != std::string::npos) {
-        str.replace(pos, search.length(), replace);
-        pos += replace.length();
-    }
+    size_t pos = StringKernels::find(str, search);
+    if (pos == StringKernels::npos)
+        return args[0];
 
-    return str;
+    std::string out;
+    out.reserve(str.size());
+    size_t start = 0;
+    do {
+        out.append(str, start, pos - start);
+        out.append(replace);
+        start = pos + search.size();
+    } while ((pos = StringKernels::find(str, search, start)) != StringKernels::npos);
+    out.append(str, start, std::string_view::npos);
+    return out;
 }
 
 static VMValue stringIndexOf(int argCount, VMValue *args) {
     if (argCount != 2 || !args[0].isString() || !args[1].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
-    std::string search = args[1].asString()->flatten();
-
-    size_t pos = str.find(search);
-    if (pos == std::string::npos)
+    size_t pos = StringKernels::find(args[0].asString()->flatView(), args[1].asString()->flatView());
+    if (pos == StringKernels::npos)
         return (double)-1;
     return (double)pos;
 }
@@ -117,32 +139,27 @@ static VMValue stringIndexOf(int argCount, VMValue *args) {
 static VMValue stringIncludes(int argCount, VMValue *args) {
     if (argCount != 2 || !args[0].isString() || !args[1].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
-    std::string search = args[1].asString()->flatten();
-
-    return str.find(search) != std::string::npos;
+    return StringKernels::find(args[0].asString()->flatView(), args[1].asString()->flatView()) != StringKernels::npos;
 }
 
 static VMValue stringStartsWith(int argCount, VMValue *args) {
     if (argCount != 2 || !args[0].isString() || !args[1].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
-    std::string prefix = args[1].asString()->flatten();
-
-    return str.rfind(prefix, 0) == 0;
+    std::string_view str = args[0].asString()->flatView();
+    return str.starts_with(args[1].asString()->flatView());
 }
 
 static VMValue stringEndsWith(int argCount, VMValue *args) {
     if (argCount != 2 || !args[0].isString() || !args[1].isString())
         return nullptr;
-    std::string str = args[0].asString()->flatten();
-    std::string suffix = args[1].asString()->flatten();
+    std::string_view str = args[0].asString()->flatView();
+    return str.ends_with(args[1].asString()->flatView());
+}
 
-    if (str.length() >= suffix.length()) {
-        return (0 == str.compare(str.length() - suffix.length(), suffix.length(), suffix));
-    } else {
-        return false;
-    }
+static VMValue stringIsValidUtf8(int argCount, VMValue *args) {
+    if (argCount != 1 || !args[0].isString())
+        return nullptr;
+    return StringKernels::isValidUtf8(args[0].asString()->flatView());
 }
 
 static VMValue stringToNumber(int argCount, VMValue *args) {
@@ -166,12 +183,15 @@ void registerAll(VM *vm) {
     stringClass->statics["toLower"] = new ObjNative("toLower", 1, stringToLower);
     stringClass->statics["trim"] = new ObjNative("trim", 1, stringTrim);
     stringClass->statics["split"] = new ObjNative("split", 2, stringSplit);
-    stringClass->statics["replace"] = new ObjNative("replace", 3, stringReplace);
+    stringClass->statics["splitLimit"] = new ObjNative("splitLimit", 3, stringSplitLimit);
+    stringClass->statics["replace"] = new ObjNative("replace", 3, stringReplaceAll);
+    stringClass->statics["replaceAll"] = new ObjNative("replaceAll", 3, stringReplaceAll);
     stringClass->statics["indexOf"] = new ObjNative("indexOf", 2, stringIndexOf);
     stringClass->statics["includes"] = new ObjNative("includes", 2, stringIncludes);
     stringClass->statics["startsWith"] = new ObjNative("startsWith", 2, stringStartsWith);
     stringClass->statics["endsWith"] = new ObjNative("endsWith", 2, stringEndsWith);
     stringClass->statics["toNumber"] = new ObjNative("toNumber", 1, stringToNumber);
+    stringClass->statics["isValidUtf8"] = new ObjNative("isValidUtf8", 1, stringIsValidUtf8);
 
     vm->globals["String"] = stringClass;
 }
@@ -0,0 +1,300 @@
+#include "StringKernels.h"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define TRYPILLIA_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace StdLib {
+namespace StringKernels {
+
+namespace {
+
+// Needles at least this long go to glibc's memmem, which switches to the
+// Two-Way algorithm and stays linear where the byte filter below would
+// degrade on repetitive text.
+constexpr size_t kLongNeedle = 32;
+
+#ifdef TRYPILLIA_SSE2
+inline __m128i load16(const void *p) {
+    return _mm_loadu_si128(static_cast<const __m128i *>(p));
+}
+
+inline unsigned highBits(__m128i v) {
+    return static_cast<unsigned>(_mm_movemask_epi8(v));
+}
+
+// 0xFF in each lane holding " \t\n\v\f\r"
+inline __m128i whitespaceLanes(__m128i v) {
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    __m128i control = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(8)), _mm_cmplt_epi8(v, _mm_set1_epi8(14)));
+    return _mm_or_si128(space, control);
+}
+#endif
+
+inline bool isSpace(unsigned char c) {
+    return c == ' ' || (c >= 9 && c <= 13);
+}
+
+unsigned upperOf(unsigned cp) {
+    if (cp >= 0xE0 && cp <= 0xFE && cp != 0xF7)
+        return cp - 0x20; // Latin-1 à..þ
+    if (cp >= 0x430 && cp <= 0x44F)
+        return cp - 0x20; // а..я
+    if (cp >= 0x450 && cp <= 0x45F)
+        return cp - 0x50; // ѐ..џ, including є, і, ї
+    if (cp == 0x491)
+        return 0x490; // ґ
+    return cp;
+}
+
+unsigned lowerOf(unsigned cp) {
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7)
+        return cp + 0x20;
+    if (cp >= 0x410 && cp <= 0x42F)
+        return cp + 0x20;
+    if (cp >= 0x400 && cp <= 0x40F)
+        return cp + 0x50;
+    if (cp == 0x490)
+        return 0x491;
+    return cp;
+}
+
+// Re-cases the two-byte sequence at `i`, if any, and returns the index of
+// the next unprocessed byte. ASCII bytes are skipped untouched.
+template <bool Upper> size_t mapSequence(unsigned char *p, size_t n, size_t i) {
+    unsigned char c = p[i];
+    if ((c & 0xE0) != 0xC0 || i + 1 >= n || (p[i + 1] & 0xC0) != 0x80)
+        return i + 1;
+    unsigned cp = ((c & 0x1Fu) << 6) | (p[i + 1] & 0x3Fu);
+    unsigned mapped = Upper ? upperOf(cp) : lowerOf(cp);
+    if (mapped != cp) {
+        p[i] = static_cast<unsigned char>(0xC0 | (mapped >> 6));
+        p[i + 1] = static_cast<unsigned char>(0x80 | (mapped & 0x3F));
+    }
+    return i + 2;
+}
+
+template <bool Upper> std::string mapCase(std::string_view text) {
+    std::string out(text);
+    auto *p = reinterpret_cast<unsigned char *>(out.data());
+    size_t n = out.size();
+    const unsigned char from = Upper ? 'a' : 'A';
+    const unsigned char to = Upper ? 'z' : 'Z';
+    size_t i = 0;
+
+#ifdef TRYPILLIA_SSE2
+    // Bytes >= 0x80 compare as negative, so the range mask only ever
+    // selects ASCII letters and the flip is safe on mixed blocks.
+    const __m128i lo = _mm_set1_epi8(static_cast<char>(from - 1));
+    const __m128i hi = _mm_set1_epi8(static_cast<char>(to + 1));
+    const __m128i flip = _mm_set1_epi8(0x20);
+    while (i + 16 <= n) {
+        __m128i v = load16(p + i);
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), _mm_xor_si128(v, _mm_and_si128(letters, flip)));
+        unsigned wide = highBits(v);
+        if (wide == 0) {
+            i += 16;
+            continue;
+        }
+        size_t stop = i + 16;
+        size_t j = i + std::countr_zero(wide);
+        while (j < stop)
+            j = mapSequence<Upper>(p, n, j);
+        i = j;
+    }
+#endif
+
+    while (i < n) {
+        if (p[i] < 0x80) {
+            if (p[i] >= from && p[i] <= to)
+                p[i] ^= 0x20;
+            i++;
+        } else {
+            i = mapSequence<Upper>(p, n, i);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+size_t find(std::string_view haystack, std::string_view needle, size_t from) {
+    size_t n = haystack.size();
+    size_t k = needle.size();
+    if (from > n)
+        return npos;
+    if (k == 0)
+        return from;
+    if (k > n - from)
+        return npos;
+
+    const char *base = haystack.data();
+    if (k == 1) {
+        const void *hit = memchr(base + from, needle[0], n - from);
+        return hit ? static_cast<size_t>(static_cast<const char *>(hit) - base) : npos;
+    }
+#ifdef __GLIBC__
+    if (k >= kLongNeedle) {
+        const void *hit = memmem(base + from, n - from, needle.data(), k);
+        return hit ? static_cast<size_t>(static_cast<const char *>(hit) - base) : npos;
+    }
+#endif
+
+    // Filter candidate positions on the first and last needle byte at
+    // once, then confirm the middle with memcmp.
+    const char first = needle[0];
+    const char last = needle[k - 1];
+    const char *middle = needle.data() + 1;
+    size_t lastStart = n - k;
+    size_t i = from;
+
+#ifdef TRYPILLIA_SSE2
+    const __m128i vFirst = _mm_set1_epi8(first);
+    const __m128i vLast = _mm_set1_epi8(last);
+    while (i + 15 <= lastStart) {
+        __m128i a = _mm_cmpeq_epi8(load16(base + i), vFirst);
+        __m128i b = _mm_cmpeq_epi8(load16(base + i + k - 1), vLast);
+        unsigned candidates = highBits(_mm_and_si128(a, b));
+        while (candidates) {
+            size_t at = i + std::countr_zero(candidates);
+            if (memcmp(base + at + 1, middle, k - 2) == 0)
+                return at;
+            candidates &= candidates - 1;
+        }
+        i += 16;
+    }
+#endif
+
+    for (; i <= lastStart; i++) {
+        if (base[i] == first && base[i + k - 1] == last && memcmp(base + i + 1, middle, k - 2) == 0)
+            return i;
+    }
+    return npos;
+}
+
+size_t findAny(std::string_view text, size_t from, char a, char b, char c, char d) {
+    const char *p = text.data();
+    size_t n = text.size();
+    size_t i = from;
+
+#ifdef TRYPILLIA_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    const __m128i vd = _mm_set1_epi8(d);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = load16(p + i);
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd)));
+        unsigned mask = highBits(hits);
+        if (mask)
+            return i + std::countr_zero(mask);
+    }
+#endif
+
+    for (; i < n; i++) {
+        char ch = p[i];
+        if (ch == a || ch == b || ch == c || ch == d)
+            return i;
+    }
+    return npos;
+}
+
+std::string toUpper(std::string_view text) {
+    return mapCase<true>(text);
+}
+
+std::string toLower(std::string_view text) {
+    return mapCase<false>(text);
+}
+
+std::string_view trim(std::string_view text) {
+    const char *p = text.data();
+    size_t start = 0;
+    size_t end = text.size();
+
+#ifdef TRYPILLIA_SSE2
+    while (start + 16 <= end) {
+        unsigned content = ~highBits(whitespaceLanes(load16(p + start))) & 0xFFFF;
+        if (content) {
+            start += std::countr_zero(content);
+            break;
+        }
+        start += 16;
+    }
+#endif
+    while (start < end && isSpace(p[start]))
+        start++;
+
+#ifdef TRYPILLIA_SSE2
+    while (end >= start + 16) {
+        unsigned content = ~highBits(whitespaceLanes(load16(p + end - 16))) & 0xFFFF;
+        if (content) {
+            end = end - 16 + std::bit_width(content);
+            break;
+        }
+        end -= 16;
+    }
+#endif
+    while (end > start && isSpace(p[end - 1]))
+        end--;
+
+    return text.substr(start, end - start);
+}
+
+bool isValidUtf8(std::string_view text) {
+    const auto *s = reinterpret_cast<const unsigned char *>(text.data());
+    size_t n = text.size();
+    size_t i = 0;
+
+    while (i < n) {
+#ifdef TRYPILLIA_SSE2
+        while (i + 16 <= n && highBits(load16(s + i)) == 0)
+            i += 16;
+        if (i >= n)
+            break;
+#endif
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t length;
+        uint32_t cp;
+        if (c >= 0xC2 && c <= 0xDF) {
+            length = 2;
+            cp = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            length = 3;
+            cp = c & 0x0F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            length = 4;
+            cp = c & 0x07;
+        } else {
+            return false;
+        }
+        if (i + length > n)
+            return false;
+        for (size_t k = 1; k < length; k++) {
+            if ((s[i + k] & 0xC0) != 0x80)
+                return false;
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        // Reject overlong forms, surrogates and code points past U+10FFFF
+        if (length == 3 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)))
+            return false;
+        if (length == 4 && (cp < 0x10000 || cp > 0x10FFFF))
+            return false;
+        i += length;
+    }
+    return true;
+}
+
+} // namespace StringKernels
+} // namespace StdLib
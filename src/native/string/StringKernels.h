@@ -0,0 +1,38 @@
+#ifndef TRYPILLIA_STRING_KERNELS_H
+#define TRYPILLIA_STRING_KERNELS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Byte-level string routines shared by the String module and parsers.
+// They use SSE2 where the target has it (always on x86-64) and fall back
+// to scalar code elsewhere; results never depend on which path ran.
+namespace StdLib {
+namespace StringKernels {
+
+constexpr size_t npos = std::string_view::npos;
+
+// Offset of the first occurrence of `needle` at or after `from`, or npos.
+size_t find(std::string_view haystack, std::string_view needle, size_t from = 0);
+
+// Offset of the first byte at or after `from` equal to any of a, b, c or
+// d (repeat a byte to look for fewer), or npos. Tokenizers use it to jump
+// over plain runs of text.
+size_t findAny(std::string_view text, size_t from, char a, char b, char c, char d);
+
+// Case mapping for ASCII plus the two-byte UTF-8 letters of Latin-1 and
+// Cyrillic; everything else is copied unchanged. Output length equals
+// input length.
+std::string toUpper(std::string_view text);
+std::string toLower(std::string_view text);
+
+// `text` without leading and trailing ASCII whitespace (" \t\n\v\f\r").
+std::string_view trim(std::string_view text);
+
+bool isValidUtf8(std::string_view text);
+
+} // namespace StringKernels
+} // namespace StdLib
+
+#endif
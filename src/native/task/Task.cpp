@@ -0,0 +1,122 @@
+#include "Task.h"
+#include "../../vm/runtime/GC.h"
+#include "../StdLib.h"
+
+namespace StdLib {
+namespace TaskModule {
+
+static GreenTask *taskOf(VMValue receiver) {
+    if (!receiver.isInstance())
+        return nullptr;
+    return static_cast<GreenTask *>(receiver.asInstance()->nativeData);
+}
+
+static void traceTask(void *ptr) {
+    GreenTask *task = static_cast<GreenTask *>(ptr);
+    GC::markValue(task->fn);
+    GC::markValue(task->result);
+    for (auto &v : task->args)
+        GC::markValue(v);
+    for (auto &v : task->stack)
+        GC::markValue(v);
+    for (auto &frame : task->frames)
+        GC::markObj(frame.closure);
+    for (ObjUpvalue *up = task->openUpvalues; up; up = up->next)
+        GC::markObj(up);
+    for (GreenTask *joiner : task->joiners)
+        GC::markObj(joiner->handle);
+}
+
+static VMValue taskSpawn(int argCount, VMValue *args) {
+    if (argCount < 1 || !(args[0].isClosure() || args[0].isNative() || args[0].isBoundMethod()))
+        return nullptr;
+
+    auto instance = new ObjInstance(currentVM->globals["Task"].asClass());
+    GreenTask *task = new GreenTask();
+    task->fn = args[0];
+    task->args.assign(args + 1, args + argCount);
+    task->handle = instance;
+
+    instance->nativeData = task;
+    instance->traceFn = traceTask;
+    instance->freeFn = [](void *ptr) { delete static_cast<GreenTask *>(ptr); };
+
+    currentVM->spawnTask(task);
+    return instance;
+}
+
+static VMValue taskYield(int argCount, VMValue *args) {
+    (void)argCount;
+    (void)args;
+    VM *vm = currentVM;
+    if (vm->canSuspendTask())
+        vm->taskSwitchPending = true;
+    else
+        vm->runTaskRound();
+    return nullptr;
+}
+
+static VMValue taskJoin(int argCount, VMValue *args) {
+    (void)argCount;
+    VM *vm = currentVM;
+    GreenTask *task = taskOf(args[-1]);
+    if (!task || task == vm->currentTask)
+        return nullptr;
+    if (task->done)
+        return task->result;
+
+    if (vm->canSuspendTask()) {
+        // Park the caller; finishTask() overwrites the nil we return with
+        // the result before requeueing it.
+        vm->currentTask->waitingOn = task;
+        task->joiners.push_back(vm->currentTask);
+        vm->taskSwitchPending = true;
+        return nullptr;
+    }
+
+    vm->runTasks(task);
+    return task->done ? task->result : VMValue(nullptr);
+}
+
+static VMValue taskDone(int argCount, VMValue *args) {
+    (void)argCount;
+    GreenTask *task = taskOf(args[-1]);
+    return task && task->done;
+}
+
+static VMValue taskFailed(int argCount, VMValue *args) {
+    (void)argCount;
+    GreenTask *task = taskOf(args[-1]);
+    return task && task->failed;
+}
+
+static VMValue taskPending(int argCount, VMValue *args) {
+    (void)argCount;
+    (void)args;
+    return static_cast<double>(currentVM->liveTasks.size());
+}
+
+void registerAll(VM *vm) {
+    currentVM = vm;
+    auto taskClass = new ObjClass("Task");
+
+    taskClass->statics["spawn"] = new ObjNative("spawn", -1, taskSpawn);
+    taskClass->statics["yield"] = new ObjNative("yield", 0, taskYield);
+    taskClass->statics["pending"] = new ObjNative("pending", 0, taskPending);
+    taskClass->methods["join"] = new ObjNative("join", 0, taskJoin);
+    taskClass->methods["done"] = new ObjNative("done", 0, taskDone);
+    taskClass->methods["failed"] = new ObjNative("failed", 0, taskFailed);
+
+    vm->globals["Task"] = taskClass;
+}
+
+void registerSymbols(SymbolTable *scope) {
+    Symbol sym;
+    sym.name = "Task";
+    sym.type = "class";
+    sym.isConst = true;
+    scope->define(sym);
+}
+
+} // namespace TaskModule
+} // namespace StdLib
@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_TASK_H
+#define TRYPILLIA_TASK_H
+
+#include "../../symbol/SymbolTable.h"
+#include "../../vm/VM.h"
+
+namespace StdLib {
+namespace TaskModule {
+void registerAll(VM *vm);
+void registerSymbols(SymbolTable *scope);
+} // namespace TaskModule
+} // namespace StdLib
+
+#endif
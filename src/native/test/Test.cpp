@@ -32,6 +32,16 @@ static std::string valueToString(const VMValue &val, int depth = 0) {
         result += "}";
         return result;
     }
+    if (val.isSet()) {
+        auto set = val.asSet();
+        std::string result = "Set {";
+        for (size_t i = 0; i < set->entries.size(); i++) {
+            if (i > 0) result += ", ";
+            result += valueToString(set->entries[i], depth + 1);
+        }
+        result += "}";
+        return result;
+    }
     return val.toString(true);
 }
 
@@ -198,6 +208,8 @@ static VMValue assertThrowsNative(int argCount, VMValue *args) {
 
     auto savedStackTop = vm->stackTop;
     auto savedFrameCount = vm->frames.size();
+    auto savedJitFrames = vm->jitFrames.size();
+    auto savedRunJmpBuf = vm->runJmpBuf;
 
     if (sigsetjmp(vm->catchJmpBuf, 1) == 0) {
         vm->catchJumpEnabled = true;
@@ -217,6 +229,8 @@ static VMValue assertThrowsNative(int argCount, VMValue *args) {
         vm->suppressRuntimeErrors = false;
         vm->stackTop = savedStackTop;
         vm->frames.resize(savedFrameCount);
+        vm->jitFrames.resize(savedJitFrames);
+        vm->runJmpBuf = savedRunJmpBuf;
 
         if (result == InterpretResult::INTERPRET_OK) {
             std::string filename;
@@ -238,6 +252,8 @@ static VMValue assertThrowsNative(int argCount, VMValue *args) {
         vm->suppressRuntimeErrors = false;
         vm->stackTop = savedStackTop;
         vm->frames.resize(savedFrameCount);
+        vm->jitFrames.resize(savedJitFrames);
+        vm->runJmpBuf = savedRunJmpBuf;
     }
 
     return nullptr;
@@ -338,7 +354,7 @@ static VMValue describeNative(int argCount, VMValue *args) {
     vm->globals["__test_after"] = VMValue(new ObjList({}));
 
     if (prev.empty()) {
-        vm->globals.erase("__test_describe");
+        vm->eraseGlobal("__test_describe");
     } else {
         vm->globals["__test_describe"] = VMValue(prev);
     }
@@ -382,6 +398,8 @@ static VMValue itNative(int argCount, VMValue *args) {
 
     auto savedStackTop = vm->stackTop;
     auto savedFrameCount = vm->frames.size();
+    auto savedJitFrames = vm->jitFrames.size();
+    auto savedRunJmpBuf = vm->runJmpBuf;
     bool passed = true;
 
     if (sigsetjmp(vm->catchJmpBuf, 1) == 0) {
@@ -407,6 +425,8 @@ static VMValue itNative(int argCount, VMValue *args) {
 
     vm->stackTop = savedStackTop;
     vm->frames.resize(savedFrameCount);
+    vm->jitFrames.resize(savedJitFrames);
+    vm->runJmpBuf = savedRunJmpBuf;
 
     runCallbacks(vm, "__test_afterEach");
 
@@ -464,6 +484,8 @@ static VMValue fitNative(int argCount, VMValue *args) {
 
     auto savedStackTop = vm->stackTop;
     auto savedFrameCount = vm->frames.size();
+    auto savedJitFrames = vm->jitFrames.size();
+    auto savedRunJmpBuf = vm->runJmpBuf;
     bool passed = true;
 
     if (sigsetjmp(vm->catchJmpBuf, 1) == 0) {
@@ -489,6 +511,8 @@ static VMValue fitNative(int argCount, VMValue *args) {
 
     vm->stackTop = savedStackTop;
     vm->frames.resize(savedFrameCount);
+    vm->jitFrames.resize(savedJitFrames);
+    vm->runJmpBuf = savedRunJmpBuf;
 
     runCallbacks(vm, "__test_afterEach");
 
@@ -520,7 +544,7 @@ static VMValue fdescribeNative(int argCount, VMValue *args) {
     vm->globals["__test_after"] = VMValue(new ObjList({}));
 
     if (prev.empty()) {
-        vm->globals.erase("__test_describe");
+        vm->eraseGlobal("__test_describe");
     } else {
         vm->globals["__test_describe"] = VMValue(prev);
     }
@@ -4,6 +4,9 @@
 #include "../../semantic/SemanticAnalyzer.h"
 #include "../../vm/Compiler.h"
 #include "../StdLib.h"
+#include "../atomics/Atomics.h"
+#include "../immutable/Immutable.h"
+#include "../msgpack/MsgPack.h"
 #include <condition_variable>
 #include <fstream>
 #include <mutex>
@@ -15,12 +18,23 @@
 namespace StdLib {
 namespace WorkerModule {
 
+// A message is either a string copy, a SharedArrayBuffer passed by
+// handle, the root of a shared frozen region, or any other plain value
+// packed as MessagePack into `text`; the receiving VM references the same
+// memory in the shared and region cases.
+struct WorkerMessage {
+    std::string text;
+    bool packed = false;
+    std::shared_ptr<AtomicsModule::SharedStore> shared;
+    std::shared_ptr<SharedRegion> region;
+};
+
 struct WorkerChannel {
-    std::queue<std::string> mainToWorker;
+    std::queue<WorkerMessage> mainToWorker;
     std::mutex mtwMutex;
     std::condition_variable mtwCond;
 
-    std::queue<std::string> workerToMain;
+    std::queue<WorkerMessage> workerToMain;
     std::mutex wtmMutex;
     std::condition_variable wtmCond;
 
@@ -34,6 +48,36 @@ struct WorkerData {
 
 thread_local std::shared_ptr<WorkerChannel> currentWorkerChannel = nullptr;
 
+static bool toMessage(VMValue value, WorkerMessage &out) {
+    if (value.isString()) {
+        out.text = value.asString()->flatten();
+        return true;
+    }
+    out.region = ImmutableModule::regionOf(value);
+    if (out.region)
+        return true;
+    out.shared = AtomicsModule::sharedStoreOf(value);
+    if (out.shared)
+        return true;
+    if (value.isObj() && !value.isList() && !value.isMap() && !value.isSet())
+        return false;
+    out.packed = true;
+    return MsgPackModule::encodeValue(value, out.text);
+}
+
+static VMValue fromMessage(WorkerMessage &message) {
+    if (message.region)
+        return ImmutableModule::adoptRegion(std::move(message.region));
+    if (message.shared)
+        return AtomicsModule::wrapSharedStore(std::move(message.shared));
+    if (message.packed) {
+        VMValue value;
+        MsgPackModule::decodeValue(message.text, value);
+        return value;
+    }
+    return new ObjString(message.text);
+}
+
 static void workerThreadEntry(std::string scriptPath, std::shared_ptr<WorkerChannel> channel) {
     currentWorkerChannel = channel;
 
@@ -96,7 +140,8 @@ static VMValue workerCreate(int argCount, VMValue *args) {
 }
 
 static VMValue workerSend(int argCount, VMValue *args) {
-    if (argCount != 1 || !args[0].isString())
+    WorkerMessage message;
+    if (argCount != 1 || !toMessage(args[0], message))
         return nullptr;
 
     VMValue receiver = args[-1];
@@ -107,7 +152,7 @@ static VMValue workerSend(int argCount, VMValue *args) {
         return makeResultErr(currentVM, "Worker is dead");
 
     std::lock_guard<std::mutex> lock(data->channel->mtwMutex);
-    data->channel->mainToWorker.push(args[0].asString()->flatten());
+    data->channel->mainToWorker.push(std::move(message));
     data->channel->mtwCond.notify_one();
 
     return makeResultOk(currentVM, true);
@@ -129,22 +174,23 @@ static VMValue workerReceive(int argCount, VMValue *args) {
                                 [&data] { return !data->channel->workerToMain.empty() || !data->channel->isAlive; });
 
     if (!data->channel->workerToMain.empty()) {
-        std::string msg = data->channel->workerToMain.front();
+        WorkerMessage msg = std::move(data->channel->workerToMain.front());
         data->channel->workerToMain.pop();
-        return makeResultOk(currentVM, msg);
+        return makeResultOk(currentVM, fromMessage(msg));
     }
 
     return makeResultErr(currentVM, "Worker terminated");
 }
 
 static VMValue workerSelfSend(int argCount, VMValue *args) {
-    if (argCount != 1 || !args[0].isString())
+    WorkerMessage message;
+    if (argCount != 1 || !toMessage(args[0], message))
         return nullptr;
     if (!currentWorkerChannel)
         return makeResultErr(currentVM, "Not in a worker thread");
 
     std::lock_guard<std::mutex> lock(currentWorkerChannel->wtmMutex);
-    currentWorkerChannel->workerToMain.push(args[0].asString()->flatten());
+    currentWorkerChannel->workerToMain.push(std::move(message));
     currentWorkerChannel->wtmCond.notify_one();
 
     return makeResultOk(currentVM, true);
@@ -161,9 +207,9 @@ static VMValue workerSelfReceive(int argCount, VMValue *args) {
         lock, [] { return !currentWorkerChannel->mainToWorker.empty() || !currentWorkerChannel->isAlive; });
 
     if (!currentWorkerChannel->mainToWorker.empty()) {
-        std::string msg = currentWorkerChannel->mainToWorker.front();
+        WorkerMessage msg = std::move(currentWorkerChannel->mainToWorker.front());
         currentWorkerChannel->mainToWorker.pop();
-        return makeResultOk(currentVM, msg);
+        return makeResultOk(currentVM, fromMessage(msg));
     }
 
     return makeResultErr(currentVM, "Main channel closed");
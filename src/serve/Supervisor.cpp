@@ -0,0 +1,232 @@
+#include "Supervisor.h"
+#include "../native/net/Net.h"
+#include "../vm/VM.h"
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#endif
+
+namespace Serve {
+
+#ifndef _WIN32
+
+// One per worker, in memory shared with the children so the supervisor
+// can read their counters.
+struct WorkerSlot {
+    std::atomic<uint64_t> accepted{0};
+    pid_t pid = 0;
+    uint32_t restarts = 0;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+static volatile sig_atomic_t statsRequested = 0;
+
+// Signal mask from before runPrefork blocked the signals it handles
+static sigset_t originalMask;
+
+static void onStop(int) {
+    stopRequested = 1;
+}
+
+static void onStats(int) {
+    statsRequested = 1;
+}
+
+// Only there so SIGCHLD interrupts sigsuspend
+static void onChild(int) {
+}
+
+// A stop signal that arrived but is still blocked counts as well
+static bool stopPending() {
+    sigset_t pending;
+    sigpending(&pending);
+    return stopRequested || sigismember(&pending, SIGTERM) || sigismember(&pending, SIGINT);
+}
+
+static pid_t startWorker(ObjFunction *function, WorkerSlot *slot) {
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGUSR1, SIG_IGN);
+    signal(SIGCHLD, SIG_DFL);
+    sigprocmask(SIG_SETMASK, &originalMask, nullptr);
+    StdLib::Net::reusePort = true;
+    StdLib::Net::acceptedConnections = &slot->accepted;
+
+    int code;
+    {
+        VM vm;
+        code = vm.interpret(function) == InterpretResult::INTERPRET_OK ? 0 : 1;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(code);
+}
+
+static void printStats(const WorkerSlot *slots, int procs) {
+    uint64_t accepted = 0;
+    uint32_t restarts = 0;
+    for (int i = 0; i < procs; i++) {
+        accepted += slots[i].accepted.load(std::memory_order_relaxed);
+        restarts += slots[i].restarts;
+    }
+    std::cerr << "serve: " << procs << " workers, " << accepted << " connections accepted, " << restarts
+              << " restarts" << std::endl;
+    for (int i = 0; i < procs; i++) {
+        std::cerr << "  worker " << i;
+        if (slots[i].pid > 0)
+            std::cerr << " (pid " << slots[i].pid << ")";
+        std::cerr << ": " << slots[i].accepted.load(std::memory_order_relaxed) << " accepted, " << slots[i].restarts
+                  << " restarts" << std::endl;
+    }
+}
+
+int runPrefork(ObjFunction *function, int procs) {
+    size_t bytes = sizeof(WorkerSlot) * procs;
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "Error: could not allocate worker table" << std::endl;
+        return 1;
+    }
+    WorkerSlot *slots = static_cast<WorkerSlot *>(mem);
+    for (int i = 0; i < procs; i++)
+        new (&slots[i]) WorkerSlot();
+
+    // The signals stay blocked except inside sigsuspend, so one that
+    // arrives between checking the flags and going to sleep is not lost:
+    // it stays pending and wakes the sigsuspend straight away.
+    sigset_t handled;
+    sigemptyset(&handled);
+    sigaddset(&handled, SIGTERM);
+    sigaddset(&handled, SIGINT);
+    sigaddset(&handled, SIGUSR1);
+    sigaddset(&handled, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &handled, &originalMask);
+    sigset_t waitMask = originalMask;
+    sigdelset(&waitMask, SIGTERM);
+    sigdelset(&waitMask, SIGINT);
+    sigdelset(&waitMask, SIGUSR1);
+    sigdelset(&waitMask, SIGCHLD);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = onStop;
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGINT, &sa, nullptr);
+    sa.sa_handler = onStats;
+    sigaction(SIGUSR1, &sa, nullptr);
+    sa.sa_handler = onChild;
+    sigaction(SIGCHLD, &sa, nullptr);
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> startedAt(procs, Clock::now());
+    int live = 0;
+    for (int i = 0; i < procs; i++) {
+        slots[i].pid = startWorker(function, &slots[i]);
+        if (slots[i].pid < 0) {
+            std::cerr << "Error: fork failed: " << strerror(errno) << std::endl;
+            slots[i].pid = 0;
+            continue;
+        }
+        live++;
+    }
+
+    int exitCode = live == procs ? 0 : 1;
+    bool stopping = false;
+    while (live > 0) {
+        if (statsRequested) {
+            statsRequested = 0;
+            printStats(slots, procs);
+        }
+        if (stopRequested && !stopping) {
+            stopping = true;
+            for (int i = 0; i < procs; i++) {
+                if (slots[i].pid > 0)
+                    kill(slots[i].pid, SIGTERM);
+            }
+        }
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid == 0) {
+            sigsuspend(&waitMask);
+            continue;
+        }
+        if (pid < 0) {
+            if (errno != EINTR)
+                break;
+            continue;
+        }
+
+        int index = -1;
+        for (int i = 0; i < procs; i++) {
+            if (slots[i].pid == pid)
+                index = i;
+        }
+        if (index < 0)
+            continue;
+
+        bool crashed = WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+        if (crashed && !stopping) {
+            if (WIFSIGNALED(status))
+                std::cerr << "serve: worker " << index << " (pid " << pid << ") killed by signal " << WTERMSIG(status);
+            else
+                std::cerr << "serve: worker " << index << " (pid " << pid << ") exited with " << WEXITSTATUS(status);
+            std::cerr << ", restarting" << std::endl;
+
+            // Back off when a worker dies right after starting, so a script
+            // that always fails does not turn into a fork loop.
+            if (Clock::now() - startedAt[index] < std::chrono::seconds(1))
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (stopPending()) {
+                slots[index].pid = 0;
+                live--;
+                continue;
+            }
+            slots[index].restarts++;
+            startedAt[index] = Clock::now();
+            slots[index].pid = startWorker(function, &slots[index]);
+            if (slots[index].pid > 0)
+                continue;
+        }
+
+        slots[index].pid = 0;
+        live--;
+        if (crashed && !stopping)
+            exitCode = 1;
+    }
+
+    printStats(slots, procs);
+    munmap(mem, bytes);
+    sigprocmask(SIG_SETMASK, &originalMask, nullptr);
+    return exitCode;
+}
+
+#else
+
+int runPrefork(ObjFunction *function, int procs) {
+    (void)function;
+    (void)procs;
+    std::cerr << "Error: serve --procs is not supported on this platform" << std::endl;
+    return 1;
+}
+
+#endif
+
+} // namespace Serve
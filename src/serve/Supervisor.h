@@ -0,0 +1,14 @@
+#ifndef TRYPILLIA_SUPERVISOR_H
+#define TRYPILLIA_SUPERVISOR_H
+
+#include "../vm/Chunk.h"
+
+namespace Serve {
+// Runs the compiled script in `procs` forked worker processes. Workers
+// share listening ports through SO_REUSEPORT and the bytecode pages
+// copy-on-write; crashed workers are restarted. SIGUSR1 prints stats.
+// Returns the process exit code.
+int runPrefork(ObjFunction *function, int procs);
+} // namespace Serve
+
+#endif
@@ -1,5 +1,6 @@
 #include "ast/ASTOptimizer.h"
 #include "lexer/Lexer.h"
+#include "native/fs/Walk.h"
 #include "parser/Parser.h"
 #include "semantic/SemanticAnalyzer.h"
 #include "vm/Compiler.h"
@@ -8,82 +9,52 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
+#include <cstdlib>
 #include <cstring>
 
 namespace fs = std::filesystem;
 
 static std::vector<std::string> expandGlobs(const std::vector<std::string>& patterns) {
-    std::vector<std::string> files;
+    std::set<std::string> files;
 
     auto addFile = [&](const fs::path& path) {
         std::error_code ec;
-        if (!fs::is_regular_file(path, ec))
-            return;
-
-        std::string p = path.lexically_normal().string();
+        if (fs::is_regular_file(path, ec))
+            files.insert(path.lexically_normal().string());
+    };
 
-        if (std::find(files.begin(), files.end(), p) == files.end())
-            files.push_back(p);
+    // Same engine as FS.walk: parallel, and only descends where the glob can match
+    auto addMatches = [&](const std::string& base, const std::string& glob) {
+        StdLib::Walk::WalkOptions options;
+        options.glob = glob;
+        StdLib::Walk::Walker walker(base, options);
+        StdLib::Walk::Entry entry;
+        while (walker.next(entry)) {
+            if (entry.type != StdLib::Walk::EntryType::DIR)
+                addFile(entry.path);
+        }
     };
 
     for (const auto& pattern : patterns) {
         std::error_code ec;
-        fs::path p(pattern);
-
-        if (fs::is_directory(p, ec)) {
-            for (const auto& entry : fs::recursive_directory_iterator(p, ec)) {
-                if (!ec && entry.path().extension() == ".try")
-                    addFile(entry.path());
-            }
-            continue;
-        }
-
-        if (pattern.find("**") != std::string::npos) {
-            size_t pos = pattern.find("**");
-
-            fs::path base = pattern.substr(0, pos);
-            if (base.empty())
-                base = ".";
-
-            std::string suffix = pattern.substr(pos + 2);
-
-            if (suffix.starts_with('/'))
-                suffix.erase(0, 1);
-
-            if (fs::is_directory(base, ec)) {
-                for (const auto& entry : fs::recursive_directory_iterator(base, ec)) {
-                    if (ec || !entry.is_regular_file())
-                        continue;
-
-                    auto rel = fs::relative(entry.path(), base, ec);
-                    if (ec)
-                        continue;
-
-                    std::string relPath = rel.generic_string();
-
-                    if (suffix == "*.try") {
-                        if (entry.path().extension() == ".try")
-                            addFile(entry.path());
-                    } else if (relPath.ends_with(suffix)) {
-                        addFile(entry.path());
-                    }
-                }
-            }
-
+        if (fs::is_directory(pattern, ec)) {
+            addMatches(pattern, "**/*.try");
             continue;
         }
 
-        if (pattern.find('*') == std::string::npos &&
-            pattern.find('?') == std::string::npos) {
-            addFile(p);
-        }
+        std::string base, glob;
+        StdLib::Walk::splitGlob(pattern, base, glob);
+        if (glob.empty())
+            addFile(pattern);
+        else if (fs::is_directory(base, ec))
+            addMatches(base, glob);
     }
 
-    std::sort(files.begin(), files.end());
-    return files;
+    return std::vector<std::string>(files.begin(), files.end());
 }
 
 static bool pathMatchesFilter(const std::string &path, const std::string &filter) {
@@ -96,6 +67,32 @@ static bool hasFocusedTests(const std::string &source) {
     return source.find("fit(") != std::string::npos || source.find("fdescribe(") != std::string::npos;
 }
 
+static void exportEnv(const char *name, const std::string &value, bool overwrite) {
+#ifdef _WIN32
+    if (overwrite || !std::getenv(name))
+        _putenv_s(name, value.c_str());
+#else
+    setenv(name, value.c_str(), overwrite ? 1 : 0);
+#endif
+}
+
+// Tests that spawn processes read these instead of guessing where the binaries
+// live: TRYPILLIA_BIN is the interpreter (a value from the caller wins, else the
+// one built next to this runner), TRYPILLIA_TEST_RUNNER is this runner and
+// TRYPILLIA_TEST_FILE the file being run.
+static void exportRunnerPaths(const char *argv0) {
+    std::error_code ec;
+    fs::path runner = fs::absolute(argv0, ec);
+    if (ec || std::string(argv0).find_first_of("/\\") == std::string::npos)
+        return;
+    exportEnv("TRYPILLIA_TEST_RUNNER", runner.lexically_normal().string(), true);
+#ifdef _WIN32
+    exportEnv("TRYPILLIA_BIN", (runner.parent_path() / "trypillia.exe").string(), false);
+#else
+    exportEnv("TRYPILLIA_BIN", (runner.parent_path() / "trypillia").string(), false);
+#endif
+}
+
 static bool readTestResults(VM &vm, std::vector<std::string> &names, std::vector<bool> &results) {
     auto namesIt = vm.globals.find("__test_names");
     auto resultsIt = vm.globals.find("__test_results");
@@ -136,6 +133,7 @@ int main(int argc, char **argv) {
     }
 
     std::vector<std::string> paths = expandGlobs(rawPatterns);
+    exportRunnerPaths(argv[0]);
 
     if (paths.empty()) {
         std::cerr << "No test files found matching the given patterns." << std::endl;
@@ -162,6 +160,7 @@ int main(int argc, char **argv) {
             continue;
         }
         std::string source((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+        exportEnv("TRYPILLIA_TEST_FILE", fs::absolute(path).lexically_normal().string(), true);
 
         Lexer lexer(source);
         Parser parser(lexer);
@@ -69,6 +69,13 @@ struct ObjString : public Obj {
         return flatData;
     }
 
+    // Same contents as flatten(), without copying an already flat string.
+    const std::string &flatView() const {
+        if (!isFlat)
+            flatten();
+        return flatData;
+    }
+
     ~ObjString() {
     }
 };
@@ -102,8 +109,21 @@ struct ObjClass : public Obj {
     bool isAbstract = false;
     std::unordered_map<std::string, VMValue> statics;
     std::unordered_map<std::string, VMAccessModifier> fieldModifiers;
+
+    // Per-class data a native derives and caches (Json's field plan);
+    // freed with the class so it can never outlive or be reused by another
+    void *nativeCache = nullptr;
+    void (*freeCacheFn)(void *) = nullptr;
+
     ObjClass(std::string name) : Obj(ObjType::OBJ_CLASS), name(name), superclass(nullptr) {
     }
+
+    ~ObjClass() {
+        if (nativeCache && freeCacheFn) {
+            freeCacheFn(nativeCache);
+            nativeCache = nullptr;
+        }
+    }
 };
 
 struct ObjInstance : public Obj {
@@ -113,6 +133,8 @@ struct ObjInstance : public Obj {
     // Native resource binding
     void *nativeData = nullptr;
     void (*freeFn)(void *) = nullptr;
+    // Marks VM values held by nativeData during GC
+    void (*traceFn)(void *) = nullptr;
 
     ObjInstance(ObjClass *k) : Obj(ObjType::OBJ_INSTANCE), klass(k) {
     }
@@ -166,6 +188,32 @@ struct ObjMap : public Obj {
     }
 };
 
+// Hash set that keeps its members dense and in insertion order, so foreach
+// can walk `entries` by position. `slots` is a linear-probing index into
+// `entries` (0 = empty, otherwise index + 1). Removal moves the last member
+// into the hole and shifts probe chains back instead of leaving tombstones.
+struct ObjSet : public Obj {
+    std::vector<VMValue> entries;
+    std::vector<uint32_t> hashes;
+    std::vector<uint32_t> slots;
+
+    ObjSet() : Obj(ObjType::OBJ_SET) {
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+    bool contains(VMValue value) const;
+    bool insert(VMValue value);
+    bool erase(VMValue value);
+    void reserve(size_t count);
+    void clear();
+
+  private:
+    size_t probe(VMValue value, uint32_t hash) const;
+    void rebuild(size_t capacity);
+};
+
 struct ObjNative : public Obj {
     std::string name;
     int arity;
@@ -190,6 +238,10 @@ struct ObjFunction : public Obj {
     int upvalueCount = 0;
     int callCount = 0;
     void *jitAddr = nullptr;
+    // Slots of the JIT virtual stack that may hold boxed values (GC stack map)
+    std::vector<uint8_t> jitStackMap;
+    // Bit p-1 set: parameter p is compiled as a list (checked on JIT entry)
+    uint32_t jitListArgMask = 0;
 
     ObjFunction() : Obj(ObjType::OBJ_FUNCTION), arity(0), maxArity(0), upvalueCount(0), callCount(0), jitAddr(nullptr) {
     }
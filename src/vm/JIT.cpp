@@ -2,13 +2,473 @@
 #include "OpCode.h"
 #include "UniversalEmitter.h"
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <map>
 #include <set>
 #include <vector>
 
 enum class InferredType { UNKNOWN, NUMBER, BOOL, STRING, NIL, OBJECT, CLOSURE };
 
+// Numbers, booleans and nil are stored unboxed (1.0/0.0) in JIT slots;
+// anything else may be a NaN-boxed object pointer the GC must see.
+static bool mayHoldRef(InferredType t) {
+    return t != InferredType::NUMBER && t != InferredType::BOOL && t != InferredType::NIL;
+}
+
+// Float arithmetic propagates NaN payloads, so an operand that may be a
+// boxed object can leak its pointer bits into the result slot.
+static InferredType arithResult(InferredType a, InferredType b) {
+    return (mayHoldRef(a) || mayHoldRef(b)) ? InferredType::UNKNOWN : InferredType::NUMBER;
+}
+
+// Byte length of the instruction at `i`, operands included.
+static size_t instructionLength(const Chunk *chunk, size_t i) {
+    switch (static_cast<OpCode>(chunk->code[i])) {
+    case OpCode::OP_JUMP:
+    case OpCode::OP_JUMP_IF_FALSE:
+    case OpCode::OP_LOOP:
+    case OpCode::OP_CONSTANT_WIDE:
+    case OpCode::OP_FIELD_MODIFIER:
+        return 3;
+    case OpCode::OP_GET_LOCAL:
+    case OpCode::OP_SET_LOCAL:
+    case OpCode::OP_CONSTANT:
+    case OpCode::OP_GET_GLOBAL:
+    case OpCode::OP_DEFINE_GLOBAL:
+    case OpCode::OP_SET_GLOBAL:
+    case OpCode::OP_CALL:
+    case OpCode::OP_BUILD_LIST:
+    case OpCode::OP_BUILD_MAP:
+    case OpCode::OP_PROPERTY_GET:
+    case OpCode::OP_PROPERTY_SET:
+    case OpCode::OP_GET_UPVALUE:
+    case OpCode::OP_SET_UPVALUE:
+    case OpCode::OP_CLASS:
+    case OpCode::OP_ABSTRACT_CLASS:
+    case OpCode::OP_GET_SUPER:
+    case OpCode::OP_METHOD:
+    case OpCode::OP_ABSTRACT_METHOD:
+    case OpCode::OP_STATIC_METHOD:
+        return 2;
+    case OpCode::OP_CLOSURE: {
+        VMValue funcVal = chunk->constants[chunk->code[i + 1]];
+        return 2 + 2 * funcVal.asFunction()->upvalueCount;
+    }
+    default:
+        return 1;
+    }
+}
+
+// ------------------------------------------------------------
+// Counted loop analysis
+//
+// Recognizes loops of the shape
+//     header: i < n | i <= n | i < k | i < xs.length() | foreach
+//     body:   ... xs[i] ... (no calls, xs and n not reassigned)
+//             i = i + c     (c >= 0, the only write to i)
+// and plans a preheader range check (0 <= i, bound <= xs.length) that
+// lets every xs[i] before the increment skip its type/bounds checks and
+// read through a data pointer hoisted out of the loop. Without calls in
+// the body nothing can resize the lists, so the pointers stay valid.
+// ------------------------------------------------------------
+
+struct CountedLoop {
+    LoopRangeGuard guard;
+    std::map<size_t, int> hoistedSites; // OP_INDEX_GET position -> hoist slot
+};
+
+struct DecodedInstr {
+    size_t pos;
+    uint8_t op;
+};
+
+static bool isNumberConstant(const Chunk *chunk, const DecodedInstr &ins, double &out) {
+    if (ins.op != static_cast<uint8_t>(OpCode::OP_CONSTANT))
+        return false;
+    VMValue val = chunk->constants[chunk->code[ins.pos + 1]];
+    if (!val.isNumber())
+        return false;
+    out = val.asNumber();
+    return true;
+}
+
+static bool isLengthCall(const Chunk *chunk, const std::vector<DecodedInstr> &code, size_t k) {
+    if (k + 1 >= code.size() || code[k].op != static_cast<uint8_t>(OpCode::OP_PROPERTY_GET) ||
+        code[k + 1].op != static_cast<uint8_t>(OpCode::OP_CALL) || chunk->code[code[k + 1].pos + 1] != 0)
+        return false;
+    VMValue name = chunk->constants[chunk->code[code[k].pos + 1]];
+    return name.isString() && name.asString()->flatten() == "length";
+}
+
+static std::set<size_t> collectJumpTargets(const Chunk *chunk) {
+    std::set<size_t> targets;
+    for (size_t i = 0; i < chunk->code.size(); i += instructionLength(chunk, i)) {
+        uint8_t op = chunk->code[i];
+        uint16_t offset = 0;
+        if (op == static_cast<uint8_t>(OpCode::OP_JUMP) || op == static_cast<uint8_t>(OpCode::OP_JUMP_IF_FALSE) ||
+            op == static_cast<uint8_t>(OpCode::OP_LOOP))
+            offset = (chunk->code[i + 1] << 8) | chunk->code[i + 2];
+        if (op == static_cast<uint8_t>(OpCode::OP_LOOP))
+            targets.insert(i + 3 - offset);
+        else if (op == static_cast<uint8_t>(OpCode::OP_JUMP) || op == static_cast<uint8_t>(OpCode::OP_JUMP_IF_FALSE))
+            targets.insert(i + 3 + offset);
+    }
+    return targets;
+}
+
+static std::map<size_t, CountedLoop> analyzeCountedLoops(const Chunk *chunk) {
+    std::map<size_t, CountedLoop> loops;
+    std::vector<DecodedInstr> code;
+    std::map<size_t, size_t> indexOf;
+    for (size_t i = 0; i < chunk->code.size(); i += instructionLength(chunk, i)) {
+        indexOf[i] = code.size();
+        code.push_back({i, chunk->code[i]});
+    }
+    std::set<size_t> jumpTargets = collectJumpTargets(chunk);
+    auto slotOf = [&](size_t k) { return static_cast<int>(chunk->code[code[k].pos + 1]); };
+    auto is = [&](size_t k, OpCode op) { return k < code.size() && code[k].op == static_cast<uint8_t>(op); };
+
+    int nextHoistSlot = JIT_HOIST_SLOT_BASE;
+    for (size_t e = 0; e < code.size(); e++) {
+        if (!is(e, OpCode::OP_LOOP))
+            continue;
+        uint16_t offset = (chunk->code[code[e].pos + 1] << 8) | chunk->code[code[e].pos + 2];
+        size_t header = code[e].pos + 3 - offset;
+        if (!indexOf.count(header))
+            continue;
+        size_t h = indexOf[header];
+
+        // 1. Loop condition
+        LoopRangeGuard guard;
+        size_t condEnd;            // index of the OP_JUMP_IF_FALSE
+        size_t allowedCall = SIZE_MAX; // the xs.length() call in the condition
+        if (is(h, OpCode::OP_GET_LOCAL) && is(h + 1, OpCode::OP_GET_LOCAL) && is(h + 2, OpCode::OP_ITER_HAS_NEXT) &&
+            is(h + 3, OpCode::OP_JUMP_IF_FALSE)) {
+            guard.boundListSlot = slotOf(h);
+            guard.inductionSlot = slotOf(h + 1);
+            condEnd = h + 3;
+        } else if (is(h, OpCode::OP_GET_LOCAL)) {
+            guard.inductionSlot = slotOf(h);
+            size_t cmp;
+            if (is(h + 1, OpCode::OP_GET_LOCAL) && isLengthCall(chunk, code, h + 2)) {
+                guard.boundListSlot = slotOf(h + 1);
+                allowedCall = h + 3;
+                cmp = h + 4;
+            } else if (is(h + 1, OpCode::OP_GET_LOCAL)) {
+                guard.boundSlot = slotOf(h + 1);
+                cmp = h + 2;
+            } else if (h + 1 < code.size() && isNumberConstant(chunk, code[h + 1], guard.boundConst)) {
+                cmp = h + 2;
+            } else {
+                continue;
+            }
+            if (is(cmp, OpCode::OP_LESS_EQUAL))
+                guard.inclusive = true;
+            else if (!is(cmp, OpCode::OP_LESS))
+                continue;
+            if (!is(cmp + 1, OpCode::OP_JUMP_IF_FALSE))
+                continue;
+            condEnd = cmp + 1;
+        } else {
+            continue;
+        }
+        bool enteredMidCondition = false;
+        for (size_t k = h + 1; k <= condEnd; k++)
+            enteredMidCondition |= jumpTargets.count(code[k].pos) > 0;
+        if (enteredMidCondition)
+            continue;
+
+        // 2. Body: no calls, find writes to locals and inner loops
+        bool hasCall = false;
+        std::map<int, int> writes;
+        size_t increment = SIZE_MAX;
+        std::vector<std::pair<size_t, size_t>> innerLoops;
+        for (size_t k = h; k < e; k++) {
+            if (is(k, OpCode::OP_CALL) && k != allowedCall)
+                hasCall = true;
+            if (is(k, OpCode::OP_SET_LOCAL)) {
+                writes[slotOf(k)]++;
+                if (slotOf(k) == guard.inductionSlot)
+                    increment = k;
+            }
+            if (is(k, OpCode::OP_LOOP)) {
+                uint16_t off = (chunk->code[code[k].pos + 1] << 8) | chunk->code[code[k].pos + 2];
+                innerLoops.push_back({code[k].pos + 3 - off, code[k].pos});
+            }
+        }
+        if (hasCall || writes[guard.inductionSlot] != 1 || increment < h + 3)
+            continue;
+        if (guard.boundSlot >= 0 && writes[guard.boundSlot] != 0)
+            continue;
+        if (guard.boundListSlot >= 0 && writes[guard.boundListSlot] != 0)
+            continue;
+
+        // 3. The induction variable only grows: i = i + c, c >= 0
+        double step;
+        if (!is(increment - 3, OpCode::OP_GET_LOCAL) || slotOf(increment - 3) != guard.inductionSlot ||
+            !isNumberConstant(chunk, code[increment - 2], step) || step < 0 || !is(increment - 1, OpCode::OP_ADD))
+            continue;
+        bool incrementInInnerLoop = false;
+        for (auto &[from, to] : innerLoops)
+            incrementInInnerLoop |= code[increment].pos >= from && code[increment].pos < to;
+        if (incrementInInnerLoop)
+            continue;
+
+        // 4. list[i] sites executed before the increment
+        CountedLoop loop;
+        std::map<int, int> hoistSlotFor;
+        for (size_t k = condEnd + 1; k < increment; k++) {
+            if (!is(k, OpCode::OP_INDEX_GET) || k < 2 || !is(k - 1, OpCode::OP_GET_LOCAL) ||
+                slotOf(k - 1) != guard.inductionSlot || !is(k - 2, OpCode::OP_GET_LOCAL))
+                continue;
+            int listSlot = slotOf(k - 2);
+            if (listSlot == guard.inductionSlot || writes[listSlot] != 0)
+                continue;
+            if (jumpTargets.count(code[k - 1].pos) || jumpTargets.count(code[k].pos))
+                continue;
+            if (!hoistSlotFor.count(listSlot)) {
+                if (nextHoistSlot >= JIT_HOIST_SLOT_BASE + JIT_HOIST_SLOT_COUNT)
+                    continue;
+                hoistSlotFor[listSlot] = nextHoistSlot++;
+                guard.lists.push_back({listSlot, hoistSlotFor[listSlot]});
+            }
+            loop.hoistedSites[code[k].pos] = hoistSlotFor[listSlot];
+        }
+        if (loop.hoistedSites.empty())
+            continue;
+        loop.guard = std::move(guard);
+        loops[header] = std::move(loop);
+    }
+    return loops;
+}
+
+// Parameters only ever indexed (p[i]) or measured (p.length()) are
+// compiled as lists; VM::executeCall checks the argument types on entry.
+static uint32_t detectListParams(const Chunk *chunk, int arity) {
+    std::vector<DecodedInstr> code;
+    for (size_t i = 0; i < chunk->code.size(); i += instructionLength(chunk, i))
+        code.push_back({i, chunk->code[i]});
+    uint32_t mask = 0;
+    for (int param = 1; param <= arity && param <= 32; param++) {
+        bool used = false, listOnly = true;
+        for (size_t k = 0; k < code.size() && listOnly; k++) {
+            uint8_t op = code[k].op;
+            if (op != static_cast<uint8_t>(OpCode::OP_GET_LOCAL) && op != static_cast<uint8_t>(OpCode::OP_SET_LOCAL))
+                continue;
+            if (chunk->code[code[k].pos + 1] != param)
+                continue;
+            if (op == static_cast<uint8_t>(OpCode::OP_SET_LOCAL)) {
+                listOnly = false;
+                break;
+            }
+            used = true;
+            bool indexed = k + 2 < code.size() && code[k + 1].op == static_cast<uint8_t>(OpCode::OP_GET_LOCAL) &&
+                           code[k + 2].op == static_cast<uint8_t>(OpCode::OP_INDEX_GET);
+            listOnly = indexed || isLengthCall(chunk, code, k + 1);
+        }
+        if (used && listOnly)
+            mask |= 1u << (param - 1);
+    }
+    return mask;
+}
+
+// ------------------------------------------------------------
+// Escape analysis
+//
+// Two kinds of short-lived objects never need to exist in JIT code:
+//   - the ObjBoundMethod made by `obj.m` when the only use is the call
+//     that immediately follows (`obj.m(args)`): the call is done through
+//     jit_invoke_helper with the receiver still on the stack;
+//   - list literals bound to a local that is only read as `v[k]` with a
+//     constant k: the elements stay in frame slots and no ObjList is
+//     allocated. Any other use of the local keeps the function in the
+//     interpreter rather than materializing the list.
+// ------------------------------------------------------------
+
+// Stack effect of straight-line instructions; false for branches and
+// anything not modelled here.
+static bool straightLineStackEffect(const Chunk *chunk, size_t pos, int &effect) {
+    uint8_t operand = pos + 1 < chunk->code.size() ? chunk->code[pos + 1] : 0;
+    switch (static_cast<OpCode>(chunk->code[pos])) {
+    case OpCode::OP_GET_LOCAL:
+    case OpCode::OP_GET_GLOBAL:
+    case OpCode::OP_GET_UPVALUE:
+    case OpCode::OP_CONSTANT:
+    case OpCode::OP_CONSTANT_WIDE:
+    case OpCode::OP_NIL:
+    case OpCode::OP_TRUE:
+    case OpCode::OP_FALSE:
+        effect = 1;
+        return true;
+    case OpCode::OP_SET_LOCAL:
+    case OpCode::OP_SET_GLOBAL:
+    case OpCode::OP_SET_UPVALUE:
+    case OpCode::OP_NOT:
+    case OpCode::OP_NEGATE:
+    case OpCode::OP_BIT_NOT:
+    case OpCode::OP_PROPERTY_GET:
+        effect = 0;
+        return true;
+    case OpCode::OP_ADD:
+    case OpCode::OP_SUBTRACT:
+    case OpCode::OP_MULTIPLY:
+    case OpCode::OP_DIVIDE:
+    case OpCode::OP_MOD:
+    case OpCode::OP_EQUAL:
+    case OpCode::OP_NOT_EQUAL:
+    case OpCode::OP_GREATER:
+    case OpCode::OP_GREATER_EQUAL:
+    case OpCode::OP_LESS:
+    case OpCode::OP_LESS_EQUAL:
+    case OpCode::OP_INDEX_GET:
+    case OpCode::OP_BIT_AND:
+    case OpCode::OP_BIT_OR:
+    case OpCode::OP_BIT_XOR:
+    case OpCode::OP_BIT_SHIFT_LEFT:
+    case OpCode::OP_BIT_SHIFT_RIGHT:
+        effect = -1;
+        return true;
+    case OpCode::OP_CALL:
+        effect = -operand;
+        return true;
+    case OpCode::OP_BUILD_LIST:
+        effect = 1 - operand;
+        return true;
+    case OpCode::OP_BUILD_MAP:
+        effect = 1 - 2 * operand;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// OP_PROPERTY_GET position -> position of the OP_CALL that consumes its result
+static std::map<size_t, size_t> pairMethodCalls(const Chunk *chunk, const std::set<size_t> &jumpTargets) {
+    std::map<size_t, size_t> pairs;
+    for (size_t i = 0; i < chunk->code.size(); i += instructionLength(chunk, i)) {
+        if (chunk->code[i] != static_cast<uint8_t>(OpCode::OP_PROPERTY_GET))
+            continue;
+        int depth = 0; // values pushed above the method since the property get
+        for (size_t k = i + instructionLength(chunk, i); k < chunk->code.size(); k += instructionLength(chunk, k)) {
+            int effect;
+            if (jumpTargets.count(k) || !straightLineStackEffect(chunk, k, effect))
+                break;
+            if (chunk->code[k] == static_cast<uint8_t>(OpCode::OP_CALL) && chunk->code[k + 1] == depth) {
+                pairs[i] = k;
+                break;
+            }
+            depth += effect;
+            if (depth < 0)
+                break;
+        }
+    }
+    return pairs;
+}
+
+// ------------------------------------------------------------
+// Math intrinsics
+//
+// Math.f(x) call sites on the Math global skip the native call machinery
+// and call libm on unboxed doubles (sljit has no sqrt/round instructions;
+// abs is emitted inline).
+// ------------------------------------------------------------
+
+struct MathIntrinsic {
+    const char *name;
+    int arity;
+    void *fn; // nullptr: inline
+};
+
+static double intrinsicSqrt(double x) {
+    return std::sqrt(x);
+}
+static double intrinsicFloor(double x) {
+    return std::floor(x);
+}
+static double intrinsicCeil(double x) {
+    return std::ceil(x);
+}
+static double intrinsicMin(double a, double b) {
+    return std::fmin(a, b);
+}
+static double intrinsicMax(double a, double b) {
+    return std::fmax(a, b);
+}
+static double intrinsicPow(double a, double b) {
+    return std::pow(a, b);
+}
+static double intrinsicExp(double x) {
+    return std::exp(x);
+}
+static double intrinsicLog(double x) {
+    return std::log(x);
+}
+static double intrinsicSin(double x) {
+    return std::sin(x);
+}
+static double intrinsicCos(double x) {
+    return std::cos(x);
+}
+static double intrinsicAtan2(double y, double x) {
+    return std::atan2(y, x);
+}
+static double intrinsicFma(double a, double b, double c) {
+    return std::fma(a, b, c);
+}
+
+static const MathIntrinsic *findMathIntrinsic(const std::string &name, int argCount) {
+    static const MathIntrinsic intrinsics[] = {
+        {"sqrt", 1, (void *)intrinsicSqrt}, {"abs", 1, nullptr},
+        {"floor", 1, (void *)intrinsicFloor}, {"ceil", 1, (void *)intrinsicCeil},
+        {"min", 2, (void *)intrinsicMin}, {"max", 2, (void *)intrinsicMax},
+        {"pow", 2, (void *)intrinsicPow}, {"exp", 1, (void *)intrinsicExp},
+        {"log", 1, (void *)intrinsicLog}, {"sin", 1, (void *)intrinsicSin},
+        {"cos", 1, (void *)intrinsicCos}, {"atan2", 2, (void *)intrinsicAtan2},
+        {"fma", 3, (void *)intrinsicFma},
+    };
+    for (const auto &intrinsic : intrinsics) {
+        if (name == intrinsic.name && argCount == intrinsic.arity)
+            return &intrinsic;
+    }
+    return nullptr;
+}
+
+// Locals that are never assigned, captured or read other than as v[k]
+static std::set<int> scalarListCandidates(const Chunk *chunk, int arity, const std::set<int> &capturedLocals,
+                                          const std::set<size_t> &jumpTargets) {
+    std::set<int> read, rejected(capturedLocals.begin(), capturedLocals.end());
+    for (size_t i = 0; i < chunk->code.size(); i += instructionLength(chunk, i)) {
+        uint8_t op = chunk->code[i];
+        if (op == static_cast<uint8_t>(OpCode::OP_SET_LOCAL)) {
+            rejected.insert(chunk->code[i + 1]);
+        } else if (op == static_cast<uint8_t>(OpCode::OP_GET_LOCAL)) {
+            int slot = chunk->code[i + 1];
+            read.insert(slot);
+            size_t constPos = i + 2, indexPos = i + 4;
+            bool constantIndex = indexPos < chunk->code.size() &&
+                                 chunk->code[constPos] == static_cast<uint8_t>(OpCode::OP_CONSTANT) &&
+                                 chunk->code[indexPos] == static_cast<uint8_t>(OpCode::OP_INDEX_GET) &&
+                                 !jumpTargets.count(constPos) && !jumpTargets.count(indexPos);
+            if (constantIndex) {
+                VMValue k = chunk->constants[chunk->code[constPos + 1]];
+                constantIndex = k.isNumber() && k.asNumber() >= 0 && k.asNumber() < JIT_SCALAR_SLOT_COUNT &&
+                                k.asNumber() == static_cast<int>(k.asNumber());
+            }
+            if (!constantIndex)
+                rejected.insert(slot);
+        }
+    }
+    std::set<int> candidates;
+    for (int slot : read) {
+        if (slot > arity && !rejected.count(slot))
+            candidates.insert(slot);
+    }
+    return candidates;
+}
+
 JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
     if (!function || !function->chunk)
         return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
@@ -30,40 +490,12 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
 
     int maxLocal = 0;
     std::set<int> capturedLocals;
-    for (size_t i = 0; i < function->chunk->code.size();) {
+    for (size_t i = 0; i < function->chunk->code.size(); i += instructionLength(function->chunk, i)) {
         uint8_t op = function->chunk->code[i];
-        if (op == static_cast<uint8_t>(OpCode::OP_NOP)) {
-            i += 1;
-        } else if (op == static_cast<uint8_t>(OpCode::OP_JUMP) ||
-                   op == static_cast<uint8_t>(OpCode::OP_JUMP_IF_FALSE)) {
-            i += 3;
-        } else if (op == static_cast<uint8_t>(OpCode::OP_LOOP)) {
-            i += 3;
-        } else if (op == static_cast<uint8_t>(OpCode::OP_GET_LOCAL) ||
-                   op == static_cast<uint8_t>(OpCode::OP_SET_LOCAL)) {
+        if (op == static_cast<uint8_t>(OpCode::OP_GET_LOCAL) || op == static_cast<uint8_t>(OpCode::OP_SET_LOCAL)) {
             int slot = function->chunk->code[i + 1];
             if (slot > maxLocal)
                 maxLocal = slot;
-            i += 2;
-        } else if (op == static_cast<uint8_t>(OpCode::OP_CONSTANT_WIDE)) {
-            i += 3;
-        } else if (op == static_cast<uint8_t>(OpCode::OP_CONSTANT) ||
-                   op == static_cast<uint8_t>(OpCode::OP_GET_GLOBAL) ||
-                   op == static_cast<uint8_t>(OpCode::OP_DEFINE_GLOBAL) ||
-                   op == static_cast<uint8_t>(OpCode::OP_SET_GLOBAL) || op == static_cast<uint8_t>(OpCode::OP_CALL) ||
-                   op == static_cast<uint8_t>(OpCode::OP_BUILD_LIST) ||
-                   op == static_cast<uint8_t>(OpCode::OP_BUILD_MAP) ||
-                   op == static_cast<uint8_t>(OpCode::OP_PROPERTY_GET) ||
-                   op == static_cast<uint8_t>(OpCode::OP_PROPERTY_SET) ||
-                   op == static_cast<uint8_t>(OpCode::OP_GET_UPVALUE) ||
-                   op == static_cast<uint8_t>(OpCode::OP_SET_UPVALUE) || op == static_cast<uint8_t>(OpCode::OP_CLASS) ||
-                   op == static_cast<uint8_t>(OpCode::OP_ABSTRACT_CLASS) ||
-                   op == static_cast<uint8_t>(OpCode::OP_GET_SUPER) || op == static_cast<uint8_t>(OpCode::OP_METHOD) ||
-                   op == static_cast<uint8_t>(OpCode::OP_ABSTRACT_METHOD) ||
-                   op == static_cast<uint8_t>(OpCode::OP_STATIC_METHOD)) {
-            i += 2;
-        } else if (op == static_cast<uint8_t>(OpCode::OP_FIELD_MODIFIER)) {
-            i += 3;
         } else if (op == static_cast<uint8_t>(OpCode::OP_CLOSURE)) {
             uint8_t constIdx = function->chunk->code[i + 1];
             VMValue funcVal = function->chunk->constants[constIdx];
@@ -74,9 +506,6 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
                     capturedLocals.insert(upvalueBytes[j * 2 + 1]);
                 }
             }
-            i += 2 + 2 * upvalueCount;
-        } else {
-            i += 1;
         }
     }
 
@@ -92,9 +521,46 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
     std::vector<InferredType> localTypes(256, InferredType::UNKNOWN);
     for (int i = 0; i <= function->maxArity; i++)
         localTypes[i] = InferredType::NUMBER;
+    uint32_t listParams = detectListParams(function->chunk, function->maxArity);
+    for (int i = 1; i <= function->maxArity && i <= 32; i++) {
+        if (listParams & (1u << (i - 1)))
+            localTypes[i] = InferredType::OBJECT;
+    }
+
+    std::map<size_t, CountedLoop> countedLoops;
+    if (jitVectorLayoutSupported())
+        countedLoops = analyzeCountedLoops(function->chunk);
+    std::map<size_t, int> hoistedSites;
+    for (auto &[header, loop] : countedLoops)
+        hoistedSites.insert(loop.hoistedSites.begin(), loop.hoistedSites.end());
+
+    std::set<size_t> jumpTargets = collectJumpTargets(function->chunk);
+    std::map<size_t, size_t> methodCalls = pairMethodCalls(function->chunk, jumpTargets);
+    std::map<size_t, std::string> pendingInvokes; // OP_CALL position -> method name
+    std::map<size_t, size_t> mathReceivers;       // OP_CALL position -> OP_GET_GLOBAL "Math" position
+    VMValue mathClass = nullptr;
+    if (currentVM) {
+        auto math = currentVM->globals.find("Math");
+        if (math != currentVM->globals.end() && math->second.isClass())
+            mathClass = math->second;
+    }
+    size_t prevInstr = SIZE_MAX;
+    std::set<int> scalarCandidates =
+        scalarListCandidates(function->chunk, function->maxArity, capturedLocals, jumpTargets);
+    struct ScalarList {
+        int base;
+        std::vector<InferredType> types;
+    };
+    std::map<int, ScalarList> scalarLists; // local slot -> slots holding its elements
+    int nextScalarSlot = JIT_SCALAR_SLOT_BASE;
 
     bool tosInFR0 = false; // Is the top stack value in the FR0 register?
 
+    // GC stack map: slot 0 holds the callee closure, the rest is filled in
+    // as slots receive values that may be boxed.
+    std::vector<uint8_t> stackMap(JIT_MAX_SLOTS, 0);
+    stackMap[0] = 1;
+
     // Initial SP includes the function itself (slot 0) and any arguments
     int sp = function->maxArity >= 0 ? function->maxArity + 1 : 1;
 
@@ -109,6 +575,9 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
     };
 
     for (size_t i = 0; i < function->chunk->code.size(); ++i) {
+        size_t instrStart = i;
+        size_t instrBefore = prevInstr;
+        prevInstr = i;
         if (expectedSp.count(i)) {
             // Flush ToS only if sp matches the expected state (legitimate fall-through).
             // If sp differs, the value in FR0 came from unreachable code processed
@@ -120,7 +589,19 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             sp = expectedSp[i];
             typeStack = expectedStackTypes[i];
         }
+        auto countedLoop = countedLoops.find(i);
+        if (countedLoop != countedLoops.end())
+            flushTos(sp);
         emitter.bindLabel(i);
+        if (countedLoop != countedLoops.end()) {
+            emitter.emitLoopPreheader(countedLoop->second.guard);
+            emitter.bindLoopEntry(i);
+        }
+
+        for (auto it = scalarLists.begin(); it != scalarLists.end();)
+            it = it->first >= sp ? scalarLists.erase(it) : std::next(it);
+        int spBefore = sp;
+        int newScalarList = -1;
 
         uint8_t op = function->chunk->code[i];
         switch (op) {
@@ -129,16 +610,27 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
         case static_cast<uint8_t>(OpCode::OP_POP):
             if (sp == 0)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
-            if (tosInFR0)
-                tosInFR0 = false;
-            else
-                sp--;
+            tosInFR0 = false;
+            sp--;
             break;
         case static_cast<uint8_t>(OpCode::OP_GET_LOCAL): {
             uint8_t slot = function->chunk->code[++i];
             if (sp >= 256)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
+            auto scalar = scalarLists.find(slot);
+            if (scalar != scalarLists.end()) {
+                // v[k]: read the element slot, skipping OP_CONSTANT k and OP_INDEX_GET
+                int k = static_cast<int>(function->chunk->constants[function->chunk->code[i + 2]].asNumber());
+                if (k >= static_cast<int>(scalar->second.types.size()))
+                    return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
+                emitter.emitGetLocalToFR0(scalar->second.base + k);
+                tosInFR0 = true;
+                typeStack[sp] = scalar->second.types[k];
+                sp++;
+                i += 3;
+                break;
+            }
             emitter.emitGetLocalToFR0(slot);
             tosInFR0 = true;
             typeStack[sp] = localTypes[slot];
@@ -154,6 +646,8 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             else
                 emitter.emitSetLocal(slot, sp - 1);
             localTypes[slot] = typeStack[sp - 1];
+            if (mayHoldRef(localTypes[slot]))
+                stackMap[slot] = 1;
             break;
         }
         case static_cast<uint8_t>(OpCode::OP_GET_GLOBAL): {
@@ -221,7 +715,7 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
                 emitter.emitGetLocalToFR0(sp - 2); // Put result in FR0
             }
             tosInFR0 = true;
-            typeStack[sp - 2] = InferredType::NUMBER;
+            typeStack[sp - 2] = arithResult(typeStack[sp - 2], typeStack[sp - 1]);
             sp--;
             break;
         }
@@ -235,7 +729,7 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
                 emitter.emitGetLocalToFR0(sp - 2);
             }
             tosInFR0 = true;
-            typeStack[sp - 2] = InferredType::NUMBER;
+            typeStack[sp - 2] = arithResult(typeStack[sp - 2], typeStack[sp - 1]);
             sp--;
             break;
         }
@@ -249,7 +743,7 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
                 emitter.emitGetLocalToFR0(sp - 2);
             }
             tosInFR0 = true;
-            typeStack[sp - 2] = InferredType::NUMBER;
+            typeStack[sp - 2] = arithResult(typeStack[sp - 2], typeStack[sp - 1]);
             sp--;
             break;
         }
@@ -263,7 +757,7 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
                 emitter.emitGetLocalToFR0(sp - 2);
             }
             tosInFR0 = true;
-            typeStack[sp - 2] = InferredType::NUMBER;
+            typeStack[sp - 2] = arithResult(typeStack[sp - 2], typeStack[sp - 1]);
             sp--;
             break;
         }
@@ -345,7 +839,8 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             uint16_t offset = (function->chunk->code[i + 1] << 8) | function->chunk->code[i + 2];
             size_t target = i + 3 - offset;
             flushTos(sp);
-            emitter.emitJump(target);
+            emitter.emitGcSafepoint();
+            emitter.emitLoopJump(target);
             i += 2;
             break;
         }
@@ -366,6 +861,25 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             flushTos(sp);
             int calleeSp = sp - argCount - 1;
 
+            auto invoke = pendingInvokes.find(instrStart);
+            if (invoke != pendingInvokes.end()) {
+                const MathIntrinsic *intrinsic = nullptr;
+                if (mathReceivers.count(instrStart) && mathClass.isClass())
+                    intrinsic = findMathIntrinsic(invoke->second, argCount);
+                if (intrinsic) {
+                    double mathClassRaw;
+                    memcpy(&mathClassRaw, &mathClass, sizeof(double));
+                    emitter.emitMathIntrinsic(calleeSp, calleeSp, invoke->second, argCount, intrinsic->fn,
+                                              mathClassRaw);
+                } else {
+                    emitter.emitInvoke(calleeSp, calleeSp, invoke->second, argCount);
+                }
+                pendingInvokes.erase(invoke);
+                sp = calleeSp + 1;
+                typeStack[calleeSp] = InferredType::UNKNOWN;
+                break;
+            }
+
             if (hasBaseCase && argCount == 1) {
                 struct sljit_jump *isBaseCase = nullptr;
                 // Inline the check: if (args[1] < baseCaseThreshold) result = args[1]
@@ -403,7 +917,7 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
             emitter.emitMod(sp - 2, sp - 1);
-            typeStack[sp - 2] = InferredType::NUMBER;
+            typeStack[sp - 2] = arithResult(typeStack[sp - 2], typeStack[sp - 1]);
             sp--;
             break;
         }
@@ -513,6 +1027,8 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             uint8_t slot = function->chunk->code[++i];
             if (sp >= 256)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
+            if (slot >= function->upvalueCount)
+                return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
             emitter.emitGetUpvalue(sp, slot);
             typeStack[sp] = InferredType::UNKNOWN;
@@ -523,6 +1039,8 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             uint8_t slot = function->chunk->code[++i];
             if (sp == 0)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
+            if (slot >= function->upvalueCount)
+                return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
             emitter.emitSetUpvalue(slot, sp - 1);
             sp--;
@@ -540,6 +1058,8 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             uint8_t constIdx = function->chunk->code[++i];
             VMValue constant = function->chunk->constants[constIdx];
             int upvalueCount = constant.asFunction()->upvalueCount;
+            if (JIT_UPVALUE_DATA_SLOT + 2 * upvalueCount > JIT_HOIST_SLOT_BASE)
+                return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             const uint8_t *upvalueBytes = &function->chunk->code[i + 1];
             double funcRaw;
             memcpy(&funcRaw, &constant, sizeof(double));
@@ -555,6 +1075,27 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             if (sp < count)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
+            int listSlot = sp - count;
+            if (count > 0 && scalarCandidates.count(listSlot) &&
+                nextScalarSlot + count <= JIT_SCALAR_SLOT_BASE + JIT_SCALAR_SLOT_COUNT) {
+                ScalarList scalar{nextScalarSlot, {}};
+                for (int j = 0; j < count; j++) {
+                    emitter.emitMove(scalar.base + j, listSlot + j);
+                    scalar.types.push_back(typeStack[listSlot + j]);
+                    if (mayHoldRef(typeStack[listSlot + j]))
+                        stackMap[scalar.base + j] = 1;
+                }
+                nextScalarSlot += count;
+                double nilRaw;
+                VMValue nil = nullptr;
+                memcpy(&nilRaw, &nil, sizeof(double));
+                emitter.emitLoadConst(listSlot, nilRaw);
+                sp = listSlot + 1;
+                typeStack[listSlot] = InferredType::OBJECT;
+                scalarLists[listSlot] = std::move(scalar);
+                newScalarList = listSlot;
+                break;
+            }
             emitter.emitBuildList(sp - count, count);
             sp = sp - count + 1;
             typeStack[sp - 1] = InferredType::OBJECT;
@@ -574,7 +1115,10 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             if (sp < 2)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
-            emitter.emitIndexGet(sp - 2, sp - 2, sp - 1);
+            if (hoistedSites.count(i))
+                emitter.emitIndexGetHoisted(sp - 2, sp - 2, sp - 1, hoistedSites[i]);
+            else
+                emitter.emitIndexGet(sp - 2, sp - 2, sp - 1);
             typeStack[sp - 2] = InferredType::UNKNOWN;
             sp--;
             break;
@@ -642,6 +1186,16 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             if (sp < 1)
                 return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
             flushTos(sp);
+            auto call = methodCalls.find(instrStart);
+            if (call != methodCalls.end()) {
+                // Only called: leave the receiver in place for emitInvoke
+                pendingInvokes[call->second] = name;
+                if (instrBefore != SIZE_MAX && !jumpTargets.count(instrStart) &&
+                    function->chunk->code[instrBefore] == static_cast<uint8_t>(OpCode::OP_GET_GLOBAL) &&
+                    function->chunk->constants[function->chunk->code[instrBefore + 1]].asString()->flatten() == "Math")
+                    mathReceivers[call->second] = instrBefore;
+                break;
+            }
             emitter.emitPropertyGet(sp - 1, name);
             typeStack[sp - 1] = InferredType::UNKNOWN;
             break;
@@ -713,7 +1267,31 @@ JitFunc JITCompiler::compileMathFunction(ObjFunction *function) {
             flushTos(sp);
             return (printf("JIT Abort at line %d opcode %d\n", __LINE__, op), nullptr);
         }
+
+        // A scalar-replaced list must not be consumed as a value
+        bool keepsStackSlots = op == static_cast<uint8_t>(OpCode::OP_POP) || op == static_cast<uint8_t>(OpCode::OP_JUMP) ||
+                               op == static_cast<uint8_t>(OpCode::OP_LOOP) || op == static_cast<uint8_t>(OpCode::OP_NOP) ||
+                               (sp > spBefore && op != static_cast<uint8_t>(OpCode::OP_DUP));
+        for (auto &[slot, scalar] : scalarLists) {
+            if (!keepsStackSlots && slot != newScalarList && (spBefore - 1 == slot || sp - 1 <= slot))
+                return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
+        }
+        if (nextScalarSlot > JIT_SCALAR_SLOT_BASE && sp >= JIT_SCALAR_SLOT_BASE)
+            return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
+        if (!countedLoops.empty() && sp >= JIT_HOIST_SLOT_BASE)
+            return (printf("JIT Abort at line %d\n", __LINE__), nullptr);
+
+        for (int slot = 0; slot < sp && slot < JIT_MAX_SLOTS; slot++) {
+            if (mayHoldRef(typeStack[slot]))
+                stackMap[slot] = 1;
+        }
     }
     emitter.bindLabel(function->chunk->code.size());
-    return emitter.finalize();
+    function->jitStackMap = std::move(stackMap);
+    JitFunc code = emitter.finalize();
+    if (code) {
+        emitter.releaseGlobalCells(globalCells);
+        function->jitListArgMask = listParams;
+    }
+    return code;
 }
@@ -5,6 +5,15 @@
 #include "JitEmitter.h"
 #include <memory>
 #include <variant>
+#include <vector>
+
+// Per-site cache for a global accessed from JIT code. `slot` points into
+// the globals map node and is only valid while `epoch` matches
+// VM::globalsEpoch (bumped whenever a global is erased).
+struct JitGlobalCell {
+    VMValue *slot = nullptr;
+    uint64_t epoch = 0;
+};
 
 class JITCompiler {
   public:
@@ -16,6 +25,10 @@ class JITCompiler {
     // Tries to compile a chunk into native code using sljit.
     // Returns nullptr if compilation is unsupported (e.g., uses strings or objects)
     JitFunc compileMathFunction(ObjFunction *function);
+
+  private:
+    // Global caches referenced by emitted code; they live as long as the code does
+    std::vector<std::unique_ptr<JitGlobalCell>> globalCells;
 };
 
 #endif // TRYPILLIA_JIT_H
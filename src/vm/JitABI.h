@@ -1,7 +1,10 @@
 #pragma once
 #include "Chunk.h"
+#include "VM.h"
 #include "Value.h"
 #include <cstddef>
+#include <cstring>
+#include <vector>
 
 // ============================================================
 // ABI constants for JIT compiler
@@ -33,6 +36,7 @@ static constexpr int OBJ_TYPE_OFFSET = offsetof(Obj, type);
 
 // --- ObjType enum values used in JIT comparisons ---
 static constexpr int OBJ_TYPE_CLOSURE_INT = static_cast<int>(ObjType::OBJ_CLOSURE);
+static constexpr int OBJ_TYPE_LIST_INT = static_cast<int>(ObjType::OBJ_LIST);
 
 // --- ObjClosure ---
 // +0-31: Obj base (32 bytes)
@@ -40,6 +44,35 @@ static constexpr int OBJ_TYPE_CLOSURE_INT = static_cast<int>(ObjType::OBJ_CLOSUR
 // +40: std::vector<ObjUpvalue*> upvalues (24 bytes)
 // sizeof(ObjClosure) = 64
 static constexpr int OBJ_CLOSURE_FUNCTION_OFFSET = offsetof(ObjClosure, function);
+static constexpr int OBJ_CLOSURE_UPVALUES_OFFSET = offsetof(ObjClosure, upvalues);
+
+// --- ObjUpvalue ---
+// +0-31: Obj base (32 bytes)
+// +32: ObjUpvalue::location (VMValue*, 8 bytes)
+static constexpr int OBJ_UPVALUE_LOCATION_OFFSET = offsetof(ObjUpvalue, location);
+
+// --- ObjList ---
+// +0-31: Obj base (32 bytes)
+// +32: std::vector<VMValue> elements (24 bytes)
+static constexpr int OBJ_LIST_ELEMENTS_OFFSET = offsetof(ObjList, elements);
+
+// --- std::vector ---
+// Inline upvalue and list access read the vector's begin/end
+// pointers directly. libstdc++, libc++ and MSVC all store them
+// first and second; the layout is checked once at runtime and
+// the emitter falls back to helpers if it does not hold.
+static constexpr int STD_VECTOR_BEGIN_OFFSET = 0;
+static constexpr int STD_VECTOR_END_OFFSET = sizeof(void *);
+
+inline bool jitVectorLayoutSupported() {
+    static const bool ok = [] {
+        std::vector<VMValue> probe(3);
+        void *ptrs[2];
+        std::memcpy(ptrs, &probe, sizeof(ptrs));
+        return ptrs[0] == static_cast<void *>(probe.data()) && ptrs[1] == static_cast<void *>(probe.data() + 3);
+    }();
+    return ok;
+}
 
 // --- ObjFunction ---
 // +0-31: Obj base (32 bytes)
@@ -48,6 +81,20 @@ static constexpr int OBJ_CLOSURE_FUNCTION_OFFSET = offsetof(ObjClosure, function
 // +jitAddr: void* (varies by platform)
 static constexpr int OBJ_FUNCTION_JITADDR_OFFSET = offsetof(ObjFunction, jitAddr);
 
+// --- VM (GC accounting read by safepoints) ---
+// Loop back-edges compare bytesAllocated against nextGC inline and
+// only call into the runtime when a collection is due.
+static constexpr int VM_BYTES_ALLOCATED_OFFSET = offsetof(VM, bytesAllocated);
+static constexpr int VM_NEXT_GC_OFFSET = offsetof(VM, nextGC);
+
+// --- VM (closure and global caches) ---
+static constexpr int VM_JIT_CLOSURE_OFFSET = offsetof(VM, jitClosure);
+static constexpr int VM_GLOBALS_EPOCH_OFFSET = offsetof(VM, globalsEpoch);
+
+// --- JitGlobalCell ---
+static constexpr int JIT_GLOBAL_CELL_SLOT_OFFSET = offsetof(JitGlobalCell, slot);
+static constexpr int JIT_GLOBAL_CELL_EPOCH_OFFSET = offsetof(JitGlobalCell, epoch);
+
 // ============================================================
 // JIT virtual stack slot conventions
 //
@@ -69,6 +116,15 @@ static constexpr int JIT_SCRATCH_SLOT = 250;
 // Base slot for upvalue metadata buffer in closure creation
 static constexpr int JIT_UPVALUE_DATA_SLOT = 200;
 
+// Slots holding the elements of scalar-replaced list literals
+static constexpr int JIT_SCALAR_SLOT_BASE = 184;
+static constexpr int JIT_SCALAR_SLOT_COUNT = 16;
+
+// Slots holding list data pointers hoisted out of counted loops
+// (raw pointers, never NaN-boxed)
+static constexpr int JIT_HOIST_SLOT_BASE = 240;
+static constexpr int JIT_HOIST_SLOT_COUNT = 8;
+
 // Maximum virtual stack slots
 static constexpr int JIT_MAX_SLOTS = 256;
 
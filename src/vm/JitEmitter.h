@@ -49,6 +49,7 @@ class JitEmitter {
 
     // Calls and Globals
     virtual void emitCallDynamic(int targetOffset, int calleeOffset, int argCount) = 0;
+    virtual void emitInvoke(int targetOffset, int receiverOffset, const std::string &name, int argCount) = 0;
     virtual void emitGetGlobal(const std::string &name, int targetOffset) = 0;
     virtual void emitSetGlobal(const std::string &name, int sourceOffset) = 0;
 
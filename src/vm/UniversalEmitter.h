@@ -5,13 +5,15 @@
 #include <cstring>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 extern "C" double jit_call_helper(void *vm_ptr, double callee_val, double *args, int argCount);
+extern "C" double jit_invoke_helper(void *vm_ptr, double *slots, const char *name, int argCount);
 extern "C" double jit_get_global_helper(void *vm_ptr, const char *name);
-extern "C" void jit_set_global_helper(void *vm_ptr, const char *name, double val_d);
+extern "C" void jit_set_global_helper(void *vm_ptr, const char *name, double val_d, JitGlobalCell *cell);
 extern "C" double jit_index_get_helper(void *vm_ptr, double object_val, double index_val);
 extern "C" double jit_index_set_helper(void *vm_ptr, double object_val, double index_val, double value_val);
 extern "C" double jit_mod_helper(double a, double b);
@@ -20,7 +22,7 @@ extern "C" double jit_build_map_helper(double *args, int count);
 extern "C" double jit_property_get_helper(void *vm_ptr, double object_val, const char *name);
 extern "C" double jit_property_set_helper(void *vm_ptr, double object_val, const char *name, double value_val);
 extern "C" double jit_iter_has_next_helper(double index_val, double iterable_val);
-extern "C" void *jit_resolve_global_address(void *vm_ptr, const char *name, VMValue **cell);
+extern "C" void *jit_resolve_global_address(void *vm_ptr, const char *name, JitGlobalCell *cell);
 extern "C" double jit_create_class_helper(void *vm, const char *name);
 extern "C" double jit_create_abstract_class_helper(void *vm, const char *name);
 extern "C" double jit_bind_method_helper(double class_val, double method_val, const char *name, int isAbstract);
@@ -33,15 +35,30 @@ extern "C" double jit_create_closure_helper(void *vm, double func_val, double *u
 extern "C" double jit_get_upvalue_helper(void *vm_ptr, int slot);
 extern "C" void jit_set_upvalue_helper(void *vm_ptr, int slot, double val);
 extern "C" void jit_close_upvalue_helper(void *vm_ptr, double *addr);
+extern "C" void jit_gc_safepoint_helper(void *vm_ptr);
+
+// Range check emitted in front of a counted loop. When it passes, every
+// list[i] access in the body is known to be in bounds and the list data
+// pointers are cached in hoist slots; otherwise the slots are zeroed and
+// the accesses take the checked path.
+struct LoopRangeGuard {
+    int inductionSlot = -1;
+    int boundSlot = -1;     // local holding the bound, or -1
+    int boundListSlot = -1; // list whose length is the bound, or -1
+    double boundConst = 0;  // used when both slots are -1
+    bool inclusive = false; // i <= bound instead of i < bound
+    std::vector<std::pair<int, int>> lists; // (list local, hoist slot)
+};
 
 class UniversalEmitter : public JitEmitter {
   private:
     struct sljit_compiler *compiler;
     int funcArity;
     std::map<size_t, struct sljit_label *> labels;
+    std::map<size_t, struct sljit_label *> loopEntries;
     std::map<size_t, std::vector<struct sljit_jump *>> unresolvedJumps;
     std::vector<char *> ownedStrings;
-    std::vector<VMValue **> ownedCells;
+    std::vector<std::unique_ptr<JitGlobalCell>> ownedCells;
     std::set<std::string> stringPool;
 
     const char *cacheString(const std::string &s) {
@@ -63,8 +80,13 @@ class UniversalEmitter : public JitEmitter {
             sljit_free_compiler(compiler);
         for (char *s : ownedStrings)
             free(s);
-        for (VMValue **cell : ownedCells)
-            delete cell;
+    }
+
+    // Hands the global caches over to the owner of the generated code
+    void releaseGlobalCells(std::vector<std::unique_ptr<JitGlobalCell>> &out) {
+        for (auto &cell : ownedCells)
+            out.push_back(std::move(cell));
+        ownedCells.clear();
     }
 
     void setCapturedLocals(const std::vector<int> &slots) override {
@@ -74,10 +96,12 @@ class UniversalEmitter : public JitEmitter {
     void emitPrologue(int maxLocals) override {
         // ABI: void* vm (R0), double* args (R1), int argCount (R2), double n (FR0)
         sljit_emit_enter(compiler, 0, SLJIT_ARGS4(F64, W, P, W, F64), 4 | SLJIT_ENTER_FLOAT(4),
-                         3 | SLJIT_ENTER_FLOAT(0), 8);
+                         4 | SLJIT_ENTER_FLOAT(0), 8);
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_S0, 0, SLJIT_R0, 0); // vm_ptr
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_S1, 0, SLJIT_R1, 0); // args_ptr
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_S2, 0, SLJIT_R2, 0); // argCount
+        // vm->jitClosure is set by the caller for the duration of this frame
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_S3, 0, SLJIT_MEM1(SLJIT_S0), VM_JIT_CLOSURE_OFFSET); // closure
 
         // Sync register n (FR0) to virtual stack local 0 (args[1]) for consistency
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), JIT_FIRST_ARG_SLOT * sizeof(double), SLJIT_FR0, 0);
@@ -466,31 +490,81 @@ class UniversalEmitter : public JitEmitter {
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
     }
 
-    std::vector<VMValue *> globalCaches;
+    void emitInvoke(int targetOffset, int receiverOffset, const std::string &name, int argCount) override {
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
+        sljit_emit_op2(compiler, SLJIT_ADD, SLJIT_R1, 0, SLJIT_S1, 0, SLJIT_IMM, receiverOffset * sizeof(double));
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R2, 0, SLJIT_IMM, (sljit_sw)cacheString(name));
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R3, 0, SLJIT_IMM, argCount);
+        sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS4(F64, W, P, W, W), SLJIT_IMM, (sljit_sw)jit_invoke_helper);
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
+    }
 
-    void emitGetGlobal(const std::string &name, int targetOffset) override {
-        // Allocate a persistent "cell" for this global variable
-        VMValue **cell = new VMValue *(nullptr);
-        ownedCells.push_back(cell);
+    // Math.<name>(args) with `fn` called directly on the unboxed arguments
+    // (fn == nullptr: abs, done inline). Falls back to emitInvoke when the
+    // receiver is no longer the Math class or an argument is not a number.
+    void emitMathIntrinsic(int targetOffset, int receiverOffset, const std::string &name, int argCount, void *fn,
+                           double mathClass) {
+        uint64_t mathClassRaw;
+        memcpy(&mathClassRaw, &mathClass, sizeof(uint64_t));
+        std::vector<struct sljit_jump *> slow;
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_S1), receiverOffset * sizeof(double));
+        slow.push_back(sljit_emit_cmp(compiler, SLJIT_NOT_EQUAL, SLJIT_R0, 0, SLJIT_IMM, (sljit_sw)mathClassRaw));
+        for (int i = 1; i <= argCount; i++) {
+            sljit_emit_op2(compiler, SLJIT_AND, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_S1), (receiverOffset + i) * sizeof(double),
+                           SLJIT_IMM, (sljit_sw)QNAN);
+            slow.push_back(sljit_emit_cmp(compiler, SLJIT_EQUAL, SLJIT_R0, 0, SLJIT_IMM, (sljit_sw)QNAN));
+        }
 
-        // 1. Load the value from the cell
+        if (!fn) {
+            sljit_emit_fop1(compiler, SLJIT_ABS_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_S1),
+                            (receiverOffset + 1) * sizeof(double));
+        } else {
+            static const sljit_s32 argRegs[] = {SLJIT_FR0, SLJIT_FR1, SLJIT_FR2};
+            for (int i = 0; i < argCount; i++)
+                sljit_emit_fop1(compiler, SLJIT_MOV_F64, argRegs[i], 0, SLJIT_MEM1(SLJIT_S1),
+                                (receiverOffset + 1 + i) * sizeof(double));
+            sljit_s32 argTypes = argCount == 1   ? SLJIT_ARGS1(F64, F64)
+                                 : argCount == 2 ? SLJIT_ARGS2(F64, F64, F64)
+                                                 : SLJIT_ARGS3(F64, F64, F64, F64);
+            sljit_emit_icall(compiler, SLJIT_CALL, argTypes, SLJIT_IMM, (sljit_sw)fn);
+        }
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
+        struct sljit_jump *done = sljit_emit_jump(compiler, SLJIT_JUMP);
+
+        struct sljit_label *slowPath = sljit_emit_label(compiler);
+        for (auto *jump : slow)
+            sljit_set_label(jump, slowPath);
+        emitInvoke(targetOffset, receiverOffset, name, argCount);
+        sljit_set_label(done, sljit_emit_label(compiler));
+    }
+
+    JitGlobalCell *newGlobalCell() {
+        ownedCells.push_back(std::make_unique<JitGlobalCell>());
+        return ownedCells.back().get();
+    }
+
+    // R1 = cell->slot if the cell is valid, otherwise jumps to the returned slow path
+    struct sljit_jump *emitLoadGlobalCell(JitGlobalCell *cell) {
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_IMM, (sljit_sw)cell);
-        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_R0), 0);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_R0), JIT_GLOBAL_CELL_EPOCH_OFFSET);
+        struct sljit_jump *stale =
+            sljit_emit_cmp(compiler, SLJIT_NOT_EQUAL, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_S0), VM_GLOBALS_EPOCH_OFFSET);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_R0), JIT_GLOBAL_CELL_SLOT_OFFSET);
+        return stale;
+    }
 
-        // 2. If cell is null, go to slow path to resolve it
-        struct sljit_jump *is_null = sljit_emit_cmp(compiler, SLJIT_EQUAL, SLJIT_R1, 0, SLJIT_IMM, 0);
+    void emitGetGlobal(const std::string &name, int targetOffset) override {
+        JitGlobalCell *cell = newGlobalCell();
 
-        // --- FAST PATH: Already cached ---
-        // Load VMValue (8 bytes) from the address in R1
+        // --- FAST PATH: cached cell with a matching epoch ---
+        struct sljit_jump *stale = emitLoadGlobalCell(cell);
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_R1), 0);
         struct sljit_jump *fast_end = sljit_emit_jump(compiler, SLJIT_JUMP);
 
         // --- SLOW PATH: Resolve and cache ---
-        sljit_set_label(is_null, sljit_emit_label(compiler));
+        sljit_set_label(stale, sljit_emit_label(compiler));
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0); // vm_ptr
-        const char *cname = cacheString(name);
-        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_IMM, (sljit_sw)cname);
-
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_IMM, (sljit_sw)cacheString(name));
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R2, 0, SLJIT_IMM, (sljit_sw)cell);
         sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS3(W, W, W, W), SLJIT_IMM,
                          (sljit_sw)jit_resolve_global_address);
@@ -503,20 +577,135 @@ class UniversalEmitter : public JitEmitter {
     }
 
     void emitSetGlobal(const std::string &name, int sourceOffset) override {
-        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
-        const char *cname = cacheString(name);
-        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_IMM, (sljit_sw)cname);
+        JitGlobalCell *cell = newGlobalCell();
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_S1), sourceOffset * sizeof(double));
-        sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS3V(W, W, F64), SLJIT_IMM, (sljit_sw)jit_set_global_helper);
+
+        struct sljit_jump *stale = emitLoadGlobalCell(cell);
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_R1), 0, SLJIT_FR0, 0);
+        struct sljit_jump *fast_end = sljit_emit_jump(compiler, SLJIT_JUMP);
+
+        // Slow path defines/updates the global and fills the cell
+        sljit_set_label(stale, sljit_emit_label(compiler));
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_IMM, (sljit_sw)cacheString(name));
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R2, 0, SLJIT_IMM, (sljit_sw)cell);
+        sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS4V(W, W, F64, W), SLJIT_IMM, (sljit_sw)jit_set_global_helper);
+
+        sljit_set_label(fast_end, sljit_emit_label(compiler));
     }
 
-    void emitIndexGet(int targetOffset, int objectOffset, int indexOffset) override {
+    // R0 = ObjList* held in `slot`, R1 = elements begin, R2 = element count.
+    // Jumps that fire when the slot does not hold a list are appended to `fail`.
+    void emitLoadListBounds(int slot, std::vector<struct sljit_jump *> &fail) {
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_S1), slot * sizeof(double));
+        sljit_emit_op2(compiler, SLJIT_AND, SLJIT_R1, 0, SLJIT_R0, 0, SLJIT_IMM, (sljit_sw)(QNAN | SIGN_BIT));
+        fail.push_back(sljit_emit_cmp(compiler, SLJIT_NOT_EQUAL, SLJIT_R1, 0, SLJIT_IMM, (sljit_sw)(QNAN | SIGN_BIT)));
+        sljit_emit_op2(compiler, SLJIT_AND, SLJIT_R0, 0, SLJIT_R0, 0, SLJIT_IMM, (sljit_sw)~(QNAN | SIGN_BIT));
+        sljit_emit_op1(compiler, SLJIT_MOV_U32, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_R0), OBJ_TYPE_OFFSET);
+        fail.push_back(sljit_emit_cmp(compiler, SLJIT_NOT_EQUAL, SLJIT_R1, 0, SLJIT_IMM, OBJ_TYPE_LIST_INT));
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_R0),
+                       OBJ_LIST_ELEMENTS_OFFSET + STD_VECTOR_BEGIN_OFFSET);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R2, 0, SLJIT_MEM1(SLJIT_R0),
+                       OBJ_LIST_ELEMENTS_OFFSET + STD_VECTOR_END_OFFSET);
+        sljit_emit_op2(compiler, SLJIT_SUB, SLJIT_R2, 0, SLJIT_R2, 0, SLJIT_R1, 0);
+        sljit_emit_op2(compiler, SLJIT_LSHR, SLJIT_R2, 0, SLJIT_R2, 0, SLJIT_IMM, 3);
+    }
+
+    void emitIndexGetHelperCall(int objectOffset, int indexOffset) {
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_S1), objectOffset * sizeof(double));
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR1, 0, SLJIT_MEM1(SLJIT_S1), indexOffset * sizeof(double));
         sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS3(F64, W, F64, F64), SLJIT_IMM,
                          (sljit_sw)jit_index_get_helper);
+    }
+
+    void emitIndexGet(int targetOffset, int objectOffset, int indexOffset) override {
+        if (!jitVectorLayoutSupported()) {
+            emitIndexGetHelperCall(objectOffset, indexOffset);
+            sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
+            return;
+        }
+
+        // --- FAST PATH: list receiver, in-range numeric index ---
+        std::vector<struct sljit_jump *> slow;
+        emitLoadListBounds(objectOffset, slow);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R3, 0, SLJIT_MEM1(SLJIT_S1), indexOffset * sizeof(double));
+        sljit_emit_op2(compiler, SLJIT_AND, SLJIT_R3, 0, SLJIT_R3, 0, SLJIT_IMM, (sljit_sw)QNAN);
+        slow.push_back(sljit_emit_cmp(compiler, SLJIT_EQUAL, SLJIT_R3, 0, SLJIT_IMM, (sljit_sw)QNAN));
+        sljit_emit_fop1(compiler, SLJIT_CONV_SW_FROM_F64, SLJIT_R3, 0, SLJIT_MEM1(SLJIT_S1),
+                        indexOffset * sizeof(double));
+        // Unsigned compare also rejects negative indices
+        slow.push_back(sljit_emit_cmp(compiler, SLJIT_GREATER_EQUAL, SLJIT_R3, 0, SLJIT_R2, 0));
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM2(SLJIT_R1, SLJIT_R3), 3);
+        struct sljit_jump *fast_end = sljit_emit_jump(compiler, SLJIT_JUMP);
+
+        // --- SLOW PATH: maps, strings, out of range ---
+        struct sljit_label *slow_label = sljit_emit_label(compiler);
+        for (auto *jump : slow)
+            sljit_set_label(jump, slow_label);
+        emitIndexGetHelperCall(objectOffset, indexOffset);
+
+        sljit_set_label(fast_end, sljit_emit_label(compiler));
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
+    }
+
+    // list[i] inside a counted loop whose preheader proved the range:
+    // one load of the hoisted data pointer replaces type and bounds checks.
+    void emitIndexGetHoisted(int targetOffset, int objectOffset, int indexOffset, int hoistSlot) {
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_MEM1(SLJIT_S1), hoistSlot * sizeof(double));
+        struct sljit_jump *unchecked = sljit_emit_cmp(compiler, SLJIT_EQUAL, SLJIT_R1, 0, SLJIT_IMM, 0);
+        sljit_emit_fop1(compiler, SLJIT_CONV_SW_FROM_F64, SLJIT_R3, 0, SLJIT_MEM1(SLJIT_S1),
+                        indexOffset * sizeof(double));
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM2(SLJIT_R1, SLJIT_R3), 3);
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
+        struct sljit_jump *done = sljit_emit_jump(compiler, SLJIT_JUMP);
+
+        sljit_set_label(unchecked, sljit_emit_label(compiler));
+        emitIndexGet(targetOffset, objectOffset, indexOffset);
+        sljit_set_label(done, sljit_emit_label(compiler));
+    }
+
+    void emitLoopPreheader(const LoopRangeGuard &guard) {
+        std::vector<struct sljit_jump *> fail;
+
+        // FR1 = exclusive upper bound of the induction variable
+        if (guard.boundListSlot >= 0) {
+            emitLoadListBounds(guard.boundListSlot, fail);
+            sljit_emit_fop1(compiler, SLJIT_CONV_F64_FROM_SW, SLJIT_FR1, 0, SLJIT_R2, 0);
+        } else if (guard.boundSlot >= 0) {
+            sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR1, 0, SLJIT_MEM1(SLJIT_S1), guard.boundSlot * sizeof(double));
+        } else {
+            sljit_emit_fset64(compiler, SLJIT_FR1, guard.boundConst);
+        }
+        fail.push_back(sljit_emit_fcmp(compiler, SLJIT_UNORDERED, SLJIT_FR1, 0, SLJIT_FR1, 0));
+        if (guard.inclusive) {
+            sljit_emit_fset64(compiler, SLJIT_FR2, 1.0);
+            sljit_emit_fop2(compiler, SLJIT_ADD_F64, SLJIT_FR1, 0, SLJIT_FR1, 0, SLJIT_FR2, 0);
+        }
+
+        // 0 <= i on entry; it only grows inside the loop
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR2, 0, SLJIT_MEM1(SLJIT_S1),
+                        guard.inductionSlot * sizeof(double));
+        fail.push_back(sljit_emit_fcmp(compiler, SLJIT_UNORDERED, SLJIT_FR2, 0, SLJIT_FR2, 0));
+        sljit_emit_fset64(compiler, SLJIT_FR3, 0.0);
+        fail.push_back(sljit_emit_fcmp(compiler, SLJIT_F_LESS, SLJIT_FR2, 0, SLJIT_FR3, 0));
+
+        // bound <= length for every list indexed by i
+        for (const auto &[listSlot, hoistSlot] : guard.lists) {
+            emitLoadListBounds(listSlot, fail);
+            sljit_emit_fop1(compiler, SLJIT_CONV_F64_FROM_SW, SLJIT_FR3, 0, SLJIT_R2, 0);
+            fail.push_back(sljit_emit_fcmp(compiler, SLJIT_F_GREATER, SLJIT_FR1, 0, SLJIT_FR3, 0));
+            sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_MEM1(SLJIT_S1), hoistSlot * sizeof(double), SLJIT_R1, 0);
+        }
+        struct sljit_jump *done = sljit_emit_jump(compiler, SLJIT_JUMP);
+
+        struct sljit_label *fail_label = sljit_emit_label(compiler);
+        for (auto *jump : fail)
+            sljit_set_label(jump, fail_label);
+        for (const auto &[listSlot, hoistSlot] : guard.lists)
+            sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_MEM1(SLJIT_S1), hoistSlot * sizeof(double), SLJIT_IMM, 0);
+
+        sljit_set_label(done, sljit_emit_label(compiler));
     }
 
     void emitIndexSet(int objectOffset, int indexOffset, int valueOffset) override {
@@ -662,18 +851,56 @@ class UniversalEmitter : public JitEmitter {
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
     }
 
+    // R0 = closure->upvalues[slot]->location, or jumps to the returned slow path
+    // when the closure or upvalue is missing (e.g. captured outside a closure)
+    struct sljit_jump *emitLoadUpvalueLocation(int slot, struct sljit_jump **noClosure) {
+        *noClosure = sljit_emit_cmp(compiler, SLJIT_EQUAL, SLJIT_S3, 0, SLJIT_IMM, 0);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_S3),
+                       OBJ_CLOSURE_UPVALUES_OFFSET + STD_VECTOR_BEGIN_OFFSET);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_R0), slot * sizeof(ObjUpvalue *));
+        struct sljit_jump *noUpvalue = sljit_emit_cmp(compiler, SLJIT_EQUAL, SLJIT_R0, 0, SLJIT_IMM, 0);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_R0), OBJ_UPVALUE_LOCATION_OFFSET);
+        return noUpvalue;
+    }
+
     void emitGetUpvalue(int targetOffset, int slot) override {
+        struct sljit_jump *fast_end = nullptr;
+        struct sljit_jump *noClosure = nullptr;
+        struct sljit_jump *noUpvalue = nullptr;
+        if (jitVectorLayoutSupported()) {
+            noUpvalue = emitLoadUpvalueLocation(slot, &noClosure);
+            sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_R0), 0);
+            fast_end = sljit_emit_jump(compiler, SLJIT_JUMP);
+            struct sljit_label *slow = sljit_emit_label(compiler);
+            sljit_set_label(noClosure, slow);
+            sljit_set_label(noUpvalue, slow);
+        }
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_IMM, slot);
         sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS2(F64, W, W), SLJIT_IMM, (sljit_sw)jit_get_upvalue_helper);
+        if (fast_end)
+            sljit_set_label(fast_end, sljit_emit_label(compiler));
         sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_S1), targetOffset * sizeof(double), SLJIT_FR0, 0);
     }
 
     void emitSetUpvalue(int slot, int sourceOffset) override {
+        struct sljit_jump *fast_end = nullptr;
+        struct sljit_jump *noClosure = nullptr;
+        struct sljit_jump *noUpvalue = nullptr;
+        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_S1), sourceOffset * sizeof(double));
+        if (jitVectorLayoutSupported()) {
+            noUpvalue = emitLoadUpvalueLocation(slot, &noClosure);
+            sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_MEM1(SLJIT_R0), 0, SLJIT_FR0, 0);
+            fast_end = sljit_emit_jump(compiler, SLJIT_JUMP);
+            struct sljit_label *slow = sljit_emit_label(compiler);
+            sljit_set_label(noClosure, slow);
+            sljit_set_label(noUpvalue, slow);
+        }
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
         sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R1, 0, SLJIT_IMM, slot);
-        sljit_emit_fop1(compiler, SLJIT_MOV_F64, SLJIT_FR0, 0, SLJIT_MEM1(SLJIT_S1), sourceOffset * sizeof(double));
         sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS3V(W, W, F64), SLJIT_IMM, (sljit_sw)jit_set_upvalue_helper);
+        if (fast_end)
+            sljit_set_label(fast_end, sljit_emit_label(compiler));
     }
 
     void emitCloseUpvalue(int stackOffset) override {
@@ -682,6 +909,16 @@ class UniversalEmitter : public JitEmitter {
         sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS2V(W, P), SLJIT_IMM, (sljit_sw)jit_close_upvalue_helper);
     }
 
+    void emitGcSafepoint() {
+        // Fast path: a single load + compare, the helper runs only when a collection is due
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_S0), VM_BYTES_ALLOCATED_OFFSET);
+        struct sljit_jump *no_gc =
+            sljit_emit_cmp(compiler, SLJIT_LESS_EQUAL, SLJIT_R0, 0, SLJIT_MEM1(SLJIT_S0), VM_NEXT_GC_OFFSET);
+        sljit_emit_op1(compiler, SLJIT_MOV, SLJIT_R0, 0, SLJIT_S0, 0);
+        sljit_emit_icall(compiler, SLJIT_CALL, SLJIT_ARGS1V(W), SLJIT_IMM, (sljit_sw)jit_gc_safepoint_helper);
+        sljit_set_label(no_gc, sljit_emit_label(compiler));
+    }
+
     void bindLabel(size_t byteCodeIndex) override {
         labels[byteCodeIndex] = sljit_emit_label(compiler);
         if (unresolvedJumps.count(byteCodeIndex)) {
@@ -692,6 +929,20 @@ class UniversalEmitter : public JitEmitter {
         }
     }
 
+    // Back-edges enter the loop past its preheader
+    void bindLoopEntry(size_t headerByteCodeIndex) {
+        loopEntries[headerByteCodeIndex] = sljit_emit_label(compiler);
+    }
+
+    void emitLoopJump(size_t headerByteCodeIndex) {
+        auto it = loopEntries.find(headerByteCodeIndex);
+        if (it == loopEntries.end()) {
+            emitJump(headerByteCodeIndex);
+            return;
+        }
+        sljit_set_label(sljit_emit_jump(compiler, SLJIT_JUMP), it->second);
+    }
+
     void emitJump(size_t targetByteCodeIndex) override {
         struct sljit_jump *jump = sljit_emit_jump(compiler, SLJIT_JUMP);
         if (labels.count(targetByteCodeIndex)) {
@@ -11,7 +11,13 @@ thread_local VM *currentVM = nullptr;
 struct JmpBufHolder {
     sigjmp_buf buf;
 };
-static thread_local JmpBufHolder *stackOverflowJmpBuf = nullptr;
+
+// Restores the enclosing run's jump target when a nested run returns.
+struct JmpBufScope {
+    VM *vm;
+    JmpBufHolder *saved;
+    ~JmpBufScope() { vm->runJmpBuf = saved; }
+};
 static std::once_flag guardHandlerFlag;
 
 extern "C" void stackGuardHandler(int sig, siginfo_t *info, void *ctx) {
@@ -23,8 +29,8 @@ extern "C" void stackGuardHandler(int sig, siginfo_t *info, void *ctx) {
         char *guardEnd = guardStart + GUARD_SIZE;
         void *fault = info->si_addr;
         if (fault >= (void *)guardStart && fault < (void *)guardEnd) {
-            if (stackOverflowJmpBuf) {
-                siglongjmp(stackOverflowJmpBuf->buf, 1);
+            if (vm->runJmpBuf) {
+                siglongjmp(vm->runJmpBuf->buf, 1);
             }
         }
     }
@@ -187,6 +193,13 @@ InterpretResult VM::interpret(ObjFunction *function) {
 
     if (result == InterpretResult::INTERPRET_OK) {
         drainMicrotasks();
+        while (!runQueue.empty() || (pollIO && !pendingIO.empty())) {
+            if (runQueue.empty())
+                pollIO(this, true);
+            else
+                runTasks();
+            drainMicrotasks();
+        }
     }
 
     return result;
@@ -233,14 +246,34 @@ InterpretResult VM::runtimeError(const std::string &message) {
     return InterpretResult::INTERPRET_RUNTIME_ERROR;
 }
 
+void VM::jitRuntimeError(const char *message) {
+    if (runJmpBuf) {
+        jitErrorMessage = message;
+        siglongjmp(runJmpBuf->buf, 1);
+    }
+    runtimeError(message);
+}
+
 InterpretResult VM::run(int targetFrameDepth) {
     CallFrame *frame = &frames.back();
+    // Only the run resumeTask starts for a task may be preempted or parked;
+    // runs nested under it for native callbacks start at the same depth.
+    bool taskRun = enteringTaskRun;
+    enteringTaskRun = false;
 
     JmpBufHolder holder;
-    stackOverflowJmpBuf = &holder;
+    JmpBufScope scope{this, runJmpBuf};
+    runJmpBuf = &holder;
+    size_t savedJitFrames = jitFrames.size();
     if (sigsetjmp(holder.buf, 1) != 0) {
-        stackOverflowJmpBuf = nullptr;
+        runJmpBuf = scope.saved;
         jitClosure = nullptr;
+        jitFrames.resize(savedJitFrames);
+        if (!jitErrorMessage.empty()) {
+            std::string message = std::move(jitErrorMessage);
+            jitErrorMessage.clear();
+            return runtimeError(message);
+        }
         return runtimeError("Stack overflow.");
     }
 
@@ -542,6 +575,8 @@ InterpretResult VM::run(int targetFrameDepth) {
                 GC::collect(this);
             uint16_t offset = READ_SHORT();
             frame->ip -= offset;
+            if (taskRun && --taskBudget <= 0)
+                return InterpretResult::INTERPRET_OK; // preempted
             break;
         }
         case static_cast<uint8_t>(OpCode::OP_ITER_HAS_NEXT): {
@@ -557,6 +592,9 @@ InterpretResult VM::run(int targetFrameDepth) {
                     auto str = iterableVal.asString()->flatten();
                     push(index < utf8_length(str));
                     break;
+                } else if (iterableVal.isSet()) {
+                    push(index < iterableVal.asSet()->size());
+                    break;
                 }
             }
             return runtimeError(std::string("Invalid operand types for iteration."));
@@ -620,6 +658,9 @@ InterpretResult VM::run(int targetFrameDepth) {
             VMValue value = pop();
             VMValue index = pop();
             VMValue listVal = pop();
+            if (listVal.isObj() && listVal.asObj()->isFrozen) {
+                return runtimeError(std::string("Cannot modify a frozen value."));
+            }
             if (listVal.isList()) {
                 auto list = listVal.asList();
                 if (index.isNumber()) {
@@ -750,6 +791,9 @@ InterpretResult VM::run(int targetFrameDepth) {
 
             if (instanceVal.isInstance()) {
                 auto instance = instanceVal.asInstance();
+                if (instance->isFrozen) {
+                    return runtimeError(std::string("Cannot modify a frozen value."));
+                }
                 VMAccessModifier mod = VMAccessModifier::PUBLIC;
                 if (instance->klass->fieldModifiers.count(name))
                     mod = instance->klass->fieldModifiers[name];
@@ -769,8 +813,15 @@ InterpretResult VM::run(int targetFrameDepth) {
         }
         case static_cast<uint8_t>(OpCode::OP_CALL): {
             uint8_t argCount = READ_BYTE();
+            taskSafePoint = taskRun;
             if (!executeCall(argCount))
                 return InterpretResult::INTERPRET_RUNTIME_ERROR;
+            if (taskSwitchPending) {
+                // Task.yield / join parked the running task; its frames stay
+                // on the stack for the scheduler to save.
+                taskSwitchPending = false;
+                return InterpretResult::INTERPRET_OK;
+            }
             frame = &frames.back();
             break;
         }
@@ -840,8 +891,22 @@ bool VM::executeIndexGet() {
         } else {
             push(nullptr); // Return nil for missing keys
         }
+    } else if (listVal.isSet()) {
+        // Positional access in iteration order; this is what foreach uses
+        auto set = listVal.asSet();
+        if (!index.isNumber()) {
+            runtimeError(std::string("Set index must be a number."));
+            return false;
+        }
+        int i = static_cast<int>(index.asNumber());
+        if (i >= 0 && i < static_cast<int>(set->size())) {
+            push(set->entries[i]);
+        } else {
+            runtimeError(std::string("Set index out of bounds."));
+            return false;
+        }
     } else {
-        runtimeError(std::string("Can only index into lists, maps, or strings."));
+        runtimeError(std::string("Can only index into lists, maps, sets, or strings."));
         return false;
     }
     return true;
@@ -930,6 +995,17 @@ bool VM::executePropertyGet(const std::string &name) {
         }
         runtimeError(std::string("Undefined property '") + name + "' on Map.");
         return false;
+    } else if (instanceVal.isSet()) {
+        if (globals.count("Set")) {
+            auto klass = globals["Set"].asClass();
+            if (klass->statics.count(name)) {
+                pop(); // pop set
+                push(new ObjBoundMethod(instanceVal, klass->statics[name]));
+                return true;
+            }
+        }
+        runtimeError(std::string("Undefined property '") + name + "' on Set.");
+        return false;
     } else if (instanceVal.isPromise()) {
         if (globals.count("__promise_then") && name == "then") {
             pop();
@@ -993,13 +1069,14 @@ bool VM::executeCall(uint8_t argCount) {
                 jitArgs[i] = raw;
             }
 
-            // Guard: JIT assumes all values are numbers; fall back to
-            // interpreter if any argument is not a number
+            // Guard: JIT assumes all values are numbers (or lists, for
+            // parameters compiled as lists); fall back to interpreter otherwise
             bool allNumbers = true;
             for (int i = 1; i <= argCount; i++) {
                 VMValue val;
                 memcpy(&val, &jitArgs[i], sizeof(double));
-                if (!val.isNumber()) {
+                bool listArg = i <= 32 && (funcPtr->jitListArgMask & (1u << (i - 1)));
+                if (listArg ? !val.isList() : !val.isNumber()) {
                     allNumbers = false;
                     break;
                 }
@@ -1007,7 +1084,9 @@ bool VM::executeCall(uint8_t argCount) {
 
             if (allNumbers) {
                 jitClosure = closure;
+                jitFrames.push_back({closure, jitArgs.data(), &function->jitStackMap});
                 double result = nativeJitFunc(this, jitArgs.data(), argCount, argCount > 0 ? jitArgs[1] : 0.0);
+                jitFrames.pop_back();
                 jitClosure = nullptr;
                 stackTop -= argCount + 1;
                 push(result);
@@ -1028,6 +1107,7 @@ bool VM::executeCall(uint8_t argCount) {
                          std::to_string(argCount) + ".");
             return false;
         }
+        size_t savedJitFrames = jitFrames.size();
         if (sigsetjmp(assertJmpBuf, 1) == 0) {
             assertJumpEnabled = true;
             VMValue result = native->function(argCount, stack + (stackTop - stack) - argCount);
@@ -1036,6 +1116,7 @@ bool VM::executeCall(uint8_t argCount) {
             push(result);
         } else {
             assertJumpEnabled = false;
+            jitFrames.resize(savedJitFrames);
             resetStack();
             return false;
         }
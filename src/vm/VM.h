@@ -5,8 +5,10 @@
 #include "JIT.h"
 #include <csignal>
 #include <csetjmp>
+#include <deque>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 enum class InterpretResult { INTERPRET_OK, INTERPRET_COMPILE_ERROR, INTERPRET_RUNTIME_ERROR };
@@ -17,6 +19,38 @@ struct CallFrame {
     int stackStart;
 };
 
+// Active native (JIT) frame. The JIT keeps its virtual stack in a
+// separate double buffer, so the GC scans the slots listed in the
+// function's stack map while the frame is live.
+struct JitFrame {
+    ObjClosure *closure;
+    double *slots;
+    const std::vector<uint8_t> *stackMap;
+};
+
+// Green thread started with Task.spawn. Tasks share the VM value stack:
+// the running task's slice sits on top of it, and a suspended task keeps
+// a copy of that slice (frames rebased to 0) until it is resumed, possibly
+// at a different depth.
+struct GreenTask {
+    VMValue fn = nullptr;
+    std::vector<VMValue> args;
+    std::vector<VMValue> stack;
+    std::vector<CallFrame> frames;
+    ObjUpvalue *openUpvalues = nullptr;
+    ObjInstance *handle = nullptr;
+    VMValue result = nullptr;
+    bool started = false;
+    bool done = false;
+    bool failed = false;
+    GreenTask *waitingOn = nullptr;
+    std::vector<GreenTask *> joiners;
+    size_t liveIndex = 0;
+};
+
+// Loop back-edges a task may take before it is preempted.
+static constexpr int TASK_TIME_SLICE = 10000;
+
 #define STACK_MAX 8192
 static constexpr size_t STACK_BYTES = STACK_MAX * sizeof(VMValue);
 static constexpr size_t GUARD_SIZE = 4096;
@@ -24,6 +58,9 @@ static constexpr size_t GUARD_SIZE = 4096;
 class VM;
 extern thread_local VM *currentVM;
 
+struct SharedRegion;
+struct JmpBufHolder;
+
 class VM {
   public:
     std::vector<CallFrame> frames;
@@ -34,6 +71,7 @@ class VM {
     VMValue *stackTop;
     bool stackIsMMap = false;
     std::unordered_map<std::string, VMValue> globals;
+    uint64_t globalsEpoch = 1;
     ObjUpvalue *openUpvalues;
 
     void resetStack();
@@ -42,6 +80,10 @@ class VM {
     VMValue peek(int distance);
 
     InterpretResult runtimeError(const std::string &message);
+    // Raised from JIT helpers: unwinds the compiled code back to the
+    // innermost run() and reports the error from there.
+    void jitRuntimeError(const char *message);
+    std::string jitErrorMessage;
     InterpretResult run(int targetFrameDepth = 0);
 
     bool executeCall(uint8_t argCount);
@@ -53,12 +95,14 @@ class VM {
     void closeUpvalues(VMValue *last);
 
     void defineNative(const std::string &name, int arity, NativeFn function);
+    void eraseGlobal(const std::string &name);
     VMValue callClosure(VMValue closureVal, int argCount, VMValue *args);
 
     VM();
     ~VM();
 
     ObjClosure *jitClosure = nullptr;
+    std::vector<JitFrame> jitFrames;
     JITCompiler jit;
     std::unordered_map<void *, JitFunc> compiledFuncs;
 
@@ -67,6 +111,9 @@ class VM {
     bool assertJumpEnabled = false;
     sigjmp_buf catchJmpBuf;
     bool catchJumpEnabled = false;
+    // Innermost live run()'s landing pad for stack overflow and JIT errors;
+    // code that longjmps past nested runs must restore it.
+    JmpBufHolder *runJmpBuf = nullptr;
 
     struct PromiseMicrotask {
         ObjPromise *targetPromise;
@@ -78,6 +125,32 @@ class VM {
     std::vector<PromiseMicrotask> promiseMicrotasks;
     void drainMicrotasks();
 
+    // Green thread scheduler (runtime/Scheduler.cpp)
+    std::deque<GreenTask *> runQueue;
+    std::vector<GreenTask *> liveTasks;
+    GreenTask *currentTask = nullptr;
+    bool enteringTaskRun = false; // consumed by the next run() call
+    size_t taskJitBase = 0;
+    int taskBudget = 0;
+    bool taskSafePoint = false;
+    bool taskSwitchPending = false;
+    void spawnTask(GreenTask *task);
+    void resumeTask(GreenTask *task);
+    void finishTask(GreenTask *task, VMValue result, bool failed);
+    void runTasks(GreenTask *until = nullptr);
+    void runTaskRound();
+    bool canSuspendTask() const;
+
+    // Promises that host I/O will settle (File.readAsync and friends).
+    // pollIO reaps finished requests, blocking for one when `wait` is set;
+    // interpret() waits on it once no task is runnable.
+    std::unordered_set<ObjPromise *> pendingIO;
+    void (*pollIO)(VM *vm, bool wait) = nullptr;
+
+    // Frozen regions this VM can reach, keyed by root object (Immutable.share).
+    // GC::collect drops the ones the heap no longer references.
+    std::unordered_map<Obj *, std::shared_ptr<SharedRegion>> sharedRegions;
+
     VMValue instantiateClass(VMValue classVal, int argCount, VMValue *args);
 
     InterpretResult interpret(ObjFunction *function);
@@ -64,6 +64,16 @@ std::string VMValue::toString(bool inContainer) const {
         }
         s += "}";
         return s;
+    } else if (this->isSet()) {
+        std::string s = "Set {";
+        auto set = this->asSet();
+        for (size_t i = 0; i < set->entries.size(); ++i) {
+            s += set->entries[i].toString(true);
+            if (i < set->entries.size() - 1)
+                s += ", ";
+        }
+        s += "}";
+        return s;
     } else if (this->isClass()) {
         return "<class " + this->asClass()->name + ">";
     } else if (this->isInstance()) {
@@ -19,6 +19,7 @@ struct ObjBoundMethod;
 struct ObjWeakRef;
 struct ObjUpvalue;
 struct ObjPromise;
+struct ObjSet;
 
 enum class ObjType {
     OBJ_STRING,
@@ -32,13 +33,18 @@ enum class ObjType {
     OBJ_BOUND_METHOD,
     OBJ_WEAK_REF,
     OBJ_UPVALUE,
-    OBJ_PROMISE
+    OBJ_PROMISE,
+    OBJ_SET
 };
 
 struct Obj {
     ObjType type;
     Obj *nextObj;
     bool isMarked;
+    // Deeply frozen: mutating natives and opcodes refuse to change it
+    bool isFrozen = false;
+    // Lives in a SharedRegion referenced by several VMs; never marked or swept
+    bool isShared = false;
 
     Obj(ObjType type);
     virtual ~Obj() = default;
@@ -149,6 +155,13 @@ class VMValue {
         return (ObjMap *)asObj();
     }
 
+    bool isSet() const {
+        return isObj() && asObj()->type == ObjType::OBJ_SET;
+    }
+    ObjSet *asSet() const {
+        return (ObjSet *)asObj();
+    }
+
     bool isClass() const {
         return isObj() && asObj()->type == ObjType::OBJ_CLASS;
     }
@@ -1,12 +1,21 @@
 #include "GC.h"
 #include "../Chunk.h"
 #include "../VM.h"
+#include "../../native/immutable/Immutable.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <unordered_set>
 
 #include <vector>
 
 std::vector<Obj *> grayStack;
 
+// Shared-region objects reached while marking. They are never marked
+// themselves (other VMs may be reading them), so this records which
+// regions the heap still uses.
+static thread_local std::unordered_set<Obj *> reachedShared;
+
 void GC::markValue(VMValue &value) {
     if (value.isObj()) {
         markObj(value.asObj());
@@ -16,6 +25,10 @@ void GC::markValue(VMValue &value) {
 void GC::markObj(Obj *obj) {
     if (obj == nullptr)
         return;
+    if (obj->isShared) {
+        reachedShared.insert(obj);
+        return;
+    }
     if (obj->isMarked)
         return;
     obj->isMarked = true;
@@ -28,7 +41,13 @@ void processGrayStack() {
         grayStack.pop_back();
 
         switch (obj->type) {
-        case ObjType::OBJ_STRING:
+        case ObjType::OBJ_STRING: {
+            // An unflattened rope keeps its halves alive
+            auto str = static_cast<ObjString *>(obj);
+            GC::markObj(str->left);
+            GC::markObj(str->right);
+            break;
+        }
         case ObjType::OBJ_NATIVE:
             break;
         case ObjType::OBJ_FUNCTION: {
@@ -65,6 +84,13 @@ void processGrayStack() {
             }
             break;
         }
+        case ObjType::OBJ_SET: {
+            auto set = static_cast<ObjSet *>(obj);
+            for (auto &v : set->entries) {
+                GC::markValue(v);
+            }
+            break;
+        }
         case ObjType::OBJ_CLASS: {
             auto klass = static_cast<ObjClass *>(obj);
             GC::markObj(klass->superclass);
@@ -85,6 +111,8 @@ void processGrayStack() {
                 VMValue v = pair.second;
                 GC::markValue(v);
             }
+            if (instance->traceFn && instance->nativeData)
+                instance->traceFn(instance->nativeData);
             break;
         }
         case ObjType::OBJ_BOUND_METHOD: {
@@ -126,6 +154,22 @@ void GC::collect(VM *vm) {
         if (frame.closure)
             markObj(frame.closure);
     }
+    for (auto &jitFrame : vm->jitFrames) {
+        markObj(jitFrame.closure);
+        if (!jitFrame.stackMap)
+            continue;
+        for (size_t slot = 0; slot < jitFrame.stackMap->size(); slot++) {
+            if (!(*jitFrame.stackMap)[slot])
+                continue;
+            VMValue v;
+            memcpy(&v, &jitFrame.slots[slot], sizeof(VMValue));
+            markValue(v);
+        }
+    }
+    for (GreenTask *task : vm->liveTasks)
+        markObj(task->handle);
+    for (ObjPromise *promise : vm->pendingIO)
+        markObj(promise);
     ObjUpvalue *upvalue = vm->openUpvalues;
     while (upvalue != nullptr) {
         markObj(upvalue);
@@ -134,6 +178,16 @@ void GC::collect(VM *vm) {
 
     processGrayStack();
 
+    // 1.25 Release shared regions nothing in this heap reaches any more.
+    // A value may hold an inner object of a region without its root.
+    for (auto it = vm->sharedRegions.begin(); it != vm->sharedRegions.end();) {
+        auto &objects = it->second->objects;
+        bool reached = std::any_of(objects.begin(), objects.end(),
+                                   [](Obj *member) { return reachedShared.count(member) != 0; });
+        it = reached ? std::next(it) : vm->sharedRegions.erase(it);
+    }
+    reachedShared.clear();
+
     // 1.5 Handle weak refs
     Obj *obj = vm->objects;
     while (obj != nullptr) {
@@ -1,14 +1,27 @@
 #include "../VM.h"
+#include "GC.h"
 #include "ObjectRuntime.h"
 #include <cmath>
 #include <cstring>
 #include <vector>
 
+// Allocation helpers collect before allocating: every live value is
+// either on the VM stack or in a JIT frame covered by its stack map.
+static inline void collectIfNeeded(VM *vm) {
+    if (vm && vm->bytesAllocated > vm->nextGC)
+        GC::collect(vm);
+}
+
+extern "C" void jit_gc_safepoint_helper(void *vm_ptr) {
+    collectIfNeeded(static_cast<VM *>(vm_ptr));
+}
+
 extern "C" double jit_mod_helper(double a, double b) {
     return std::fmod(a, b);
 }
 
 extern "C" double jit_build_list_helper(double *args, int count) {
+    collectIfNeeded(currentVM);
     std::vector<VMValue> elements(count);
     for (int i = 0; i < count; i++) {
         VMValue val;
@@ -24,6 +37,7 @@ extern "C" double jit_build_list_helper(double *args, int count) {
 }
 
 extern "C" double jit_build_map_helper(double *args, int count) {
+    collectIfNeeded(currentVM);
     ObjMap *map = new ObjMap();
     for (int i = 0; i < count; i++) {
         VMValue key, val;
@@ -60,6 +74,17 @@ extern "C" double jit_index_get_helper(void *vm_ptr, double object_val, double i
                 memcpy(&ret, &result, sizeof(double));
                 return ret;
             }
+        } else if (obj->type == ObjType::OBJ_SET) {
+            ObjSet *set = (ObjSet *)obj;
+            double indexDouble;
+            memcpy(&indexDouble, &index_val, sizeof(double));
+            int i = static_cast<int>(indexDouble);
+            if (i >= 0 && i < static_cast<int>(set->size())) {
+                VMValue result = set->entries[i];
+                double ret;
+                memcpy(&ret, &result, sizeof(double));
+                return ret;
+            }
         }
     }
     double ret = 0;
@@ -77,6 +102,8 @@ extern "C" double jit_index_set_helper(void *vm_ptr, double object_val, double i
 
     if (isObj && isNum) {
         Obj *obj = (Obj *)(uintptr_t)(objRaw & ~(SIGN_BIT | QNAN));
+        if (obj->isFrozen || obj->isShared)
+            static_cast<VM *>(vm_ptr)->jitRuntimeError("Cannot modify a frozen value.");
         if (obj->type == ObjType::OBJ_LIST) {
             ObjList *list = (ObjList *)obj;
             double indexDouble;
@@ -94,6 +121,26 @@ extern "C" double jit_index_set_helper(void *vm_ptr, double object_val, double i
     return ret;
 }
 
+// Methods of primitive receivers live as statics on the String/List/Map/Set classes.
+static bool findPrimitiveMethod(VM *vm, VMValue receiver, const std::string &name, VMValue &method) {
+    const char *className = receiver.isString() ? "String"
+                            : receiver.isList() ? "List"
+                            : receiver.isMap()  ? "Map"
+                            : receiver.isSet()  ? "Set"
+                                                : nullptr;
+    if (!className)
+        return false;
+    auto it = vm->globals.find(className);
+    if (it == vm->globals.end() || !it->second.isClass())
+        return false;
+    ObjClass *klass = it->second.asClass();
+    auto methodIt = klass->statics.find(name);
+    if (methodIt == klass->statics.end())
+        return false;
+    method = methodIt->second;
+    return true;
+}
+
 extern "C" double jit_property_get_helper(void *vm_ptr, double object_val, const char *name) {
     VM *vm = static_cast<VM *>(vm_ptr);
     uint64_t objRaw;
@@ -118,6 +165,12 @@ extern "C" double jit_property_get_helper(void *vm_ptr, double object_val, const
             ObjClass *klass = (ObjClass *)obj;
             if (klass->statics.count(propName))
                 result = klass->statics[propName];
+        } else {
+            VMValue receiver;
+            memcpy(&receiver, &object_val, sizeof(double));
+            VMValue method;
+            if (findPrimitiveMethod(vm, receiver, propName, method))
+                result = new ObjBoundMethod(receiver, method);
         }
     }
     double ret;
@@ -129,11 +182,14 @@ extern "C" double jit_property_set_helper(void *vm_ptr, double object_val, const
     VM *vm = static_cast<VM *>(vm_ptr);
     uint64_t objRaw;
     memcpy(&objRaw, &object_val, sizeof(uint64_t));
-    std::string propName(name);
 
     bool isObj = (objRaw & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT);
     if (isObj) {
         Obj *obj = (Obj *)(uintptr_t)(objRaw & ~(SIGN_BIT | QNAN));
+        // Checked before any locals with destructors exist: the error unwinds past this frame
+        if (obj->type == ObjType::OBJ_INSTANCE && (obj->isFrozen || obj->isShared))
+            vm->jitRuntimeError("Cannot modify a frozen value.");
+        std::string propName(name);
         VMValue val;
         memcpy(&val, &value_val, sizeof(double));
         if (obj->type == ObjType::OBJ_INSTANCE) {
@@ -169,6 +225,8 @@ extern "C" double jit_iter_has_next_helper(double index_val, double iterable_val
         } else if (obj->type == ObjType::OBJ_STRING) {
             ObjString *strObj = (ObjString *)obj;
             result = index < utf8_length(strObj->flatten());
+        } else if (obj->type == ObjType::OBJ_SET) {
+            result = index < static_cast<int>(((ObjSet *)obj)->size());
         }
     }
     VMValue ret(result);
@@ -177,6 +235,29 @@ extern "C" double jit_iter_has_next_helper(double index_val, double iterable_val
     return dret;
 }
 
+// Calls `method` with `receiver` prepended to args[1..argCount].
+static VMValue callMethod(VM *vm, VMValue receiver, VMValue method, double *args, int argCount) {
+    VMValue result = nullptr;
+    std::vector<VMValue> vmArgs(argCount + 1);
+    vmArgs[0] = receiver;
+    for (int i = 0; i < argCount; i++) {
+        memcpy(&vmArgs[i + 1], &args[i + 1], sizeof(double));
+    }
+    if (method.isClosure()) {
+        ObjClosure *savedJitClosure = vm->jitClosure;
+        vm->jitClosure = nullptr;
+        result = vm->callClosure(method, argCount + 1, vmArgs.data());
+        vm->jitClosure = savedJitClosure;
+    } else if (method.isNative()) {
+        // Instance methods expect the receiver at args[-1], primitive ones at args[0]
+        if (receiver.isInstance())
+            result = method.asNative()->function(argCount, vmArgs.data() + 1);
+        else
+            result = method.asNative()->function(argCount + 1, vmArgs.data());
+    }
+    return result;
+}
+
 extern "C" double jit_call_helper(void *vm_ptr, double callee_val, double *args, int argCount) {
     VM *vm = static_cast<VM *>(vm_ptr);
     VMValue result = nullptr;
@@ -203,7 +284,9 @@ extern "C" double jit_call_helper(void *vm_ptr, double callee_val, double *args,
                 std::vector<double> freshArgs(argCount + 1 > 256 ? argCount + 1 : 256);
                 std::memcpy(freshArgs.data(), args, (argCount + 1) * sizeof(double));
                 vm->jitClosure = closure;
+                vm->jitFrames.push_back({closure, freshArgs.data(), &function->jitStackMap});
                 result = nativeJitFunc(vm, freshArgs.data(), argCount, argCount > 0 ? freshArgs[1] : 0.0);
+                vm->jitFrames.pop_back();
                 vm->jitClosure = savedJitClosure;
             } else {
                 std::vector<VMValue> vmArgs(argCount);
@@ -218,26 +301,7 @@ extern "C" double jit_call_helper(void *vm_ptr, double callee_val, double *args,
             }
         } else if (obj->type == ObjType::OBJ_BOUND_METHOD) {
             ObjBoundMethod *bound = (ObjBoundMethod *)obj;
-            VMValue method = bound->method;
-            VMValue receiver = bound->receiver;
-            if (method.isClosure()) {
-                std::vector<VMValue> vmArgs(argCount + 1);
-                vmArgs[0] = receiver;
-                for (int i = 0; i < argCount; i++) {
-                    memcpy(&vmArgs[i + 1], &args[i + 1], sizeof(double));
-                }
-                vm->jitClosure = nullptr;
-                result = vm->callClosure(method, argCount + 1, vmArgs.data());
-                vm->jitClosure = savedJitClosure;
-            } else if (method.isNative()) {
-                ObjNative *native = method.asNative();
-                std::vector<VMValue> vmArgs(argCount + 1);
-                vmArgs[0] = receiver;
-                for (int i = 0; i < argCount; i++) {
-                    memcpy(&vmArgs[i + 1], &args[i + 1], sizeof(double));
-                }
-                result = native->function(argCount + 1, vmArgs.data());
-            }
+            result = callMethod(vm, bound->receiver, bound->method, args, argCount);
         } else if (obj->type == ObjType::OBJ_CLASS) {
             VMValue classVal;
             memcpy(&classVal, &callee_val, sizeof(double));
@@ -256,13 +320,54 @@ extern "C" double jit_call_helper(void *vm_ptr, double callee_val, double *args,
     return ret;
 }
 
-extern "C" void *jit_resolve_global_address(void *vm_ptr, const char *name, VMValue **cell) {
+// receiver.name(args...) without materializing the ObjBoundMethod.
+// slots[0] holds the receiver, slots[1..argCount] the arguments.
+extern "C" double jit_invoke_helper(void *vm_ptr, double *slots, const char *name, int argCount) {
+    VM *vm = static_cast<VM *>(vm_ptr);
+    VMValue receiver;
+    memcpy(&receiver, &slots[0], sizeof(double));
+    std::string methodName(name);
+    VMValue result = nullptr;
+
+    if (receiver.isInstance()) {
+        ObjInstance *instance = receiver.asInstance();
+        auto field = instance->fields.find(methodName);
+        if (field != instance->fields.end()) {
+            double callee;
+            memcpy(&callee, &field->second, sizeof(double));
+            return jit_call_helper(vm_ptr, callee, slots, argCount);
+        }
+        auto method = instance->klass->methods.find(methodName);
+        if (method != instance->klass->methods.end())
+            result = callMethod(vm, receiver, method->second, slots, argCount);
+    } else if (receiver.isClass()) {
+        ObjClass *klass = receiver.asClass();
+        auto member = klass->statics.find(methodName);
+        if (member != klass->statics.end()) {
+            double callee;
+            memcpy(&callee, &member->second, sizeof(double));
+            return jit_call_helper(vm_ptr, callee, slots, argCount);
+        }
+    } else {
+        VMValue method;
+        if (findPrimitiveMethod(vm, receiver, methodName, method))
+            result = callMethod(vm, receiver, method, slots, argCount);
+    }
+
+    double ret;
+    memcpy(&ret, &result, sizeof(double));
+    return ret;
+}
+
+extern "C" void *jit_resolve_global_address(void *vm_ptr, const char *name, JitGlobalCell *cell) {
     VM *vm = static_cast<VM *>(vm_ptr);
-    // std::map::operator[] or find is stable for pointers to values.
+    // unordered_map nodes are pointer-stable until erased; VM::eraseGlobal
+    // bumps the epoch so cached cells are revalidated.
     // We use find to avoid inserting nulls if not found.
     auto it = vm->globals.find(name);
     if (it != vm->globals.end()) {
-        *cell = &(it->second);
+        cell->slot = &(it->second);
+        cell->epoch = vm->globalsEpoch;
         return (void *)&(it->second);
     }
     // Return address of a dummy null if not found
@@ -282,14 +387,20 @@ extern "C" double jit_get_global_helper(void *vm_ptr, const char *name) {
     return ret;
 }
 
-extern "C" void jit_set_global_helper(void *vm_ptr, const char *name, double val_d) {
+extern "C" void jit_set_global_helper(void *vm_ptr, const char *name, double val_d, JitGlobalCell *cell) {
     VM *vm = static_cast<VM *>(vm_ptr);
     VMValue val;
     memcpy(&val, &val_d, sizeof(double));
-    vm->globals[name] = val;
+    VMValue &slot = vm->globals[name];
+    slot = val;
+    if (cell) {
+        cell->slot = &slot;
+        cell->epoch = vm->globalsEpoch;
+    }
 }
 
 extern "C" double jit_create_class_helper(void *vm, const char *name) {
+    collectIfNeeded(static_cast<VM *>(vm));
     auto klass = new ObjClass(name);
 
     VMValue result(klass);
@@ -299,6 +410,7 @@ extern "C" double jit_create_class_helper(void *vm, const char *name) {
 }
 
 extern "C" double jit_create_abstract_class_helper(void *vm, const char *name) {
+    collectIfNeeded(static_cast<VM *>(vm));
     auto klass = new ObjClass(name);
     klass->isAbstract = true;
 
@@ -420,6 +532,7 @@ extern "C" void jit_field_modifier_helper(double class_val, const char *name, in
 
 extern "C" double jit_create_closure_helper(void *vm_ptr, double func_val, double *upvalue_data, int upvalue_count) {
     VM *vm = static_cast<VM *>(vm_ptr);
+    collectIfNeeded(vm);
     uint64_t funcRaw;
     memcpy(&funcRaw, &func_val, sizeof(uint64_t));
     ObjFunction *function;
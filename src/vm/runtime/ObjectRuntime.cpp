@@ -196,3 +196,9 @@ void VM::closeUpvalues(VMValue *last) {
 void VM::defineNative(const std::string &name, int arity, NativeFn function) {
     globals[name] = new ObjNative(name, arity, function);
 }
+
+void VM::eraseGlobal(const std::string &name) {
+    // Erasing frees the map node, so JIT global caches pointing at it go stale
+    if (globals.erase(name))
+        globalsEpoch++;
+}
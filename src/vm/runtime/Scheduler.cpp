@@ -0,0 +1,148 @@
+#include "../VM.h"
+
+#include <algorithm>
+
+void VM::spawnTask(GreenTask *task) {
+    task->liveIndex = liveTasks.size();
+    liveTasks.push_back(task);
+    runQueue.push_back(task);
+}
+
+bool VM::canSuspendTask() const {
+    // Only a call made directly from the task's own run loop can be parked:
+    // nested runs (callbacks from natives) and JIT frames live on the C stack.
+    return currentTask && taskSafePoint && jitFrames.size() == taskJitBase;
+}
+
+void VM::finishTask(GreenTask *task, VMValue result, bool failed) {
+    task->done = true;
+    task->failed = failed;
+    task->result = result;
+    task->fn = nullptr;
+    task->stack = std::vector<VMValue>();
+    task->frames = std::vector<CallFrame>();
+
+    GreenTask *last = liveTasks.back();
+    liveTasks[task->liveIndex] = last;
+    last->liveIndex = task->liveIndex;
+    liveTasks.pop_back();
+
+    for (GreenTask *joiner : task->joiners) {
+        joiner->waitingOn = nullptr;
+        joiner->stack.back() = result; // the nil pushed by join()
+        runQueue.push_back(joiner);
+    }
+    task->joiners.clear();
+}
+
+void VM::resumeTask(GreenTask *task) {
+    GreenTask *outerTask = currentTask;
+    size_t outerJitBase = taskJitBase;
+    bool outerCatch = catchJumpEnabled;
+    // A failing task must not unwind into a catch handler armed outside it.
+    catchJumpEnabled = false;
+
+    int base = static_cast<int>(stackTop - stack);
+    int depth = static_cast<int>(frames.size());
+    currentTask = task;
+    taskJitBase = jitFrames.size();
+    taskBudget = TASK_TIME_SLICE;
+    taskSafePoint = false;
+
+    InterpretResult result = InterpretResult::INTERPRET_OK;
+    if (!task->started) {
+        task->started = true;
+        push(task->fn);
+        for (auto &arg : task->args)
+            push(arg);
+        int argCount = static_cast<int>(task->args.size());
+        task->args.clear();
+        if (!executeCall(static_cast<uint8_t>(argCount)))
+            result = InterpretResult::INTERPRET_RUNTIME_ERROR;
+        else if (static_cast<int>(frames.size()) > depth) {
+            enteringTaskRun = true;
+            result = run(depth);
+        }
+    } else {
+        std::copy(task->stack.begin(), task->stack.end(), stackTop);
+        VMValue *segment = stackTop;
+        if (task->openUpvalues) {
+            ObjUpvalue *tail = task->openUpvalues;
+            for (ObjUpvalue *up = task->openUpvalues; up; up = up->next) {
+                up->location = segment + (up->location - task->stack.data());
+                tail = up;
+            }
+            tail->next = openUpvalues;
+            openUpvalues = task->openUpvalues;
+            task->openUpvalues = nullptr;
+        }
+        stackTop += task->stack.size();
+        task->stack.clear();
+        for (CallFrame frame : task->frames) {
+            frame.stackStart += base;
+            frames.push_back(frame);
+        }
+        task->frames.clear();
+        enteringTaskRun = true;
+        result = run(depth);
+    }
+
+    currentTask = outerTask;
+    taskJitBase = outerJitBase;
+    catchJumpEnabled = outerCatch;
+    taskSafePoint = false;
+    taskSwitchPending = false;
+
+    if (result == InterpretResult::INTERPRET_RUNTIME_ERROR) {
+        closeUpvalues(stack + base);
+        frames.resize(depth);
+        jitFrames.resize(taskJitBase);
+        stackTop = stack + base;
+        finishTask(task, nullptr, true);
+        return;
+    }
+    if (static_cast<int>(frames.size()) == depth) {
+        VMValue value = pop();
+        stackTop = stack + base;
+        finishTask(task, value, false);
+        return;
+    }
+
+    // Suspended: move the task's slice of the stack, its frames and the
+    // upvalues still open over them out of the VM.
+    VMValue *segment = stack + base;
+    task->stack.assign(segment, stackTop);
+    ObjUpvalue **tail = &task->openUpvalues;
+    while (openUpvalues != nullptr && openUpvalues->location >= segment) {
+        ObjUpvalue *up = openUpvalues;
+        openUpvalues = up->next;
+        up->location = task->stack.data() + (up->location - segment);
+        up->next = nullptr;
+        *tail = up;
+        tail = &up->next;
+    }
+    task->frames.assign(frames.begin() + depth, frames.end());
+    for (auto &frame : task->frames)
+        frame.stackStart -= base;
+    frames.resize(depth);
+    stackTop = segment;
+
+    if (!task->waitingOn)
+        runQueue.push_back(task);
+}
+
+void VM::runTasks(GreenTask *until) {
+    while (!runQueue.empty() && !(until && until->done)) {
+        GreenTask *task = runQueue.front();
+        runQueue.pop_front();
+        resumeTask(task);
+    }
+}
+
+void VM::runTaskRound() {
+    for (size_t n = runQueue.size(); n > 0 && !runQueue.empty(); n--) {
+        GreenTask *task = runQueue.front();
+        runQueue.pop_front();
+        resumeTask(task);
+    }
+}
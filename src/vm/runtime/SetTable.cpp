@@ -0,0 +1,133 @@
+#include "../VM.h"
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+uint32_t mixBits(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<uint32_t>(x);
+}
+
+// Strings hash by content and numbers by value (0 and -0 agree); every
+// other member hashes and compares by identity, as map keys do.
+uint32_t hashMember(VMValue value) {
+    if (value.isNumber()) {
+        double d = value.asNumber();
+        if (d == 0)
+            d = 0;
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        return mixBits(bits);
+    }
+    if (value.isString())
+        return static_cast<uint32_t>(std::hash<std::string_view>{}(value.asString()->flatView()));
+    return mixBits(value.getRaw());
+}
+
+bool sameMember(VMValue a, VMValue b) {
+    if (a.isNumber() && b.isNumber())
+        return a.asNumber() == b.asNumber();
+    if (a.isString() && b.isString()) {
+        ObjString *x = a.asString();
+        ObjString *y = b.asString();
+        return x == y || (x->length == y->length && x->flatView() == y->flatView());
+    }
+    return a.getRaw() == b.getRaw();
+}
+
+} // namespace
+
+size_t ObjSet::probe(VMValue value, uint32_t hash) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t slot = slots[i];
+        if (slot == 0 || (hashes[slot - 1] == hash && sameMember(entries[slot - 1], value)))
+            return i;
+    }
+}
+
+void ObjSet::rebuild(size_t capacity) {
+    slots.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t k = 0; k < entries.size(); k++) {
+        size_t i = hashes[k] & mask;
+        while (slots[i] != 0)
+            i = (i + 1) & mask;
+        slots[i] = static_cast<uint32_t>(k + 1);
+    }
+}
+
+void ObjSet::reserve(size_t count) {
+    size_t capacity = slots.empty() ? 8 : slots.size();
+    while (capacity < count * 2)
+        capacity *= 2;
+    entries.reserve(count);
+    hashes.reserve(count);
+    if (capacity != slots.size())
+        rebuild(capacity);
+}
+
+bool ObjSet::contains(VMValue value) const {
+    if (entries.empty())
+        return false;
+    return slots[probe(value, hashMember(value))] != 0;
+}
+
+bool ObjSet::insert(VMValue value) {
+    if ((entries.size() + 1) * 2 > slots.size())
+        reserve(entries.size() + 1);
+    uint32_t hash = hashMember(value);
+    size_t i = probe(value, hash);
+    if (slots[i] != 0)
+        return false;
+    entries.push_back(value);
+    hashes.push_back(hash);
+    slots[i] = static_cast<uint32_t>(entries.size());
+    return true;
+}
+
+bool ObjSet::erase(VMValue value) {
+    if (entries.empty())
+        return false;
+    size_t mask = slots.size() - 1;
+    size_t hole = probe(value, hashMember(value));
+    if (slots[hole] == 0)
+        return false;
+    size_t index = slots[hole] - 1;
+
+    // Backward-shift deletion: pull later members of the probe chain into
+    // the hole when that does not move them before their home slot.
+    slots[hole] = 0;
+    for (size_t j = (hole + 1) & mask; slots[j] != 0; j = (j + 1) & mask) {
+        size_t home = hashes[slots[j] - 1] & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            slots[hole] = slots[j];
+            slots[j] = 0;
+            hole = j;
+        }
+    }
+
+    size_t last = entries.size() - 1;
+    if (index != last) {
+        size_t i = hashes[last] & mask;
+        while (slots[i] != last + 1)
+            i = (i + 1) & mask;
+        slots[i] = static_cast<uint32_t>(index + 1);
+        entries[index] = entries[last];
+        hashes[index] = hashes[last];
+    }
+    entries.pop_back();
+    hashes.pop_back();
+    return true;
+}
+
+void ObjSet::clear() {
+    entries.clear();
+    hashes.clear();
+    slots.clear();
+}
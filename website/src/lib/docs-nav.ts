@@ -70,9 +70,52 @@ export const modules: ModuleEntry[] = [
 			{ name: 'sin', label: 'sin()', summary: 'Синус кута в радіанах.' },
 			{ name: 'cos', label: 'cos()', summary: 'Косинус кута в радіанах.' },
 			{ name: 'random', label: 'random()', summary: 'Випадкове число від 0 до 1.' },
+			{ name: 'sqrt', label: 'sqrt()', summary: 'Квадратний корінь.' },
+			{ name: 'abs', label: 'abs()', summary: 'Модуль числа.' },
+			{ name: 'floor', label: 'floor()', summary: 'Округлення вниз.' },
+			{ name: 'ceil', label: 'ceil()', summary: 'Округлення вгору.' },
+			{ name: 'min', label: 'min()', summary: 'Менше з двох чисел.' },
+			{ name: 'max', label: 'max()', summary: 'Більше з двох чисел.' },
+			{ name: 'pow', label: 'pow()', summary: 'Піднесення до степеня.' },
+			{ name: 'exp', label: 'exp()', summary: 'Експонента.' },
+			{ name: 'log', label: 'log()', summary: 'Натуральний логарифм.' },
+			{ name: 'atan2', label: 'atan2()', summary: 'Кут до точки (x, y).' },
+			{ name: 'fma', label: 'fma()', summary: 'a * b + c з одним округленням.' },
+			{ name: 'map', label: 'map()', summary: 'Числова операція над усім списком.' },
 			{ name: 'PI', label: 'PI', summary: 'Константа числа Пі.' }
 		]
 	},
+	{
+		slug: 'NDArray',
+		title: 'NDArray',
+		description: 'Багатовимірні числові масиви та лінійна алгебра.',
+		methods: [
+			{ name: 'fromList', label: 'fromList()', summary: 'Масив із вкладеного списку.' },
+			{ name: 'zeros', label: 'zeros()', summary: 'Масив нулів.' },
+			{ name: 'ones', label: 'ones()', summary: 'Масив одиниць.' },
+			{ name: 'full', label: 'full()', summary: 'Масив з одним значенням.' },
+			{ name: 'arange', label: 'arange()', summary: 'Послідовність чисел.' },
+			{ name: 'shape', label: 'shape()', summary: 'Форма масиву.' },
+			{ name: 'ndim', label: 'ndim()', summary: 'Кількість вимірів.' },
+			{ name: 'size', label: 'size()', summary: 'Кількість елементів.' },
+			{ name: 'get', label: 'get()', summary: 'Читання елемента.' },
+			{ name: 'set', label: 'set()', summary: 'Запис елемента.' },
+			{ name: 'toList', label: 'toList()', summary: 'Експорт у список.' },
+			{ name: 'add', label: 'add()', summary: 'Поелементне додавання.' },
+			{ name: 'sub', label: 'sub()', summary: 'Поелементне віднімання.' },
+			{ name: 'mul', label: 'mul()', summary: 'Поелементне множення.' },
+			{ name: 'div', label: 'div()', summary: 'Поелементне ділення.' },
+			{ name: 'sum', label: 'sum()', summary: 'Сума елементів.' },
+			{ name: 'mean', label: 'mean()', summary: 'Середнє значення.' },
+			{ name: 'min', label: 'min()', summary: 'Мінімум.' },
+			{ name: 'max', label: 'max()', summary: 'Максимум.' },
+			{ name: 'matmul', label: 'matmul()', summary: 'Матричний добуток.' },
+			{ name: 'transpose', label: 'transpose()', summary: 'Транспонування без копіювання.' },
+			{ name: 'slice', label: 'slice()', summary: 'Зріз без копіювання.' },
+			{ name: 'reshape', label: 'reshape()', summary: 'Зміна форми.' },
+			{ name: 'copy', label: 'copy()', summary: 'Суцільна копія.' }
+		]
+	},
 	{
 		slug: 'String',
 		title: 'String',
@@ -84,12 +127,15 @@ export const modules: ModuleEntry[] = [
 			{ name: 'toLower', label: 'toLower()', summary: 'Переводить рядок у нижній регістр.' },
 			{ name: 'trim', label: 'trim()', summary: 'Видаляє пробіли з країв.' },
 			{ name: 'split', label: 'split()', summary: 'Розбиває рядок на список за роздільником.' },
+			{ name: 'splitLimit', label: 'splitLimit()', summary: 'Розбиває рядок на обмежену кількість частин.' },
 			{ name: 'replace', label: 'replace()', summary: 'Замінює всі входження підрядка.' },
+			{ name: 'replaceAll', label: 'replaceAll()', summary: 'Замінює всі входження за один прохід.' },
 			{ name: 'indexOf', label: 'indexOf()', summary: 'Індекс першого входження підрядка.' },
 			{ name: 'includes', label: 'includes()', summary: 'Чи містить рядок підрядок.' },
 			{ name: 'startsWith', label: 'startsWith()', summary: 'Чи починається рядок із префікса.' },
 			{ name: 'endsWith', label: 'endsWith()', summary: 'Чи закінчується рядок суфіксом.' },
-			{ name: 'toNumber', label: 'toNumber()', summary: 'Перетворює рядок на число.' }
+			{ name: 'toNumber', label: 'toNumber()', summary: 'Перетворює рядок на число.' },
+			{ name: 'isValidUtf8', label: 'isValidUtf8()', summary: 'Чи є рядок коректним UTF-8.' }
 		]
 	},
 	{
@@ -121,6 +167,54 @@ export const modules: ModuleEntry[] = [
 			{ name: 'set', label: 'set()', summary: 'Встановлює значення за ключем.' }
 		]
 	},
+	{
+		slug: 'Set',
+		title: 'Set',
+		description: 'Множини з швидкою перевіркою належності та операціями над множинами.',
+		methods: [
+			{ name: 'create', label: 'create()', summary: 'Створює множину.' },
+			{ name: 'size', label: 'size()', summary: 'Кількість елементів.' },
+			{ name: 'has', label: 'has()', summary: 'Чи належить значення множині.' },
+			{ name: 'add', label: 'add()', summary: 'Додає значення.' },
+			{ name: 'remove', label: 'remove()', summary: 'Видаляє значення.' },
+			{ name: 'clear', label: 'clear()', summary: 'Видаляє всі елементи.' },
+			{ name: 'toList', label: 'toList()', summary: 'Елементи списком.' },
+			{ name: 'union', label: 'union()', summary: 'Об\'єднання.' },
+			{ name: 'intersection', label: 'intersection()', summary: 'Перетин.' },
+			{ name: 'difference', label: 'difference()', summary: 'Різниця.' },
+			{ name: 'isSubset', label: 'isSubset()', summary: 'Чи є підмножиною.' }
+		]
+	},
+	{
+		slug: 'Deque',
+		title: 'Deque',
+		description: 'Двостороння черга на кільцевому буфері.',
+		methods: [
+			{ name: 'create', label: 'create()', summary: 'Створює чергу.' },
+			{ name: 'pushBack', label: 'pushBack()', summary: 'Додає в кінець.' },
+			{ name: 'pushFront', label: 'pushFront()', summary: 'Додає на початок.' },
+			{ name: 'popBack', label: 'popBack()', summary: 'Забирає з кінця.' },
+			{ name: 'popFront', label: 'popFront()', summary: 'Забирає з початку.' },
+			{ name: 'peekFront', label: 'peekFront()', summary: 'Перше значення.' },
+			{ name: 'peekBack', label: 'peekBack()', summary: 'Останнє значення.' },
+			{ name: 'get', label: 'get()', summary: 'Значення за позицією.' },
+			{ name: 'size', label: 'size()', summary: 'Кількість значень.' },
+			{ name: 'clear', label: 'clear()', summary: 'Очищає чергу.' },
+			{ name: 'toList', label: 'toList()', summary: 'Вміст списком.' }
+		]
+	},
+	{
+		slug: 'PriorityQueue',
+		title: 'PriorityQueue',
+		description: 'Черга з пріоритетами на купі.',
+		methods: [
+			{ name: 'create', label: 'create()', summary: 'Створює чергу.' },
+			{ name: 'push', label: 'push()', summary: 'Додає значення.' },
+			{ name: 'pop', label: 'pop()', summary: 'Забирає наступне значення.' },
+			{ name: 'peek', label: 'peek()', summary: 'Наступне значення.' },
+			{ name: 'size', label: 'size()', summary: 'Кількість значень.' }
+		]
+	},
 	{
 		slug: 'Time',
 		title: 'Time',
@@ -186,7 +280,88 @@ export const modules: ModuleEntry[] = [
 		description: 'Серіалізація та розбір JSON.',
 		methods: [
 			{ name: 'stringify', label: 'stringify()', summary: 'Перетворює значення на рядок JSON.' },
-			{ name: 'parse', label: 'parse()', summary: 'Розбирає рядок JSON у значення.' }
+			{ name: 'parse', label: 'parse()', summary: 'Розбирає рядок JSON у значення.' },
+			{ name: 'parseAs', label: 'parseAs()', summary: 'Розбирає JSON в екземпляр класу.' },
+			{ name: 'parseListAs', label: 'parseListAs()', summary: 'Розбирає масив JSON у список екземплярів.' }
+		]
+	},
+	{
+		slug: 'Csv',
+		title: 'Csv',
+		description: 'Потокове читання та запис CSV (RFC 4180).',
+		methods: [
+			{ name: 'open', label: 'open()', summary: 'Відкриває файл для читання.' },
+			{ name: 'fromString', label: 'fromString()', summary: 'Читач над рядком.' },
+			{ name: 'parse', label: 'parse()', summary: 'Розбирає рядок CSV.' },
+			{ name: 'stringify', label: 'stringify()', summary: 'Форматує рядки в CSV.' },
+			{ name: 'writer', label: 'writer()', summary: 'Створює запис у файл.' }
+		]
+	},
+	{
+		slug: 'CsvReader',
+		title: 'CsvReader',
+		description: 'Потоковий читач CSV.',
+		methods: [
+			{ name: 'next', label: 'next()', summary: 'Наступний запис.' },
+			{ name: 'readAll', label: 'readAll()', summary: 'Усі записи, що залишилися.' },
+			{ name: 'headers', label: 'headers()', summary: 'Назви колонок.' },
+			{ name: 'close', label: 'close()', summary: 'Закриває читача.' }
+		]
+	},
+	{
+		slug: 'CsvWriter',
+		title: 'CsvWriter',
+		description: 'Буферизований запис CSV.',
+		methods: [
+			{ name: 'write', label: 'write()', summary: 'Записує рядок.' },
+			{ name: 'flush', label: 'flush()', summary: 'Скидає буфер.' },
+			{ name: 'close', label: 'close()', summary: 'Закриває файл.' }
+		]
+	},
+	{
+		slug: 'MsgPack',
+		title: 'MsgPack',
+		description: 'Двійкова серіалізація MessagePack.',
+		methods: [
+			{ name: 'encode', label: 'encode()', summary: 'Кодує значення.' },
+			{ name: 'decode', label: 'decode()', summary: 'Декодує значення.' },
+			{ name: 'decoder', label: 'decoder()', summary: 'Потоковий декодер.' }
+		]
+	},
+	{
+		slug: 'MsgPackDecoder',
+		title: 'MsgPackDecoder',
+		description: 'Потоковий декодер MessagePack.',
+		methods: [
+			{ name: 'feed', label: 'feed()', summary: 'Додає байти.' },
+			{ name: 'pending', label: 'pending()', summary: 'Байти в буфері.' }
+		]
+	},
+	{
+		slug: 'Compress',
+		title: 'Compress',
+		description: 'Стиснення LZ4, DEFLATE і gzip.',
+		methods: [
+			{ name: 'lz4', label: 'lz4()', summary: 'Стискає у кадр LZ4.' },
+			{ name: 'unlz4', label: 'unlz4()', summary: 'Розпаковує кадри LZ4.' },
+			{ name: 'lz4Block', label: 'lz4Block()', summary: 'Стискає сирий блок.' },
+			{ name: 'unlz4Block', label: 'unlz4Block()', summary: 'Розпаковує сирий блок.' },
+			{ name: 'deflate', label: 'deflate()', summary: 'Стискає DEFLATE.' },
+			{ name: 'inflate', label: 'inflate()', summary: 'Розпаковує DEFLATE.' },
+			{ name: 'gzip', label: 'gzip()', summary: 'Стискає gzip.' },
+			{ name: 'gunzip', label: 'gunzip()', summary: 'Розпаковує gzip.' },
+			{ name: 'crc32', label: 'crc32()', summary: 'Контрольна сума CRC-32.' },
+			{ name: 'stream', label: 'stream()', summary: 'Потоковий компресор.' }
+		]
+	},
+	{
+		slug: 'CompressStream',
+		title: 'CompressStream',
+		description: 'Потоковий компресор.',
+		methods: [
+			{ name: 'write', label: 'write()', summary: 'Стискає частину даних.' },
+			{ name: 'flush', label: 'flush()', summary: 'Скидає буфер.' },
+			{ name: 'finish', label: 'finish()', summary: 'Завершує потік.' }
 		]
 	},
 	{
@@ -199,7 +374,71 @@ export const modules: ModuleEntry[] = [
 			{ name: 'remove', label: 'remove()', summary: 'Видаляє файл.' },
 			{ name: 'read', label: 'read()', summary: 'Читає вміст файлу.' },
 			{ name: 'write', label: 'write()', summary: 'Записує вміст у файл.' },
-			{ name: 'close', label: 'close()', summary: 'Закриває файл.' }
+			{ name: 'close', label: 'close()', summary: 'Закриває файл.' },
+			{ name: 'copyTo', label: 'copyTo()', summary: 'Надсилає файл у сокет.' },
+			{ name: 'readAsync', label: 'readAsync()', summary: 'Асинхронно читає файл.' },
+			{ name: 'readManyAsync', label: 'readManyAsync()', summary: 'Читає багато файлів пакетом.' },
+			{ name: 'readAtAsync', label: 'readAtAsync()', summary: 'Асинхронно читає діапазон.' },
+			{ name: 'writeAsync', label: 'writeAsync()', summary: 'Асинхронно записує файл.' },
+			{ name: 'fsyncAsync', label: 'fsyncAsync()', summary: 'Асинхронний fsync.' },
+			{ name: 'await', label: 'await()', summary: 'Чекає на асинхронний запит.' },
+			{ name: 'asyncBackend', label: 'asyncBackend()', summary: 'Механізм асинхронного I/O.' }
+		]
+	},
+	{
+		slug: 'FS',
+		title: 'FS',
+		description: 'Каталоги, метадані, обхід дерев і стеження за змінами файлів.',
+		methods: [
+			{ name: 'list', label: 'list()', summary: 'Вміст каталогу.' },
+			{ name: 'stat', label: 'stat()', summary: 'Метадані файлу.' },
+			{ name: 'walk', label: 'walk()', summary: 'Паралельний обхід дерева.' },
+			{ name: 'watch', label: 'watch()', summary: 'Сповіщення про зміни файлів.' },
+			{ name: 'follow', label: 'follow()', summary: 'Стеження за дописаними рядками.' }
+		]
+	},
+	{
+		slug: 'FSWalk',
+		title: 'FSWalk',
+		description: 'Потік записів від FS.walk().',
+		methods: [
+			{ name: 'next', label: 'next()', summary: 'Наступний запис.' },
+			{ name: 'readAll', label: 'readAll()', summary: 'Усі записи.' },
+			{ name: 'close', label: 'close()', summary: 'Зупиняє обхід.' }
+		]
+	},
+	{
+		slug: 'FSWatcher',
+		title: 'FSWatcher',
+		description: 'Події змін файлів від FS.watch().',
+		methods: [
+			{ name: 'next', label: 'next()', summary: 'Наступна подія.' },
+			{ name: 'nextAsync', label: 'nextAsync()', summary: 'Події через цикл подій.' },
+			{ name: 'close', label: 'close()', summary: 'Припиняє стеження.' }
+		]
+	},
+	{
+		slug: 'FSFollower',
+		title: 'FSFollower',
+		description: 'Рядки, дописані у файл, від FS.follow().',
+		methods: [
+			{ name: 'next', label: 'next()', summary: 'Наступний рядок.' },
+			{ name: 'close', label: 'close()', summary: 'Припиняє стеження.' }
+		]
+	},
+	{
+		slug: 'Log',
+		title: 'Log',
+		description: 'Асинхронне структуроване логування з фоновим записом.',
+		methods: [
+			{ name: 'debug', label: 'debug()', summary: 'Запис рівня debug.' },
+			{ name: 'info', label: 'info()', summary: 'Запис рівня info.' },
+			{ name: 'warn', label: 'warn()', summary: 'Запис рівня warn.' },
+			{ name: 'error', label: 'error()', summary: 'Запис рівня error.' },
+			{ name: 'enabled', label: 'enabled()', summary: 'Чи ввімкнений рівень.' },
+			{ name: 'configure', label: 'configure()', summary: 'Налаштування логування.' },
+			{ name: 'flush', label: 'flush()', summary: 'Дописує чергу.' },
+			{ name: 'stats', label: 'stats()', summary: 'Лічильники записів.' }
 		]
 	},
 	{
@@ -214,14 +453,47 @@ export const modules: ModuleEntry[] = [
 	{
 		slug: 'Socket',
 		title: 'Socket',
-		description: 'TCP-зʼєднання (клієнт і сервер).',
+		description: 'TCP- і Unix-зʼєднання (клієнт і сервер).',
 		methods: [
 			{ name: 'connect', label: 'connect()', summary: 'Підключається до хоста та порту.' },
 			{ name: 'listen', label: 'listen()', summary: 'Слухає вхідні зʼєднання на порту.' },
 			{ name: 'accept', label: 'accept()', summary: 'Приймає вхідне зʼєднання.' },
 			{ name: 'send', label: 'send()', summary: 'Надсилає дані.' },
 			{ name: 'recv', label: 'recv()', summary: 'Отримує дані.' },
-			{ name: 'close', label: 'close()', summary: 'Закриває зʼєднання.' }
+			{ name: 'close', label: 'close()', summary: 'Закриває зʼєднання.' },
+			{ name: 'connectUnix', label: 'connectUnix()', summary: 'Підключається до Unix-сокета.' },
+			{ name: 'listenUnix', label: 'listenUnix()', summary: 'Слухає Unix-сокет.' },
+			{ name: 'setBlocking', label: 'setBlocking()', summary: 'Режим блокування.' },
+			{ name: 'fd', label: 'fd()', summary: 'Дескриптор сокета.' },
+			{ name: 'readLine', label: 'readLine()', summary: 'Читає рядок.' },
+			{ name: 'readUntil', label: 'readUntil()', summary: 'Читає до роздільника.' },
+			{ name: 'readExactly', label: 'readExactly()', summary: 'Читає n байтів.' },
+			{ name: 'readAvailable', label: 'readAvailable()', summary: 'Читає наявні дані.' },
+			{ name: 'listenTls', label: 'listenTls()', summary: 'Слухає порт із TLS.' },
+			{ name: 'handshake', label: 'handshake()', summary: 'Виконує TLS-рукостискання.' },
+			{ name: 'alpn', label: 'alpn()', summary: 'Узгоджений протокол ALPN.' },
+			{ name: 'sendFile', label: 'sendFile()', summary: 'Надсилає файл без копіювання.' },
+			{ name: 'localAddress', label: 'localAddress()', summary: 'Локальна адреса.' }
+		]
+	},
+	{
+		slug: 'Datagram',
+		title: 'Datagram',
+		description: 'UDP і Unix-датаграмні сокети з пакетним обміном.',
+		methods: [
+			{ name: 'udp', label: 'udp()', summary: 'Створює UDP-сокет.' },
+			{ name: 'unix', label: 'unix()', summary: 'Створює Unix-датаграмний сокет.' },
+			{ name: 'connect', label: 'connect()', summary: 'Задає адресата.' },
+			{ name: 'send', label: 'send()', summary: 'Надсилає датаграму.' },
+			{ name: 'sendTo', label: 'sendTo()', summary: 'Надсилає на адресу.' },
+			{ name: 'recv', label: 'recv()', summary: 'Отримує датаграму.' },
+			{ name: 'recvFrom', label: 'recvFrom()', summary: 'Отримує з адресою.' },
+			{ name: 'sendBatch', label: 'sendBatch()', summary: 'Надсилає пакет датаграм.' },
+			{ name: 'recvBatch', label: 'recvBatch()', summary: 'Отримує пакет датаграм.' },
+			{ name: 'localAddress', label: 'localAddress()', summary: 'Локальна адреса.' },
+			{ name: 'setBlocking', label: 'setBlocking()', summary: 'Режим блокування.' },
+			{ name: 'fd', label: 'fd()', summary: 'Дескриптор сокета.' },
+			{ name: 'close', label: 'close()', summary: 'Закриває сокет.' }
 		]
 	},
 	{
@@ -255,6 +527,54 @@ export const modules: ModuleEntry[] = [
 			{ name: 'selfReceive', label: 'selfReceive()', summary: 'Отримує повідомлення в воркері з головного потоку.' }
 		]
 	},
+	{
+		slug: 'Task',
+		title: 'Task',
+		description: 'Легкі зелені потоки всередині однієї VM.',
+		methods: [
+			{ name: 'spawn', label: 'spawn()', summary: 'Запускає функцію як окрему задачу.' },
+			{ name: 'yield', label: 'yield()', summary: 'Поступається виконанням іншим задачам.' },
+			{ name: 'pending', label: 'pending()', summary: 'Кількість незавершених задач.' },
+			{ name: 'join', label: 'join()', summary: 'Чекає на результат задачі.' },
+			{ name: 'done', label: 'done()', summary: 'Чи завершилася задача.' },
+			{ name: 'failed', label: 'failed()', summary: 'Чи завершилася задача помилкою.' }
+		]
+	},
+	{
+		slug: 'SharedArrayBuffer',
+		title: 'SharedArrayBuffer',
+		description: 'Спільна памʼять між воркерами без копіювання.',
+		methods: [
+			{ name: 'create', label: 'create()', summary: 'Створює спільний байтовий буфер.' },
+			{ name: 'byteLength', label: 'byteLength()', summary: 'Розмір буфера в байтах.' },
+			{ name: 'get', label: 'get()', summary: 'Читає байт.' },
+			{ name: 'set', label: 'set()', summary: 'Записує байт.' }
+		]
+	},
+	{
+		slug: 'Atomics',
+		title: 'Atomics',
+		description: 'Атомарні операції та очікування на спільній памʼяті.',
+		methods: [
+			{ name: 'read', label: 'read()', summary: 'Атомарно читає комірку.' },
+			{ name: 'write', label: 'write()', summary: 'Атомарно записує комірку.' },
+			{ name: 'add', label: 'add()', summary: 'Атомарно додає до комірки.' },
+			{ name: 'compareExchange', label: 'compareExchange()', summary: 'Порівняння з обміном.' },
+			{ name: 'wait', label: 'wait()', summary: 'Чекає на зміну комірки (futex).' },
+			{ name: 'notify', label: 'notify()', summary: 'Будить потоки, що чекають.' }
+		]
+	},
+	{
+		slug: 'Immutable',
+		title: 'Immutable',
+		description: 'Заморожені та спільні між воркерами дані.',
+		methods: [
+			{ name: 'freeze', label: 'freeze()', summary: 'Глибоко заморожує значення.' },
+			{ name: 'isFrozen', label: 'isFrozen()', summary: 'Чи значення заморожене.' },
+			{ name: 'share', label: 'share()', summary: 'Копіює дані у спільну область.' },
+			{ name: 'isShared', label: 'isShared()', summary: 'Чи значення спільне.' }
+		]
+	},
 	{
 		slug: 'Crypto',
 		title: 'Crypto',